@@ -0,0 +1,22 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class IKCore : ModuleRules
+{
+	public IKCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// the SIMD batch kernels switch the instruction set per translation unit, which a unity blob would mix up
+		bUseUnity = false;
+
+		// the solver phase timers compile away in shipping builds
+		PublicDefinitions.Add(Target.Configuration != UnrealTargetConfiguration.Shipping ? "IKCORE_STATS=1" : "IKCORE_STATS=0");
+
+		PublicDependencyModuleNames.AddRange(new string[] {
+            "Core",
+            "Eigen"
+        });
+	}
+}
@@ -0,0 +1,139 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+namespace IKCore
+{
+	namespace
+	{
+		std::atomic<int64_t> NumScratchHeapAllocations{ 0 };
+
+		// room for blocks doubling from the default size to well past anything a solve asks for
+		constexpr size_t MaxExpectedBlocks = 16;
+	}
+
+	FScratchArena::FScratchArena(size_t InitialSize)
+	{
+		Blocks.reserve(MaxExpectedBlocks);
+		if (InitialSize > 0)
+		{
+			AddBlock(InitialSize);
+		}
+	}
+
+	FScratchArena::~FScratchArena()
+	{
+		for (const FBlock& Block : Blocks)
+		{
+			std::free(Block.Data);
+		}
+	}
+
+	void* FScratchArena::Allocate(size_t Size, size_t Alignment)
+	{
+		Alignment = std::max(Alignment, MinAlignment);
+		if (Blocks.empty() && !AddBlock(Size + Alignment))
+		{
+			return nullptr;
+		}
+
+		for (;;)
+		{
+			const FBlock& Block = Blocks[CurrentBlock];
+			const uintptr_t Base = reinterpret_cast<uintptr_t>(Block.Data);
+			const size_t Start = static_cast<size_t>(((Base + Offset + Alignment - 1) & ~static_cast<uintptr_t>(Alignment - 1)) - Base);
+			if (Start + Size <= Block.Size)
+			{
+				Offset = Start + Size;
+				PeakBytesUsed = std::max(PeakBytesUsed, BytesBeforeBlock + Offset);
+				return Block.Data + Start;
+			}
+
+			// on to the next block, one left by an earlier frame or a new one, skipping those too small
+			if (CurrentBlock + 1 == Blocks.size() && !AddBlock(std::max(Size + Alignment, 2 * Block.Size)))
+			{
+				return nullptr;
+			}
+			BytesBeforeBlock += Blocks[CurrentBlock].Size;
+			++CurrentBlock;
+			Offset = 0;
+		}
+	}
+
+	void FScratchArena::Rewind(const FMark& Mark)
+	{
+		CurrentBlock = Mark.Block;
+		Offset = Mark.Offset;
+
+		if (CurrentBlock == 0 && Offset == 0 && Blocks.size() > 1)
+		{
+			// one block holding the whole frame, so the next one fits without growing
+			size_t TotalSize = 0;
+			for (const FBlock& Block : Blocks)
+			{
+				TotalSize += Block.Size;
+				std::free(Block.Data);
+			}
+			Blocks.clear();
+			AddBlock(TotalSize);
+			CurrentBlock = 0;
+		}
+
+		BytesBeforeBlock = 0;
+		for (size_t Index = 0; Index < CurrentBlock; ++Index)
+		{
+			BytesBeforeBlock += Blocks[Index].Size;
+		}
+	}
+
+	size_t FScratchArena::GetBytesUsed() const
+	{
+		return BytesBeforeBlock + Offset;
+	}
+
+	size_t FScratchArena::GetCapacity() const
+	{
+		size_t Capacity = 0;
+		for (const FBlock& Block : Blocks)
+		{
+			Capacity += Block.Size;
+		}
+		return Capacity;
+	}
+
+	bool FScratchArena::AddBlock(size_t MinSize)
+	{
+		FBlock Block;
+		Block.Size = std::max(MinSize, DefaultBlockSize);
+		Block.Data = static_cast<char*>(std::malloc(Block.Size));
+		if (Block.Data == nullptr)
+		{
+			return false;
+		}
+		Blocks.push_back(Block);
+
+		++NumHeapAllocations;
+		AddScratchHeapAllocations(1);
+		return true;
+	}
+
+	FScratchArena& GetThreadScratchArena()
+	{
+		thread_local FScratchArena Arena;
+		return Arena;
+	}
+
+	int64_t GetNumScratchHeapAllocations()
+	{
+		return NumScratchHeapAllocations.load(std::memory_order_relaxed);
+	}
+
+	void AddScratchHeapAllocations(int64_t NumAllocations)
+	{
+		NumScratchHeapAllocations.fetch_add(NumAllocations, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,48 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreBatchCCD.h"
+#include "IKCoreArena.h"
+
+#include <algorithm>
+
+namespace IKCore
+{
+	void SolveCCDBatchScalar(FChainBatch& Batch, const FSolverSettings& Settings, float* SweepRotations)
+	{
+		Simd::SolveCCDBatchKernel<Simd::FFloat1>(Batch, Settings, SweepRotations);
+	}
+
+	void SolveCCDBatch(FChainBatch& Batch, const FSolverSettings& Settings, ESimdLevel SimdLevel)
+	{
+		if (Batch.NumChains <= 0 || Batch.NumBones < 2)
+		{
+			return;
+		}
+
+		const ESimdLevel Level = std::min(SimdLevel, GetSupportedSimdLevel());
+		FScratchScope Scratch(GetThreadScratchArena());
+		float* const SweepRotations = Scratch.GetArena().AllocateArray<float>(static_cast<size_t>(Batch.NumBones - 1) * 4 * GetSimdWidth(Level));
+		switch (Level)
+		{
+#if IKCORE_SIMD_X86
+		case ESimdLevel::AVX512:
+			SolveCCDBatchAVX512(Batch, Settings, SweepRotations);
+			break;
+		case ESimdLevel::AVX2:
+			SolveCCDBatchAVX2(Batch, Settings, SweepRotations);
+			break;
+		case ESimdLevel::SSE:
+			SolveCCDBatchSSE(Batch, Settings, SweepRotations);
+			break;
+#endif
+		default:
+			SolveCCDBatchScalar(Batch, Settings, SweepRotations);
+			break;
+		}
+	}
+
+	void SolveCCDBatch(FChainBatch& Batch, const FSolverSettings& Settings)
+	{
+		SolveCCDBatch(Batch, Settings, GetSupportedSimdLevel());
+	}
+}
@@ -0,0 +1,110 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreBatchMath.h"
+
+namespace IKCore
+{
+	/**
+	 * One entry point per kernel; the vector ones are only defined on x86 and only called when the CPU supports them.
+	 * SweepRotations is scratch for 4 * SIMD width floats per link, allocated by the caller so that no container code
+	 * gets instantiated for the kernels' instruction sets.
+	 */
+	void SolveCCDBatchScalar(FChainBatch& Batch, const FSolverSettings& Settings, float* SweepRotations);
+	void SolveCCDBatchSSE(FChainBatch& Batch, const FSolverSettings& Settings, float* SweepRotations);
+	void SolveCCDBatchAVX2(FChainBatch& Batch, const FSolverSettings& Settings, float* SweepRotations);
+	void SolveCCDBatchAVX512(FChainBatch& Batch, const FSolverSettings& Settings, float* SweepRotations);
+
+	namespace Simd
+	{
+		namespace
+		{
+			/**
+			 * SolveCCD on FloatType::Width chains at a time, the joints of every lane turned in lockstep.
+			 * A sweep only moves the tip while it walks from the tip's parent to the root and keeps each joint's rotation,
+			 * then rewrites the chain once as the prefix product of those rotations (see FPose::RotateBones).
+			 * A lane whose tip is within precision gets identity rotations; the group exits when no lane is active anymore.
+			 */
+			template <typename FloatType>
+			void SolveCCDBatchKernel(FChainBatch& Batch, const FSolverSettings& Settings, float* SweepRotations)
+			{
+				using FMask = typename FloatType::FMask;
+				using FVector = TVector3<FloatType>;
+				using FQuat = TQuat<FloatType>;
+
+				const int32_t TipIndex = Batch.NumBones - 1;
+				const FloatType Zero = FloatType::Splat(0.f);
+				const FloatType One = FloatType::Splat(1.f);
+				const FloatType Precision = FloatType::Splat(Settings.Precision);
+
+				// below this the tip, the joint and the target are taken as aligned, padding lanes are all zero
+				const FloatType MinAxisSquared = FloatType::Splat(1e-12f);
+
+				// one sweep's joint rotations of the current lane group as X, Y, Z, W rows, reused by every group
+				const auto StoreRotation = [SweepRotations](int32_t Index, const FQuat& Rotation)
+				{
+					float* Destination = SweepRotations + Index * 4 * FloatType::Width;
+					Rotation.V.X.Store(Destination);
+					Rotation.V.Y.Store(Destination + FloatType::Width);
+					Rotation.V.Z.Store(Destination + 2 * FloatType::Width);
+					Rotation.W.Store(Destination + 3 * FloatType::Width);
+				};
+				const auto LoadRotation = [SweepRotations](int32_t Index)
+				{
+					const float* Source = SweepRotations + Index * 4 * FloatType::Width;
+					return FQuat{ { FloatType::Load(Source), FloatType::Load(Source + FloatType::Width), FloatType::Load(Source + 2 * FloatType::Width) }, FloatType::Load(Source + 3 * FloatType::Width) };
+				};
+
+				for (int32_t Lane = 0; Lane < Batch.NumChains; Lane += FloatType::Width)
+				{
+					const FVector Target = { FloatType::Load(Batch.TargetX.data() + Lane), FloatType::Load(Batch.TargetY.data() + Lane), FloatType::Load(Batch.TargetZ.data() + Lane) };
+
+					FVector TipLocation = LoadPosition<FloatType>(Batch, TipIndex, Lane);
+					FloatType Iterations = Zero;
+					FMask Active = FloatType::Greater(Distance(TipLocation, Target), Precision);
+					for (int32_t Iteration = 0; Iteration < Settings.MaxIterations && FloatType::Any(Active); ++Iteration)
+					{
+						Iterations = Iterations + FloatType::Select(Active, One, Zero);
+
+						for (int32_t Index = TipIndex - 1; Index >= 0; --Index)
+						{
+							const FVector Position = LoadPosition<FloatType>(Batch, Index, Lane);
+							const FVector ToEnd = Subtract(TipLocation, Position);
+							const FQuat DeltaRotation = Select(Active, ShortestArc(ToEnd, Subtract(Target, Position), MinAxisSquared), FQuat::Identity());
+							const FVector RotatedToEnd = Rotate(DeltaRotation, ToEnd);
+							TipLocation = { Position.X + RotatedToEnd.X, Position.Y + RotatedToEnd.Y, Position.Z + RotatedToEnd.Z };
+							StoreRotation(Index, DeltaRotation);
+						}
+
+						FQuat PrefixRotation = FQuat::Identity();
+						FVector OriginalParent = LoadPosition<FloatType>(Batch, 0, Lane);
+						FVector Parent = OriginalParent;
+						for (int32_t Index = 0; Index < TipIndex; ++Index)
+						{
+							PrefixRotation = Multiply(PrefixRotation, LoadRotation(Index));
+
+							const FVector OriginalChild = LoadPosition<FloatType>(Batch, Index + 1, Lane);
+							const FVector Link = Rotate(PrefixRotation, Subtract(OriginalChild, OriginalParent));
+							Parent = Select(Active, FVector{ Parent.X + Link.X, Parent.Y + Link.Y, Parent.Z + Link.Z }, OriginalChild);
+							StorePosition(Batch, Index + 1, Lane, Parent);
+							OriginalParent = OriginalChild;
+						}
+
+						// the rebuilt tip, not the one tracked through the sweep, so the residual is the one of the stored chain
+						TipLocation = Parent;
+						Active = FloatType::And(Active, FloatType::Greater(Distance(TipLocation, Target), Precision));
+					}
+
+					Distance(TipLocation, Target).Store(Batch.Residuals.data() + Lane);
+					alignas(64) float LaneIterations[FloatType::Width];
+					Iterations.Store(LaneIterations);
+					for (int32_t Index = 0; Index < FloatType::Width; ++Index)
+					{
+						Batch.Iterations[Lane + Index] = static_cast<int32_t>(LaneIterations[Index]);
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,183 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreBatchFABRIK.h"
+
+#include <algorithm>
+
+#if IKCORE_SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace IKCore
+{
+	namespace
+	{
+		// widest SIMD width, every Stride is a multiple of it so kernels never need a remainder loop
+		constexpr int32_t MaxSimdWidth = 16;
+
+		ESimdLevel DetectSimdLevel()
+		{
+#if IKCORE_SIMD_X86 && defined(_MSC_VER)
+			int CpuInfo[4];
+			__cpuid(CpuInfo, 1);
+			const bool bOSXSave = (CpuInfo[2] & (1 << 27)) != 0;
+			const bool bAVX = (CpuInfo[2] & (1 << 28)) != 0;
+			if (!bOSXSave || !bAVX)
+			{
+				return ESimdLevel::SSE;
+			}
+
+			// the OS has to save the YMM (and for AVX-512 the opmask and ZMM) registers on context switches
+			const unsigned long long EnabledStates = _xgetbv(0);
+			__cpuidex(CpuInfo, 7, 0);
+			if ((EnabledStates & 0xE6) == 0xE6 && (CpuInfo[1] & (1 << 16)) != 0)
+			{
+				return ESimdLevel::AVX512;
+			}
+			if ((EnabledStates & 0x6) == 0x6 && (CpuInfo[1] & (1 << 5)) != 0)
+			{
+				return ESimdLevel::AVX2;
+			}
+			return ESimdLevel::SSE;
+#elif IKCORE_SIMD_X86
+			// libgcc checks the OS support through xgetbv as well
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f"))
+			{
+				return ESimdLevel::AVX512;
+			}
+			if (__builtin_cpu_supports("avx2"))
+			{
+				return ESimdLevel::AVX2;
+			}
+			return ESimdLevel::SSE;
+#else
+			return ESimdLevel::Scalar;
+#endif
+		}
+	}
+
+	ESimdLevel GetSupportedSimdLevel()
+	{
+		static const ESimdLevel SupportedLevel = DetectSimdLevel();
+		return SupportedLevel;
+	}
+
+	int32_t GetSimdWidth(ESimdLevel SimdLevel)
+	{
+		switch (SimdLevel)
+		{
+		case ESimdLevel::SSE:
+			return 4;
+		case ESimdLevel::AVX2:
+			return 8;
+		case ESimdLevel::AVX512:
+			return 16;
+		default:
+			return 1;
+		}
+	}
+
+	void FChainBatch::Reset(int32_t InNumChains, int32_t InNumBones)
+	{
+		NumChains = InNumChains;
+		NumBones = InNumBones;
+		Stride = (InNumChains + MaxSimdWidth - 1) / MaxSimdWidth * MaxSimdWidth;
+
+		const size_t NumPositions = static_cast<size_t>(Stride) * InNumBones;
+		PositionX.assign(NumPositions, 0.f);
+		PositionY.assign(NumPositions, 0.f);
+		PositionZ.assign(NumPositions, 0.f);
+		Lengths.assign(static_cast<size_t>(Stride) * std::max(InNumBones - 1, 0), 0.f);
+		TargetX.assign(Stride, 0.f);
+		TargetY.assign(Stride, 0.f);
+		TargetZ.assign(Stride, 0.f);
+		Residuals.assign(Stride, 0.f);
+		Iterations.assign(Stride, 0);
+	}
+
+	void FChainBatch::SetChain(int32_t Chain, const FPose& Pose, const Eigen::Vector3f& Target)
+	{
+		for (int32_t Index = 0; Index < NumBones; ++Index)
+		{
+			const int32_t Offset = Index * Stride + Chain;
+			PositionX[Offset] = Pose.Positions[Index].x();
+			PositionY[Offset] = Pose.Positions[Index].y();
+			PositionZ[Offset] = Pose.Positions[Index].z();
+		}
+		for (int32_t Index = 0; Index < NumBones - 1; ++Index)
+		{
+			Lengths[Index * Stride + Chain] = Pose.Lengths[Index];
+		}
+		TargetX[Chain] = Target.x();
+		TargetY[Chain] = Target.y();
+		TargetZ[Chain] = Target.z();
+	}
+
+	void FChainBatch::GetChain(int32_t Chain, FPose& Pose) const
+	{
+		// same as FPose::AlignRotationsToPositions, with Pose still holding the original positions
+		const int32_t TipIndex = NumBones - 1;
+		const Eigen::Quaternionf TipLocalRotation = Pose.Rotations[TipIndex - 1].conjugate() * Pose.Rotations[TipIndex];
+
+		Eigen::Vector3f Position(PositionX[Chain], PositionY[Chain], PositionZ[Chain]);
+		for (int32_t Index = 0; Index < TipIndex; ++Index)
+		{
+			const int32_t ChildOffset = (Index + 1) * Stride + Chain;
+			const Eigen::Vector3f ChildPosition(PositionX[ChildOffset], PositionY[ChildOffset], PositionZ[ChildOffset]);
+
+			const Eigen::Vector3f OriginalOrientation = Pose.Positions[Index + 1] - Pose.Positions[Index];
+			const Eigen::Quaternionf DeltaRotation = Eigen::Quaternionf::FromTwoVectors(OriginalOrientation, ChildPosition - Position);
+			Pose.Rotations[Index] = (DeltaRotation * Pose.Rotations[Index]).normalized();
+			Pose.Positions[Index] = Position;
+			Position = ChildPosition;
+		}
+		Pose.Positions[TipIndex] = Position;
+		Pose.Rotations[TipIndex] = Pose.Rotations[TipIndex - 1] * TipLocalRotation;
+	}
+
+	FSolveResult FChainBatch::GetResult(int32_t Chain, const FSolverSettings& Settings) const
+	{
+		FSolveResult Result;
+		Result.Iterations = Iterations[Chain];
+		Result.Residual = Residuals[Chain];
+		Result.bConverged = Result.Residual <= Settings.Precision;
+		return Result;
+	}
+
+	void SolveFABRIKBatchScalar(FChainBatch& Batch, const FSolverSettings& Settings)
+	{
+		Simd::SolveFABRIKBatchKernel<Simd::FFloat1>(Batch, Settings);
+	}
+
+	void SolveFABRIKBatch(FChainBatch& Batch, const FSolverSettings& Settings, ESimdLevel SimdLevel)
+	{
+		if (Batch.NumChains <= 0 || Batch.NumBones < 2)
+		{
+			return;
+		}
+
+		switch (std::min(SimdLevel, GetSupportedSimdLevel()))
+		{
+#if IKCORE_SIMD_X86
+		case ESimdLevel::AVX512:
+			SolveFABRIKBatchAVX512(Batch, Settings);
+			break;
+		case ESimdLevel::AVX2:
+			SolveFABRIKBatchAVX2(Batch, Settings);
+			break;
+		case ESimdLevel::SSE:
+			SolveFABRIKBatchSSE(Batch, Settings);
+			break;
+#endif
+		default:
+			SolveFABRIKBatchScalar(Batch, Settings);
+			break;
+		}
+	}
+
+	void SolveFABRIKBatch(FChainBatch& Batch, const FSolverSettings& Settings)
+	{
+		SolveFABRIKBatch(Batch, Settings, GetSupportedSimdLevel());
+	}
+}
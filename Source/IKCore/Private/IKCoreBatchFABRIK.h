@@ -0,0 +1,114 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreBatchMath.h"
+
+namespace IKCore
+{
+	/** One entry point per kernel; the vector ones are only defined on x86 and only called when the CPU supports them. */
+	void SolveFABRIKBatchScalar(FChainBatch& Batch, const FSolverSettings& Settings);
+	void SolveFABRIKBatchSSE(FChainBatch& Batch, const FSolverSettings& Settings);
+	void SolveFABRIKBatchAVX2(FChainBatch& Batch, const FSolverSettings& Settings);
+	void SolveFABRIKBatchAVX512(FChainBatch& Batch, const FSolverSettings& Settings);
+
+	namespace Simd
+	{
+		namespace
+		{
+			/** Point at Length from From towards To, i.e. the (1 - Lambda) * From + Lambda * To step of FABRIK. */
+			template <typename FloatType>
+			TVector3<FloatType> PlaceAtLength(const TVector3<FloatType>& From, const TVector3<FloatType>& To, FloatType Length, FloatType MinDistanceSquared)
+			{
+				const TVector3<FloatType> Delta = { To.X - From.X, To.Y - From.Y, To.Z - From.Z };
+				const FloatType Lambda = Length * FloatType::InvSqrt(FloatType::Max(Delta.X * Delta.X + Delta.Y * Delta.Y + Delta.Z * Delta.Z, MinDistanceSquared));
+				return { From.X + Delta.X * Lambda, From.Y + Delta.Y * Lambda, From.Z + Delta.Z * Lambda };
+			}
+
+			/**
+			 * SolveFABRIK on FloatType::Width chains at a time. A lane whose tip is within precision stops moving
+			 * (its positions are selected back unchanged); the group exits when no lane is active anymore.
+			 */
+			template <typename FloatType>
+			void SolveFABRIKBatchKernel(FChainBatch& Batch, const FSolverSettings& Settings)
+			{
+				using FMask = typename FloatType::FMask;
+				using FVector = TVector3<FloatType>;
+
+				const int32_t Stride = Batch.Stride;
+				const int32_t TipIndex = Batch.NumBones - 1;
+				const FloatType Zero = FloatType::Splat(0.f);
+				const FloatType One = FloatType::Splat(1.f);
+				const FloatType Precision = FloatType::Splat(Settings.Precision);
+
+				// coincident joints would divide by zero, padding lanes are all zero
+				const FloatType MinDistanceSquared = FloatType::Splat(1e-12f);
+
+				for (int32_t Lane = 0; Lane < Batch.NumChains; Lane += FloatType::Width)
+				{
+					const FVector Target = { FloatType::Load(Batch.TargetX.data() + Lane), FloatType::Load(Batch.TargetY.data() + Lane), FloatType::Load(Batch.TargetZ.data() + Lane) };
+					const FVector Root = LoadPosition<FloatType>(Batch, 0, Lane);
+
+					FloatType TotalLength = Zero;
+					for (int32_t Index = 0; Index < TipIndex; ++Index)
+					{
+						TotalLength = TotalLength + FloatType::Load(Batch.Lengths.data() + Index * Stride + Lane);
+					}
+
+					// unreachable lanes are stretched towards the target in one pass
+					const FMask Unreachable = FloatType::Greater(Distance(Target, Root), TotalLength);
+					FloatType Iterations = FloatType::Select(Unreachable, One, Zero);
+					if (FloatType::Any(Unreachable))
+					{
+						FVector Parent = Root;
+						for (int32_t Index = 0; Index < TipIndex; ++Index)
+						{
+							const FloatType Length = FloatType::Load(Batch.Lengths.data() + Index * Stride + Lane);
+							const FVector Child = LoadPosition<FloatType>(Batch, Index + 1, Lane);
+							Parent = Select(Unreachable, PlaceAtLength(Parent, Target, Length, MinDistanceSquared), Child);
+							StorePosition(Batch, Index + 1, Lane, Parent);
+						}
+					}
+
+					FMask Active = FloatType::AndNot(FloatType::Greater(Distance(LoadPosition<FloatType>(Batch, TipIndex, Lane), Target), Precision), Unreachable);
+					for (int32_t Iteration = 0; Iteration < Settings.MaxIterations && FloatType::Any(Active); ++Iteration)
+					{
+						Iterations = Iterations + FloatType::Select(Active, One, Zero);
+
+						// forward reaching
+						FVector Child = Select(Active, Target, LoadPosition<FloatType>(Batch, TipIndex, Lane));
+						StorePosition(Batch, TipIndex, Lane, Child);
+						for (int32_t Index = TipIndex - 1; Index >= 0; --Index)
+						{
+							const FloatType Length = FloatType::Load(Batch.Lengths.data() + Index * Stride + Lane);
+							const FVector Position = LoadPosition<FloatType>(Batch, Index, Lane);
+							Child = Select(Active, PlaceAtLength(Child, Position, Length, MinDistanceSquared), Position);
+							StorePosition(Batch, Index, Lane, Child);
+						}
+
+						// backward reaching
+						FVector Parent = Root;
+						StorePosition(Batch, 0, Lane, Parent);
+						for (int32_t Index = 0; Index < TipIndex; ++Index)
+						{
+							const FloatType Length = FloatType::Load(Batch.Lengths.data() + Index * Stride + Lane);
+							const FVector Position = LoadPosition<FloatType>(Batch, Index + 1, Lane);
+							Parent = Select(Active, PlaceAtLength(Parent, Position, Length, MinDistanceSquared), Position);
+							StorePosition(Batch, Index + 1, Lane, Parent);
+						}
+
+						Active = FloatType::And(Active, FloatType::Greater(Distance(Parent, Target), Precision));
+					}
+
+					Distance(LoadPosition<FloatType>(Batch, TipIndex, Lane), Target).Store(Batch.Residuals.data() + Lane);
+					alignas(64) float LaneIterations[FloatType::Width];
+					Iterations.Store(LaneIterations);
+					for (int32_t Index = 0; Index < FloatType::Width; ++Index)
+					{
+						Batch.Iterations[Lane + Index] = static_cast<int32_t>(LaneIterations[Index]);
+					}
+				}
+			}
+		}
+	}
+}
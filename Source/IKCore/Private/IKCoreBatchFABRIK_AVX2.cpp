@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+// everything compiled before the target switch must stay baseline code, see IKCoreSimd.h
+#include "IKCoreBatch.h"
+#include "IKCoreSimd.h"
+
+#if IKCORE_SIMD_X86
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#define IKCORE_SIMD_AVX2 1
+#include "IKCoreSimd.h"
+#include "IKCoreBatchFABRIK.h"
+
+namespace IKCore
+{
+	void SolveFABRIKBatchAVX2(FChainBatch& Batch, const FSolverSettings& Settings)
+	{
+		Simd::SolveFABRIKBatchKernel<Simd::FFloat8>(Batch, Settings);
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
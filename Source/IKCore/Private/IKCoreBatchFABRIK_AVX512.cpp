@@ -0,0 +1,36 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+// everything compiled before the target switch must stay baseline code, see IKCoreSimd.h
+#include "IKCoreBatch.h"
+#include "IKCoreSimd.h"
+
+#if IKCORE_SIMD_X86
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// _mm512_undefined_ps() trips a false positive in GCC 12's avx512fintrin.h
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#define IKCORE_SIMD_AVX512 1
+#include "IKCoreSimd.h"
+#include "IKCoreBatchFABRIK.h"
+
+namespace IKCore
+{
+	void SolveFABRIKBatchAVX512(FChainBatch& Batch, const FSolverSettings& Settings)
+	{
+		Simd::SolveFABRIKBatchKernel<Simd::FFloat16>(Batch, Settings);
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
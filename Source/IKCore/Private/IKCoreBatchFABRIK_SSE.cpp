@@ -0,0 +1,16 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreBatchFABRIK.h"
+
+#if IKCORE_SIMD_X86
+
+namespace IKCore
+{
+	// SSE2 is the x86-64 baseline, no target switch needed
+	void SolveFABRIKBatchSSE(FChainBatch& Batch, const FSolverSettings& Settings)
+	{
+		Simd::SolveFABRIKBatchKernel<Simd::FFloat4>(Batch, Settings);
+	}
+}
+
+#endif
@@ -0,0 +1,127 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreBatch.h"
+#include "IKCoreSimd.h"
+
+namespace IKCore
+{
+	namespace Simd
+	{
+		/** Vector and quaternion math on FloatType::Width lanes, shared by the batch kernels. */
+		namespace
+		{
+			template <typename FloatType>
+			struct TVector3
+			{
+				FloatType X;
+				FloatType Y;
+				FloatType Z;
+
+				FloatType Length() const { return FloatType::Sqrt(X * X + Y * Y + Z * Z); }
+			};
+
+			template <typename FloatType>
+			TVector3<FloatType> LoadPosition(const FChainBatch& Batch, int32_t Bone, int32_t Lane)
+			{
+				const int32_t Offset = Bone * Batch.Stride + Lane;
+				return { FloatType::Load(Batch.PositionX.data() + Offset), FloatType::Load(Batch.PositionY.data() + Offset), FloatType::Load(Batch.PositionZ.data() + Offset) };
+			}
+
+			template <typename FloatType>
+			void StorePosition(FChainBatch& Batch, int32_t Bone, int32_t Lane, const TVector3<FloatType>& Position)
+			{
+				const int32_t Offset = Bone * Batch.Stride + Lane;
+				Position.X.Store(Batch.PositionX.data() + Offset);
+				Position.Y.Store(Batch.PositionY.data() + Offset);
+				Position.Z.Store(Batch.PositionZ.data() + Offset);
+			}
+
+			template <typename FloatType>
+			TVector3<FloatType> Select(typename FloatType::FMask Mask, const TVector3<FloatType>& IfTrue, const TVector3<FloatType>& IfFalse)
+			{
+				return { FloatType::Select(Mask, IfTrue.X, IfFalse.X), FloatType::Select(Mask, IfTrue.Y, IfFalse.Y), FloatType::Select(Mask, IfTrue.Z, IfFalse.Z) };
+			}
+
+			template <typename FloatType>
+			FloatType Distance(const TVector3<FloatType>& A, const TVector3<FloatType>& B)
+			{
+				const TVector3<FloatType> Delta = { A.X - B.X, A.Y - B.Y, A.Z - B.Z };
+				return Delta.Length();
+			}
+
+			template <typename FloatType>
+			TVector3<FloatType> Subtract(const TVector3<FloatType>& A, const TVector3<FloatType>& B)
+			{
+				return { A.X - B.X, A.Y - B.Y, A.Z - B.Z };
+			}
+
+			template <typename FloatType>
+			FloatType Dot(const TVector3<FloatType>& A, const TVector3<FloatType>& B)
+			{
+				return A.X * B.X + A.Y * B.Y + A.Z * B.Z;
+			}
+
+			template <typename FloatType>
+			TVector3<FloatType> Cross(const TVector3<FloatType>& A, const TVector3<FloatType>& B)
+			{
+				return { A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X };
+			}
+
+			/** Quaternion per lane, in the X, Y, Z, W order of Eigen's coefficients. */
+			template <typename FloatType>
+			struct TQuat
+			{
+				TVector3<FloatType> V;
+				FloatType W;
+
+				static TQuat Identity() { return { { FloatType::Splat(0.f), FloatType::Splat(0.f), FloatType::Splat(0.f) }, FloatType::Splat(1.f) }; }
+			};
+
+			template <typename FloatType>
+			TQuat<FloatType> Select(typename FloatType::FMask Mask, const TQuat<FloatType>& IfTrue, const TQuat<FloatType>& IfFalse)
+			{
+				return { Select(Mask, IfTrue.V, IfFalse.V), FloatType::Select(Mask, IfTrue.W, IfFalse.W) };
+			}
+
+			template <typename FloatType>
+			TQuat<FloatType> Multiply(const TQuat<FloatType>& A, const TQuat<FloatType>& B)
+			{
+				const TVector3<FloatType> Axis = Cross(A.V, B.V);
+				return {
+					{ A.W * B.V.X + B.W * A.V.X + Axis.X, A.W * B.V.Y + B.W * A.V.Y + Axis.Y, A.W * B.V.Z + B.W * A.V.Z + Axis.Z },
+					A.W * B.W - Dot(A.V, B.V) };
+			}
+
+			/** Q * Vector * Q^-1 for a unit Q, as v + 2w (q x v) + 2 q x (q x v). */
+			template <typename FloatType>
+			TVector3<FloatType> Rotate(const TQuat<FloatType>& Q, const TVector3<FloatType>& Vector)
+			{
+				const FloatType Two = FloatType::Splat(2.f);
+				const TVector3<FloatType> QCrossV = Cross(Q.V, Vector);
+				const TVector3<FloatType> T = { Two * QCrossV.X, Two * QCrossV.Y, Two * QCrossV.Z };
+				const TVector3<FloatType> QCrossT = Cross(Q.V, T);
+				return { Vector.X + Q.W * T.X + QCrossT.X, Vector.Y + Q.W * T.Y + QCrossT.Y, Vector.Z + Q.W * T.Z + QCrossT.Z };
+			}
+
+			/**
+			 * Shortest arc rotation taking the direction of From onto the direction of To, built from the half angle:
+			 * (|From| |To| + From . To, From x To) is that rotation scaled by 2 |From| |To| cos(angle / 2), so a single
+			 * normalization replaces the acos, sin and cos of the axis-angle construction. Lanes where the directions are
+			 * (anti)parallel or a vector is zero get the identity.
+			 */
+			template <typename FloatType>
+			TQuat<FloatType> ShortestArc(const TVector3<FloatType>& From, const TVector3<FloatType>& To, FloatType MinAxisSquared)
+			{
+				const TVector3<FloatType> Axis = Cross(From, To);
+				const FloatType AxisSquared = Dot(Axis, Axis);
+				const FloatType W = FloatType::Sqrt(Dot(From, From) * Dot(To, To)) + Dot(From, To);
+				const FloatType InvNorm = FloatType::InvSqrt(FloatType::Max(W * W + AxisSquared, MinAxisSquared));
+
+				const TQuat<FloatType> Rotation = { { Axis.X * InvNorm, Axis.Y * InvNorm, Axis.Z * InvNorm }, W * InvNorm };
+				return Select(FloatType::Greater(AxisSquared, MinAxisSquared), Rotation, TQuat<FloatType>::Identity());
+			}
+		}
+	}
+}
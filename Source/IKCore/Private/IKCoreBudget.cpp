@@ -0,0 +1,124 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreBudget.h"
+
+#include <algorithm>
+
+namespace IKCore
+{
+	float ComputeSignificance(float Distance, float BoundsRadius, float TanHalfFOV, float Priority)
+	{
+		const float HalfViewHeight = std::max(Distance * TanHalfFOV, 1e-3f);
+		return Priority * BoundsRadius / HalfViewHeight;
+	}
+
+	FSolverSettings GetTierSettings(ELODTier Tier, const FSolverSettings& FullSettings, const FBudgetSettings& BudgetSettings)
+	{
+		FSolverSettings Settings = FullSettings;
+		switch (Tier)
+		{
+		case ELODTier::Reduced:
+			Settings.MaxIterations = std::max(std::min(Settings.MaxIterations, BudgetSettings.ReducedMaxIterations), 1);
+			break;
+		case ELODTier::AnalyticOnly:
+			// there is no closed form past two links, a single iteration of the chain's solver is the cheapest stand-in
+			Settings.bAnalyticTwoBone = true;
+			Settings.MaxIterations = 1;
+			break;
+		default:
+			break;
+		}
+		return Settings;
+	}
+
+	FFrameBudget::FFrameBudget()
+	{
+		// first guesses for a short chain, replaced by measurements after the first frame that uses a tier
+		EstimatedSeconds[static_cast<int32_t>(ELODTier::Full)] = 20e-6;
+		EstimatedSeconds[static_cast<int32_t>(ELODTier::Reduced)] = 8e-6;
+		EstimatedSeconds[static_cast<int32_t>(ELODTier::Interval)] = 6e-6;
+		EstimatedSeconds[static_cast<int32_t>(ELODTier::AnalyticOnly)] = 3e-6;
+	}
+
+	void FFrameBudget::BeginFrame(const FBudgetSettings& InSettings)
+	{
+		Settings = InSettings;
+		Requests.clear();
+	}
+
+	int32_t FFrameBudget::AddRequest(float Significance, int32_t NumChains)
+	{
+		FRequest Request;
+		Request.Significance = Significance;
+		Request.NumChains = std::max(NumChains, 1);
+		Requests.push_back(Request);
+		return static_cast<int32_t>(Requests.size()) - 1;
+	}
+
+	void FFrameBudget::AssignTiers()
+	{
+		const double Smoothing = std::min(std::max(static_cast<double>(Settings.CostSmoothing), 0.0), 1.0);
+		for (int32_t Tier = 0; Tier < NumTiers; ++Tier)
+		{
+			if (NumReported[Tier] > 0)
+			{
+				const double MeasuredSeconds = ReportedSeconds[Tier] / NumReported[Tier];
+				EstimatedSeconds[Tier] += Smoothing * (MeasuredSeconds - EstimatedSeconds[Tier]);
+			}
+			ReportedSeconds[Tier] = 0.0;
+			NumReported[Tier] = 0;
+		}
+
+		SortedRequests.resize(Requests.size());
+		for (int32_t Index = 0; Index < static_cast<int32_t>(Requests.size()); ++Index)
+		{
+			SortedRequests[Index] = Index;
+		}
+		std::stable_sort(SortedRequests.begin(), SortedRequests.end(), [this](int32_t A, int32_t B)
+		{
+			return Requests[A].Significance > Requests[B].Significance;
+		});
+
+		// every character is reserved at the cheapest tier, the rest of the budget buys upgrades in order of significance;
+		// that is usually AnalyticOnly, but the interpolated frames can make Interval cheaper on long chains
+		const ELODTier CheapestTier = static_cast<ELODTier>(std::min_element(EstimatedSeconds, EstimatedSeconds + NumTiers) - EstimatedSeconds);
+		const double CheapestSeconds = GetEstimatedSeconds(CheapestTier);
+		double RemainingSeconds = Settings.BudgetSeconds;
+		for (const FRequest& Request : Requests)
+		{
+			RemainingSeconds -= CheapestSeconds * Request.NumChains;
+		}
+
+		std::fill(NumInTier, NumInTier + NumTiers, 0);
+		PlannedSeconds = 0.0;
+		for (int32_t RequestIndex : SortedRequests)
+		{
+			FRequest& Request = Requests[RequestIndex];
+			RemainingSeconds += CheapestSeconds * Request.NumChains;
+
+			Request.Tier = CheapestTier;
+			if (Request.Significance > 0.f)
+			{
+				for (int32_t Tier = 0; Tier < static_cast<int32_t>(CheapestTier); ++Tier)
+				{
+					if (EstimatedSeconds[Tier] * Request.NumChains <= RemainingSeconds)
+					{
+						Request.Tier = static_cast<ELODTier>(Tier);
+						break;
+					}
+				}
+			}
+
+			const double Seconds = GetEstimatedSeconds(Request.Tier) * Request.NumChains;
+			RemainingSeconds -= Seconds;
+			PlannedSeconds += Seconds;
+			++NumInTier[static_cast<int32_t>(Request.Tier)];
+		}
+	}
+
+	void FFrameBudget::ReportSolve(ELODTier Tier, double Seconds)
+	{
+		ReportedSeconds[static_cast<int32_t>(Tier)] += Seconds;
+		++NumReported[static_cast<int32_t>(Tier)];
+	}
+}
@@ -0,0 +1,93 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreSolvers.h"
+#include "IKCoreArena.h"
+
+#include <cmath>
+
+namespace IKCore
+{
+	namespace
+	{
+		// chains up to this many links keep a sweep's rotations on the stack, longer ones in the thread's scratch arena
+		constexpr int32_t MaxStackLinks = 32;
+
+		using FSweepRotations = Eigen::Matrix<float, 4, Eigen::Dynamic, Eigen::ColMajor, 4, MaxStackLinks>;
+
+		/**
+		 * One CCD sweep from the tip's parent to the root. Only the tip is moved while sweeping, the joints above the one
+		 * being rotated have not moved yet, and the whole chain is rewritten once at the end from the first joint that turned.
+		 * A joint's turn leaves its rotation relative to its parent at Parent^-1 * Delta * Rotation whatever its ancestors
+		 * do later in the sweep, so a limited joint is clamped right there and the tip follows the clamped turn.
+		 */
+		template <typename RotationsType>
+		void Sweep(FPose& Pose, const Eigen::Vector3f& Target, RotationsType& SweepRotations)
+		{
+			const int32_t TipIndex = Pose.NumLinks();
+			const bool bLimited = Pose.HasJointLimits();
+			Eigen::Vector3f TipLocation = Pose.Positions[TipIndex];
+			int32_t FirstRotated = TipIndex;
+			for (int32_t Index = TipIndex - 1; Index >= 0; --Index)
+			{
+				const Eigen::Vector3f& CurrentBoneLocation = Pose.Positions[Index];
+				const Eigen::Vector3f ToEnd = TipLocation - CurrentBoneLocation;
+				const Eigen::Vector3f ToTarget = Target - CurrentBoneLocation;
+
+				// shortest arc from the half-angle quaternion (|a||b| + a.b, a x b), no normalized inputs and no acos
+				const Eigen::Vector3f RotationAxis = ToEnd.cross(ToTarget);
+				Eigen::Quaternionf DeltaRotation = Eigen::Quaternionf::Identity();
+				if (RotationAxis.squaredNorm() > 0.f)
+				{
+					const float W = std::sqrt(ToEnd.squaredNorm() * ToTarget.squaredNorm()) + ToEnd.dot(ToTarget);
+					DeltaRotation = Eigen::Quaternionf(W, RotationAxis.x(), RotationAxis.y(), RotationAxis.z()).normalized();
+				}
+				if (bLimited)
+				{
+					const Eigen::Quaternionf& Rotation = Pose.Rotations[Index];
+					const Eigen::Quaternionf ParentRotation = Index > 0 ? Pose.Rotations[Index - 1] : Eigen::Quaternionf(Pose.RootParentRotation);
+					DeltaRotation = (Pose.ConstrainRotation(Index, ParentRotation, DeltaRotation * Rotation) * Rotation.conjugate()).normalized();
+				}
+				if (bLimited || RotationAxis.squaredNorm() > 0.f)
+				{
+					TipLocation = CurrentBoneLocation + DeltaRotation * (TipLocation - CurrentBoneLocation);
+					FirstRotated = Index;
+				}
+				SweepRotations.col(Index) = DeltaRotation.coeffs();
+			}
+
+			Pose.RotateBones(FirstRotated, [&SweepRotations](int32_t Index)
+			{
+				return Eigen::Quaternionf(SweepRotations.col(Index));
+			});
+		}
+
+		template <typename RotationsType>
+		FSolveResult SolveCCD(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, RotationsType& SweepRotations)
+		{
+			FSolveResult Result;
+			float Distance = Pose.TipDistance(Target);
+			while (Distance > Settings.Precision && Result.Iterations < Settings.MaxIterations)
+			{
+				++Result.Iterations;
+				Sweep(Pose, Target, SweepRotations);
+				Distance = Pose.TipDistance(Target);
+			}
+
+			Result.Residual = Distance;
+			Result.bConverged = Distance <= Settings.Precision;
+			return Result;
+		}
+	}
+
+	FSolveResult SolveCCD(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings)
+	{
+		if (Pose.NumLinks() <= MaxStackLinks)
+		{
+			FSweepRotations SweepRotations(4, Pose.NumLinks());
+			return SolveCCD(Pose, Target, Settings, SweepRotations);
+		}
+		FScratchScope Scratch(GetThreadScratchArena());
+		Eigen::Map<Eigen::Matrix4Xf, Eigen::Aligned16> SweepRotations(Scratch.GetArena().AllocateArray<float>(4 * Pose.NumLinks()), 4, Pose.NumLinks());
+		return SolveCCD(Pose, Target, Settings, SweepRotations);
+	}
+}
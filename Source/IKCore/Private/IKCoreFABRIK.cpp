@@ -0,0 +1,204 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreSolvers.h"
+#include "IKCoreArena.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace IKCore
+{
+	namespace
+	{
+		/**
+		 * Backward reaching with joint limits. Each bone's rotation is carried along instead of being rebuilt from the
+		 * positions afterwards: the bone takes the shortest turn that points its link (Links, in its own frame) at
+		 * GetDirection(Index), is clamped against its parent's new rotation, and places the next bone from the clamped link.
+		 */
+		template <typename DirectionFunctionType>
+		void PlaceConstrainedLinks(FPose& Pose, const Eigen::Vector3f* Links, DirectionFunctionType&& GetDirection)
+		{
+			Eigen::Quaternionf ParentRotation = Pose.RootParentRotation;
+			for (int32_t Index = 0; Index < Pose.NumLinks(); ++Index)
+			{
+				const Eigen::Vector3f Link = Pose.Rotations[Index] * Links[Index];
+				const Eigen::Vector3f Direction = GetDirection(Index);
+
+				// shortest arc from the half-angle quaternion, as in CCD
+				const Eigen::Vector3f RotationAxis = Link.cross(Direction);
+				Eigen::Quaternionf Rotation = Pose.Rotations[Index];
+				if (RotationAxis.squaredNorm() > 0.f)
+				{
+					const float W = std::sqrt(Link.squaredNorm() * Direction.squaredNorm()) + Link.dot(Direction);
+					Rotation = Eigen::Quaternionf(W, RotationAxis.x(), RotationAxis.y(), RotationAxis.z()).normalized() * Rotation;
+				}
+				Rotation = Pose.ConstrainRotation(Index, ParentRotation, Rotation);
+
+				Pose.Rotations[Index] = Rotation;
+				Pose.Positions[Index + 1] = Pose.Positions[Index] + Rotation * Links[Index];
+				ParentRotation = Rotation;
+			}
+		}
+
+		/**
+		 * Forward reaching with joint limits, from the bone below the tip down to the root. Each bone takes the shortest turn
+		 * that points its link at the sketched position of its joint, then is turned back as little as needed for its child
+		 * to be within the child's limits, and places its joint from the projected link. The root bone's own limit holds
+		 * against the fixed root parent and is left to the backward pass.
+		 */
+		void ReachConstrainedLinksForward(FPose& Pose, const Eigen::Vector3f* Links, const Eigen::Vector3f& Target)
+		{
+			const int32_t TipIndex = Pose.NumLinks();
+			Pose.Positions[TipIndex] = Target;
+			for (int32_t Index = TipIndex - 1; Index >= 0; --Index)
+			{
+				const Eigen::Vector3f Link = Pose.Rotations[Index] * Links[Index];
+				const Eigen::Vector3f Direction = Pose.Positions[Index + 1] - Pose.Positions[Index];
+
+				const Eigen::Vector3f RotationAxis = Link.cross(Direction);
+				Eigen::Quaternionf Rotation = Pose.Rotations[Index];
+				if (RotationAxis.squaredNorm() > 0.f)
+				{
+					const float W = std::sqrt(Link.squaredNorm() * Direction.squaredNorm()) + Link.dot(Direction);
+					Rotation = Eigen::Quaternionf(W, RotationAxis.x(), RotationAxis.y(), RotationAxis.z()).normalized() * Rotation;
+				}
+
+				// the rotation that leaves the child's local rotation clamped, with the child held in place
+				if (Index + 1 < TipIndex)
+				{
+					const Eigen::Quaternionf& ChildRotation = Pose.Rotations[Index + 1];
+					const Eigen::Quaternionf ConstrainedChild = Pose.ConstrainRotation(Index + 1, Rotation, ChildRotation);
+					Rotation = (ChildRotation * ConstrainedChild.conjugate() * Rotation).normalized();
+				}
+
+				Pose.Rotations[Index] = Rotation;
+				Pose.Positions[Index] = Pose.Positions[Index + 1] - Rotation * Links[Index];
+			}
+		}
+
+		FSolveResult SolveConstrainedFABRIK(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings)
+		{
+			FSolveResult Result;
+			const int32_t TipIndex = Pose.NumLinks();
+			std::vector<Eigen::Vector3f>& Positions = Pose.Positions;
+
+			// every link in the frame of its bone, and the tip bone relative to its parent, both kept through the solve
+			FScratchScope Scratch(GetThreadScratchArena());
+			Eigen::Vector3f* const Links = Scratch.GetArena().AllocateArray<Eigen::Vector3f>(TipIndex);
+			for (int32_t Index = 0; Index < TipIndex; ++Index)
+			{
+				Links[Index] = Pose.Rotations[Index].conjugate() * (Positions[Index + 1] - Positions[Index]);
+			}
+			const Eigen::Quaternionf TipLocalRotation = Pose.Rotations[TipIndex - 1].conjugate() * Pose.Rotations[TipIndex];
+
+			const Eigen::Vector3f RootLocation = Positions[0];
+			if ((Target - RootLocation).norm() > Pose.TotalLength())
+			{
+				// unreachable: every link points at the target as far as its limits let it
+				PlaceConstrainedLinks(Pose, Links, [&Positions, &Target](int32_t Index)
+				{
+					return Eigen::Vector3f(Target - Positions[Index]);
+				});
+				Result.Iterations = 1;
+			}
+			else
+			{
+				float Distance = Pose.TipDistance(Target);
+				while (Distance > Settings.Precision && Result.Iterations < Settings.MaxIterations)
+				{
+					++Result.Iterations;
+
+					// forward reaching projects onto the limits too, or the backward pass chases a sketch it cannot follow
+					ReachConstrainedLinksForward(Pose, Links, Target);
+
+					// backward reaching follows the sketch within the limits
+					Positions[0] = RootLocation;
+					PlaceConstrainedLinks(Pose, Links, [&Positions](int32_t Index)
+					{
+						return Eigen::Vector3f(Positions[Index + 1] - Positions[Index]);
+					});
+
+					Distance = Pose.TipDistance(Target);
+				}
+			}
+			Pose.Rotations[TipIndex] = (Pose.Rotations[TipIndex - 1] * TipLocalRotation).normalized();
+
+			Result.Residual = Pose.TipDistance(Target);
+			Result.bConverged = Result.Residual <= Settings.Precision;
+			return Result;
+		}
+	}
+
+	FSolveResult SolveFABRIK(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings)
+	{
+		if (Pose.HasJointLimits())
+		{
+			return SolveConstrainedFABRIK(Pose, Target, Settings);
+		}
+
+		FSolveResult Result;
+		const int32_t TipIndex = Pose.NumLinks();
+		std::vector<Eigen::Vector3f>& Positions = Pose.Positions;
+		const std::vector<float>& BoneLengths = Pose.Lengths;
+
+		FScratchScope Scratch(GetThreadScratchArena());
+		Eigen::Vector3f* const OriginalLocation = Scratch.GetArena().AllocateArray<Eigen::Vector3f>(Positions.size());
+		std::copy(Positions.begin(), Positions.end(), OriginalLocation);
+
+		// reachability calculation
+		const Eigen::Vector3f RootLocation = Positions[0];
+		const float RootToTargetDist = (Target - RootLocation).norm();
+
+		// unreachable
+		if (RootToTargetDist > Pose.TotalLength())
+		{
+			for (int32_t Index = 0; Index < TipIndex; ++Index)
+			{
+				const float DistanceToTarget = (Target - Positions[Index]).norm();
+				const float Lambda = BoneLengths[Index] / DistanceToTarget;
+
+				Positions[Index + 1] = (1 - Lambda) * Positions[Index] + Lambda * Target;
+			}
+			Result.Iterations = 1;
+		}
+
+		// reachable
+		else
+		{
+			float Distance = Pose.TipDistance(Target);
+			while (Distance > Settings.Precision && Result.Iterations < Settings.MaxIterations)
+			{
+				++Result.Iterations;
+
+				// forward reaching
+				Positions[TipIndex] = Target;
+				for (int32_t Index = TipIndex - 1; Index >= 0; --Index)
+				{
+					const float JointDistance = (Positions[Index] - Positions[Index + 1]).norm();
+					const float Lambda = BoneLengths[Index] / JointDistance;
+
+					Positions[Index] = (1 - Lambda) * Positions[Index + 1] + Lambda * Positions[Index];
+				}
+
+				// backward reaching
+				Positions[0] = RootLocation;
+				for (int32_t Index = 0; Index < TipIndex; ++Index)
+				{
+					const float JointDistance = (Positions[Index] - Positions[Index + 1]).norm();
+					const float Lambda = BoneLengths[Index] / JointDistance;
+
+					Positions[Index + 1] = (1 - Lambda) * Positions[Index] + Lambda * Positions[Index + 1];
+				}
+
+				Distance = Pose.TipDistance(Target);
+			}
+		}
+
+		// orientation adjustment
+		Pose.AlignRotationsToPositions(OriginalLocation);
+
+		Result.Residual = Pose.TipDistance(Target);
+		Result.bConverged = Result.Residual <= Settings.Precision;
+		return Result;
+	}
+}
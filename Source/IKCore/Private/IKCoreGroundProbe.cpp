@@ -0,0 +1,205 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreGroundProbe.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace IKCore
+{
+	namespace
+	{
+		// bisections of the step in which a probe crosses the heightfield
+		constexpr int32_t NumRefinements = 8;
+	}
+
+	void FHeightfieldGroundQuery::SetHeights(const Eigen::Vector3f& InOrigin, float InCellSize, int32_t InNumX, int32_t InNumY, const std::vector<float>& InHeights)
+	{
+		Origin = InOrigin;
+		CellSize = InCellSize;
+		NumX = InNumX;
+		NumY = InNumY;
+		Heights = InHeights;
+		if (NumX <= 0 || NumY <= 0 || CellSize <= 0.f || Heights.size() != static_cast<size_t>(NumX) * NumY)
+		{
+			NumX = 0;
+			NumY = 0;
+			Heights.clear();
+		}
+	}
+
+	float FHeightfieldGroundQuery::GetSample(int32_t X, int32_t Y) const
+	{
+		X = std::min(std::max(X, 0), NumX - 1);
+		Y = std::min(std::max(Y, 0), NumY - 1);
+		return Heights[static_cast<size_t>(Y) * NumX + X];
+	}
+
+	float FHeightfieldGroundQuery::GetHeight(float X, float Y) const
+	{
+		if (Heights.empty())
+		{
+			return Origin.z();
+		}
+
+		const float CellX = std::min(std::max((X - Origin.x()) / CellSize, 0.f), static_cast<float>(NumX - 1));
+		const float CellY = std::min(std::max((Y - Origin.y()) / CellSize, 0.f), static_cast<float>(NumY - 1));
+		const int32_t X0 = static_cast<int32_t>(CellX);
+		const int32_t Y0 = static_cast<int32_t>(CellY);
+		const float AlphaX = CellX - static_cast<float>(X0);
+		const float AlphaY = CellY - static_cast<float>(Y0);
+
+		const float Bottom = GetSample(X0, Y0) + (GetSample(X0 + 1, Y0) - GetSample(X0, Y0)) * AlphaX;
+		const float Top = GetSample(X0, Y0 + 1) + (GetSample(X0 + 1, Y0 + 1) - GetSample(X0, Y0 + 1)) * AlphaX;
+		return Origin.z() + Bottom + (Top - Bottom) * AlphaY;
+	}
+
+	Eigen::Vector3f FHeightfieldGroundQuery::GetNormal(float X, float Y) const
+	{
+		const float Delta = 0.5f * CellSize;
+		const float SlopeX = (GetHeight(X + Delta, Y) - GetHeight(X - Delta, Y)) / (2.f * Delta);
+		const float SlopeY = (GetHeight(X, Y + Delta) - GetHeight(X, Y - Delta)) / (2.f * Delta);
+		return Eigen::Vector3f(-SlopeX, -SlopeY, 1.f).normalized();
+	}
+
+	FGroundHit FHeightfieldGroundQuery::Trace(const FGroundProbe& Probe) const
+	{
+		FGroundHit Hit;
+		const auto HeightAbove = [this, &Probe](float Alpha)
+		{
+			const Eigen::Vector3f Point = Probe.Start + (Probe.End - Probe.Start) * Alpha;
+			return Point.z() - GetHeight(Point.x(), Point.y());
+		};
+
+		// march in steps of half a cell, the surface cannot fold between two samples that close
+		const float Length = (Probe.End - Probe.Start).norm();
+		const int32_t NumSteps = std::max(1, static_cast<int32_t>(std::ceil(Length / (0.5f * CellSize))));
+		float Alpha = 0.f;
+		if (HeightAbove(0.f) > 0.f)
+		{
+			float LastAlpha = 0.f;
+			int32_t Step = 1;
+			for (; Step <= NumSteps; ++Step)
+			{
+				Alpha = static_cast<float>(Step) / static_cast<float>(NumSteps);
+				if (HeightAbove(Alpha) <= 0.f)
+				{
+					break;
+				}
+				LastAlpha = Alpha;
+			}
+			if (Step > NumSteps)
+			{
+				return Hit;
+			}
+
+			for (int32_t Refinement = 0; Refinement < NumRefinements; ++Refinement)
+			{
+				const float MidAlpha = 0.5f * (LastAlpha + Alpha);
+				if (HeightAbove(MidAlpha) > 0.f)
+				{
+					LastAlpha = MidAlpha;
+				}
+				else
+				{
+					Alpha = MidAlpha;
+				}
+			}
+		}
+
+		Hit.bHit = true;
+		Hit.Location = Probe.Start + (Probe.End - Probe.Start) * Alpha;
+		Hit.Location.z() = GetHeight(Hit.Location.x(), Hit.Location.y());
+		Hit.Normal = GetNormal(Hit.Location.x(), Hit.Location.y());
+		return Hit;
+	}
+
+	void FHeightfieldGroundQuery::Submit(const FGroundProbe* Probes, int32_t NumProbes)
+	{
+		Hits.resize(NumProbes);
+		for (int32_t Index = 0; Index < NumProbes; ++Index)
+		{
+			Hits[Index] = Trace(Probes[Index]);
+		}
+	}
+
+	bool FHeightfieldGroundQuery::Fetch(FGroundHit* OutHits, int32_t NumProbes)
+	{
+		if (NumProbes != static_cast<int32_t>(Hits.size()))
+		{
+			return false;
+		}
+		std::copy(Hits.begin(), Hits.end(), OutHits);
+		return true;
+	}
+
+	int32_t FGroundProbeQueue::Add(const FGroundProbe* Probes, int32_t NumProbes)
+	{
+		const int32_t FirstIndex = static_cast<int32_t>(Queued.size());
+		Queued.insert(Queued.end(), Probes, Probes + NumProbes);
+		return FirstIndex;
+	}
+
+	void FGroundProbeQueue::Submit()
+	{
+		NumSubmitted = Backend != nullptr ? static_cast<int32_t>(Queued.size()) : 0;
+		bCollected = false;
+		if (NumSubmitted > 0)
+		{
+			Backend->Submit(Queued.data(), NumSubmitted);
+		}
+		Queued.clear();
+	}
+
+	bool FGroundProbeQueue::Collect()
+	{
+		if (!bCollected && NumSubmitted > 0)
+		{
+			Hits.resize(NumSubmitted);
+			bCollected = Backend->Fetch(Hits.data(), NumSubmitted);
+		}
+		return bCollected;
+	}
+
+	const FGroundHit* FGroundProbeQueue::GetHits(int32_t FirstIndex, int32_t NumProbes)
+	{
+		if (FirstIndex < 0 || NumProbes <= 0 || FirstIndex + NumProbes > NumSubmitted || !Collect())
+		{
+			return nullptr;
+		}
+		return Hits.data() + FirstIndex;
+	}
+
+	void FFootPlacement::Reset(int32_t InNumFeet)
+	{
+		Offsets.assign(InNumFeet, 0.f);
+	}
+
+	void FFootPlacement::MakeProbes(const Eigen::Vector3f* FootLocations, const Eigen::Vector3f& Up, const FFootPlacementSettings& Settings, const void* IgnoredOwner, FGroundProbe* OutProbes) const
+	{
+		for (int32_t Index = 0; Index < GetNumFeet(); ++Index)
+		{
+			OutProbes[Index].Start = FootLocations[Index] + Up * Settings.ProbeAbove;
+			OutProbes[Index].End = FootLocations[Index] - Up * Settings.ProbeBelow;
+			OutProbes[Index].IgnoredOwner = IgnoredOwner;
+		}
+	}
+
+	void FFootPlacement::Update(const FGroundHit* Hits, const Eigen::Vector3f* FootLocations, const Eigen::Vector3f& Up, const FFootPlacementSettings& Settings, float DeltaSeconds,
+		Eigen::Vector3f* OutTargets)
+	{
+		// exponential smoothing with a half-life, the same easing whatever the frame rate
+		const float Blend = Settings.SmoothingHalfLife > 0.f ? 1.f - std::exp2(-DeltaSeconds / Settings.SmoothingHalfLife) : 1.f;
+		for (int32_t Index = 0; Index < GetNumFeet(); ++Index)
+		{
+			float Offset = 0.f;
+			if (Hits != nullptr && Hits[Index].bHit)
+			{
+				Offset = (Hits[Index].Location - FootLocations[Index]).dot(Up) + Settings.FootHeight;
+				Offset = std::min(std::max(Offset, -Settings.ProbeBelow), Settings.ProbeAbove);
+			}
+			Offsets[Index] += (Offset - Offsets[Index]) * Blend;
+			OutTargets[Index] = FootLocations[Index] + Up * Offsets[Index];
+		}
+	}
+}
@@ -0,0 +1,89 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreJacobian.h"
+#include "IKCoreArena.h"
+#include "IKCoreSolvers.h"
+
+#include <memory>
+
+namespace IKCore
+{
+	namespace
+	{
+		/**
+		 * Dynamic-size workspace of the calling thread for chains of NumLinks links, for solves given none. There is one
+		 * per length, so chains of different lengths solved one after the other do not resize a shared one back and forth.
+		 */
+		template <int NumTaskRows>
+		TJacobianSolver<Eigen::Dynamic, NumTaskRows>& GetThreadWorkspace(int32_t NumLinks)
+		{
+			thread_local std::vector<std::unique_ptr<TJacobianSolver<Eigen::Dynamic, NumTaskRows>>> Workspaces;
+			if (Workspaces.size() <= static_cast<size_t>(NumLinks))
+			{
+				Workspaces.resize(NumLinks + 1);
+				AddScratchHeapAllocations(1);
+			}
+
+			std::unique_ptr<TJacobianSolver<Eigen::Dynamic, NumTaskRows>>& Workspace = Workspaces[NumLinks];
+			if (Workspace == nullptr)
+			{
+				Workspace.reset(new TJacobianSolver<Eigen::Dynamic, NumTaskRows>(NumLinks));
+				AddScratchHeapAllocations(1);
+			}
+			return *Workspace;
+		}
+
+		/** Run SolveFunction on a fixed-size solver for common limb lengths, on Workspace or the thread's one otherwise. */
+		template <int NumTaskRows, typename SolveFunctionType>
+		FSolveResult DispatchByChainLength(int32_t NumLinks, TJacobianSolver<Eigen::Dynamic, NumTaskRows>* Workspace, SolveFunctionType&& SolveFunction)
+		{
+			switch (NumLinks)
+			{
+			case 2: { TJacobianSolver<2, NumTaskRows> Solver; return SolveFunction(Solver); }
+			case 3: { TJacobianSolver<3, NumTaskRows> Solver; return SolveFunction(Solver); }
+			case 4: { TJacobianSolver<4, NumTaskRows> Solver; return SolveFunction(Solver); }
+			case 6: { TJacobianSolver<6, NumTaskRows> Solver; return SolveFunction(Solver); }
+			default: break;
+			}
+
+			if (Workspace != nullptr)
+			{
+				Workspace->Resize(NumLinks);
+				return SolveFunction(*Workspace);
+			}
+			return SolveFunction(GetThreadWorkspace<NumTaskRows>(NumLinks));
+		}
+	}
+
+	FSolveResult SolveJacobianTranspose(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, FJacobianWorkspace* Workspace)
+	{
+		return DispatchByChainLength(Pose.NumLinks(), Workspace, [&](auto& Solver)
+		{
+			return Solver.SolveTranspose(Pose, Target, Settings);
+		});
+	}
+
+	FSolveResult SolveJacobianPinv(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, FJacobianWorkspace* Workspace)
+	{
+		return DispatchByChainLength(Pose.NumLinks(), Workspace, [&](auto& Solver)
+		{
+			return Solver.SolvePinv(Pose, Target, Settings);
+		});
+	}
+
+	FSolveResult SolveDampedLeastSquares(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, FJacobianWorkspace* Workspace)
+	{
+		return DispatchByChainLength(Pose.NumLinks(), Workspace, [&](auto& Solver)
+		{
+			return Solver.SolveDampedLeastSquares(Pose, Target, Settings);
+		});
+	}
+
+	FSolveResult SolveJacobianTransform(ESolver Solver, FPose& Pose, const FTransformTarget& Target, const FSolverSettings& Settings, FTransformJacobianWorkspace* Workspace)
+	{
+		return DispatchByChainLength(Pose.NumLinks(), Workspace, [&](auto& JacobianSolver)
+		{
+			return JacobianSolver.SolveTransform(Solver, Pose, Target, Settings);
+		});
+	}
+}
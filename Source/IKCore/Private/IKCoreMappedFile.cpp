@@ -0,0 +1,110 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreMappedFile.h"
+
+#include <string>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace IKCore
+{
+	FMappedFile::~FMappedFile()
+	{
+		Close();
+	}
+
+	bool FMappedFile::Open(const char* FilePath)
+	{
+		Close();
+
+#ifdef _WIN32
+		// paths are UTF-8, as everywhere in IKCore
+		const int32_t PathLength = MultiByteToWideChar(CP_UTF8, 0, FilePath, -1, nullptr, 0);
+		if (PathLength <= 0)
+		{
+			return false;
+		}
+		std::wstring WidePath(PathLength, L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, FilePath, -1, &WidePath[0], PathLength);
+
+		const HANDLE File = CreateFileW(WidePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (File == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER FileSize;
+		HANDLE Mapping = nullptr;
+		if (GetFileSizeEx(File, &FileSize) && FileSize.QuadPart > 0)
+		{
+			Mapping = CreateFileMappingW(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		}
+		CloseHandle(File);
+		if (Mapping == nullptr)
+		{
+			return false;
+		}
+
+		// the view keeps the mapping alive
+		Data = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(Mapping);
+		if (Data == nullptr)
+		{
+			return false;
+		}
+		Size = static_cast<size_t>(FileSize.QuadPart);
+#else
+		const int Descriptor = open(FilePath, O_RDONLY);
+		if (Descriptor < 0)
+		{
+			return false;
+		}
+
+		struct stat Status;
+		void* MappedData = MAP_FAILED;
+		if (fstat(Descriptor, &Status) == 0 && Status.st_size > 0)
+		{
+			MappedData = mmap(nullptr, static_cast<size_t>(Status.st_size), PROT_READ, MAP_SHARED, Descriptor, 0);
+		}
+
+		// the mapping keeps the file alive
+		close(Descriptor);
+		if (MappedData == MAP_FAILED)
+		{
+			return false;
+		}
+		Data = MappedData;
+		Size = static_cast<size_t>(Status.st_size);
+#endif
+		return true;
+	}
+
+	void FMappedFile::Close()
+	{
+		if (Data == nullptr)
+		{
+			return;
+		}
+
+#ifdef _WIN32
+		UnmapViewOfFile(Data);
+#else
+		munmap(const_cast<void*>(Data), Size);
+#endif
+		Data = nullptr;
+		Size = 0;
+	}
+}
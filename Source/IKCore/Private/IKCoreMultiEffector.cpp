@@ -0,0 +1,423 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreMultiEffector.h"
+#include "IKCoreStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace IKCore
+{
+	namespace
+	{
+		/** Workspace of the calling thread for solves given none, it only allocates when the tree or the effectors grow. */
+		FMultiEffectorWorkspace& GetThreadWorkspace()
+		{
+			thread_local FMultiEffectorWorkspace Workspace;
+			return Workspace;
+		}
+	}
+
+	void FTreePose::UpdateLengths()
+	{
+		Lengths.resize(Positions.size());
+		for (int32_t Index = 0; Index < Num(); ++Index)
+		{
+			Lengths[Index] = Parents[Index] < 0 ? 0.f : (Positions[Index] - Positions[Parents[Index]]).norm();
+		}
+	}
+
+	FSolveResult FMultiEffectorWorkspace::SolveFABRIK(FTreePose& Pose, const std::vector<FEffector>& Effectors, const FSolverSettings& Settings)
+	{
+		FSolveResult Result;
+		if (!Prepare(Pose, Effectors))
+		{
+			return Result;
+		}
+
+		OriginalPositions = Pose.Positions;
+		OriginalRotations = Pose.Rotations;
+		std::fill(DeltaRotations.begin(), DeltaRotations.end(), Eigen::Quaternionf::Identity());
+		const Eigen::Vector3f RootLocation = Pose.Positions[0];
+
+		float Distance = MaxEffectorDistance(Pose, Effectors);
+		while (Distance > Settings.Precision && Result.Iterations < Settings.MaxIterations)
+		{
+			++Result.Iterations;
+
+			// forward reaching: every bone goes to the weighted centroid of its target and of what its branches ask for,
+			// each parent is visited once all of its children were
+			std::fill(PositionSums.begin(), PositionSums.end(), Eigen::Vector3f::Zero());
+			std::fill(WeightSums.begin(), WeightSums.end(), 0.f);
+			for (int32_t EffectorIndex : ActiveEffectors)
+			{
+				const FEffector& Effector = Effectors[EffectorIndex];
+				PositionSums[Effector.BoneIndex] += Effector.Weight * Effector.Target;
+				WeightSums[Effector.BoneIndex] += Effector.Weight;
+			}
+			for (int32_t Index = Pose.Num() - 1; Index > 0; --Index)
+			{
+				if (WeightSums[Index] <= 0.f)
+				{
+					continue;
+				}
+
+				const Eigen::Vector3f Position = PositionSums[Index] / WeightSums[Index];
+				Pose.Positions[Index] = Position;
+
+				const int32_t Parent = Pose.Parents[Index];
+				const Eigen::Vector3f ToParent = Pose.Positions[Parent] - Position;
+				const float JointDistance = ToParent.norm();
+				const Eigen::Vector3f ParentPosition = JointDistance > 0.f ? Position + ToParent * (Pose.Lengths[Index] / JointDistance) : Pose.Positions[Parent];
+				PositionSums[Parent] += BranchWeights[Index] * ParentPosition;
+				WeightSums[Parent] += BranchWeights[Index];
+			}
+
+			// backward reaching: from the fixed root, each bone turns towards its children and carries them along
+			Pose.Positions[0] = RootLocation;
+			for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+			{
+				DeltaRotations[Index] = ComputeBranchRotation(Pose, Index);
+				for (int32_t ChildIndex = ChildStart[Index]; ChildIndex < ChildStart[Index + 1]; ++ChildIndex)
+				{
+					const int32_t Child = Children[ChildIndex];
+					Pose.Positions[Child] = Pose.Positions[Index] + DeltaRotations[Index] * (OriginalPositions[Child] - OriginalPositions[Index]);
+				}
+			}
+
+			Distance = MaxEffectorDistance(Pose, Effectors);
+		}
+
+		if (Result.Iterations > 0)
+		{
+			for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+			{
+				Pose.Rotations[Index] = (DeltaRotations[Index] * OriginalRotations[Index]).normalized();
+			}
+		}
+
+		Result.Residual = Distance;
+		Result.bConverged = Distance <= Settings.Precision;
+		return Result;
+	}
+
+	FSolveResult FMultiEffectorWorkspace::SolveDampedLeastSquares(FTreePose& Pose, const std::vector<FEffector>& Effectors, const FSolverSettings& Settings)
+	{
+		FSolveResult Result;
+		if (!Prepare(Pose, Effectors))
+		{
+			return Result;
+		}
+
+		float Damping = Settings.Damping;
+		float Distance = MaxEffectorDistance(Pose, Effectors);
+		float CurrentError = WeightedError(Pose, Effectors);
+		bool bJacobianValid = false;
+		while (Distance > Settings.Precision && Result.Iterations < Settings.MaxIterations)
+		{
+			++Result.Iterations;
+			if (!bJacobianValid)
+			{
+				BuildJacobian(Pose, Effectors);
+				bJacobianValid = true;
+			}
+			if (!ComputeDampedStep(Damping))
+			{
+				break;
+			}
+
+			if (!Settings.bAdaptiveDamping)
+			{
+				ApplyDeltaRotation(Pose);
+				Distance = MaxEffectorDistance(Pose, Effectors);
+				bJacobianValid = false;
+				continue;
+			}
+
+			SavedPositions = Pose.Positions;
+			SavedRotations = Pose.Rotations;
+			ApplyDeltaRotation(Pose);
+			const float NewError = WeightedError(Pose, Effectors);
+			if (NewError < CurrentError)
+			{
+				CurrentError = NewError;
+				Distance = MaxEffectorDistance(Pose, Effectors);
+				Damping = std::max(Damping * DampingDecrease, Settings.MinDamping);
+				bJacobianValid = false;
+			}
+			else
+			{
+				// the Jacobian is still the one of the restored pose
+				Pose.Positions = SavedPositions;
+				Pose.Rotations = SavedRotations;
+				Damping *= DampingIncrease;
+				if (Damping > Settings.MaxDamping)
+				{
+					break;
+				}
+			}
+		}
+
+		Result.Residual = Distance;
+		Result.bConverged = Distance <= Settings.Precision;
+		return Result;
+	}
+
+	bool FMultiEffectorWorkspace::Prepare(const FTreePose& Pose, const std::vector<FEffector>& Effectors)
+	{
+		const int32_t NumBones = Pose.Num();
+		if (NumBones < 2 || static_cast<int32_t>(Pose.Rotations.size()) != NumBones || static_cast<int32_t>(Pose.Parents.size()) != NumBones
+			|| static_cast<int32_t>(Pose.Lengths.size()) != NumBones || Pose.Parents[0] >= 0)
+		{
+			return false;
+		}
+
+		// children lists in one array, counted per parent first
+		ChildStart.assign(NumBones + 1, 0);
+		for (int32_t Index = 1; Index < NumBones; ++Index)
+		{
+			const int32_t Parent = Pose.Parents[Index];
+			if (Parent < 0 || Parent >= Index)
+			{
+				return false;
+			}
+			++ChildStart[Parent + 1];
+		}
+		for (int32_t Index = 0; Index < NumBones; ++Index)
+		{
+			ChildStart[Index + 1] += ChildStart[Index];
+		}
+		Children.resize(NumBones - 1);
+		for (int32_t Index = 1; Index < NumBones; ++Index)
+		{
+			Children[ChildStart[Pose.Parents[Index]]++] = Index;
+		}
+		for (int32_t Index = NumBones; Index > 0; --Index)
+		{
+			ChildStart[Index] = ChildStart[Index - 1];
+		}
+		ChildStart[0] = 0;
+
+		BranchWeights.assign(NumBones, 0.f);
+		ActiveEffectors.clear();
+		for (int32_t EffectorIndex = 0; EffectorIndex < static_cast<int32_t>(Effectors.size()); ++EffectorIndex)
+		{
+			const FEffector& Effector = Effectors[EffectorIndex];
+			if (Effector.BoneIndex < 0 || Effector.BoneIndex >= NumBones)
+			{
+				return false;
+			}
+			if (Effector.Weight > 0.f)
+			{
+				BranchWeights[Effector.BoneIndex] += Effector.Weight;
+				ActiveEffectors.push_back(EffectorIndex);
+			}
+		}
+		if (ActiveEffectors.empty())
+		{
+			return false;
+		}
+		for (int32_t Index = NumBones - 1; Index > 0; --Index)
+		{
+			BranchWeights[Pose.Parents[Index]] += BranchWeights[Index];
+		}
+
+		PositionSums.resize(NumBones);
+		WeightSums.resize(NumBones);
+		DeltaRotations.resize(NumBones);
+		return true;
+	}
+
+	float FMultiEffectorWorkspace::MaxEffectorDistance(const FTreePose& Pose, const std::vector<FEffector>& Effectors) const
+	{
+		float Distance = 0.f;
+		for (int32_t EffectorIndex : ActiveEffectors)
+		{
+			const FEffector& Effector = Effectors[EffectorIndex];
+			Distance = std::max(Distance, (Pose.Positions[Effector.BoneIndex] - Effector.Target).norm());
+		}
+		return Distance;
+	}
+
+	float FMultiEffectorWorkspace::WeightedError(const FTreePose& Pose, const std::vector<FEffector>& Effectors) const
+	{
+		float SquaredError = 0.f;
+		for (int32_t EffectorIndex : ActiveEffectors)
+		{
+			const FEffector& Effector = Effectors[EffectorIndex];
+			SquaredError += Effector.Weight * (Pose.Positions[Effector.BoneIndex] - Effector.Target).squaredNorm();
+		}
+		return std::sqrt(SquaredError);
+	}
+
+	Eigen::Quaternionf FMultiEffectorWorkspace::ComputeBranchRotation(const FTreePose& Pose, int32_t Index) const
+	{
+		// weighted sum of outer products of the children's offsets at the start of the solve and now
+		Eigen::Matrix3f Covariance = Eigen::Matrix3f::Zero();
+		Eigen::Vector3f OriginalOffset = Eigen::Vector3f::Zero();
+		Eigen::Vector3f NewOffset = Eigen::Vector3f::Zero();
+		int32_t NumBranches = 0;
+		for (int32_t ChildIndex = ChildStart[Index]; ChildIndex < ChildStart[Index + 1]; ++ChildIndex)
+		{
+			const int32_t Child = Children[ChildIndex];
+			if (BranchWeights[Child] <= 0.f)
+			{
+				continue;
+			}
+			OriginalOffset = OriginalPositions[Child] - OriginalPositions[Index];
+			NewOffset = Pose.Positions[Child] - Pose.Positions[Index];
+			Covariance.noalias() += BranchWeights[Child] * OriginalOffset * NewOffset.transpose();
+			++NumBranches;
+		}
+
+		// a leaf, or a bone whose branches are all off the effectors' paths, keeps its rotation relative to its parent
+		if (NumBranches == 0)
+		{
+			return Pose.Parents[Index] < 0 ? Eigen::Quaternionf::Identity() : DeltaRotations[Pose.Parents[Index]];
+		}
+
+		// on a chain this is FPose::AlignRotationsToPositions
+		if (NumBranches == 1)
+		{
+			return Eigen::Quaternionf::FromTwoVectors(OriginalOffset, NewOffset);
+		}
+
+		// a sub-base: the rotation that best fits all of its branches at once, so the branch stays rigid. It is refined
+		// from the last iteration's by a few steps of Mueller et al.'s rotation extraction instead of a 3 x 3 SVD; the
+		// warm start also keeps the twist about nearly parallel branches from flipping between iterations.
+		const Eigen::Matrix3f Target = Covariance.transpose();
+		Eigen::Quaternionf Rotation = DeltaRotations[Index];
+		for (int32_t Step = 0; Step < MaxRotationFitSteps; ++Step)
+		{
+			const Eigen::Matrix3f Current = Rotation.toRotationMatrix();
+			const Eigen::Vector3f Torque = Current.col(0).cross(Target.col(0)) + Current.col(1).cross(Target.col(1)) + Current.col(2).cross(Target.col(2));
+			const float Stiffness = std::abs(Current.col(0).dot(Target.col(0)) + Current.col(1).dot(Target.col(1)) + Current.col(2).dot(Target.col(2)));
+			const Eigen::Vector3f Omega = Torque / (Stiffness + 1e-9f);
+			const float Angle = Omega.norm();
+			if (Angle < 1e-6f)
+			{
+				break;
+			}
+			Rotation = (Eigen::Quaternionf(Eigen::AngleAxisf(Angle, Omega / Angle)) * Rotation).normalized();
+		}
+		return Rotation;
+	}
+
+	void FMultiEffectorWorkspace::BuildJacobian(const FTreePose& Pose, const std::vector<FEffector>& Effectors)
+	{
+		IKCORE_SCOPE_PHASE(JacobianAssembly);
+		const int32_t NumRows = static_cast<int32_t>(ActiveEffectors.size()) * 3;
+		const int32_t NumColumns = Pose.Num() * 3;
+		JacobianMat.setZero(NumRows, NumColumns);
+		Error.resize(NumRows);
+
+		// a bone's axes are shared by every effector below it
+		BoneAxes.resize(Pose.Num());
+		for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+		{
+			BoneAxes[Index] = Pose.Rotations[Index].toRotationMatrix();
+		}
+
+		for (int32_t Row = 0; Row < static_cast<int32_t>(ActiveEffectors.size()); ++Row)
+		{
+			const FEffector& Effector = Effectors[ActiveEffectors[Row]];
+			const float RowWeight = std::sqrt(Effector.Weight);
+			const Eigen::Vector3f& TipLocation = Pose.Positions[Effector.BoneIndex];
+			Error.segment<3>(Row * 3) = RowWeight * (Effector.Target - TipLocation);
+
+			// only the effector's ancestors move it
+			for (int32_t Index = Pose.Parents[Effector.BoneIndex]; Index >= 0; Index = Pose.Parents[Index])
+			{
+				const Eigen::Vector3f ToTip = RowWeight * (TipLocation - Pose.Positions[Index]);
+				for (int Axis = 0; Axis < 3; ++Axis)
+				{
+					JacobianMat.block<3, 1>(Row * 3, Index * 3 + Axis) = BoneAxes[Index].col(Axis).cross(ToTip);
+				}
+			}
+		}
+	}
+
+	bool FMultiEffectorWorkspace::ComputeDampedStep(float Damping)
+	{
+		IKCORE_SCOPE_PHASE(LinearSolve);
+		TaskSquare.noalias() = JacobianMat * JacobianMat.transpose();
+		TaskSquare.diagonal().array() += Damping * Damping;
+
+		TaskSquareLDLT.compute(TaskSquare);
+		if (TaskSquareLDLT.info() != Eigen::Success || !TaskSquareLDLT.isPositive())
+		{
+			return false;
+		}
+		TaskStep = TaskSquareLDLT.solve(Error);
+		if (!TaskStep.allFinite())
+		{
+			return false;
+		}
+		DeltaRotation.noalias() = JacobianMat.transpose() * TaskStep;
+		return true;
+	}
+
+	void FMultiEffectorWorkspace::ApplyDeltaRotation(FTreePose& Pose)
+	{
+		IKCORE_SCOPE_PHASE(PoseUpdate);
+
+		// the tree version of FPose::RotateBones: positions become offsets from their parent first, children before
+		// parents, and are then laid out again from the root with each parent's prefix rotation
+		for (int32_t Index = Pose.Num() - 1; Index > 0; --Index)
+		{
+			Pose.Positions[Index] -= Pose.Positions[Pose.Parents[Index]];
+		}
+		for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+		{
+			const Eigen::Matrix3f& RotAxes = BoneAxes[Index];
+			const Eigen::AngleAxisf DeltaQuatX(DeltaRotation(Index * 3), RotAxes.col(0));
+			const Eigen::AngleAxisf DeltaQuatY(DeltaRotation(Index * 3 + 1), RotAxes.col(1));
+			const Eigen::AngleAxisf DeltaQuatZ(DeltaRotation(Index * 3 + 2), RotAxes.col(2));
+
+			const int32_t Parent = Pose.Parents[Index];
+			if (Parent >= 0)
+			{
+				Pose.Positions[Index] = Pose.Positions[Parent] + DeltaRotations[Parent] * Pose.Positions[Index];
+				DeltaRotations[Index] = DeltaRotations[Parent] * Eigen::Quaternionf(DeltaQuatZ * DeltaQuatY * DeltaQuatX);
+			}
+			else
+			{
+				DeltaRotations[Index] = Eigen::Quaternionf(DeltaQuatZ * DeltaQuatY * DeltaQuatX);
+			}
+			Pose.Rotations[Index] = (DeltaRotations[Index] * Pose.Rotations[Index]).normalized();
+		}
+	}
+
+	FSolveResult SolveMultiEffectorFABRIK(FTreePose& Pose, const std::vector<FEffector>& Effectors, const FSolverSettings& Settings, FMultiEffectorWorkspace* Workspace)
+	{
+		if (Workspace != nullptr)
+		{
+			return Workspace->SolveFABRIK(Pose, Effectors, Settings);
+		}
+		return GetThreadWorkspace().SolveFABRIK(Pose, Effectors, Settings);
+	}
+
+	FSolveResult SolveMultiEffectorDampedLeastSquares(FTreePose& Pose, const std::vector<FEffector>& Effectors, const FSolverSettings& Settings, FMultiEffectorWorkspace* Workspace)
+	{
+		if (Workspace != nullptr)
+		{
+			return Workspace->SolveDampedLeastSquares(Pose, Effectors, Settings);
+		}
+		return GetThreadWorkspace().SolveDampedLeastSquares(Pose, Effectors, Settings);
+	}
+
+	FSolveResult SolveMultiEffector(ESolver Solver, FTreePose& Pose, const std::vector<FEffector>& Effectors, const FSolverSettings& Settings, FMultiEffectorWorkspace* Workspace)
+	{
+		switch (Solver)
+		{
+		case ESolver::JacobianTranspose:
+		case ESolver::JacobianPinv:
+		case ESolver::DampedLeastSquares:
+		case ESolver::Pipeline:
+		case ESolver::Auto:
+			return SolveMultiEffectorDampedLeastSquares(Pose, Effectors, Settings, Workspace);
+		default:
+			return SolveMultiEffectorFABRIK(Pose, Effectors, Settings, Workspace);
+		}
+	}
+}
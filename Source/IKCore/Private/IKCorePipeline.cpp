@@ -0,0 +1,90 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreSolvers.h"
+
+#include <algorithm>
+
+namespace IKCore
+{
+	namespace
+	{
+		// below this many links a FABRIK iteration is so cheap that FABRIK alone wins even close to the target
+		constexpr int32_t HybridMinLinks = 8;
+
+		// FABRIK hands over to damped least squares once the tip is this share of the reach from the target
+		constexpr float HandOffReachRatio = 0.02f;
+
+		// damped least squares steps after FABRIK, and after a previous solve that did not converge
+		constexpr int32_t RefineIterations = 2;
+		constexpr int32_t RecoverIterations = 4;
+
+		// a previous solve that converged within this many iterations means the chain starts near the target again
+		constexpr int32_t CoherentIterations = 2;
+
+		bool IsPipeline(ESolver Solver)
+		{
+			return Solver == ESolver::Pipeline || Solver == ESolver::Auto;
+		}
+	}
+
+	FSolveResult SolvePipeline(const FSolverPipeline& Pipeline, FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, FJacobianWorkspace* Workspace)
+	{
+		FSolveResult Result;
+		Result.Residual = Pose.TipDistance(Target);
+		Result.bConverged = Result.Residual <= Settings.Precision;
+
+		FSolverSettings StageSettings = Settings;
+		const int32_t LastStage = Pipeline.NumStages - 1;
+		for (int32_t StageIndex = 0; StageIndex <= LastStage && !Result.bConverged && Result.Iterations < Settings.MaxIterations; ++StageIndex)
+		{
+			const FSolverStage& Stage = Pipeline.Stages[StageIndex];
+			if (IsPipeline(Stage.Solver))
+			{
+				continue;
+			}
+
+			StageSettings.Precision = StageIndex == LastStage ? Settings.Precision : std::max(Stage.HandOffDistance, Settings.Precision);
+			StageSettings.MaxIterations = std::min(Stage.MaxIterations, Settings.MaxIterations - Result.Iterations);
+			const FSolveResult StageResult = Solve(Stage.Solver, Pose, Target, StageSettings, Workspace);
+
+			Result.Iterations += StageResult.Iterations;
+			Result.Residual = StageResult.Residual;
+			Result.bConverged = StageResult.Residual <= Settings.Precision;
+		}
+		return Result;
+	}
+
+	FSolverPipeline SelectPipeline(const FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, const FSolveResult* LastResult)
+	{
+		FSolverPipeline Pipeline;
+		if (Settings.bAnalyticTwoBone && Pose.NumLinks() == 2 && !Pose.HasJointLimits())
+		{
+			return Pipeline.Add(ESolver::TwoBone, 1);
+		}
+
+		// out of reach the chain ends up straight towards the target, which FABRIK places exactly in one pass
+		const float Reach = Pose.TotalLength();
+		if ((Target - Pose.Positions[0]).norm() >= Reach)
+		{
+			return Pipeline.Add(ESolver::FABRIK, 1);
+		}
+
+		if (Pose.NumLinks() < HybridMinLinks)
+		{
+			return Pipeline.Add(ESolver::FABRIK, Settings.MaxIterations);
+		}
+
+		// damped least squares converges quadratically once close, FABRIK only linearly but from anywhere
+		const float HandOffDistance = std::max(HandOffReachRatio * Reach, Settings.Precision);
+		const bool bCoherent = LastResult != nullptr && LastResult->bConverged && LastResult->Iterations <= CoherentIterations;
+		if (bCoherent || Pose.TipDistance(Target) <= HandOffDistance)
+		{
+			return Pipeline.Add(ESolver::DampedLeastSquares, Settings.MaxIterations);
+		}
+
+		const bool bStruggled = LastResult != nullptr && LastResult->Iterations > 0 && !LastResult->bConverged;
+		return Pipeline
+			.Add(ESolver::FABRIK, Settings.MaxIterations, HandOffDistance)
+			.Add(ESolver::DampedLeastSquares, bStruggled ? RecoverIterations : RefineIterations);
+	}
+}
@@ -0,0 +1,121 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreTypes.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace IKCore
+{
+	FJointLimit::FJointLimit(const Eigen::Quaternionf& InRestRotation, const Eigen::Vector3f& InTwistAxis, float SwingLimit, float InMinTwist, float InMaxTwist)
+		: RestRotation(InRestRotation.normalized())
+		, TwistAxis(InTwistAxis.normalized())
+		, MinTwist(std::min(InMinTwist, InMaxTwist))
+		, MaxTwist(std::max(InMinTwist, InMaxTwist))
+	{
+		constexpr float Pi = 3.14159265f;
+		const float HalfSwing = 0.5f * std::min(std::max(SwingLimit, 0.f), Pi);
+		CosHalfSwing = SwingLimit >= Pi ? -1.f : std::cos(HalfSwing);
+		SinHalfSwing = std::sin(HalfSwing);
+		bLimitTwist = MinTwist > -Pi || MaxTwist < Pi;
+	}
+
+	Eigen::Quaternionf FJointLimit::Clamp(const Eigen::Quaternionf& LocalRotation) const
+	{
+		// the deviation from rest, on the short way round
+		Eigen::Quaternionf Deviation = Eigen::Quaternionf(RestRotation).conjugate() * LocalRotation;
+		Deviation.coeffs() *= Deviation.w() < 0.f ? -1.f : 1.f;
+
+		// twist: the deviation projected on the axis; a half turn swing leaves none, which then counts as no twist
+		const float TwistSin = Deviation.vec().dot(TwistAxis);
+		const float TwistNorm = std::sqrt(TwistSin * TwistSin + Deviation.w() * Deviation.w());
+		Eigen::Quaternionf Twist = Eigen::Quaternionf::Identity();
+		if (TwistNorm > 1e-6f)
+		{
+			Twist = Eigen::Quaternionf(Deviation.w() / TwistNorm, 0.f, 0.f, 0.f);
+			Twist.vec() = TwistAxis * (TwistSin / TwistNorm);
+		}
+		Eigen::Quaternionf Swing = Deviation * Twist.conjugate();
+		Swing.coeffs() *= Swing.w() < 0.f ? -1.f : 1.f;
+
+		if (bLimitTwist)
+		{
+			const float Angle = 2.f * std::atan2(Twist.vec().dot(TwistAxis), Twist.w());
+			const float HalfAngle = 0.5f * std::min(std::max(Angle, MinTwist), MaxTwist);
+			Twist.w() = std::cos(HalfAngle);
+			Twist.vec() = TwistAxis * std::sin(HalfAngle);
+		}
+
+		// past the cone the swing keeps its direction at the cone's half-angle
+		const float SwingSin = Swing.vec().norm();
+		if (Swing.w() < CosHalfSwing && SwingSin > 0.f)
+		{
+			Swing.w() = CosHalfSwing;
+			Swing.vec() *= SinHalfSwing / SwingSin;
+		}
+		return Eigen::Quaternionf(RestRotation) * Swing * Twist;
+	}
+
+	float FPose::TotalLength() const
+	{
+		float Sum = 0.f;
+		for (float Length : Lengths)
+		{
+			Sum += Length;
+		}
+		return Sum;
+	}
+
+	Eigen::Vector3f FPose::TipRotationError(const Eigen::Quaternionf& TargetRotation) const
+	{
+		Eigen::Quaternionf DeltaRotation = TargetRotation * Rotations.back().conjugate();
+		if (DeltaRotation.w() < 0.f)
+		{
+			DeltaRotation.coeffs() = -DeltaRotation.coeffs();
+		}
+
+		// angle * axis from the vector part, atan2 keeps small angles accurate
+		const float SinHalfAngle = DeltaRotation.vec().norm();
+		if (SinHalfAngle <= 0.f)
+		{
+			return Eigen::Vector3f::Zero();
+		}
+		const float Angle = 2.f * std::atan2(SinHalfAngle, DeltaRotation.w());
+		return DeltaRotation.vec() * (Angle / SinHalfAngle);
+	}
+
+	void FPose::UpdateLengths()
+	{
+		Lengths.resize(Positions.empty() ? 0 : Positions.size() - 1);
+		for (int32_t Index = 0; Index < NumLinks(); ++Index)
+		{
+			Lengths[Index] = (Positions[Index + 1] - Positions[Index]).norm();
+		}
+	}
+
+	void FPose::RotateBone(int32_t Index, const Eigen::Quaternionf& DeltaRotation)
+	{
+		const Eigen::Vector3f Pivot = Positions[Index];
+		for (int32_t ChildIndex = Index; ChildIndex < Num(); ++ChildIndex)
+		{
+			Positions[ChildIndex] = Pivot + DeltaRotation * (Positions[ChildIndex] - Pivot);
+			Rotations[ChildIndex] = (DeltaRotation * Rotations[ChildIndex]).normalized();
+		}
+	}
+
+	void FPose::AlignRotationsToPositions(const Eigen::Vector3f* OriginalPositions)
+	{
+		const int32_t TipIndex = NumLinks();
+		const Eigen::Quaternionf TipLocalRotation = Rotations[TipIndex - 1].conjugate() * Rotations[TipIndex];
+
+		for (int32_t Index = 0; Index < TipIndex; ++Index)
+		{
+			const Eigen::Vector3f OriginalOrientation = OriginalPositions[Index + 1] - OriginalPositions[Index];
+			const Eigen::Vector3f NewOrientation = Positions[Index + 1] - Positions[Index];
+
+			const Eigen::Quaternionf DeltaRotation = Eigen::Quaternionf::FromTwoVectors(OriginalOrientation, NewOrientation);
+			Rotations[Index] = (DeltaRotation * Rotations[Index]).normalized();
+		}
+		Rotations[TipIndex] = Rotations[TipIndex - 1] * TipLocalRotation;
+	}
+}
@@ -0,0 +1,445 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCorePoseDatabase.h"
+#include "IKCoreSolvers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace IKCore
+{
+	namespace
+	{
+		struct FHeader
+		{
+			char Magic[4];
+			uint32_t Version;
+			int32_t NumBones;
+			int32_t NumSamples;
+			int32_t CellsPerAxis;
+			float GridExtent;
+			uint32_t Reserved[2];
+		};
+		static_assert(sizeof(FHeader) == 32, "The header is part of the file format");
+
+		constexpr char Magic[4] = { 'I', 'K', 'P', 'D' };
+		constexpr float QuaternionScale = 32767.f;
+
+		// a grid this fine would hold more cells than any chain has samples
+		constexpr int32_t MaxCellsPerAxis = 256;
+
+		struct FLayout
+		{
+			size_t TargetsOffset = 0;
+			size_t RotationsOffset = 0;
+			size_t CellStartsOffset = 0;
+			size_t Size = 0;
+		};
+
+		size_t Align8(size_t Offset)
+		{
+			return (Offset + 7) & ~size_t(7);
+		}
+
+		FLayout GetLayout(int32_t NumBones, int32_t NumSamples, int32_t CellsPerAxis)
+		{
+			const size_t NumCells = static_cast<size_t>(CellsPerAxis) * CellsPerAxis * CellsPerAxis;
+
+			FLayout Layout;
+			Layout.TargetsOffset = sizeof(FHeader);
+			Layout.RotationsOffset = Align8(Layout.TargetsOffset + sizeof(float) * 3 * NumSamples);
+			Layout.CellStartsOffset = Align8(Layout.RotationsOffset + sizeof(int16_t) * 4 * NumBones * NumSamples);
+			Layout.Size = Align8(Layout.CellStartsOffset + sizeof(uint32_t) * (NumCells + 1));
+			return Layout;
+		}
+
+		int32_t GetCellCoordinate(float LocalCoordinate, float GridExtent, float CellSize, int32_t CellsPerAxis)
+		{
+			// targets outside the grid fall into its border cells
+			const int32_t Coordinate = static_cast<int32_t>(std::floor((LocalCoordinate + GridExtent) / CellSize));
+			return std::min(std::max(Coordinate, 0), CellsPerAxis - 1);
+		}
+	}
+
+	bool FPoseDatabase::Bake(const FPose& RestPose, ESolver Solver, const FSolverSettings& Settings, const FPoseDatabaseBakeSettings& BakeSettings)
+	{
+		Reset();
+		if (RestPose.NumLinks() < 1 || BakeSettings.NumSamples <= 0)
+		{
+			return false;
+		}
+
+		const int32_t InNumBones = RestPose.Num();
+		const int32_t InCellsPerAxis = std::min(std::max(BakeSettings.CellsPerAxis, 1), MaxCellsPerAxis);
+		const float Reach = RestPose.TotalLength();
+		const float InGridExtent = std::max(BakeSettings.MaxReachRatio * Reach, 1e-3f);
+		const float InCellSize = 2.f * InGridExtent / static_cast<float>(InCellsPerAxis);
+		const Eigen::Vector3f Root = RestPose.Positions[0];
+
+		// the cube of the radius is uniform for points spread evenly over the volume of the shell
+		std::mt19937 Random(BakeSettings.Seed);
+		std::normal_distribution<float> Normal;
+		std::uniform_real_distribution<float> RadiusCube(std::pow(BakeSettings.MinReachRatio, 3.f), std::pow(BakeSettings.MaxReachRatio, 3.f));
+
+		std::vector<Eigen::Vector3f> SampleTargets;
+		TAlignedArray<Eigen::Quaternionf> SampleRotations;
+		std::vector<uint32_t> SampleCells;
+		SampleTargets.reserve(BakeSettings.NumSamples);
+		SampleRotations.reserve(static_cast<size_t>(BakeSettings.NumSamples) * InNumBones);
+		SampleCells.reserve(BakeSettings.NumSamples);
+
+		FPose Pose;
+		FJacobianWorkspace Workspace(RestPose.NumLinks());
+		for (int32_t Sample = 0; Sample < BakeSettings.NumSamples; ++Sample)
+		{
+			const Eigen::Vector3f Direction = Eigen::Vector3f(Normal(Random), Normal(Random), Normal(Random)).normalized();
+			const Eigen::Vector3f LocalTarget = Direction * (Reach * std::cbrt(RadiusCube(Random)));
+
+			// every sample starts from the rest pose, so neighbouring targets get neighbouring solutions to blend
+			Pose = RestPose;
+			if (!IKCore::Solve(Solver, Pose, Root + LocalTarget, Settings, &Workspace).bConverged)
+			{
+				continue;
+			}
+
+			SampleTargets.push_back(LocalTarget);
+			SampleRotations.insert(SampleRotations.end(), Pose.Rotations.begin(), Pose.Rotations.end());
+
+			int32_t Cell[3];
+			for (int32_t Axis = 0; Axis < 3; ++Axis)
+			{
+				Cell[Axis] = GetCellCoordinate(LocalTarget[Axis], InGridExtent, InCellSize, InCellsPerAxis);
+			}
+			SampleCells.push_back(static_cast<uint32_t>((Cell[2] * InCellsPerAxis + Cell[1]) * InCellsPerAxis + Cell[0]));
+		}
+
+		const int32_t InNumSamples = static_cast<int32_t>(SampleTargets.size());
+		if (InNumSamples == 0)
+		{
+			return false;
+		}
+
+		const FLayout Layout = GetLayout(InNumBones, InNumSamples, InCellsPerAxis);
+		OwnedImage.assign(Layout.Size / sizeof(uint64_t), 0);
+		char* Data = reinterpret_cast<char*>(OwnedImage.data());
+
+		FHeader Header = {};
+		std::memcpy(Header.Magic, Magic, sizeof(Magic));
+		Header.Version = Version;
+		Header.NumBones = InNumBones;
+		Header.NumSamples = InNumSamples;
+		Header.CellsPerAxis = InCellsPerAxis;
+		Header.GridExtent = InGridExtent;
+		std::memcpy(Data, &Header, sizeof(Header));
+
+		// counting sort by cell, so a cell's samples are one range
+		const size_t NumCells = static_cast<size_t>(InCellsPerAxis) * InCellsPerAxis * InCellsPerAxis;
+		uint32_t* OutCellStarts = reinterpret_cast<uint32_t*>(Data + Layout.CellStartsOffset);
+		for (const uint32_t Cell : SampleCells)
+		{
+			++OutCellStarts[Cell + 1];
+		}
+		for (size_t Cell = 0; Cell < NumCells; ++Cell)
+		{
+			OutCellStarts[Cell + 1] += OutCellStarts[Cell];
+		}
+
+		std::vector<uint32_t> NextInCell(OutCellStarts, OutCellStarts + NumCells);
+		float* OutTargets = reinterpret_cast<float*>(Data + Layout.TargetsOffset);
+		int16_t* OutRotations = reinterpret_cast<int16_t*>(Data + Layout.RotationsOffset);
+		for (int32_t Sample = 0; Sample < InNumSamples; ++Sample)
+		{
+			const uint32_t Slot = NextInCell[SampleCells[Sample]]++;
+			std::memcpy(OutTargets + 3 * Slot, SampleTargets[Sample].data(), sizeof(float) * 3);
+			for (int32_t Bone = 0; Bone < InNumBones; ++Bone)
+			{
+				const Eigen::Vector4f Coefficients = SampleRotations[static_cast<size_t>(Sample) * InNumBones + Bone].normalized().coeffs();
+				int16_t* OutRotation = OutRotations + 4 * (static_cast<size_t>(Slot) * InNumBones + Bone);
+				for (int32_t Component = 0; Component < 4; ++Component)
+				{
+					OutRotation[Component] = static_cast<int16_t>(std::lround(Coefficients[Component] * QuaternionScale));
+				}
+			}
+		}
+
+		return SetImage(OwnedImage.data(), Layout.Size);
+	}
+
+	bool FPoseDatabase::Save(const char* FilePath) const
+	{
+		if (!IsValid())
+		{
+			return false;
+		}
+
+		std::FILE* File = std::fopen(FilePath, "wb");
+		if (File == nullptr)
+		{
+			return false;
+		}
+		const bool bWritten = std::fwrite(Image, 1, ImageSize, File) == ImageSize;
+		return std::fclose(File) == 0 && bWritten;
+	}
+
+	bool FPoseDatabase::Load(const char* FilePath)
+	{
+		Reset();
+		std::FILE* File = std::fopen(FilePath, "rb");
+		if (File == nullptr)
+		{
+			return false;
+		}
+
+		std::fseek(File, 0, SEEK_END);
+		const long Size = std::ftell(File);
+		std::fseek(File, 0, SEEK_SET);
+		bool bRead = Size > 0;
+		if (bRead)
+		{
+			OwnedImage.resize((static_cast<size_t>(Size) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+			bRead = std::fread(OwnedImage.data(), 1, static_cast<size_t>(Size), File) == static_cast<size_t>(Size);
+		}
+		std::fclose(File);
+
+		if (!bRead || !SetImage(OwnedImage.data(), static_cast<size_t>(Size)))
+		{
+			Reset();
+			return false;
+		}
+		return true;
+	}
+
+	bool FPoseDatabase::Map(const char* FilePath)
+	{
+		Reset();
+		if (!MappedFile.Open(FilePath) || !SetImage(MappedFile.GetData(), MappedFile.GetSize()))
+		{
+			Reset();
+			return false;
+		}
+		return true;
+	}
+
+	bool FPoseDatabase::SetImage(const void* Data, size_t Size)
+	{
+		ClearView();
+		if (Data != OwnedImage.data())
+		{
+			OwnedImage.clear();
+		}
+		if (Data != MappedFile.GetData())
+		{
+			MappedFile.Close();
+		}
+
+		FHeader Header;
+		if (Data == nullptr || reinterpret_cast<uintptr_t>(Data) % 8 != 0 || Size < sizeof(Header))
+		{
+			return false;
+		}
+		std::memcpy(&Header, Data, sizeof(Header));
+		if (std::memcmp(Header.Magic, Magic, sizeof(Magic)) != 0 || Header.Version != Version || Header.NumBones < 2 || Header.NumSamples <= 0
+			|| Header.CellsPerAxis < 1 || Header.CellsPerAxis > MaxCellsPerAxis || !(Header.GridExtent > 0.f))
+		{
+			return false;
+		}
+
+		const FLayout Layout = GetLayout(Header.NumBones, Header.NumSamples, Header.CellsPerAxis);
+		if (Layout.Size != Size)
+		{
+			return false;
+		}
+
+		// a range past the samples would send FindNearest out of the image
+		const char* Bytes = static_cast<const char*>(Data);
+		const uint32_t* InCellStarts = reinterpret_cast<const uint32_t*>(Bytes + Layout.CellStartsOffset);
+		const size_t NumCells = static_cast<size_t>(Header.CellsPerAxis) * Header.CellsPerAxis * Header.CellsPerAxis;
+		if (InCellStarts[0] != 0 || InCellStarts[NumCells] != static_cast<uint32_t>(Header.NumSamples))
+		{
+			return false;
+		}
+		for (size_t Cell = 0; Cell < NumCells; ++Cell)
+		{
+			if (InCellStarts[Cell] > InCellStarts[Cell + 1])
+			{
+				return false;
+			}
+		}
+
+		Image = Data;
+		ImageSize = Size;
+		NumBones = Header.NumBones;
+		NumSamples = Header.NumSamples;
+		CellsPerAxis = Header.CellsPerAxis;
+		GridExtent = Header.GridExtent;
+		CellSize = 2.f * GridExtent / static_cast<float>(CellsPerAxis);
+		Targets = reinterpret_cast<const float*>(Bytes + Layout.TargetsOffset);
+		Rotations = reinterpret_cast<const int16_t*>(Bytes + Layout.RotationsOffset);
+		CellStarts = InCellStarts;
+		return true;
+	}
+
+	void FPoseDatabase::Reset()
+	{
+		OwnedImage.clear();
+		MappedFile.Close();
+		ClearView();
+	}
+
+	void FPoseDatabase::ClearView()
+	{
+		Image = nullptr;
+		ImageSize = 0;
+		NumBones = 0;
+		NumSamples = 0;
+		CellsPerAxis = 0;
+		GridExtent = 0.f;
+		CellSize = 0.f;
+		Targets = nullptr;
+		Rotations = nullptr;
+		CellStarts = nullptr;
+	}
+
+	int32_t FPoseDatabase::FindNearest(const Eigen::Vector3f& LocalTarget, int32_t Count, int32_t* OutSamples, float* OutDistances) const
+	{
+		if (!IsValid() || Count <= 0)
+		{
+			return 0;
+		}
+
+		int32_t Center[3];
+		for (int32_t Axis = 0; Axis < 3; ++Axis)
+		{
+			Center[Axis] = GetCellCoordinate(LocalTarget[Axis], GridExtent, CellSize, CellsPerAxis);
+		}
+
+		// grow a shell of cells around the target's cell until nothing outside the cells visited can be closer than the
+		// samples found, the grid's border not counting as a way out; squared distances until the end
+		int32_t NumFound = 0;
+		for (int32_t Ring = 0; Ring < CellsPerAxis; ++Ring)
+		{
+			if (NumFound == Count)
+			{
+				float ExitDistance = std::numeric_limits<float>::max();
+				for (int32_t Axis = 0; Axis < 3; ++Axis)
+				{
+					const int32_t Low = Center[Axis] - Ring + 1;
+					const int32_t High = Center[Axis] + Ring;
+					if (Low > 0)
+					{
+						ExitDistance = std::min(ExitDistance, LocalTarget[Axis] + GridExtent - static_cast<float>(Low) * CellSize);
+					}
+					if (High < CellsPerAxis)
+					{
+						ExitDistance = std::min(ExitDistance, static_cast<float>(High) * CellSize - GridExtent - LocalTarget[Axis]);
+					}
+				}
+				if (OutDistances[NumFound - 1] <= ExitDistance * ExitDistance)
+				{
+					break;
+				}
+			}
+
+			for (int32_t Z = std::max(Center[2] - Ring, 0); Z <= std::min(Center[2] + Ring, CellsPerAxis - 1); ++Z)
+			{
+				for (int32_t Y = std::max(Center[1] - Ring, 0); Y <= std::min(Center[1] + Ring, CellsPerAxis - 1); ++Y)
+				{
+					// inside the shell only the two cells on the X faces belong to this ring
+					const bool bOnShell = std::abs(Z - Center[2]) == Ring || std::abs(Y - Center[1]) == Ring;
+					const int32_t StepX = bOnShell ? 1 : 2 * Ring;
+					for (int32_t X = Center[0] - Ring; X <= Center[0] + Ring; X += StepX)
+					{
+						if (X < 0 || X >= CellsPerAxis)
+						{
+							continue;
+						}
+
+						const int32_t Cell = (Z * CellsPerAxis + Y) * CellsPerAxis + X;
+						for (uint32_t Sample = CellStarts[Cell]; Sample < CellStarts[Cell + 1]; ++Sample)
+						{
+							const Eigen::Map<const Eigen::Vector3f> SampleTarget(Targets + 3 * Sample);
+							const float Distance = (SampleTarget - LocalTarget).squaredNorm();
+							if (NumFound == Count && Distance >= OutDistances[NumFound - 1])
+							{
+								continue;
+							}
+
+							int32_t Slot = NumFound < Count ? NumFound++ : NumFound - 1;
+							for (; Slot > 0 && OutDistances[Slot - 1] > Distance; --Slot)
+							{
+								OutSamples[Slot] = OutSamples[Slot - 1];
+								OutDistances[Slot] = OutDistances[Slot - 1];
+							}
+							OutSamples[Slot] = static_cast<int32_t>(Sample);
+							OutDistances[Slot] = Distance;
+						}
+					}
+				}
+			}
+		}
+
+		for (int32_t Found = 0; Found < NumFound; ++Found)
+		{
+			OutDistances[Found] = std::sqrt(OutDistances[Found]);
+		}
+		return NumFound;
+	}
+
+	bool FPoseDatabase::SeedPose(FPose& Pose, const Eigen::Vector3f& Target, const Eigen::Quaternionf& RootParentRotation, int32_t NumNeighbours) const
+	{
+		if (!IsValid() || Pose.Num() != NumBones)
+		{
+			return false;
+		}
+
+		int32_t Samples[MaxNeighbours];
+		float Distances[MaxNeighbours];
+		const Eigen::Vector3f LocalTarget = RootParentRotation.conjugate() * (Target - Pose.Positions[0]);
+		const int32_t NumFound = FindNearest(LocalTarget, std::min(std::max(NumNeighbours, 1), MaxNeighbours), Samples, Distances);
+		if (NumFound == 0 || Distances[0] >= Pose.TipDistance(Target))
+		{
+			return false;
+		}
+
+		// inverse distance weights, a sample right on the target all but takes over
+		float Weights[MaxNeighbours];
+		for (int32_t Neighbour = 0; Neighbour < NumFound; ++Neighbour)
+		{
+			Weights[Neighbour] = 1.f / std::max(Distances[Neighbour], 1e-4f * CellSize);
+		}
+
+		// each link keeps its offset in its bone's frame and is turned to the blended rotation
+		Eigen::Vector3f OldPosition = Pose.Positions[0];
+		for (int32_t Bone = 0; Bone < NumBones; ++Bone)
+		{
+			const Eigen::Quaternionf Nearest = GetRotation(Samples[0], Bone);
+			Eigen::Vector4f Sum = Weights[0] * Nearest.coeffs();
+			for (int32_t Neighbour = 1; Neighbour < NumFound; ++Neighbour)
+			{
+				const Eigen::Quaternionf Rotation = GetRotation(Samples[Neighbour], Bone);
+				Sum += (Rotation.dot(Nearest) < 0.f ? -Weights[Neighbour] : Weights[Neighbour]) * Rotation.coeffs();
+			}
+			const Eigen::Quaternionf Rotation = (RootParentRotation * Eigen::Quaternionf(Sum.w(), Sum.x(), Sum.y(), Sum.z()).normalized()).normalized();
+
+			if (Bone < Pose.NumLinks())
+			{
+				const Eigen::Vector3f OldChildPosition = Pose.Positions[Bone + 1];
+				const Eigen::Vector3f Link = Pose.Rotations[Bone].conjugate() * (OldChildPosition - OldPosition);
+				Pose.Positions[Bone + 1] = Pose.Positions[Bone] + Rotation * Link;
+				OldPosition = OldChildPosition;
+			}
+			Pose.Rotations[Bone] = Rotation;
+		}
+		return true;
+	}
+
+	Eigen::Quaternionf FPoseDatabase::GetRotation(int32_t Sample, int32_t Bone) const
+	{
+		const int16_t* Rotation = Rotations + 4 * (static_cast<size_t>(Sample) * NumBones + Bone);
+		return Eigen::Quaternionf(Rotation[3], Rotation[0], Rotation[1], Rotation[2]).normalized();
+	}
+}
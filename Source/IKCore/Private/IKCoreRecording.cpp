@@ -0,0 +1,348 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreRecording.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace IKCore
+{
+	namespace
+	{
+		constexpr char Magic[4] = { 'I', 'K', 'R', 'C' };
+
+		// what the reader asks the file for at once, a capture is read in slices of this size whatever its length
+		constexpr size_t ReadBufferSize = 1 << 20;
+
+		// chain ids are dense, far more chains than any session has means the chunk is garbage
+		constexpr uint32_t MaxChains = 1 << 20;
+
+		// the engine only targets little endian platforms, so the fields are copied as they are in memory
+		template <typename T>
+		void Append(std::vector<char>& Buffer, const T& Value)
+		{
+			const char* Bytes = reinterpret_cast<const char*>(&Value);
+			Buffer.insert(Buffer.end(), Bytes, Bytes + sizeof(T));
+		}
+
+		void AppendVector(std::vector<char>& Buffer, const Eigen::Vector3f& Vector)
+		{
+			Append(Buffer, Vector.x());
+			Append(Buffer, Vector.y());
+			Append(Buffer, Vector.z());
+		}
+
+		void AppendQuaternion(std::vector<char>& Buffer, const Eigen::Quaternionf& Quaternion)
+		{
+			Append(Buffer, Quaternion.x());
+			Append(Buffer, Quaternion.y());
+			Append(Buffer, Quaternion.z());
+			Append(Buffer, Quaternion.w());
+		}
+	}
+
+	void FRecordedChain::GetPose(const Eigen::Vector3f& RootParentTranslation, const Eigen::Quaternionf& RootParentRotation, FPose& OutPose) const
+	{
+		OutPose.Positions.resize(Positions.size());
+		OutPose.Rotations.resize(Rotations.size());
+		for (size_t Index = 0; Index < Positions.size(); ++Index)
+		{
+			OutPose.Positions[Index] = RootParentTranslation + RootParentRotation * Positions[Index];
+			OutPose.Rotations[Index] = (RootParentRotation * Rotations[Index]).normalized();
+		}
+		OutPose.UpdateLengths();
+	}
+
+	FRecordingWriter::~FRecordingWriter()
+	{
+		Close();
+	}
+
+	bool FRecordingWriter::Open(const char* FilePath)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (File != nullptr)
+		{
+			FlushLocked();
+			std::fclose(File);
+		}
+
+		File = std::fopen(FilePath, "wb");
+		if (File == nullptr)
+		{
+			return false;
+		}
+
+		ChainIds.clear();
+		Chains.clear();
+		NumWrittenChains = 0;
+		PendingFrames.clear();
+		std::fwrite(Magic, 1, sizeof(Magic), File);
+		const uint32_t FileVersion = Version;
+		std::fwrite(&FileVersion, sizeof(FileVersion), 1, File);
+		return true;
+	}
+
+	void FRecordingWriter::Close()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (File != nullptr)
+		{
+			FlushLocked();
+			std::fclose(File);
+			File = nullptr;
+		}
+	}
+
+	bool FRecordingWriter::IsOpen() const
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return File != nullptr;
+	}
+
+	uint32_t FRecordingWriter::RegisterChain(const std::string& Name, const FPose& Pose, const Eigen::Vector3f& RootParentTranslation, const Eigen::Quaternionf& RootParentRotation,
+		const FSolverSettings& Settings)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return RegisterChainLocked(Name, Pose, RootParentTranslation, RootParentRotation, Settings);
+	}
+
+	uint32_t FRecordingWriter::RegisterChainLocked(const std::string& Name, const FPose& Pose, const Eigen::Vector3f& RootParentTranslation,
+		const Eigen::Quaternionf& RootParentRotation, const FSolverSettings& Settings)
+	{
+		const auto Found = ChainIds.find(Name);
+		if (Found != ChainIds.end())
+		{
+			return Found->second;
+		}
+
+		FRecordedChain Chain;
+		Chain.Id = static_cast<uint32_t>(Chains.size());
+		Chain.Name = Name;
+		Chain.Precision = Settings.Precision;
+		Chain.MaxIterations = Settings.MaxIterations;
+		const Eigen::Quaternionf InverseRotation = RootParentRotation.conjugate();
+		const int32_t NumBones = std::min(Pose.Num(), static_cast<int32_t>(UINT16_MAX));
+		Chain.Positions.resize(NumBones);
+		Chain.Rotations.resize(NumBones);
+		for (int32_t Index = 0; Index < NumBones; ++Index)
+		{
+			Chain.Positions[Index] = InverseRotation * (Pose.Positions[Index] - RootParentTranslation);
+			Chain.Rotations[Index] = (InverseRotation * Pose.Rotations[Index]).normalized();
+		}
+
+		ChainIds.emplace(Name, Chain.Id);
+		Chains.push_back(std::move(Chain));
+		return Chains.back().Id;
+	}
+
+	void FRecordingWriter::Write(const FRecordedFrame& Frame)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (File != nullptr)
+		{
+			PendingFrames.push_back(Frame);
+		}
+	}
+
+	void FRecordingWriter::Write(const FRecordedFrame& Frame, const std::string& Name, const FPose& Pose, const FSolverSettings& Settings)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (File != nullptr)
+		{
+			PendingFrames.push_back(Frame);
+			PendingFrames.back().ChainId = RegisterChainLocked(Name, Pose, Frame.RootParentTranslation, Frame.RootParentRotation, Settings);
+		}
+	}
+
+	void FRecordingWriter::Flush()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (File != nullptr)
+		{
+			FlushLocked();
+			std::fflush(File);
+		}
+	}
+
+	void FRecordingWriter::FlushLocked()
+	{
+		Buffer.clear();
+		for (; NumWrittenChains < Chains.size(); ++NumWrittenChains)
+		{
+			const FRecordedChain& Chain = Chains[NumWrittenChains];
+			const uint16_t NameLength = static_cast<uint16_t>(std::min<size_t>(Chain.Name.size(), UINT16_MAX));
+			Buffer.push_back('C');
+			Append(Buffer, Chain.Id);
+			Append(Buffer, NameLength);
+			Buffer.insert(Buffer.end(), Chain.Name.begin(), Chain.Name.begin() + NameLength);
+			Append(Buffer, Chain.Precision);
+			Append(Buffer, Chain.MaxIterations);
+			Append(Buffer, static_cast<uint16_t>(Chain.Num()));
+			for (int32_t Index = 0; Index < Chain.Num(); ++Index)
+			{
+				AppendVector(Buffer, Chain.Positions[Index]);
+				AppendQuaternion(Buffer, Chain.Rotations[Index]);
+			}
+		}
+
+		for (const FRecordedFrame& Frame : PendingFrames)
+		{
+			Buffer.push_back('F');
+			Append(Buffer, Frame.Frame);
+			Append(Buffer, Frame.ChainId);
+			AppendVector(Buffer, Frame.RootParentTranslation);
+			AppendQuaternion(Buffer, Frame.RootParentRotation);
+			AppendVector(Buffer, Frame.Target);
+		}
+
+		std::fwrite(Buffer.data(), 1, Buffer.size(), File);
+		PendingFrames.clear();
+	}
+
+	FRecordingReader::~FRecordingReader()
+	{
+		Close();
+	}
+
+	bool FRecordingReader::Open(const char* FilePath)
+	{
+		Close();
+		File = std::fopen(FilePath, "rb");
+		if (File == nullptr)
+		{
+			return false;
+		}
+
+		Buffer.resize(ReadBufferSize);
+		char FileMagic[4];
+		uint32_t FileVersion = 0;
+		if (!ReadBytes(FileMagic, sizeof(FileMagic)) || std::memcmp(FileMagic, Magic, sizeof(Magic)) != 0 || !ReadValue(FileVersion) || FileVersion != FRecordingWriter::Version)
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void FRecordingReader::Close()
+	{
+		if (File != nullptr)
+		{
+			std::fclose(File);
+			File = nullptr;
+		}
+		BufferOffset = 0;
+		BufferSize = 0;
+		Chains.clear();
+		NumFramesRead = 0;
+		NumBytesRead = 0;
+		bError = false;
+	}
+
+	bool FRecordingReader::Read(FRecordedFrame& OutFrame)
+	{
+		if (File == nullptr || bError)
+		{
+			return false;
+		}
+
+		for (;;)
+		{
+			char Tag = 0;
+			if (!ReadValue(Tag))
+			{
+				// running out of bytes between two chunks is the end of the session
+				return false;
+			}
+
+			if (Tag == 'C')
+			{
+				if (!ReadChain())
+				{
+					bError = true;
+					return false;
+				}
+				continue;
+			}
+
+			float Values[10];
+			if (Tag != 'F' || !ReadValue(OutFrame.Frame) || !ReadValue(OutFrame.ChainId) || !ReadBytes(Values, sizeof(Values)) || FindChain(OutFrame.ChainId) == nullptr)
+			{
+				bError = true;
+				return false;
+			}
+			OutFrame.RootParentTranslation = Eigen::Vector3f(Values[0], Values[1], Values[2]);
+			OutFrame.RootParentRotation = Eigen::Quaternionf(Values[6], Values[3], Values[4], Values[5]).normalized();
+			OutFrame.Target = Eigen::Vector3f(Values[7], Values[8], Values[9]);
+			++NumFramesRead;
+			return true;
+		}
+	}
+
+	const FRecordedChain* FRecordingReader::FindChain(uint32_t Id) const
+	{
+		return Id < Chains.size() && Chains[Id].Num() > 0 ? &Chains[Id] : nullptr;
+	}
+
+	bool FRecordingReader::ReadBytes(void* Data, size_t Size)
+	{
+		char* Destination = static_cast<char*>(Data);
+		while (Size > 0)
+		{
+			if (BufferOffset == BufferSize)
+			{
+				BufferSize = std::fread(Buffer.data(), 1, Buffer.size(), File);
+				BufferOffset = 0;
+				if (BufferSize == 0)
+				{
+					return false;
+				}
+			}
+
+			const size_t NumBytes = std::min(Size, BufferSize - BufferOffset);
+			std::memcpy(Destination, Buffer.data() + BufferOffset, NumBytes);
+			BufferOffset += NumBytes;
+			NumBytesRead += NumBytes;
+			Destination += NumBytes;
+			Size -= NumBytes;
+		}
+		return true;
+	}
+
+	bool FRecordingReader::ReadChain()
+	{
+		FRecordedChain Chain;
+		uint16_t NameLength = 0;
+		if (!ReadValue(Chain.Id) || Chain.Id >= MaxChains || !ReadValue(NameLength))
+		{
+			return false;
+		}
+		Chain.Name.resize(NameLength);
+		uint16_t NumBones = 0;
+		if (!ReadBytes(&Chain.Name[0], NameLength) || !ReadValue(Chain.Precision) || !ReadValue(Chain.MaxIterations) || !ReadValue(NumBones) || NumBones == 0)
+		{
+			return false;
+		}
+
+		Chain.Positions.resize(NumBones);
+		Chain.Rotations.resize(NumBones);
+		for (uint16_t Index = 0; Index < NumBones; ++Index)
+		{
+			float Values[7];
+			if (!ReadBytes(Values, sizeof(Values)))
+			{
+				return false;
+			}
+			Chain.Positions[Index] = Eigen::Vector3f(Values[0], Values[1], Values[2]);
+			Chain.Rotations[Index] = Eigen::Quaternionf(Values[6], Values[3], Values[4], Values[5]).normalized();
+		}
+
+		if (Chain.Id >= Chains.size())
+		{
+			Chains.resize(Chain.Id + 1);
+		}
+		Chains[Chain.Id] = std::move(Chain);
+		return true;
+	}
+}
@@ -0,0 +1,177 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreReplay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace IKCore
+{
+	namespace
+	{
+		constexpr double HistogramMin = 1e-4;
+		constexpr int32_t BucketsPerOctave = 32;
+
+		// 1e-4 to 1e6 is a little over 33 octaves
+		constexpr int32_t NumBuckets = 34 * BucketsPerOctave + 1;
+
+		double GetBucketUpperBound(int32_t Bucket)
+		{
+			return HistogramMin * std::exp2(static_cast<double>(Bucket) / BucketsPerOctave);
+		}
+	}
+
+	FLogHistogram::FLogHistogram()
+		: Counts(NumBuckets, 0)
+	{
+	}
+
+	void FLogHistogram::Add(double Value)
+	{
+		Value = std::max(Value, 0.0);
+		const int32_t Bucket = Value <= HistogramMin ? 0 : static_cast<int32_t>(std::ceil(std::log2(Value / HistogramMin) * BucketsPerOctave));
+		++Counts[std::min(Bucket, NumBuckets - 1)];
+		++Num;
+		Sum += Value;
+		Max = std::max(Max, Value);
+	}
+
+	double FLogHistogram::GetPercentile(double Percentile) const
+	{
+		const int64_t Rank = static_cast<int64_t>(std::ceil(std::min(std::max(Percentile, 0.0), 1.0) * static_cast<double>(Num)));
+		int64_t Count = 0;
+		for (int32_t Bucket = 0; Bucket < NumBuckets; ++Bucket)
+		{
+			if (Counts[Bucket] == 0 || Count + Counts[Bucket] < Rank)
+			{
+				Count += Counts[Bucket];
+				continue;
+			}
+			if (Bucket == 0)
+			{
+				return std::min(HistogramMin, Max);
+			}
+
+			// samples spread evenly over the bucket on the log scale
+			const double Fraction = static_cast<double>(Rank - Count) / static_cast<double>(Counts[Bucket]);
+			return std::min(GetBucketUpperBound(Bucket - 1) * std::exp2(Fraction / BucketsPerOctave), Max);
+		}
+		return Max;
+	}
+
+	FReplayHarness::FReplayHarness(const std::vector<ESolver>& Solvers, const FReplaySettings& InSettings)
+		: Settings(InSettings)
+		, Stats(Solvers.size())
+		, ChainReplays(Solvers.size())
+		, FrameSeconds(Solvers.size(), 0.0)
+	{
+		for (size_t Index = 0; Index < Solvers.size(); ++Index)
+		{
+			Stats[Index].Solver = Solvers[Index];
+		}
+	}
+
+	void FReplayHarness::Solve(const FRecordedChain& Chain, const FRecordedFrame& Frame)
+	{
+		if (bInFrame && Frame.Frame != CurrentFrame)
+		{
+			EndFrame();
+		}
+		CurrentFrame = Frame.Frame;
+		bInFrame = true;
+
+		FSolverSettings SolverSettings = Settings.Settings;
+		if (!Settings.bOverrideSettings)
+		{
+			SolverSettings.Precision = Chain.Precision;
+			SolverSettings.MaxIterations = Chain.MaxIterations;
+		}
+
+		const Eigen::Quaternionf InverseRootParentRotation = Frame.RootParentRotation.conjugate();
+		for (size_t SolverIndex = 0; SolverIndex < Stats.size(); ++SolverIndex)
+		{
+			FReplayStats& SolverStats = Stats[SolverIndex];
+			std::vector<FChainReplay>& SolverChains = ChainReplays[SolverIndex];
+			if (Chain.Id >= SolverChains.size())
+			{
+				SolverChains.resize(Chain.Id + 1);
+			}
+			FChainReplay& Replay = SolverChains[Chain.Id];
+
+			Chain.GetPose(Frame.RootParentTranslation, Frame.RootParentRotation, Pose);
+			const auto StartTime = std::chrono::steady_clock::now();
+			const FSolveResult Result = Replay.State.Solve(SolverStats.Solver, Pose, Frame.Target, Frame.RootParentRotation, SolverSettings, Settings.WarmStart);
+			const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+			FrameSeconds[SolverIndex] += Seconds;
+			SolverStats.Seconds += Seconds;
+			++SolverStats.NumSolves;
+			SolverStats.NumSkipped += Replay.State.WasSkipped() ? 1 : 0;
+			SolverStats.NumConverged += Result.bConverged ? 1 : 0;
+			SolverStats.NumIterations += Result.Iterations;
+			SolverStats.MaxIterations = std::max(SolverStats.MaxIterations, Result.Iterations);
+			SolverStats.Residuals.Add(Pose.TipDistance(Frame.Target));
+
+			// a gap in the chain's frames (it was not solved, or a new session started) restarts the jitter history
+			Offsets.resize(Pose.Num());
+			for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+			{
+				Offsets[Index] = InverseRootParentRotation * (Pose.Positions[Index] - Frame.RootParentTranslation);
+			}
+			if (Replay.NumHistory > 0 && (Frame.Frame != Replay.LastFrame + 1 || Replay.LastOffsets.size() != Offsets.size()))
+			{
+				Replay.NumHistory = 0;
+			}
+			if (Replay.NumHistory >= 2)
+			{
+				double Jitter = 0.0;
+				for (size_t Index = 0; Index < Offsets.size(); ++Index)
+				{
+					Jitter += (Offsets[Index] - 2.f * Replay.LastOffsets[Index] + Replay.OffsetsBefore[Index]).norm();
+				}
+				SolverStats.Jitter.Add(Jitter / static_cast<double>(Offsets.size()));
+			}
+			std::swap(Replay.OffsetsBefore, Replay.LastOffsets);
+			Replay.LastOffsets = Offsets;
+			Replay.LastFrame = Frame.Frame;
+			Replay.NumHistory = std::min(Replay.NumHistory + 1, 2);
+		}
+	}
+
+	bool FReplayHarness::Replay(FRecordingReader& Reader)
+	{
+		FRecordedFrame Frame;
+		while (Reader.Read(Frame))
+		{
+			Solve(*Reader.FindChain(Frame.ChainId), Frame);
+		}
+		Finish();
+		return !Reader.HasError();
+	}
+
+	void FReplayHarness::Finish()
+	{
+		if (bInFrame)
+		{
+			EndFrame();
+		}
+
+		// chain ids are per session
+		for (std::vector<FChainReplay>& SolverChains : ChainReplays)
+		{
+			SolverChains.clear();
+		}
+	}
+
+	void FReplayHarness::EndFrame()
+	{
+		for (size_t SolverIndex = 0; SolverIndex < Stats.size(); ++SolverIndex)
+		{
+			Stats[SolverIndex].FrameMicroseconds.Add(FrameSeconds[SolverIndex] * 1e6);
+			++Stats[SolverIndex].NumFrames;
+			FrameSeconds[SolverIndex] = 0.0;
+		}
+		bInFrame = false;
+	}
+}
@@ -0,0 +1,200 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace IKCore
+{
+	namespace
+	{
+		using FClock = std::chrono::steady_clock;
+
+		double SecondsSince(FClock::time_point Start)
+		{
+			return std::chrono::duration<double>(FClock::now() - Start).count();
+		}
+	}
+
+	float FParallelForStats::GetUtilization(int32_t WorkerIndex) const
+	{
+		return WallSeconds > 0.0 ? static_cast<float>(std::min(Workers[WorkerIndex].BusySeconds / WallSeconds, 1.0)) : 0.f;
+	}
+
+	float FParallelForStats::GetAverageUtilization() const
+	{
+		float Sum = 0.f;
+		for (int32_t WorkerIndex = 0; WorkerIndex < static_cast<int32_t>(Workers.size()); ++WorkerIndex)
+		{
+			Sum += GetUtilization(WorkerIndex);
+		}
+		return Workers.empty() ? 0.f : Sum / static_cast<float>(Workers.size());
+	}
+
+	void FWorkStealingQueue::Reset(int32_t InNumWorkers, int32_t InNumJobs, int32_t InJobsPerChunk)
+	{
+		NumWorkers = std::max(InNumWorkers, 1);
+		NumJobs = std::max(InNumJobs, 0);
+		JobsPerChunk = std::max(InJobsPerChunk, 1);
+		if (NumWorkers > NumAllocatedWorkers)
+		{
+			Workers.reset(new FWorker[NumWorkers]);
+			NumAllocatedWorkers = NumWorkers;
+		}
+
+		const int32_t NumChunks = (NumJobs + JobsPerChunk - 1) / JobsPerChunk;
+		for (int32_t WorkerIndex = 0; WorkerIndex < NumWorkers; ++WorkerIndex)
+		{
+			FWorker& Worker = Workers[WorkerIndex];
+			Worker.BeginChunk = static_cast<int32_t>(static_cast<int64_t>(NumChunks) * WorkerIndex / NumWorkers);
+			Worker.EndChunk = static_cast<int32_t>(static_cast<int64_t>(NumChunks) * (WorkerIndex + 1) / NumWorkers);
+			Worker.Stats = FWorkerStats();
+		}
+	}
+
+	void FWorkStealingQueue::RunWorker(int32_t WorkerIndex, const FJobFunction& Job)
+	{
+		FWorkerStats& Stats = Workers[WorkerIndex].Stats;
+		int32_t Chunk = 0;
+		while (PopOwnChunk(WorkerIndex, Chunk) || (StealChunks(WorkerIndex) && PopOwnChunk(WorkerIndex, Chunk)))
+		{
+			const FClock::time_point Start = FClock::now();
+			const int32_t EndJob = std::min((Chunk + 1) * JobsPerChunk, NumJobs);
+			for (int32_t JobIndex = Chunk * JobsPerChunk; JobIndex < EndJob; ++JobIndex)
+			{
+				Job(JobIndex, WorkerIndex);
+				++Stats.NumJobs;
+			}
+			Stats.BusySeconds += SecondsSince(Start);
+		}
+	}
+
+	void FWorkStealingQueue::GetStats(double WallSeconds, FParallelForStats& OutStats) const
+	{
+		OutStats.WallSeconds = WallSeconds;
+		OutStats.Workers.resize(NumWorkers);
+		for (int32_t WorkerIndex = 0; WorkerIndex < NumWorkers; ++WorkerIndex)
+		{
+			OutStats.Workers[WorkerIndex] = Workers[WorkerIndex].Stats;
+		}
+	}
+
+	bool FWorkStealingQueue::PopOwnChunk(int32_t WorkerIndex, int32_t& OutChunk)
+	{
+		FWorker& Worker = Workers[WorkerIndex];
+		std::lock_guard<std::mutex> Lock(Worker.Mutex);
+		if (Worker.BeginChunk == Worker.EndChunk)
+		{
+			return false;
+		}
+		OutChunk = --Worker.EndChunk;
+		return true;
+	}
+
+	bool FWorkStealingQueue::StealChunks(int32_t WorkerIndex)
+	{
+		// no job is ever added while the workers run, so one sweep finding every range empty means the work is done
+		for (int32_t Offset = 1; Offset < NumWorkers; ++Offset)
+		{
+			FWorker& Victim = Workers[(WorkerIndex + Offset) % NumWorkers];
+			int32_t StolenBegin = 0;
+			int32_t StolenEnd = 0;
+			{
+				std::lock_guard<std::mutex> Lock(Victim.Mutex);
+				const int32_t NumLeft = Victim.EndChunk - Victim.BeginChunk;
+				if (NumLeft == 0)
+				{
+					continue;
+				}
+				StolenBegin = Victim.BeginChunk;
+				StolenEnd = StolenBegin + (NumLeft + 1) / 2;
+				Victim.BeginChunk = StolenEnd;
+			}
+
+			FWorker& Worker = Workers[WorkerIndex];
+			std::lock_guard<std::mutex> Lock(Worker.Mutex);
+			Worker.BeginChunk = StolenBegin;
+			Worker.EndChunk = StolenEnd;
+			++Worker.Stats.NumSteals;
+			return true;
+		}
+		return false;
+	}
+
+	FThreadPool::FThreadPool(int32_t InNumWorkers)
+		: NumWorkers(std::max(InNumWorkers, 1))
+	{
+		Threads.reserve(NumWorkers - 1);
+		for (int32_t WorkerIndex = 1; WorkerIndex < NumWorkers; ++WorkerIndex)
+		{
+			Threads.emplace_back(&FThreadPool::ThreadMain, this, WorkerIndex);
+		}
+	}
+
+	FThreadPool::~FThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			bShutdown = true;
+		}
+		StartCondition.notify_all();
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+	}
+
+	void FThreadPool::ParallelFor(int32_t NumJobs, const FWorkStealingQueue::FJobFunction& Job, int32_t JobsPerChunk)
+	{
+		const FClock::time_point Start = FClock::now();
+		Queue.Reset(NumWorkers, NumJobs, JobsPerChunk);
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			CurrentJob = &Job;
+			NumRunningThreads = static_cast<int32_t>(Threads.size());
+			++Generation;
+		}
+		StartCondition.notify_all();
+
+		Queue.RunWorker(0, Job);
+
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			DoneCondition.wait(Lock, [this] { return NumRunningThreads == 0; });
+			CurrentJob = nullptr;
+		}
+		Queue.GetStats(SecondsSince(Start), LastStats);
+	}
+
+	void FThreadPool::ThreadMain(int32_t WorkerIndex)
+	{
+		uint64_t LastGeneration = 0;
+		for (;;)
+		{
+			const FWorkStealingQueue::FJobFunction* Job = nullptr;
+			{
+				std::unique_lock<std::mutex> Lock(Mutex);
+				StartCondition.wait(Lock, [this, LastGeneration] { return bShutdown || Generation != LastGeneration; });
+				if (bShutdown)
+				{
+					return;
+				}
+				LastGeneration = Generation;
+				Job = CurrentJob;
+			}
+
+			Queue.RunWorker(WorkerIndex, *Job);
+
+			bool bLastThread = false;
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				bLastThread = --NumRunningThreads == 0;
+			}
+			if (bLastThread)
+			{
+				DoneCondition.notify_one();
+			}
+		}
+	}
+}
@@ -0,0 +1,195 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+// no #pragma once: the AVX2 and AVX-512 wrappers are added by a second inclusion once the target is switched on
+#ifndef IKCORE_SIMD_BASE
+#define IKCORE_SIMD_BASE
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define IKCORE_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define IKCORE_SIMD_X86 0
+#endif
+
+/**
+ * Thin float vector wrappers shared by the batch kernels, so a kernel is written once as a template on the vector type.
+ *
+ * FFloat1 and FFloat4 (SSE2, the x86-64 baseline) are always available. FFloat8 and FFloat16 need AVX2 and AVX-512:
+ * the translation unit built for that instruction set includes every other header first, switches the target on
+ * (GCC/Clang target pragmas, nothing to do on MSVC) and defines IKCORE_SIMD_AVX2 or IKCORE_SIMD_AVX512 before including
+ * this file again. Everything here has internal linkage, so copies compiled for different targets are never merged by the linker.
+ */
+namespace IKCore
+{
+	namespace Simd
+	{
+		namespace
+		{
+			struct FFloat1
+			{
+				using FMask = bool;
+				static constexpr int32_t Width = 1;
+
+				float Value;
+
+				static FFloat1 Load(const float* Source) { return { *Source }; }
+				static FFloat1 Splat(float Scalar) { return { Scalar }; }
+				void Store(float* Destination) const { *Destination = Value; }
+
+				static FFloat1 Sqrt(FFloat1 A) { return { std::sqrt(A.Value) }; }
+				static FFloat1 InvSqrt(FFloat1 A) { return { 1.f / std::sqrt(A.Value) }; }
+				static FFloat1 Max(FFloat1 A, FFloat1 B) { return { A.Value > B.Value ? A.Value : B.Value }; }
+
+				static FMask Greater(FFloat1 A, FFloat1 B) { return A.Value > B.Value; }
+				static FMask And(FMask A, FMask B) { return A && B; }
+				static FMask AndNot(FMask A, FMask B) { return A && !B; }
+				static bool Any(FMask Mask) { return Mask; }
+				static FFloat1 Select(FMask Mask, FFloat1 IfTrue, FFloat1 IfFalse) { return Mask ? IfTrue : IfFalse; }
+			};
+
+			inline FFloat1 operator+(FFloat1 A, FFloat1 B) { return { A.Value + B.Value }; }
+			inline FFloat1 operator-(FFloat1 A, FFloat1 B) { return { A.Value - B.Value }; }
+			inline FFloat1 operator*(FFloat1 A, FFloat1 B) { return { A.Value * B.Value }; }
+			inline FFloat1 operator/(FFloat1 A, FFloat1 B) { return { A.Value / B.Value }; }
+
+#if IKCORE_SIMD_X86
+			struct FFloat4
+			{
+				using FMask = __m128;
+				static constexpr int32_t Width = 4;
+
+				__m128 Value;
+
+				static FFloat4 Load(const float* Source) { return { _mm_loadu_ps(Source) }; }
+				static FFloat4 Splat(float Scalar) { return { _mm_set1_ps(Scalar) }; }
+				void Store(float* Destination) const { _mm_storeu_ps(Destination, Value); }
+
+				static FFloat4 Sqrt(FFloat4 A) { return { _mm_sqrt_ps(A.Value) }; }
+				static FFloat4 InvSqrt(FFloat4 A)
+				{
+					// one Newton-Raphson step on the 12 bit estimate
+					const __m128 Estimate = _mm_rsqrt_ps(A.Value);
+					const __m128 HalfA = _mm_mul_ps(_mm_set1_ps(0.5f), A.Value);
+					return { _mm_mul_ps(Estimate, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(HalfA, _mm_mul_ps(Estimate, Estimate)))) };
+				}
+
+				static FFloat4 Max(FFloat4 A, FFloat4 B) { return { _mm_max_ps(A.Value, B.Value) }; }
+
+				static FMask Greater(FFloat4 A, FFloat4 B) { return _mm_cmpgt_ps(A.Value, B.Value); }
+				static FMask And(FMask A, FMask B) { return _mm_and_ps(A, B); }
+				static FMask AndNot(FMask A, FMask B) { return _mm_andnot_ps(B, A); }
+				static bool Any(FMask Mask) { return _mm_movemask_ps(Mask) != 0; }
+
+				// no blendv before SSE4.1
+				static FFloat4 Select(FMask Mask, FFloat4 IfTrue, FFloat4 IfFalse) { return { _mm_or_ps(_mm_and_ps(Mask, IfTrue.Value), _mm_andnot_ps(Mask, IfFalse.Value)) }; }
+			};
+
+			inline FFloat4 operator+(FFloat4 A, FFloat4 B) { return { _mm_add_ps(A.Value, B.Value) }; }
+			inline FFloat4 operator-(FFloat4 A, FFloat4 B) { return { _mm_sub_ps(A.Value, B.Value) }; }
+			inline FFloat4 operator*(FFloat4 A, FFloat4 B) { return { _mm_mul_ps(A.Value, B.Value) }; }
+			inline FFloat4 operator/(FFloat4 A, FFloat4 B) { return { _mm_div_ps(A.Value, B.Value) }; }
+#endif
+		}
+	}
+}
+
+#endif // IKCORE_SIMD_BASE
+
+#if IKCORE_SIMD_X86 && defined(IKCORE_SIMD_AVX2) && !defined(IKCORE_SIMD_AVX2_DEFINED)
+#define IKCORE_SIMD_AVX2_DEFINED
+
+namespace IKCore
+{
+	namespace Simd
+	{
+		namespace
+		{
+			struct FFloat8
+			{
+				using FMask = __m256;
+				static constexpr int32_t Width = 8;
+
+				__m256 Value;
+
+				static FFloat8 Load(const float* Source) { return { _mm256_loadu_ps(Source) }; }
+				static FFloat8 Splat(float Scalar) { return { _mm256_set1_ps(Scalar) }; }
+				void Store(float* Destination) const { _mm256_storeu_ps(Destination, Value); }
+
+				static FFloat8 Sqrt(FFloat8 A) { return { _mm256_sqrt_ps(A.Value) }; }
+				static FFloat8 InvSqrt(FFloat8 A)
+				{
+					// one Newton-Raphson step on the 12 bit estimate
+					const __m256 Estimate = _mm256_rsqrt_ps(A.Value);
+					const __m256 HalfA = _mm256_mul_ps(_mm256_set1_ps(0.5f), A.Value);
+					return { _mm256_mul_ps(Estimate, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(HalfA, _mm256_mul_ps(Estimate, Estimate)))) };
+				}
+
+				static FFloat8 Max(FFloat8 A, FFloat8 B) { return { _mm256_max_ps(A.Value, B.Value) }; }
+
+				static FMask Greater(FFloat8 A, FFloat8 B) { return _mm256_cmp_ps(A.Value, B.Value, _CMP_GT_OQ); }
+				static FMask And(FMask A, FMask B) { return _mm256_and_ps(A, B); }
+				static FMask AndNot(FMask A, FMask B) { return _mm256_andnot_ps(B, A); }
+				static bool Any(FMask Mask) { return _mm256_movemask_ps(Mask) != 0; }
+				static FFloat8 Select(FMask Mask, FFloat8 IfTrue, FFloat8 IfFalse) { return { _mm256_blendv_ps(IfFalse.Value, IfTrue.Value, Mask) }; }
+			};
+
+			inline FFloat8 operator+(FFloat8 A, FFloat8 B) { return { _mm256_add_ps(A.Value, B.Value) }; }
+			inline FFloat8 operator-(FFloat8 A, FFloat8 B) { return { _mm256_sub_ps(A.Value, B.Value) }; }
+			inline FFloat8 operator*(FFloat8 A, FFloat8 B) { return { _mm256_mul_ps(A.Value, B.Value) }; }
+			inline FFloat8 operator/(FFloat8 A, FFloat8 B) { return { _mm256_div_ps(A.Value, B.Value) }; }
+		}
+	}
+}
+
+#endif
+
+#if IKCORE_SIMD_X86 && defined(IKCORE_SIMD_AVX512) && !defined(IKCORE_SIMD_AVX512_DEFINED)
+#define IKCORE_SIMD_AVX512_DEFINED
+
+namespace IKCore
+{
+	namespace Simd
+	{
+		namespace
+		{
+			struct FFloat16
+			{
+				using FMask = __mmask16;
+				static constexpr int32_t Width = 16;
+
+				__m512 Value;
+
+				static FFloat16 Load(const float* Source) { return { _mm512_loadu_ps(Source) }; }
+				static FFloat16 Splat(float Scalar) { return { _mm512_set1_ps(Scalar) }; }
+				void Store(float* Destination) const { _mm512_storeu_ps(Destination, Value); }
+
+				static FFloat16 Sqrt(FFloat16 A) { return { _mm512_sqrt_ps(A.Value) }; }
+				static FFloat16 InvSqrt(FFloat16 A)
+				{
+					// one Newton-Raphson step on the 14 bit estimate
+					const __m512 Estimate = _mm512_rsqrt14_ps(A.Value);
+					const __m512 HalfA = _mm512_mul_ps(_mm512_set1_ps(0.5f), A.Value);
+					return { _mm512_mul_ps(Estimate, _mm512_sub_ps(_mm512_set1_ps(1.5f), _mm512_mul_ps(HalfA, _mm512_mul_ps(Estimate, Estimate)))) };
+				}
+
+				static FFloat16 Max(FFloat16 A, FFloat16 B) { return { _mm512_max_ps(A.Value, B.Value) }; }
+
+				static FMask Greater(FFloat16 A, FFloat16 B) { return _mm512_cmp_ps_mask(A.Value, B.Value, _CMP_GT_OQ); }
+				static FMask And(FMask A, FMask B) { return static_cast<FMask>(A & B); }
+				static FMask AndNot(FMask A, FMask B) { return static_cast<FMask>(A & ~B); }
+				static bool Any(FMask Mask) { return Mask != 0; }
+				static FFloat16 Select(FMask Mask, FFloat16 IfTrue, FFloat16 IfFalse) { return { _mm512_mask_blend_ps(Mask, IfFalse.Value, IfTrue.Value) }; }
+			};
+
+			inline FFloat16 operator+(FFloat16 A, FFloat16 B) { return { _mm512_add_ps(A.Value, B.Value) }; }
+			inline FFloat16 operator-(FFloat16 A, FFloat16 B) { return { _mm512_sub_ps(A.Value, B.Value) }; }
+			inline FFloat16 operator*(FFloat16 A, FFloat16 B) { return { _mm512_mul_ps(A.Value, B.Value) }; }
+			inline FFloat16 operator/(FFloat16 A, FFloat16 B) { return { _mm512_div_ps(A.Value, B.Value) }; }
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,307 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreSkeletonCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace IKCore
+{
+	namespace
+	{
+		struct FHeader
+		{
+			char Magic[4];
+			uint32_t Version;
+			int32_t NumBones;
+			int32_t NumChains;
+			int32_t NumChainBones;
+			uint32_t NameBytes;
+			uint32_t Reserved[2];
+		};
+		static_assert(sizeof(FHeader) == 32, "The header is part of the file format");
+
+		constexpr char Magic[4] = { 'I', 'K', 'S', 'K' };
+
+		struct FLayout
+		{
+			size_t BonesOffset = 0;
+			size_t ChainsOffset = 0;
+			size_t ChainBonesOffset = 0;
+			size_t NamesOffset = 0;
+			size_t Size = 0;
+		};
+
+		size_t Align8(size_t Offset)
+		{
+			return (Offset + 7) & ~size_t(7);
+		}
+
+		FLayout GetLayout(size_t NumBones, size_t NumChains, size_t NumChainBones, size_t NameBytes)
+		{
+			FLayout Layout;
+			Layout.BonesOffset = sizeof(FHeader);
+			Layout.ChainsOffset = Layout.BonesOffset + sizeof(FSkeletonBone) * NumBones;
+			Layout.ChainBonesOffset = Layout.ChainsOffset + sizeof(FSkeletonChain) * NumChains;
+			Layout.NamesOffset = Align8(Layout.ChainBonesOffset + sizeof(int32_t) * NumChainBones);
+			Layout.Size = Align8(Layout.NamesOffset + NameBytes);
+			return Layout;
+		}
+	}
+
+	bool FSkeletonCache::Open(const char* FilePath)
+	{
+		Reset();
+		if (!MappedFile.Open(FilePath) || !SetImage(MappedFile.GetData(), MappedFile.GetSize()))
+		{
+			Reset();
+			return false;
+		}
+		return true;
+	}
+
+	bool FSkeletonCache::SetImage(const void* Data, size_t Size)
+	{
+		ClearView();
+		if (Data != MappedFile.GetData())
+		{
+			MappedFile.Close();
+		}
+
+		FHeader Header;
+		if (Data == nullptr || reinterpret_cast<uintptr_t>(Data) % 8 != 0 || Size < sizeof(Header))
+		{
+			return false;
+		}
+		std::memcpy(&Header, Data, sizeof(Header));
+		if (std::memcmp(Header.Magic, Magic, sizeof(Magic)) != 0 || Header.Version != Version || Header.NumBones <= 0 || Header.NumChains < 0
+			|| Header.NumChainBones < 0 || Header.NameBytes == 0)
+		{
+			return false;
+		}
+
+		const FLayout Layout = GetLayout(Header.NumBones, Header.NumChains, Header.NumChainBones, Header.NameBytes);
+		if (Layout.Size != Size)
+		{
+			return false;
+		}
+
+		// everything the accessors index with is checked once here, so they need not be
+		const char* Bytes = static_cast<const char*>(Data);
+		const FSkeletonBone* InBones = reinterpret_cast<const FSkeletonBone*>(Bytes + Layout.BonesOffset);
+		const FSkeletonChain* InChains = reinterpret_cast<const FSkeletonChain*>(Bytes + Layout.ChainsOffset);
+		const int32_t* InChainBones = reinterpret_cast<const int32_t*>(Bytes + Layout.ChainBonesOffset);
+		const char* InNames = Bytes + Layout.NamesOffset;
+		if (InNames[Header.NameBytes - 1] != '\0')
+		{
+			return false;
+		}
+		for (int32_t Index = 0; Index < Header.NumBones; ++Index)
+		{
+			if (InBones[Index].Parent < -1 || InBones[Index].Parent >= Index || InBones[Index].NameOffset >= Header.NameBytes)
+			{
+				return false;
+			}
+		}
+		for (int32_t Index = 0; Index < Header.NumChains; ++Index)
+		{
+			const FSkeletonChain& Chain = InChains[Index];
+			if (Chain.TipNameOffset >= Header.NameBytes || Chain.RootNameOffset >= Header.NameBytes || Chain.NumBones < 2
+				|| Chain.FirstBone > static_cast<uint32_t>(Header.NumChainBones) || Chain.NumBones > static_cast<uint32_t>(Header.NumChainBones) - Chain.FirstBone)
+			{
+				return false;
+			}
+		}
+		for (int32_t Index = 0; Index < Header.NumChainBones; ++Index)
+		{
+			if (InChainBones[Index] < 0 || InChainBones[Index] >= Header.NumBones)
+			{
+				return false;
+			}
+		}
+
+		NumBones = Header.NumBones;
+		NumChains = Header.NumChains;
+		Bones = InBones;
+		Chains = InChains;
+		ChainBones = InChainBones;
+		Names = InNames;
+		return true;
+	}
+
+	void FSkeletonCache::Reset()
+	{
+		MappedFile.Close();
+		ClearView();
+	}
+
+	void FSkeletonCache::ClearView()
+	{
+		NumBones = 0;
+		NumChains = 0;
+		Bones = nullptr;
+		Chains = nullptr;
+		ChainBones = nullptr;
+		Names = nullptr;
+	}
+
+	int32_t FSkeletonCache::FindBone(const char* Name) const
+	{
+		for (int32_t Index = 0; Index < NumBones; ++Index)
+		{
+			if (std::strcmp(GetBoneName(Index), Name) == 0)
+			{
+				return Index;
+			}
+		}
+		return -1;
+	}
+
+	const FSkeletonChain* FSkeletonCache::FindChain(const char* TipBoneName, const char* RootBoneName) const
+	{
+		for (int32_t Index = 0; Index < NumChains; ++Index)
+		{
+			if (std::strcmp(GetName(Chains[Index].TipNameOffset), TipBoneName) == 0 && std::strcmp(GetName(Chains[Index].RootNameOffset), RootBoneName) == 0)
+			{
+				return &Chains[Index];
+			}
+		}
+		return nullptr;
+	}
+
+	void FSkeletonCache::GetRestPose(const FSkeletonChain& Chain, FPose& OutPose) const
+	{
+		const int32_t* BoneIndices = GetChainBones(Chain);
+		OutPose.Positions.resize(Chain.NumBones);
+		OutPose.Rotations.resize(Chain.NumBones);
+
+		Eigen::Vector3f Position = Eigen::Vector3f::Zero();
+		Eigen::Quaternionf Rotation = Eigen::Quaternionf::Identity();
+		for (uint32_t Index = 0; Index < Chain.NumBones; ++Index)
+		{
+			const FSkeletonBone& Bone = Bones[BoneIndices[Index]];
+			Position += Rotation * Eigen::Map<const Eigen::Vector3f>(Bone.RestTranslation);
+			Rotation = (Rotation * Eigen::Quaternionf(Eigen::Map<const Eigen::Vector4f>(Bone.RestRotation))).normalized();
+			OutPose.Positions[Index] = Position;
+			OutPose.Rotations[Index] = Rotation;
+		}
+		OutPose.UpdateLengths();
+	}
+
+	int32_t FSkeletonCacheBuilder::AddBone(const char* Name, int32_t Parent, const Eigen::Vector3f& RestTranslation, const Eigen::Quaternionf& RestRotation)
+	{
+		FSkeletonBone Bone;
+		Bone.Parent = Parent;
+		std::copy(RestTranslation.data(), RestTranslation.data() + 3, Bone.RestTranslation);
+		std::copy(RestRotation.coeffs().data(), RestRotation.coeffs().data() + 4, Bone.RestRotation);
+		Bones.push_back(Bone);
+		BoneNames.push_back(Name);
+		return GetNumBones() - 1;
+	}
+
+	void FSkeletonCacheBuilder::SetJointLimits(int32_t Bone, float SwingLimit, float MinTwist, float MaxTwist)
+	{
+		Bones[Bone].SwingLimit = SwingLimit;
+		Bones[Bone].MinTwist = MinTwist;
+		Bones[Bone].MaxTwist = MaxTwist;
+	}
+
+	bool FSkeletonCacheBuilder::AddChain(int32_t TipBone, int32_t RootBone)
+	{
+		const size_t FirstBone = ChainBones.size();
+		int32_t Bone = TipBone;
+		for (; Bone >= 0 && Bone != RootBone; Bone = Bones[Bone].Parent)
+		{
+			ChainBones.push_back(Bone);
+		}
+		if (Bone != RootBone || TipBone == RootBone)
+		{
+			ChainBones.resize(FirstBone);
+			return false;
+		}
+		ChainBones.push_back(RootBone);
+		std::reverse(ChainBones.begin() + FirstBone, ChainBones.end());
+		ChainEnds.emplace_back(TipBone, RootBone);
+		return true;
+	}
+
+	void FSkeletonCacheBuilder::Write(std::vector<uint64_t>& OutImage, size_t& OutSize) const
+	{
+		std::vector<FSkeletonBone> OutBones = Bones;
+		std::vector<char> NameTable;
+		std::vector<uint32_t> FirstChild(Bones.size(), UINT32_MAX);
+		for (size_t Index = 0; Index < Bones.size(); ++Index)
+		{
+			OutBones[Index].NameOffset = static_cast<uint32_t>(NameTable.size());
+			NameTable.insert(NameTable.end(), BoneNames[Index].c_str(), BoneNames[Index].c_str() + BoneNames[Index].size() + 1);
+
+			const Eigen::Map<const Eigen::Vector3f> Translation(Bones[Index].RestTranslation);
+			OutBones[Index].RestLength = Translation.norm();
+			if (Bones[Index].Parent >= 0 && FirstChild[Bones[Index].Parent] == UINT32_MAX)
+			{
+				FirstChild[Bones[Index].Parent] = static_cast<uint32_t>(Index);
+			}
+		}
+
+		for (size_t Index = 0; Index < Bones.size(); ++Index)
+		{
+			// a leaf keeps pointing the way it came from its parent
+			Eigen::Vector3f Axis = FirstChild[Index] != UINT32_MAX
+				? Eigen::Map<const Eigen::Vector3f>(Bones[FirstChild[Index]].RestTranslation)
+				: Eigen::Quaternionf(Eigen::Map<const Eigen::Vector4f>(Bones[Index].RestRotation)).conjugate() * Eigen::Map<const Eigen::Vector3f>(Bones[Index].RestTranslation);
+			Axis = Axis.squaredNorm() > 1e-8f ? Axis.normalized() : Eigen::Vector3f::UnitX();
+			std::copy(Axis.data(), Axis.data() + 3, OutBones[Index].TwistAxis);
+		}
+
+		std::vector<FSkeletonChain> OutChains(ChainEnds.size());
+		uint32_t FirstBone = 0;
+		for (size_t Index = 0; Index < ChainEnds.size(); ++Index)
+		{
+			FSkeletonChain& Chain = OutChains[Index];
+			Chain.TipNameOffset = OutBones[ChainEnds[Index].first].NameOffset;
+			Chain.RootNameOffset = OutBones[ChainEnds[Index].second].NameOffset;
+			Chain.FirstBone = FirstBone;
+			Chain.NumBones = 1;
+			for (int32_t Bone = ChainEnds[Index].first; Bone != ChainEnds[Index].second; Bone = Bones[Bone].Parent)
+			{
+				++Chain.NumBones;
+				Chain.TotalReach += OutBones[Bone].RestLength;
+			}
+			FirstBone += Chain.NumBones;
+		}
+
+		const FLayout Layout = GetLayout(Bones.size(), OutChains.size(), ChainBones.size(), NameTable.size());
+		OutImage.assign(Layout.Size / sizeof(uint64_t), 0);
+		OutSize = Layout.Size;
+		char* Data = reinterpret_cast<char*>(OutImage.data());
+
+		FHeader Header = {};
+		std::memcpy(Header.Magic, Magic, sizeof(Magic));
+		Header.Version = FSkeletonCache::Version;
+		Header.NumBones = GetNumBones();
+		Header.NumChains = GetNumChains();
+		Header.NumChainBones = static_cast<int32_t>(ChainBones.size());
+		Header.NameBytes = static_cast<uint32_t>(NameTable.size());
+		std::memcpy(Data, &Header, sizeof(Header));
+		std::memcpy(Data + Layout.BonesOffset, OutBones.data(), sizeof(FSkeletonBone) * OutBones.size());
+		std::memcpy(Data + Layout.ChainsOffset, OutChains.data(), sizeof(FSkeletonChain) * OutChains.size());
+		std::memcpy(Data + Layout.ChainBonesOffset, ChainBones.data(), sizeof(int32_t) * ChainBones.size());
+		std::memcpy(Data + Layout.NamesOffset, NameTable.data(), NameTable.size());
+	}
+
+	bool FSkeletonCacheBuilder::Save(const char* FilePath) const
+	{
+		std::vector<uint64_t> Image;
+		size_t Size = 0;
+		Write(Image, Size);
+
+		std::FILE* File = std::fopen(FilePath, "wb");
+		if (File == nullptr)
+		{
+			return false;
+		}
+		const bool bWritten = std::fwrite(Image.data(), 1, Size, File) == Size;
+		return std::fclose(File) == 0 && bWritten;
+	}
+}
@@ -0,0 +1,172 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreSolveState.h"
+#include "IKCoreSolvers.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace IKCore
+{
+	FSolveResult FChainSolveState::Solve(ESolver Solver, FPose& Pose, const Eigen::Vector3f& Target, const Eigen::Quaternionf& InRootParentRotation,
+		const FSolverSettings& Settings, const FWarmStartSettings& WarmStartSettings, FJacobianWorkspace* Workspace)
+	{
+		const Eigen::Vector3f NewLocalTarget = InRootParentRotation.conjugate() * (Target - Pose.Positions[0]);
+		const bool bCanReuse = CanReuse(Pose, WarmStartSettings);
+		const bool bSameTarget = bCanReuse && (NewLocalTarget - LocalTarget).norm() <= WarmStartSettings.TargetTolerance;
+
+		const int32_t IntervalFrames = std::max(WarmStartSettings.IntervalFrames, 1);
+		bInterpolated = bCanReuse && ++NumCallsSinceSolve < IntervalFrames;
+		if (bInterpolated)
+		{
+			bSkipped = false;
+			Interpolate(Pose, InRootParentRotation, static_cast<float>(NumCallsSinceSolve + 1) / static_cast<float>(IntervalFrames));
+
+			FSolveResult Result = LastResult;
+			Result.Iterations = 0;
+			return Result;
+		}
+		NumCallsSinceSolve = 0;
+
+		bSkipped = bSameTarget && WarmStartSettings.bSkipUnchanged && (LastResult.bConverged || bStalled)
+			&& (Pose.Positions[0] - RootPosition).norm() <= WarmStartSettings.RootTolerance
+			&& InRootParentRotation.angularDistance(RootParentRotation) <= WarmStartSettings.RootAngleTolerance;
+		if (bSkipped)
+		{
+			Restore(Pose, InRootParentRotation);
+			++NumSkipped;
+
+			// settled on the last solution, the frames until the next solve have nothing left to blend
+			PreviousLocalOffsets = LocalOffsets;
+			PreviousLocalRotations = LocalRotations;
+
+			FSolveResult Result = LastResult;
+			Result.Iterations = 0;
+			return Result;
+		}
+
+		InputLengths = Pose.Lengths;
+		if (bCanReuse && WarmStartSettings.bWarmStart)
+		{
+			Restore(Pose, InRootParentRotation);
+		}
+		if (WarmStartSettings.PoseDatabase != nullptr && WarmStartSettings.PoseDatabase->SeedPose(Pose, Target, InRootParentRotation, WarmStartSettings.PoseDatabaseNeighbours))
+		{
+			++NumSeeded;
+		}
+
+		// the automatic pipeline also goes by how the last solve of this chain went
+		FSolveResult Result = Solver == ESolver::Auto
+			? SolvePipeline(SelectPipeline(Pose, Target, Settings, bCanReuse ? &LastResult : nullptr), Pose, Target, Settings, Workspace)
+			: IKCore::Solve(Solver, Pose, Target, Settings, Workspace);
+		++NumSolved;
+
+		// a solve that can neither converge nor get closer to an unchanged target would only repeat itself,
+		// and one that drifted away from it (Jacobian transpose on an unreachable target) keeps the better last solution
+		bStalled = !Result.bConverged && bSameTarget && Result.Residual >= LastResult.Residual - WarmStartSettings.TargetTolerance;
+		if (bStalled && Result.Residual > LastResult.Residual)
+		{
+			Restore(Pose, InRootParentRotation);
+			Result.Residual = LastResult.Residual;
+		}
+
+		LastResult = Result;
+		LocalTarget = NewLocalTarget;
+		Store(Pose, InRootParentRotation);
+		if (IntervalFrames > 1)
+		{
+			Interpolate(Pose, InRootParentRotation, 1.f / static_cast<float>(IntervalFrames));
+		}
+		return Result;
+	}
+
+	void FChainSolveState::Reset()
+	{
+		bHasSolution = false;
+		bStalled = false;
+		bSkipped = false;
+		bInterpolated = false;
+		NumCallsSinceSolve = 0;
+		LastResult = FSolveResult();
+	}
+
+	bool FChainSolveState::CanReuse(const FPose& Pose, const FWarmStartSettings& WarmStartSettings) const
+	{
+		if (!bHasSolution || static_cast<int32_t>(LocalOffsets.size()) != Pose.Num())
+		{
+			return false;
+		}
+
+		// the skeleton or a stretch in the animation changed the chain, the old solution no longer fits
+		for (int32_t Index = 0; Index < Pose.NumLinks(); ++Index)
+		{
+			if (std::abs(Pose.Lengths[Index] - InputLengths[Index]) > WarmStartSettings.RootTolerance)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void FChainSolveState::Restore(FPose& Pose, const Eigen::Quaternionf& InRootParentRotation) const
+	{
+		const Eigen::Vector3f Root = Pose.Positions[0];
+		for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+		{
+			Pose.Positions[Index] = Root + InRootParentRotation * LocalOffsets[Index];
+			Pose.Rotations[Index] = InRootParentRotation * Eigen::Quaternionf(LocalRotations[Index]);
+		}
+		Pose.Lengths = Lengths;
+	}
+
+	void FChainSolveState::Store(const FPose& Pose, const Eigen::Quaternionf& InRootParentRotation)
+	{
+		const Eigen::Quaternionf InverseRotation = InRootParentRotation.conjugate();
+		if (bHasSolution && static_cast<int32_t>(LocalOffsets.size()) == Pose.Num())
+		{
+			PreviousLocalOffsets.swap(LocalOffsets);
+			PreviousLocalRotations.swap(LocalRotations);
+		}
+		LocalOffsets.resize(Pose.Num());
+		LocalRotations.resize(Pose.Num());
+		for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+		{
+			LocalOffsets[Index] = InverseRotation * (Pose.Positions[Index] - Pose.Positions[0]);
+			LocalRotations[Index] = InverseRotation * Pose.Rotations[Index];
+		}
+		Lengths = Pose.Lengths;
+
+		RootPosition = Pose.Positions[0];
+		RootParentRotation = InRootParentRotation;
+		if (PreviousLocalOffsets.size() != LocalOffsets.size())
+		{
+			PreviousLocalOffsets = LocalOffsets;
+			PreviousLocalRotations = LocalRotations;
+		}
+		bHasSolution = true;
+	}
+
+	void FChainSolveState::Interpolate(FPose& Pose, const Eigen::Quaternionf& InRootParentRotation, float Alpha) const
+	{
+		if (Alpha >= 1.f)
+		{
+			Restore(Pose, InRootParentRotation);
+			return;
+		}
+
+		// the links are blended as directions and laid end to end, so their lengths hold in between the two solutions
+		Pose.Lengths = Lengths;
+		for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+		{
+			const Eigen::Quaternionf LocalRotation = Eigen::Quaternionf(PreviousLocalRotations[Index]).slerp(Alpha, Eigen::Quaternionf(LocalRotations[Index]));
+			Pose.Rotations[Index] = InRootParentRotation * LocalRotation;
+			if (Index > 0)
+			{
+				const Eigen::Vector3f PreviousLink = PreviousLocalOffsets[Index] - PreviousLocalOffsets[Index - 1];
+				const Eigen::Vector3f Link = LocalOffsets[Index] - LocalOffsets[Index - 1];
+				const Eigen::Vector3f Direction = (PreviousLink + Alpha * (Link - PreviousLink)).normalized();
+				Pose.Positions[Index] = Pose.Positions[Index - 1] + InRootParentRotation * (Direction * Lengths[Index - 1]);
+			}
+		}
+	}
+}
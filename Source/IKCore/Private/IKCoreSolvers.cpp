@@ -0,0 +1,61 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreSolvers.h"
+
+namespace IKCore
+{
+	FSolveResult Solve(ESolver Solver, FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, FJacobianWorkspace* Workspace)
+	{
+		// the closed form knows nothing about joint limits, limited two-bone chains go through the iterative solvers
+		if (Settings.bAnalyticTwoBone && Pose.NumLinks() == 2 && !Pose.HasJointLimits())
+		{
+			return SolveTwoBone(Pose, Target, Settings);
+		}
+
+		switch (Solver)
+		{
+		case ESolver::CCD:
+			return SolveCCD(Pose, Target, Settings);
+		case ESolver::FABRIK:
+			return SolveFABRIK(Pose, Target, Settings);
+		case ESolver::JacobianTranspose:
+			return SolveJacobianTranspose(Pose, Target, Settings, Workspace);
+		case ESolver::JacobianPinv:
+			return SolveJacobianPinv(Pose, Target, Settings, Workspace);
+		case ESolver::DampedLeastSquares:
+			return SolveDampedLeastSquares(Pose, Target, Settings, Workspace);
+		case ESolver::TwoBone:
+			return Pose.NumLinks() == 2 && !Pose.HasJointLimits() ? SolveTwoBone(Pose, Target, Settings) : SolveFABRIK(Pose, Target, Settings);
+		case ESolver::Pipeline:
+			if (Settings.Pipeline.NumStages > 0)
+			{
+				return SolvePipeline(Settings.Pipeline, Pose, Target, Settings, Workspace);
+			}
+			return SolvePipeline(SelectPipeline(Pose, Target, Settings), Pose, Target, Settings, Workspace);
+		case ESolver::Auto:
+			return SolvePipeline(SelectPipeline(Pose, Target, Settings), Pose, Target, Settings, Workspace);
+		}
+		return FSolveResult();
+	}
+
+	FSolveResult Solve(ESolver Solver, FPose& Pose, const FTransformTarget& Target, const FSolverSettings& Settings, FTransformJacobianWorkspace* Workspace)
+	{
+		switch (Solver)
+		{
+		case ESolver::JacobianTranspose:
+		case ESolver::JacobianPinv:
+		case ESolver::DampedLeastSquares:
+			return SolveJacobianTransform(Solver, Pose, Target, Settings, Workspace);
+		case ESolver::Pipeline:
+		case ESolver::Auto:
+			// FABRIK and CCD know nothing about orientation, the 6-row solve is the only stage that helps
+			return SolveJacobianTransform(ESolver::DampedLeastSquares, Pose, Target, Settings, Workspace);
+		default:
+			break;
+		}
+
+		FSolveResult Result = Solve(Solver, Pose, Target.Position, Settings);
+		Pose.Rotations.back() = Target.Rotation.normalized();
+		return Result;
+	}
+}
@@ -0,0 +1,37 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreStats.h"
+
+#include <atomic>
+
+namespace IKCore
+{
+	namespace
+	{
+		std::atomic<bool> bPhaseTimingEnabled(false);
+		thread_local FPhaseTimes ThreadPhaseTimes;
+	}
+
+	void SetPhaseTimingEnabled(bool bEnabled)
+	{
+		bPhaseTimingEnabled.store(bEnabled, std::memory_order_relaxed);
+	}
+
+	bool IsPhaseTimingEnabled()
+	{
+		return bPhaseTimingEnabled.load(std::memory_order_relaxed);
+	}
+
+	void AddPhaseTime(ESolvePhase Phase, double Seconds)
+	{
+		ThreadPhaseTimes.Seconds[static_cast<int32_t>(Phase)] += Seconds;
+		++ThreadPhaseTimes.Calls[static_cast<int32_t>(Phase)];
+	}
+
+	FPhaseTimes TakePhaseTimes()
+	{
+		const FPhaseTimes PhaseTimes = ThreadPhaseTimes;
+		ThreadPhaseTimes = FPhaseTimes();
+		return PhaseTimes;
+	}
+}
@@ -0,0 +1,173 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreTrace.h"
+
+#include <cinttypes>
+#include <cstring>
+
+namespace IKCore
+{
+	namespace
+	{
+		const char* const SolverNames[] = { "CCD", "FABRIK", "JacobianTranspose", "JacobianPinv", "DampedLeastSquares", "TwoBone", "Pipeline", "Auto" };
+
+		// the engine only targets little endian platforms, so the fields are copied as they are in memory
+		template <typename T>
+		void Append(std::vector<char>& Buffer, const T& Value)
+		{
+			const char* Bytes = reinterpret_cast<const char*>(&Value);
+			Buffer.insert(Buffer.end(), Bytes, Bytes + sizeof(T));
+		}
+	}
+
+	FTraceWriter::~FTraceWriter()
+	{
+		Close();
+	}
+
+	bool FTraceWriter::Open(const char* FilePath, ETraceFormat InFormat)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (File != nullptr)
+		{
+			FlushLocked();
+			std::fclose(File);
+		}
+
+		File = std::fopen(FilePath, InFormat == ETraceFormat::Binary ? "wb" : "w");
+		if (File == nullptr)
+		{
+			return false;
+		}
+
+		Format = InFormat;
+		NameIds.clear();
+		Names.clear();
+		NumWrittenNames = 0;
+		PendingRecords.clear();
+		if (Format == ETraceFormat::Binary)
+		{
+			std::fwrite("IKTR", 1, 4, File);
+			const uint32_t Version = BinaryVersion;
+			std::fwrite(&Version, sizeof(Version), 1, File);
+		}
+		else
+		{
+			std::fputs("frame,owner,chain,solver,bones,iterations,residual,microseconds,converged,skipped\n", File);
+		}
+		return true;
+	}
+
+	void FTraceWriter::Close()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (File != nullptr)
+		{
+			FlushLocked();
+			std::fclose(File);
+			File = nullptr;
+		}
+	}
+
+	bool FTraceWriter::IsOpen() const
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return File != nullptr;
+	}
+
+	uint32_t FTraceWriter::RegisterName(const std::string& Name)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		return RegisterNameLocked(Name);
+	}
+
+	uint32_t FTraceWriter::RegisterNameLocked(const std::string& Name)
+	{
+		const auto Found = NameIds.find(Name);
+		if (Found != NameIds.end())
+		{
+			return Found->second;
+		}
+
+		const uint32_t Id = static_cast<uint32_t>(Names.size());
+		NameIds.emplace(Name, Id);
+		Names.push_back(Name);
+		return Id;
+	}
+
+	void FTraceWriter::Write(const FTraceRecord& Record)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (File != nullptr)
+		{
+			PendingRecords.push_back(Record);
+		}
+	}
+
+	void FTraceWriter::Write(const FTraceRecord& Record, const std::string& Owner, const std::string& Chain)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (File != nullptr)
+		{
+			PendingRecords.push_back(Record);
+			PendingRecords.back().OwnerId = RegisterNameLocked(Owner);
+			PendingRecords.back().ChainId = RegisterNameLocked(Chain);
+		}
+	}
+
+	void FTraceWriter::Flush()
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (File != nullptr)
+		{
+			FlushLocked();
+			std::fflush(File);
+		}
+	}
+
+	void FTraceWriter::FlushLocked()
+	{
+		Buffer.clear();
+		if (Format == ETraceFormat::Binary)
+		{
+			for (; NumWrittenNames < Names.size(); ++NumWrittenNames)
+			{
+				const std::string& Name = Names[NumWrittenNames];
+				const uint16_t Length = static_cast<uint16_t>(std::min<size_t>(Name.size(), UINT16_MAX));
+				Buffer.push_back('N');
+				Append(Buffer, static_cast<uint32_t>(NumWrittenNames));
+				Append(Buffer, Length);
+				Buffer.insert(Buffer.end(), Name.begin(), Name.begin() + Length);
+			}
+
+			for (const FTraceRecord& Record : PendingRecords)
+			{
+				Buffer.push_back('R');
+				Append(Buffer, Record.Frame);
+				Append(Buffer, Record.OwnerId);
+				Append(Buffer, Record.ChainId);
+				Append(Buffer, Record.Residual);
+				Append(Buffer, Record.Microseconds);
+				Append(Buffer, Record.Iterations);
+				Append(Buffer, Record.NumBones);
+				Append(Buffer, Record.Solver);
+				Append(Buffer, Record.Flags);
+			}
+		}
+		else
+		{
+			char Line[512];
+			for (const FTraceRecord& Record : PendingRecords)
+			{
+				const int Length = std::snprintf(Line, sizeof(Line), "%" PRIu64 ",%s,%s,%s,%u,%u,%g,%.2f,%d,%d\n",
+					Record.Frame, Names[Record.OwnerId].c_str(), Names[Record.ChainId].c_str(), SolverNames[static_cast<int32_t>(Record.Solver)],
+					static_cast<unsigned>(Record.NumBones), static_cast<unsigned>(Record.Iterations), Record.Residual, Record.Microseconds,
+					(Record.Flags & FTraceRecord::Converged) != 0 ? 1 : 0, (Record.Flags & FTraceRecord::Skipped) != 0 ? 1 : 0);
+				Buffer.insert(Buffer.end(), Line, Line + std::min<int>(Length, sizeof(Line) - 1));
+			}
+		}
+
+		std::fwrite(Buffer.data(), 1, Buffer.size(), File);
+		PendingRecords.clear();
+	}
+}
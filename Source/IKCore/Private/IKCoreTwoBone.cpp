@@ -0,0 +1,123 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreSolvers.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace IKCore
+{
+	namespace
+	{
+		constexpr float SmallNumber = 1e-6f;
+
+		/** Orthonormal frame with X along Direction and Z along the part of Normal perpendicular to it. */
+		Eigen::Matrix3f MakeFrame(const Eigen::Vector3f& Direction, const Eigen::Vector3f& Normal)
+		{
+			Eigen::Matrix3f Frame;
+			Frame.col(0) = Direction.normalized();
+			Frame.col(2) = (Normal - Frame.col(0) * Frame.col(0).dot(Normal)).normalized();
+			Frame.col(1) = Frame.col(2).cross(Frame.col(0));
+			return Frame;
+		}
+
+		/** Rotation taking a bone lying along FromDirection in the plane FromNormal to ToDirection in the plane ToNormal. */
+		Eigen::Quaternionf AlignBone(const Eigen::Vector3f& FromDirection, const Eigen::Vector3f& FromNormal, const Eigen::Vector3f& ToDirection, const Eigen::Vector3f& ToNormal)
+		{
+			return Eigen::Quaternionf(MakeFrame(ToDirection, ToNormal) * MakeFrame(FromDirection, FromNormal).transpose()).normalized();
+		}
+
+		/** Any unit vector perpendicular to Direction. */
+		Eigen::Vector3f AnyPerpendicular(const Eigen::Vector3f& Direction)
+		{
+			const Eigen::Vector3f Axis = std::abs(Direction.x()) < 0.9f ? Eigen::Vector3f::UnitX() : Eigen::Vector3f::UnitY();
+			return Direction.cross(Axis).normalized();
+		}
+	}
+
+	FSolveResult SolveTwoBone(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings)
+	{
+		FSolveResult Result;
+		if (Pose.NumLinks() != 2)
+		{
+			Result.Residual = Pose.TipDistance(Target);
+			return Result;
+		}
+		const FTwoBoneSettings& TwoBone = Settings.TwoBone;
+
+		const Eigen::Vector3f RootLocation = Pose.Positions[0];
+		const Eigen::Vector3f OldJointLocation = Pose.Positions[1];
+		const Eigen::Vector3f OldTipLocation = Pose.Positions[2];
+
+		float UpperLength = Pose.Lengths[0];
+		float LowerLength = Pose.Lengths[1];
+
+		const Eigen::Vector3f ToTarget = Target - RootLocation;
+		const float TargetDistance = ToTarget.norm();
+		if (TargetDistance < SmallNumber || UpperLength < SmallNumber || LowerLength < SmallNumber)
+		{
+			Result.Residual = Pose.TipDistance(Target);
+			return Result;
+		}
+		const Eigen::Vector3f TargetDirection = ToTarget / TargetDistance;
+
+		// reachability: soft approach to full extension, optional stretch, then clamp to [min, max] reach
+		const float MaxReach = UpperLength + LowerLength;
+		float SolveDistance = TargetDistance;
+		const float SoftStart = MaxReach * std::min(std::max(TwoBone.SoftStartRatio, 0.f), 1.f);
+		const float SoftRange = MaxReach - SoftStart;
+		if (SoftRange > SmallNumber && SolveDistance > SoftStart)
+		{
+			SolveDistance = SoftStart + SoftRange * (1.f - std::exp(-(SolveDistance - SoftStart) / SoftRange));
+		}
+		if (TwoBone.bAllowStretch && TargetDistance > SolveDistance)
+		{
+			const float StretchScale = std::min(TargetDistance / SolveDistance, std::max(TwoBone.MaxStretchScale, 1.f));
+			UpperLength *= StretchScale;
+			LowerLength *= StretchScale;
+			SolveDistance *= StretchScale;
+		}
+		const float MinReach = std::abs(UpperLength - LowerLength);
+		SolveDistance = std::min(std::max(SolveDistance, MinReach + SmallNumber), UpperLength + LowerLength - SmallNumber);
+
+		// bend plane: towards the pole vector or the current middle joint, swiveled about the target axis
+		const Eigen::Vector3f OldPlaneNormal = (OldJointLocation - RootLocation).cross(OldTipLocation - RootLocation);
+		Eigen::Vector3f BendDirection = TwoBone.bUsePoleVector ? Eigen::Vector3f(TwoBone.PoleVector - RootLocation) : Eigen::Vector3f(OldJointLocation - RootLocation);
+		BendDirection -= TargetDirection * TargetDirection.dot(BendDirection);
+		if (BendDirection.squaredNorm() < SmallNumber)
+		{
+			BendDirection = OldPlaneNormal.squaredNorm() > SmallNumber ? OldPlaneNormal.cross(TargetDirection) : AnyPerpendicular(TargetDirection);
+		}
+		BendDirection.normalize();
+		if (TwoBone.SwivelAngle != 0.f)
+		{
+			BendDirection = Eigen::AngleAxisf(TwoBone.SwivelAngle, TargetDirection) * BendDirection;
+		}
+
+		// law of cosines at the root
+		const float CosRootAngle = std::min(std::max((UpperLength * UpperLength + SolveDistance * SolveDistance - LowerLength * LowerLength) / (2.f * UpperLength * SolveDistance), -1.f), 1.f);
+		const float SinRootAngle = std::sqrt(1.f - CosRootAngle * CosRootAngle);
+		const Eigen::Vector3f NewJointLocation = RootLocation + UpperLength * (CosRootAngle * TargetDirection + SinRootAngle * BendDirection);
+		const Eigen::Vector3f NewTipLocation = RootLocation + SolveDistance * TargetDirection;
+
+		// rotate both bones so that their bend plane follows, the tip keeps its local rotation
+		const Eigen::Vector3f NewPlaneNormal = BendDirection.cross(TargetDirection);
+		const Eigen::Vector3f FromPlaneNormal = OldPlaneNormal.squaredNorm() > SmallNumber ? OldPlaneNormal : NewPlaneNormal;
+
+		const Eigen::Quaternionf UpperDelta = AlignBone(OldJointLocation - RootLocation, FromPlaneNormal, NewJointLocation - RootLocation, NewPlaneNormal);
+		const Eigen::Quaternionf LowerDelta = AlignBone(OldTipLocation - OldJointLocation, FromPlaneNormal, NewTipLocation - NewJointLocation, NewPlaneNormal);
+		Pose.Rotations[0] = (UpperDelta * Pose.Rotations[0]).normalized();
+		Pose.Rotations[1] = (LowerDelta * Pose.Rotations[1]).normalized();
+		Pose.Rotations[2] = (LowerDelta * Pose.Rotations[2]).normalized();
+
+		Pose.Positions[1] = NewJointLocation;
+		Pose.Positions[2] = NewTipLocation;
+		Pose.Lengths[0] = UpperLength;
+		Pose.Lengths[1] = LowerLength;
+
+		Result.Iterations = 1;
+		Result.Residual = Pose.TipDistance(Target);
+		Result.bConverged = Result.Residual <= Settings.Precision;
+		return Result;
+	}
+}
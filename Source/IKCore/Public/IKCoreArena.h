@@ -0,0 +1,126 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace IKCore
+{
+	/**
+	 * Linear allocator for solver scratch memory. Allocations bump an offset through the current block and are never freed
+	 * one at a time; an FScratchScope rewinds the arena to where it was when the scope was opened. Running past the last
+	 * block costs one heap allocation for another block, and the next rewind to empty merges all blocks into a single one
+	 * of their combined size, so once the arena has seen the largest frame it never touches the heap again.
+	 *
+	 * Not thread safe: each worker thread solves out of its own arena, see GetThreadScratchArena.
+	 */
+	class IKCORE_API FScratchArena
+	{
+	public:
+		static constexpr size_t DefaultBlockSize = 64 * 1024;
+
+		// every allocation starts at least this aligned, enough for the Eigen fixed-size vectorizable types
+		static constexpr size_t MinAlignment = 16;
+
+		/** Position of the arena, returned by GetMark and taken back by Rewind. */
+		struct FMark
+		{
+			size_t Block = 0;
+			size_t Offset = 0;
+		};
+
+		explicit FScratchArena(size_t InitialSize = DefaultBlockSize);
+		~FScratchArena();
+
+		FScratchArena(const FScratchArena&) = delete;
+		FScratchArena& operator=(const FScratchArena&) = delete;
+
+		/** Size bytes aligned to Alignment, a power of two, valid until the arena is rewound past them. Null when the heap is exhausted. */
+		void* Allocate(size_t Size, size_t Alignment = MinAlignment);
+
+		/** Uninitialized storage for Count elements of T, which is not destroyed on rewind. */
+		template <typename T>
+		T* AllocateArray(size_t Count)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "scratch arrays are never destroyed");
+			return static_cast<T*>(Allocate(sizeof(T) * Count, alignof(T) > MinAlignment ? alignof(T) : MinAlignment));
+		}
+
+		FMark GetMark() const { return FMark{ CurrentBlock, Offset }; }
+
+		/** Release everything allocated since Mark was taken. */
+		void Rewind(const FMark& Mark);
+
+		/** Release everything, merging the blocks into one. */
+		void Reset() { Rewind(FMark()); }
+
+		size_t GetBytesUsed() const;
+		size_t GetCapacity() const;
+
+		/** Most bytes in use at once since the arena was created. */
+		size_t GetPeakBytesUsed() const { return PeakBytesUsed; }
+
+		/** Heap allocations the arena made for its blocks. */
+		int64_t GetNumHeapAllocations() const { return NumHeapAllocations; }
+
+	private:
+		struct FBlock
+		{
+			char* Data = nullptr;
+			size_t Size = 0;
+		};
+
+		bool AddBlock(size_t MinSize);
+
+		// the vector's own storage is reserved up front, so adding a block costs the block's allocation only
+		std::vector<FBlock> Blocks;
+		size_t CurrentBlock = 0;
+		size_t Offset = 0;
+
+		// bytes used in the blocks before CurrentBlock, counting what was left at their ends
+		size_t BytesBeforeBlock = 0;
+
+		size_t PeakBytesUsed = 0;
+		int64_t NumHeapAllocations = 0;
+	};
+
+	/** Opens a scratch scope on Arena, everything allocated from it while the scope is open is released when it closes. */
+	class FScratchScope
+	{
+	public:
+		explicit FScratchScope(FScratchArena& InArena)
+			: Arena(InArena)
+			, Mark(InArena.GetMark())
+		{
+		}
+
+		~FScratchScope()
+		{
+			Arena.Rewind(Mark);
+		}
+
+		FScratchScope(const FScratchScope&) = delete;
+		FScratchScope& operator=(const FScratchScope&) = delete;
+
+		FScratchArena& GetArena() const { return Arena; }
+
+	private:
+		FScratchArena& Arena;
+		FScratchArena::FMark Mark;
+	};
+
+	/** Scratch arena of the calling thread, created on its first use. The solvers take their temporaries from it. */
+	IKCORE_API FScratchArena& GetThreadScratchArena();
+
+	/**
+	 * Heap allocations made by the scratch arenas and the threads' own Jacobian workspaces since the start of the process.
+	 * Steady state solving leaves it unchanged; a frame that moves it has grown a buffer.
+	 */
+	IKCORE_API int64_t GetNumScratchHeapAllocations();
+
+	/** Count heap allocations of solver scratch made outside an arena, e.g. when a thread's temporary workspace grows. */
+	IKCORE_API void AddScratchHeapAllocations(int64_t NumAllocations);
+}
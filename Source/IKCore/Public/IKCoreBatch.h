@@ -0,0 +1,77 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+
+namespace IKCore
+{
+	enum class ESimdLevel : uint8_t
+	{
+		Scalar,
+		SSE,
+		AVX2,
+		AVX512,
+	};
+
+	/** Widest instruction set the running CPU and OS support, detected once. */
+	IKCORE_API ESimdLevel GetSupportedSimdLevel();
+
+	/** Number of chains a batch kernel solves side by side at SimdLevel. */
+	IKCORE_API int32_t GetSimdWidth(ESimdLevel SimdLevel);
+
+	/**
+	 * Many chains with the same number of bones, stored as structure of arrays with the chains interleaved:
+	 * coordinate X of bone B of chain C is PositionX[B * Stride + C], and likewise for every other per bone array.
+	 * Stride is NumChains rounded up to the widest SIMD width; the padding lanes stay zero and are never solved.
+	 */
+	struct IKCORE_API FChainBatch
+	{
+		int32_t NumChains = 0;
+		int32_t NumBones = 0;
+		int32_t Stride = 0;
+
+		TAlignedArray<float> PositionX;
+		TAlignedArray<float> PositionY;
+		TAlignedArray<float> PositionZ;
+
+		// length of the link between bone i and bone i + 1, NumBones - 1 rows
+		TAlignedArray<float> Lengths;
+
+		TAlignedArray<float> TargetX;
+		TAlignedArray<float> TargetY;
+		TAlignedArray<float> TargetZ;
+
+		// per chain result of the last solve
+		TAlignedArray<float> Residuals;
+		TAlignedArray<int32_t> Iterations;
+
+		/** Resize for InNumChains chains of InNumBones bones and zero every array. */
+		void Reset(int32_t InNumChains, int32_t InNumBones);
+
+		/** Copy the positions and link lengths of Pose into chain Chain and set its target. Joint limits are not carried over. */
+		void SetChain(int32_t Chain, const FPose& Pose, const Eigen::Vector3f& Target);
+
+		/** Copy the solved positions of chain Chain into Pose and rebuild its rotations from them. */
+		void GetChain(int32_t Chain, FPose& Pose) const;
+
+		/** Iterations, residual and convergence of chain Chain, as the single chain solvers report them. */
+		FSolveResult GetResult(int32_t Chain, const FSolverSettings& Settings) const;
+	};
+
+	/**
+	 * FABRIK on every chain of Batch, SimdLevel chains wide (clamped to GetSupportedSimdLevel()).
+	 * Each lane stops moving as soon as its own tip is within Settings.Precision, the others carry on
+	 * until they converge too or Settings.MaxIterations is hit.
+	 */
+	IKCORE_API void SolveFABRIKBatch(FChainBatch& Batch, const FSolverSettings& Settings, ESimdLevel SimdLevel);
+	IKCORE_API void SolveFABRIKBatch(FChainBatch& Batch, const FSolverSettings& Settings);
+
+	/**
+	 * CCD on every chain of Batch, SimdLevel chains wide, with the same per lane convergence as SolveFABRIKBatch.
+	 * The joint rotations are built and chained as quaternions only; GetChain rebuilds the pose rotations from the
+	 * solved positions, so unlike SolveCCD the twist about each link is not carried through.
+	 */
+	IKCORE_API void SolveCCDBatch(FChainBatch& Batch, const FSolverSettings& Settings, ESimdLevel SimdLevel);
+	IKCORE_API void SolveCCDBatch(FChainBatch& Batch, const FSolverSettings& Settings);
+}
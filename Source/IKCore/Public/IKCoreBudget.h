@@ -0,0 +1,101 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+
+namespace IKCore
+{
+	/** Quality levels of a character's IK, from the most to the least expensive. */
+	enum class ELODTier : uint8_t
+	{
+		// the solver settings as given
+		Full,
+
+		// MaxIterations capped at FBudgetSettings::ReducedMaxIterations
+		Reduced,
+
+		// full settings, solved once every FBudgetSettings::IntervalFrames frames and interpolated in between
+		Interval,
+
+		// closed form two-bone solves, a single iteration for longer chains
+		AnalyticOnly,
+
+		Num,
+	};
+
+	struct FBudgetSettings
+	{
+		// IK time per frame the tiers are assigned to fit in
+		double BudgetSeconds = 0.0015;
+
+		int32_t ReducedMaxIterations = 3;
+		int32_t IntervalFrames = 4;
+
+		// weight of the last frame's measured cost in the per tier cost estimates
+		float CostSmoothing = 0.25f;
+	};
+
+	/** Projected size of a character on screen (its bounds radius over the half height of the view) scaled by a gameplay priority. */
+	IKCORE_API float ComputeSignificance(float Distance, float BoundsRadius, float TanHalfFOV, float Priority);
+
+	/** Solver settings of Tier derived from the full quality ones. */
+	IKCORE_API FSolverSettings GetTierSettings(ELODTier Tier, const FSolverSettings& FullSettings, const FBudgetSettings& BudgetSettings);
+
+	/**
+	 * Assigns the frame's IK budget to characters. Each frame the characters are added with their significance and
+	 * number of chains, AssignTiers ranks them and gives each, in order of significance, the best tier whose estimated cost
+	 * still fits once every less significant character is budgeted at the cheapest tier (the fallback when nothing fits). The per chain cost of each tier
+	 * follows the solve times reported since the last assignment, so the tiers adapt to the actual solver load.
+	 * Not thread safe.
+	 */
+	class IKCORE_API FFrameBudget
+	{
+	public:
+		FFrameBudget();
+
+		/** Clear the requests for a new frame. */
+		void BeginFrame(const FBudgetSettings& InSettings);
+
+		/** Register a character for this frame, returns its index for GetTier. */
+		int32_t AddRequest(float Significance, int32_t NumChains);
+
+		/** Fold the solve times reported since the last assignment into the cost estimates and rank the requests. */
+		void AssignTiers();
+
+		ELODTier GetTier(int32_t RequestIndex) const { return Requests[RequestIndex].Tier; }
+		int32_t GetNumRequests() const { return static_cast<int32_t>(Requests.size()); }
+		int32_t GetNumInTier(ELODTier Tier) const { return NumInTier[static_cast<int32_t>(Tier)]; }
+
+		/** Time one chain solve took in Tier; Interval tier frames that only interpolate are reported too. */
+		void ReportSolve(ELODTier Tier, double Seconds);
+
+		/** Estimated time of one chain solve in Tier. */
+		double GetEstimatedSeconds(ELODTier Tier) const { return EstimatedSeconds[static_cast<int32_t>(Tier)]; }
+
+		/** Estimated IK time of the last assignment. */
+		double GetPlannedSeconds() const { return PlannedSeconds; }
+
+		const FBudgetSettings& GetSettings() const { return Settings; }
+
+	private:
+		struct FRequest
+		{
+			float Significance = 0.f;
+			int32_t NumChains = 0;
+			ELODTier Tier = ELODTier::Full;
+		};
+
+		static constexpr int32_t NumTiers = static_cast<int32_t>(ELODTier::Num);
+
+		FBudgetSettings Settings;
+		std::vector<FRequest> Requests;
+		std::vector<int32_t> SortedRequests;
+
+		double EstimatedSeconds[NumTiers];
+		double ReportedSeconds[NumTiers] = {};
+		int32_t NumReported[NumTiers] = {};
+		int32_t NumInTier[NumTiers] = {};
+		double PlannedSeconds = 0.0;
+	};
+}
@@ -0,0 +1,160 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+
+#include <vector>
+
+namespace IKCore
+{
+	/** Segment traced against the environment for one effector, e.g. from above a foot to below it. */
+	struct FGroundProbe
+	{
+		Eigen::Vector3f Start = Eigen::Vector3f::Zero();
+		Eigen::Vector3f End = Eigen::Vector3f::Zero();
+
+		// object whose own geometry the backend ignores, e.g. the character probing; backends may not know what it is
+		const void* IgnoredOwner = nullptr;
+	};
+
+	/** First surface along a probe. */
+	struct FGroundHit
+	{
+		Eigen::Vector3f Location = Eigen::Vector3f::Zero();
+		Eigen::Vector3f Normal = Eigen::Vector3f::UnitZ();
+		bool bHit = false;
+	};
+
+	/**
+	 * Where the probes are traced: the engine's physics scene, or a stand-in such as FHeightfieldGroundQuery.
+	 * A batch is submitted once per frame and fetched on a later frame, so the backend may trace it asynchronously.
+	 */
+	class IGroundQueryBackend
+	{
+	public:
+		virtual ~IGroundQueryBackend() = default;
+
+		/** Start tracing NumProbes probes, copying what is needed. A batch not fetched yet is abandoned. */
+		virtual void Submit(const FGroundProbe* Probes, int32_t NumProbes) = 0;
+
+		/** Hits of the last submitted batch into OutHits, in probe order; false while the batch is still running. */
+		virtual bool Fetch(FGroundHit* OutHits, int32_t NumProbes) = 0;
+	};
+
+	/**
+	 * In-memory heightfield with Z up, tracing every batch when it is submitted. The standalone stand-in for the engine's
+	 * scene queries, for benchmarks and tools.
+	 */
+	class IKCORE_API FHeightfieldGroundQuery : public IGroundQueryBackend
+	{
+	public:
+		/** NumX * NumY heights, row by row along X, the samples CellSize apart from Origin (the height of which is added). */
+		void SetHeights(const Eigen::Vector3f& Origin, float CellSize, int32_t NumX, int32_t NumY, const std::vector<float>& Heights);
+
+		/** Height at X, Y interpolated between the four samples around it, clamped to the edges of the field. */
+		float GetHeight(float X, float Y) const;
+
+		Eigen::Vector3f GetNormal(float X, float Y) const;
+
+		/** First crossing of the probe with the surface, a hit at the start when the probe starts below it. */
+		FGroundHit Trace(const FGroundProbe& Probe) const;
+
+		// IGroundQueryBackend interface
+		virtual void Submit(const FGroundProbe* Probes, int32_t NumProbes) override;
+		virtual bool Fetch(FGroundHit* OutHits, int32_t NumProbes) override;
+		// End of IGroundQueryBackend interface
+
+	private:
+		float GetSample(int32_t X, int32_t Y) const;
+
+		Eigen::Vector3f Origin = Eigen::Vector3f::Zero();
+		float CellSize = 1.f;
+		int32_t NumX = 0;
+		int32_t NumY = 0;
+		std::vector<float> Heights;
+
+		std::vector<FGroundHit> Hits;
+	};
+
+	/**
+	 * The probes of every character of a frame, sent to the backend as one batch and read back on the next frame, so the
+	 * trace latency hides behind the frame and its cost is shared by all of them. Each frame: characters Add their probes
+	 * and read the hits of the probes they added the frame before with GetHits, then Submit sends the new batch.
+	 * Not thread safe.
+	 */
+	class IKCORE_API FGroundProbeQueue
+	{
+	public:
+		void SetBackend(IGroundQueryBackend* InBackend) { Backend = InBackend; }
+		IGroundQueryBackend* GetBackend() const { return Backend; }
+
+		/** Queue probes for the next batch, returning the index of the first one in it. */
+		int32_t Add(const FGroundProbe* Probes, int32_t NumProbes);
+
+		/** Send the probes added since the last Submit. The hits of the batch before are dropped. */
+		void Submit();
+
+		/** Read the hits of the submitted batch from the backend if it has finished. Returns whether they are available. */
+		bool Collect();
+
+		/**
+		 * Hits of probes FirstIndex to FirstIndex + NumProbes - 1 of the submitted batch, collecting it first.
+		 * Null while the batch is running or when it has no such probes.
+		 */
+		const FGroundHit* GetHits(int32_t FirstIndex, int32_t NumProbes);
+
+		int32_t GetNumQueued() const { return static_cast<int32_t>(Queued.size()); }
+		int32_t GetNumSubmitted() const { return NumSubmitted; }
+
+	private:
+		IGroundQueryBackend* Backend = nullptr;
+
+		// probes of the batch being built, and the hits of the one in flight once it came back
+		std::vector<FGroundProbe> Queued;
+		std::vector<FGroundHit> Hits;
+		int32_t NumSubmitted = 0;
+		bool bCollected = false;
+	};
+
+	struct FFootPlacementSettings
+	{
+		// probes start this far above the animated foot and end this far below it
+		float ProbeAbove = 50.f;
+		float ProbeBelow = 75.f;
+
+		// height of the foot bone over the ground in the animated pose, kept over the ground that was hit
+		float FootHeight = 0.f;
+
+		// time for a foot to cover half of the way to the height of new ground, zero snaps it there
+		float SmoothingHalfLife = 0.05f;
+	};
+
+	/**
+	 * Foot targets of one character from ground probes: every foot keeps its animated position and is raised or lowered
+	 * to the ground below it, smoothly, so steps and slopes do not make it pop. The probes of a frame are answered on the
+	 * next one, when their hits are applied to that frame's animated feet.
+	 */
+	class IKCORE_API FFootPlacement
+	{
+	public:
+		void Reset(int32_t InNumFeet);
+		int32_t GetNumFeet() const { return static_cast<int32_t>(Offsets.size()); }
+
+		/** One probe per foot through its animated location FootLocations[i], along -Up. */
+		void MakeProbes(const Eigen::Vector3f* FootLocations, const Eigen::Vector3f& Up, const FFootPlacementSettings& Settings, const void* IgnoredOwner, FGroundProbe* OutProbes) const;
+
+		/**
+		 * Targets of the feet at FootLocations, from Hits of the probes made a frame earlier, or null when none came back,
+		 * which eases the feet back to their animated height. Missed probes do the same for their foot.
+		 */
+		void Update(const FGroundHit* Hits, const Eigen::Vector3f* FootLocations, const Eigen::Vector3f& Up, const FFootPlacementSettings& Settings, float DeltaSeconds,
+			Eigen::Vector3f* OutTargets);
+
+		/** Smoothed offset of foot Index from its animated position along Up. */
+		float GetOffset(int32_t Index) const { return Offsets[Index]; }
+
+	private:
+		std::vector<float> Offsets;
+	};
+}
@@ -0,0 +1,549 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+#include "IKCoreStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace IKCore
+{
+	/**
+	 * Jacobian solvers whose matrices are sized at compile time for a chain of NumLinks links.
+	 * TJacobianSolver<Eigen::Dynamic> is the fallback for other lengths; it allocates in Resize only, so keeping one
+	 * around per chain makes steady state solving allocation free.
+	 * NumTaskRows is 3 for position targets and 6 for position and orientation targets (SolveTransform). Every linear
+	 * solve happens in that 3 x 3 or 6 x 6 task space, whatever the length of the chain.
+	 */
+	template <int NumLinks, int NumTaskRows = 3>
+	class TJacobianSolver
+	{
+		static_assert(NumTaskRows == 3 || NumTaskRows == 6, "the task is the tip position, or its position and orientation");
+
+	public:
+		static constexpr int NumColumns = NumLinks == Eigen::Dynamic ? Eigen::Dynamic : NumLinks * 3;
+		static constexpr int NumBones = NumLinks == Eigen::Dynamic ? Eigen::Dynamic : NumLinks + 1;
+
+		using FJacobianMatrix = Eigen::Matrix<float, NumTaskRows, NumColumns>;
+		using FDeltaVector = Eigen::Matrix<float, NumColumns, 1>;
+		using FTaskVector = Eigen::Matrix<float, NumTaskRows, 1>;
+		using FTaskMatrix = Eigen::Matrix<float, NumTaskRows, NumTaskRows>;
+
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+		explicit TJacobianSolver(int32_t InNumLinks = NumLinks == Eigen::Dynamic ? 0 : NumLinks)
+		{
+			Resize(InNumLinks);
+		}
+
+		void Resize(int32_t InNumLinks)
+		{
+			const int32_t Columns = InNumLinks * 3;
+			if (NumLinks == Eigen::Dynamic && JacobianMat.cols() != Columns)
+			{
+				JacobianMat.resize(NumTaskRows, Columns);
+				ConstrainedJacobianMat.resize(NumTaskRows, Columns);
+				DeltaRotation.resize(Columns);
+				ClampedDeltaRotation.resize(Columns);
+				ClampedMask.resize(Columns);
+				SavedPositions.resize(3, InNumLinks + 1);
+				SavedRotations.resize(4, InNumLinks + 1);
+			}
+		}
+
+		FSolveResult SolveTranspose(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings)
+		{
+			static_assert(NumTaskRows == 3, "position targets need the 3-row solver");
+			FSolveResult Result;
+			float Distance = Pose.TipDistance(Target);
+			bool bJacobianValid = false;
+			bool bJacobianExact = false;
+			while (Distance > Settings.Precision && Result.Iterations < Settings.MaxIterations)
+			{
+				++Result.Iterations;
+				if (!bJacobianValid)
+				{
+					BuildJacobian(Pose);
+					bJacobianValid = bJacobianExact = true;
+				}
+				if (!ComputeStep(Pose, Target - Pose.TipPosition(), true, 0.f))
+				{
+					// an updated Jacobian may have drifted degenerate where the chain is not
+					if (bJacobianExact)
+					{
+						break;
+					}
+					bJacobianValid = false;
+					continue;
+				}
+
+				// apply the result
+				const Eigen::Vector3f LastTip = Pose.TipPosition();
+				ApplyDeltaRotation(Pose);
+				const float NewDistance = Pose.TipDistance(Target);
+				bJacobianValid = Settings.bBroydenUpdates && UpdateJacobian(Pose.TipPosition() - LastTip, NewDistance, Distance);
+				bJacobianExact = false;
+				Distance = NewDistance;
+			}
+
+			Result.Residual = Distance;
+			Result.bConverged = Distance <= Settings.Precision;
+			return Result;
+		}
+
+		/** Right pseudo-inverse J^T (J J^T)^-1 e, i.e. damped least squares without damping. */
+		FSolveResult SolvePinv(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings)
+		{
+			static_assert(NumTaskRows == 3, "position targets need the 3-row solver");
+			FSolveResult Result;
+			float Distance = Pose.TipDistance(Target);
+			bool bJacobianValid = false;
+			bool bJacobianExact = false;
+			while (Distance > Settings.Precision && Result.Iterations < Settings.MaxIterations)
+			{
+				++Result.Iterations;
+				if (!bJacobianValid)
+				{
+					BuildJacobian(Pose);
+					bJacobianValid = bJacobianExact = true;
+				}
+				if (!ComputeStep(Pose, Target - Pose.TipPosition(), false, 0.f))
+				{
+					if (bJacobianExact)
+					{
+						break;
+					}
+					bJacobianValid = false;
+					continue;
+				}
+
+				// apply the result
+				const Eigen::Vector3f LastTip = Pose.TipPosition();
+				ApplyDeltaRotation(Pose);
+				const float NewDistance = Pose.TipDistance(Target);
+				bJacobianValid = Settings.bBroydenUpdates && UpdateJacobian(Pose.TipPosition() - LastTip, NewDistance, Distance);
+				bJacobianExact = false;
+				Distance = NewDistance;
+			}
+
+			Result.Residual = Distance;
+			Result.bConverged = Distance <= Settings.Precision;
+			return Result;
+		}
+
+		/**
+		 * Damped least squares J^T (J J^T + lambda^2 I)^-1 e.
+		 * With Settings.bAdaptiveDamping this is Levenberg-Marquardt: a step that does not reduce the residual is
+		 * rolled back and retried with more damping, an accepted step lowers the damping for the next one. With
+		 * Settings.bBroydenUpdates a rejected step taken on an updated Jacobian is retried on a rebuilt one first.
+		 */
+		FSolveResult SolveDampedLeastSquares(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings)
+		{
+			static_assert(NumTaskRows == 3, "position targets need the 3-row solver");
+			FSolveResult Result;
+			float Damping = Settings.Damping;
+			float Distance = Pose.TipDistance(Target);
+			bool bJacobianValid = false;
+			bool bJacobianExact = false;
+			while (Distance > Settings.Precision && Result.Iterations < Settings.MaxIterations)
+			{
+				++Result.Iterations;
+				if (!bJacobianValid)
+				{
+					BuildJacobian(Pose);
+					bJacobianValid = bJacobianExact = true;
+				}
+				if (!ComputeStep(Pose, Target - Pose.TipPosition(), false, Damping))
+				{
+					if (bJacobianExact)
+					{
+						break;
+					}
+					bJacobianValid = false;
+					continue;
+				}
+
+				const Eigen::Vector3f LastTip = Pose.TipPosition();
+				if (!Settings.bAdaptiveDamping)
+				{
+					ApplyDeltaRotation(Pose);
+					const float NewDistance = Pose.TipDistance(Target);
+					bJacobianValid = Settings.bBroydenUpdates && UpdateJacobian(Pose.TipPosition() - LastTip, NewDistance, Distance);
+					bJacobianExact = false;
+					Distance = NewDistance;
+					continue;
+				}
+
+				SavePose(Pose);
+				ApplyDeltaRotation(Pose);
+				const float NewDistance = Pose.TipDistance(Target);
+				if (NewDistance < Distance)
+				{
+					bJacobianValid = Settings.bBroydenUpdates && UpdateJacobian(Pose.TipPosition() - LastTip, NewDistance, Distance);
+					bJacobianExact = false;
+					Distance = NewDistance;
+					Damping = std::max(Damping * DampingDecrease, Settings.MinDamping);
+				}
+				else
+				{
+					// the Jacobian is still the one of the restored pose, unless it was an estimate, which is blamed first
+					RestorePose(Pose);
+					if (!bJacobianExact)
+					{
+						bJacobianValid = false;
+						continue;
+					}
+					Damping *= DampingIncrease;
+					if (Damping > Settings.MaxDamping)
+					{
+						break;
+					}
+				}
+			}
+
+			Result.Residual = Distance;
+			Result.bConverged = Distance <= Settings.Precision;
+			return Result;
+		}
+
+		/**
+		 * Position and orientation of the tip on the 6-row Jacobian, its rows scaled by Target's weights, until the tip is
+		 * within Settings.Precision of Target.Position and Settings.AnglePrecision of Target.Rotation.
+		 * Solver picks the step as for position targets: JacobianTranspose takes transpose steps, JacobianPinv plain
+		 * Gauss-Newton steps and DampedLeastSquares damped ones, Levenberg-Marquardt with Settings.bAdaptiveDamping.
+		 * The tip bone turns with its parent link, so a grip that should turn the hand ends the chain one bone past the wrist.
+		 */
+		FSolveResult SolveTransform(ESolver Solver, FPose& Pose, const FTransformTarget& Target, const FSolverSettings& Settings)
+		{
+			static_assert(NumTaskRows == 6, "orientation targets need the 6-row solver");
+			FSolveResult Result;
+			const bool bDamped = Solver == ESolver::DampedLeastSquares;
+			const bool bAdaptive = bDamped && Settings.bAdaptiveDamping;
+			float Damping = bDamped ? Settings.Damping : 0.f;
+
+			const FTaskVector Weights = GetTaskWeights(Target);
+			FTaskVector Error = ComputeTaskError(Pose, Target);
+			float Distance = Pose.TipDistance(Target.Position);
+			float Angle = Error.template tail<3>().norm();
+			bool bJacobianValid = false;
+			bool bJacobianExact = false;
+			while ((Distance > Settings.Precision || Angle > Settings.AnglePrecision) && Result.Iterations < Settings.MaxIterations)
+			{
+				++Result.Iterations;
+				if (!bJacobianValid)
+				{
+					BuildJacobian(Pose, &Target);
+					bJacobianValid = bJacobianExact = true;
+				}
+				const FTaskVector WeightedError = Error.cwiseProduct(Weights);
+				if (!ComputeStep(Pose, WeightedError, Solver == ESolver::JacobianTranspose, Damping))
+				{
+					if (bJacobianExact)
+					{
+						break;
+					}
+					bJacobianValid = false;
+					continue;
+				}
+
+				if (bAdaptive)
+				{
+					SavePose(Pose);
+				}
+				ApplyDeltaRotation(Pose);
+				const FTaskVector NewError = ComputeTaskError(Pose, Target);
+				const FTaskVector NewWeightedError = NewError.cwiseProduct(Weights);
+				const float Residual = WeightedError.norm();
+				const float NewResidual = NewWeightedError.norm();
+				if (bAdaptive && NewResidual >= Residual)
+				{
+					// the Jacobian is still the one of the restored pose, unless it was an estimate, which is blamed first
+					RestorePose(Pose);
+					if (!bJacobianExact)
+					{
+						bJacobianValid = false;
+						continue;
+					}
+					Damping *= DampingIncrease;
+					if (Damping > Settings.MaxDamping)
+					{
+						break;
+					}
+					continue;
+				}
+
+				// the error is the target minus the tip, so the tip moved by what the error lost
+				bJacobianValid = Settings.bBroydenUpdates && UpdateJacobian(WeightedError - NewWeightedError, NewResidual, Residual);
+				bJacobianExact = false;
+				Error = NewError;
+				if (bAdaptive)
+				{
+					Damping = std::max(Damping * DampingDecrease, Settings.MinDamping);
+				}
+				Distance = Pose.TipDistance(Target.Position);
+				Angle = Error.template tail<3>().norm();
+			}
+
+			Result.Residual = Distance;
+			Result.AngleResidual = Angle;
+			Result.bConverged = Distance <= Settings.Precision && Angle <= Settings.AnglePrecision;
+			return Result;
+		}
+
+	private:
+		static constexpr float DampingDecrease = 0.5f;
+		static constexpr float DampingIncrease = 4.f;
+
+		// radians a bone's turn may lose to its limits before the bone counts as boxed in
+		static constexpr float ClampTolerance = 1e-4f;
+
+		// an updated Jacobian is kept while each step leaves at most this fraction of the residual, Gauss-Newton does better
+		static constexpr float BroydenStallRatio = 0.25f;
+
+		/**
+		 * Broyden's rank-1 correction after the step DeltaRotation moved the task by TaskChange: J += (c - J d) d^T / d^T d,
+		 * so that J maps the step onto what it actually did, instead of the bone locations and axes being queried again.
+		 * Returns false, for the Jacobian to be rebuilt, when the step left more than BroydenStallRatio of the residual, or
+		 * when joint limits clamped it, as DeltaRotation is then not the step the bones took.
+		 */
+		bool UpdateJacobian(const FTaskVector& TaskChange, float NewResidual, float Residual)
+		{
+			const float StepSquaredNorm = DeltaRotation.squaredNorm();
+			if (NewResidual > BroydenStallRatio * Residual || StepSquaredNorm <= 0.f || bStepClamped)
+			{
+				return false;
+			}
+
+			IKCORE_SCOPE_PHASE(JacobianAssembly);
+			const FTaskVector Mismatch = (TaskChange - JacobianMat * DeltaRotation) / StepSquaredNorm;
+			JacobianMat.noalias() += Mismatch * DeltaRotation.transpose();
+			return true;
+		}
+
+		/**
+		 * Position Jacobian of the tip w.r.t. rotations about each bone's local X, Y and Z axes. The 6-row Jacobian adds the
+		 * tip's angular velocity below, which is the axis itself, and scales every row by Target's weights.
+		 */
+		void BuildJacobian(const FPose& Pose, const FTransformTarget* Target = nullptr)
+		{
+			IKCORE_SCOPE_PHASE(JacobianAssembly);
+			const Eigen::Vector3f& TipLocation = Pose.TipPosition();
+			for (int32_t Index = 0; Index < Pose.NumLinks(); ++Index)
+			{
+				const Eigen::Vector3f ToTip = TipLocation - Pose.Positions[Index];
+				const Eigen::Matrix3f RotAxes = Pose.Rotations[Index].toRotationMatrix();
+				for (int Axis = 0; Axis < 3; ++Axis)
+				{
+					JacobianMat.template block<3, 1>(0, Index * 3 + Axis) = RotAxes.col(Axis).cross(ToTip);
+					if (NumTaskRows == 6)
+					{
+						JacobianMat.template block<3, 1>(NumTaskRows - 3, Index * 3 + Axis) = RotAxes.col(Axis);
+					}
+				}
+			}
+			if (Target != nullptr)
+			{
+				JacobianMat.array().colwise() *= GetTaskWeights(*Target).array();
+			}
+		}
+
+		/** Unweighted error of the 6-row task: position offset, then rotation vector to the target rotation. */
+		static FTaskVector ComputeTaskError(const FPose& Pose, const FTransformTarget& Target)
+		{
+			FTaskVector Error;
+			Error.template head<3>() = Target.Position - Pose.TipPosition();
+			Error.template tail<3>() = Pose.TipRotationError(Target.Rotation);
+			return Error;
+		}
+
+		static FTaskVector GetTaskWeights(const FTransformTarget& Target)
+		{
+			FTaskVector Weights;
+			Weights.template head<3>() = Target.PositionWeights;
+			Weights.template tail<3>() = Target.RotationWeights;
+			return Weights;
+		}
+
+		/**
+		 * The step towards EffectorDerivatives, a transpose step or a damped one. With joint limits the bones it would take
+		 * past their limits are boxed in: each moves only as far as its limit, its columns leave the Jacobian and the rest of
+		 * the task is solved again on the free bones, one more 3 x 3 or 6 x 6 solve rather than another iteration.
+		 */
+		bool ComputeStep(const FPose& Pose, const FTaskVector& EffectorDerivatives, bool bTranspose, float Damping)
+		{
+			bStepClamped = false;
+			if (!(bTranspose ? ComputeTransposeStep(JacobianMat, EffectorDerivatives) : ComputeDampedStep(JacobianMat, EffectorDerivatives, Damping)))
+			{
+				return false;
+			}
+			if (!Pose.HasJointLimits())
+			{
+				return true;
+			}
+
+			FTaskVector RemainingDerivatives = EffectorDerivatives;
+			bool bClamped = false;
+			{
+				IKCORE_SCOPE_PHASE(LinearSolve);
+				ConstrainedJacobianMat = JacobianMat;
+				ClampedDeltaRotation.setZero();
+				ClampedMask.setZero();
+				Eigen::Quaternionf ParentRotation = Pose.RootParentRotation;
+				for (int32_t Index = 0; Index < Pose.NumLinks(); ++Index)
+				{
+					const Eigen::Quaternionf& Rotation = Pose.Rotations[Index];
+					const Eigen::Quaternionf LocalDelta = GetLocalDeltaRotation(Index);
+					const Eigen::Quaternionf Constrained = Pose.ConstrainRotation(Index, ParentRotation, Rotation * LocalDelta);
+					ParentRotation = Rotation;
+
+					Eigen::Quaternionf FeasibleDelta = Rotation.conjugate() * Constrained;
+					FeasibleDelta.coeffs() *= FeasibleDelta.w() < 0.f ? -1.f : 1.f;
+					if (FeasibleDelta.angularDistance(LocalDelta) <= ClampTolerance)
+					{
+						continue;
+					}
+
+					// the rotation vector of what is left of the bone's turn, as angles about its three axes to first order
+					const float SinHalfAngle = FeasibleDelta.vec().norm();
+					const Eigen::Vector3f FeasibleAngles = SinHalfAngle > 0.f
+						? Eigen::Vector3f(FeasibleDelta.vec() * (2.f * std::atan2(SinHalfAngle, FeasibleDelta.w()) / SinHalfAngle))
+						: Eigen::Vector3f::Zero();
+					RemainingDerivatives.noalias() -= JacobianMat.template block<NumTaskRows, 3>(0, Index * 3) * FeasibleAngles;
+					ConstrainedJacobianMat.template block<NumTaskRows, 3>(0, Index * 3).setZero();
+					ClampedDeltaRotation.template segment<3>(Index * 3) = FeasibleAngles;
+					ClampedMask.template segment<3>(Index * 3).setOnes();
+					bClamped = true;
+				}
+			}
+			if (!bClamped)
+			{
+				return true;
+			}
+			bStepClamped = true;
+
+			// a step that only pushes bones into their limits leaves them where they are
+			if (!(bTranspose ? ComputeTransposeStep(ConstrainedJacobianMat, RemainingDerivatives) : ComputeDampedStep(ConstrainedJacobianMat, RemainingDerivatives, Damping)))
+			{
+				DeltaRotation.setZero();
+			}
+			DeltaRotation = (ClampedMask.array() > 0.f).select(ClampedDeltaRotation, DeltaRotation);
+			return true;
+		}
+
+		/** DeltaRotation = alpha J^T e, with the step length alpha that best matches e after the J J^T projection. */
+		bool ComputeTransposeStep(const FJacobianMatrix& Jacobian, const FTaskVector& EffectorDerivatives)
+		{
+			IKCORE_SCOPE_PHASE(LinearSolve);
+			DeltaRotation.noalias() = Jacobian.transpose() * EffectorDerivatives;
+			const FTaskVector Step = Jacobian * DeltaRotation;
+			const float AlphaBottom = Step.dot(Step);
+			const float AlphaUp = EffectorDerivatives.dot(Step);
+			if (AlphaBottom <= 1e-8f)
+			{
+				return false;
+			}
+			DeltaRotation *= AlphaUp / AlphaBottom;
+			return true;
+		}
+
+		/** DeltaRotation = J^T (J J^T + Damping^2 I)^-1 e, a 3 x 3 or 6 x 6 solve. */
+		bool ComputeDampedStep(const FJacobianMatrix& Jacobian, const FTaskVector& EffectorDerivatives, float Damping)
+		{
+			IKCORE_SCOPE_PHASE(LinearSolve);
+			FTaskMatrix TaskSquare;
+			TaskSquare.noalias() = Jacobian * Jacobian.transpose();
+			TaskSquare.diagonal().array() += Damping * Damping;
+
+			const Eigen::LDLT<FTaskMatrix> TaskSquareLDLT(TaskSquare);
+			if (TaskSquareLDLT.info() != Eigen::Success || !TaskSquareLDLT.isPositive())
+			{
+				return false;
+			}
+			const FTaskVector TaskStep = TaskSquareLDLT.solve(EffectorDerivatives);
+			if (!TaskStep.allFinite())
+			{
+				return false;
+			}
+			DeltaRotation.noalias() = Jacobian.transpose() * TaskStep;
+			return true;
+		}
+
+		/** The turn of bone Index in its own frame, about its X, then Y, then Z axis. */
+		Eigen::Quaternionf GetLocalDeltaRotation(int32_t Index) const
+		{
+			return Eigen::Quaternionf(Eigen::AngleAxisf(DeltaRotation(Index * 3 + 2), Eigen::Vector3f::UnitZ())
+				* Eigen::AngleAxisf(DeltaRotation(Index * 3 + 1), Eigen::Vector3f::UnitY())
+				* Eigen::AngleAxisf(DeltaRotation(Index * 3), Eigen::Vector3f::UnitX()));
+		}
+
+		/**
+		 * Apply per-bone axis rotations as if from the tip towards the root, so that every pivot is still where the Jacobian
+		 * was taken, in a single prefix product pass down the chain. A bone's rotation relative to its parent only depends on
+		 * its own turn, which is clamped to its limits against the parent's rotation from before the pass.
+		 */
+		void ApplyDeltaRotation(FPose& Pose)
+		{
+			IKCORE_SCOPE_PHASE(PoseUpdate);
+			const bool bLimited = Pose.HasJointLimits();
+			Eigen::Quaternionf ParentRotation = Pose.RootParentRotation;
+			Pose.RotateBones(0, [this, &Pose, bLimited, &ParentRotation](int32_t Index)
+			{
+				const Eigen::Matrix3f RotAxes = Pose.Rotations[Index].toRotationMatrix();
+				const Eigen::AngleAxisf DeltaQuatX(DeltaRotation(Index * 3), RotAxes.col(0));
+				const Eigen::AngleAxisf DeltaQuatY(DeltaRotation(Index * 3 + 1), RotAxes.col(1));
+				const Eigen::AngleAxisf DeltaQuatZ(DeltaRotation(Index * 3 + 2), RotAxes.col(2));
+				Eigen::Quaternionf Delta(DeltaQuatZ * DeltaQuatY * DeltaQuatX);
+				if (bLimited)
+				{
+					const Eigen::Quaternionf Rotation = Pose.Rotations[Index];
+					const Eigen::Quaternionf Constrained = Pose.ConstrainRotation(Index, ParentRotation, Delta * Rotation);
+					bStepClamped |= Constrained.angularDistance(Delta * Rotation) > ClampTolerance;
+					Delta = (Constrained * Rotation.conjugate()).normalized();
+					ParentRotation = Rotation;
+				}
+				return Delta;
+			});
+		}
+
+		void SavePose(const FPose& Pose)
+		{
+			for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+			{
+				SavedPositions.col(Index) = Pose.Positions[Index];
+				SavedRotations.col(Index) = Pose.Rotations[Index].coeffs();
+			}
+		}
+
+		void RestorePose(FPose& Pose) const
+		{
+			for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+			{
+				Pose.Positions[Index] = SavedPositions.col(Index);
+				Pose.Rotations[Index].coeffs() = SavedRotations.col(Index);
+			}
+		}
+
+		FJacobianMatrix JacobianMat;
+		FDeltaVector DeltaRotation;
+
+		// the Jacobian without the columns of the bones boxed in by their limits, and what those bones still turn
+		FJacobianMatrix ConstrainedJacobianMat;
+		FDeltaVector ClampedDeltaRotation;
+		FDeltaVector ClampedMask;
+
+		// whether the limits changed the last step, in ComputeStep or when it was applied
+		bool bStepClamped = false;
+
+		// pose before a trial damped step, for the rollback
+		Eigen::Matrix<float, 3, NumBones> SavedPositions;
+		Eigen::Matrix<float, 4, NumBones> SavedRotations;
+	};
+
+	/** Per-chain scratch for chain lengths without a fixed-size solver. */
+	using FJacobianWorkspace = TJacobianSolver<Eigen::Dynamic>;
+
+	/** The same for position and orientation targets. */
+	using FTransformJacobianWorkspace = TJacobianSolver<Eigen::Dynamic, 6>;
+}
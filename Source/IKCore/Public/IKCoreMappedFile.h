@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace IKCore
+{
+	/**
+	 * Read only view of a whole file mapped into memory, the pages are loaded on first touch and shared by every process
+	 * mapping the same file. The view is page aligned.
+	 */
+	class IKCORE_API FMappedFile
+	{
+	public:
+		FMappedFile() = default;
+		~FMappedFile();
+
+		FMappedFile(const FMappedFile&) = delete;
+		FMappedFile& operator=(const FMappedFile&) = delete;
+
+		bool Open(const char* FilePath);
+		void Close();
+
+		bool IsOpen() const { return Data != nullptr; }
+		const void* GetData() const { return Data; }
+		size_t GetSize() const { return Size; }
+
+	private:
+		const void* Data = nullptr;
+		size_t Size = 0;
+	};
+}
@@ -0,0 +1,117 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+
+namespace IKCore
+{
+	/**
+	 * Pose of a bone tree laid out as flat arrays, every bone after its parent, bone 0 being the common root (e.g. pelvis).
+	 * Positions and rotations share one space, as in FPose.
+	 */
+	struct IKCORE_API FTreePose
+	{
+		std::vector<Eigen::Vector3f> Positions;
+		TAlignedArray<Eigen::Quaternionf> Rotations;
+
+		// index of each bone's parent in the tree, -1 for the root
+		std::vector<int32_t> Parents;
+
+		// current length of the link from bone i's parent to bone i, zero for the root
+		std::vector<float> Lengths;
+
+		int32_t Num() const { return static_cast<int32_t>(Positions.size()); }
+
+		/** Recompute Lengths from Positions. */
+		void UpdateLengths();
+	};
+
+	/** Tip of a multi-effector solve: the bone to move, where to, and how much it counts against the other effectors. */
+	struct FEffector
+	{
+		int32_t BoneIndex = 0;
+		Eigen::Vector3f Target = Eigen::Vector3f::Zero();
+		float Weight = 1.f;
+	};
+
+	/**
+	 * Scratch of the multi-effector solvers, sized on first use for a tree and its effectors; keeping one around per tree
+	 * makes steady state solving allocation free. The bones above a branch point are shared by every effector below it
+	 * and are solved once per iteration for all of them, instead of once per chain.
+	 */
+	class IKCORE_API FMultiEffectorWorkspace
+	{
+	public:
+		/**
+		 * Sub-base FABRIK: the forward pass runs from every effector up the tree and places a branch bone at the weighted
+		 * centroid of the positions its branches ask for; the backward pass runs from the fixed root down again and turns
+		 * a branch bone so that its children best match their forward pass positions, keeping the branch rigid.
+		 */
+		FSolveResult SolveFABRIK(FTreePose& Pose, const std::vector<FEffector>& Effectors, const FSolverSettings& Settings);
+
+		/**
+		 * Damped least squares on the effectors' stacked 3-row Jacobians, each weighted by the square root of its effector's
+		 * weight, with the adaptive damping of TJacobianSolver::SolveDampedLeastSquares. The linear solve is in the stacked task space,
+		 * 3 rows per effector whatever the size of the tree.
+		 */
+		FSolveResult SolveDampedLeastSquares(FTreePose& Pose, const std::vector<FEffector>& Effectors, const FSolverSettings& Settings);
+
+	private:
+		static constexpr float DampingDecrease = 0.5f;
+		static constexpr float DampingIncrease = 4.f;
+		static constexpr int32_t MaxRotationFitSteps = 8;
+
+		/** Check the tree and the effectors and derive the children lists and branch weights from them. */
+		bool Prepare(const FTreePose& Pose, const std::vector<FEffector>& Effectors);
+
+		float MaxEffectorDistance(const FTreePose& Pose, const std::vector<FEffector>& Effectors) const;
+		float WeightedError(const FTreePose& Pose, const std::vector<FEffector>& Effectors) const;
+
+		/** FABRIK backward pass: rotation of bone Index from the solve's start pose that best points it at its children. */
+		Eigen::Quaternionf ComputeBranchRotation(const FTreePose& Pose, int32_t Index) const;
+
+		void BuildJacobian(const FTreePose& Pose, const std::vector<FEffector>& Effectors);
+		bool ComputeDampedStep(float Damping);
+		void ApplyDeltaRotation(FTreePose& Pose);
+
+		// children of bone i are Children[ChildStart[i]] to Children[ChildStart[i + 1] - 1]
+		std::vector<int32_t> ChildStart;
+		std::vector<int32_t> Children;
+
+		// summed weight of the effectors at or below each bone, zero off every effector's path
+		std::vector<float> BranchWeights;
+
+		// effectors with a positive weight, the only ones solved for
+		std::vector<int32_t> ActiveEffectors;
+
+		// FABRIK: pose at the start of the solve, the sum of the positions asked for each bone and their weight
+		std::vector<Eigen::Vector3f> OriginalPositions;
+		TAlignedArray<Eigen::Quaternionf> OriginalRotations;
+		std::vector<Eigen::Vector3f> PositionSums;
+		std::vector<float> WeightSums;
+		TAlignedArray<Eigen::Quaternionf> DeltaRotations;
+
+		// damped least squares
+		Eigen::MatrixXf JacobianMat;
+		Eigen::VectorXf Error;
+		Eigen::VectorXf DeltaRotation;
+		Eigen::MatrixXf TaskSquare;
+		Eigen::LDLT<Eigen::MatrixXf> TaskSquareLDLT;
+		Eigen::VectorXf TaskStep;
+		std::vector<Eigen::Matrix3f> BoneAxes;
+		std::vector<Eigen::Vector3f> SavedPositions;
+		TAlignedArray<Eigen::Quaternionf> SavedRotations;
+	};
+
+	/**
+	 * Move every effector's bone towards its target in a single solve of the whole tree, until all of them are within
+	 * Settings.Precision or Settings.MaxIterations is hit. The residual is the largest effector distance.
+	 * The calling thread's workspace is used when Workspace is null.
+	 */
+	IKCORE_API FSolveResult SolveMultiEffectorFABRIK(FTreePose& Pose, const std::vector<FEffector>& Effectors, const FSolverSettings& Settings, FMultiEffectorWorkspace* Workspace = nullptr);
+	IKCORE_API FSolveResult SolveMultiEffectorDampedLeastSquares(FTreePose& Pose, const std::vector<FEffector>& Effectors, const FSolverSettings& Settings, FMultiEffectorWorkspace* Workspace = nullptr);
+
+	/** The Jacobian solvers, Pipeline and Auto map to the stacked damped least squares, every other one to sub-base FABRIK. */
+	IKCORE_API FSolveResult SolveMultiEffector(ESolver Solver, FTreePose& Pose, const std::vector<FEffector>& Effectors, const FSolverSettings& Settings, FMultiEffectorWorkspace* Workspace = nullptr);
+}
@@ -0,0 +1,109 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+#include "IKCoreMappedFile.h"
+
+#include <vector>
+
+namespace IKCore
+{
+	struct FPoseDatabaseBakeSettings
+	{
+		// targets solved, those the solver does not converge on are dropped
+		int32_t NumSamples = 4096;
+
+		// targets are spread evenly over the volume between these shares of the chain's reach around the root
+		float MinReachRatio = 0.1f;
+		float MaxReachRatio = 0.95f;
+
+		// the lookup grid has CellsPerAxis^3 cells over the cube around the root that holds the reach
+		int32_t CellsPerAxis = 16;
+
+		uint32_t Seed = 1;
+	};
+
+	/**
+	 * Converged solutions of one chain for targets spread over its reachable volume, to start a solve from the solution of
+	 * the nearest baked targets instead of a pose that may be far off, e.g. after a teleport, a snap or a new grab.
+	 * Targets and rotations are stored relative to the root bone's position and its parent's rotation, so one database
+	 * serves the chain wherever the animation puts it.
+	 *
+	 * The database is a single flat image, the same in memory and on disk: a 32 byte header ("IKPD", version, bone,
+	 * sample and grid cell counts, grid extent), the sample targets as float triplets, the rotations of every bone of
+	 * every sample as int16 quaternions scaled by 32767, and the first sample of each grid cell plus one past the last
+	 * as uint32, the samples being sorted by cell. Every array starts 8 byte aligned, all values are little endian.
+	 */
+	class IKCORE_API FPoseDatabase
+	{
+	public:
+		static constexpr uint32_t Version = 1;
+
+		// samples blended by SeedPose at most
+		static constexpr int32_t MaxNeighbours = 4;
+
+		/**
+		 * Solve RestPose towards BakeSettings.NumSamples targets, each from RestPose, and keep the converged solutions.
+		 * RestPose is taken to be in the frame of the root bone's parent. Returns false when no solve converged.
+		 */
+		bool Bake(const FPose& RestPose, ESolver Solver, const FSolverSettings& Settings, const FPoseDatabaseBakeSettings& BakeSettings);
+
+		bool Save(const char* FilePath) const;
+
+		/** Read a file written by Save into memory owned by the database. */
+		bool Load(const char* FilePath);
+
+		/** Map a file written by Save, nothing is copied and the pages are shared with other processes using it. */
+		bool Map(const char* FilePath);
+
+		/**
+		 * Use the image at Data, e.g. a mapped file, without copying it. Data must be 8 byte aligned and outlive the
+		 * database or the next Bake, Load, Map or Reset. Returns false, leaving the database empty, when the image is malformed.
+		 */
+		bool SetImage(const void* Data, size_t Size);
+
+		void Reset();
+
+		bool IsValid() const { return NumSamples > 0; }
+		int32_t GetNumBones() const { return NumBones; }
+		int32_t GetNumSamples() const { return NumSamples; }
+		const void* GetImage() const { return Image; }
+		size_t GetImageSize() const { return ImageSize; }
+
+		/**
+		 * Up to Count samples nearest LocalTarget (relative to the root, in the root parent's frame), closest first.
+		 * Returns how many were found.
+		 */
+		int32_t FindNearest(const Eigen::Vector3f& LocalTarget, int32_t Count, int32_t* OutSamples, float* OutDistances) const;
+
+		/**
+		 * Start Pose from the blend of the NumNeighbours samples nearest Target, weighted by inverse distance, when the
+		 * nearest baked target is closer to Target than the tip of Pose is. The baked rotations are applied with the
+		 * links of Pose, so bone offsets and lengths are kept. Returns whether Pose was changed.
+		 */
+		bool SeedPose(FPose& Pose, const Eigen::Vector3f& Target, const Eigen::Quaternionf& RootParentRotation, int32_t NumNeighbours = 1) const;
+
+	private:
+		void ClearView();
+		Eigen::Quaternionf GetRotation(int32_t Sample, int32_t Bone) const;
+
+		// image owned by the database after Bake or Load, 8 byte elements for the alignment
+		std::vector<uint64_t> OwnedImage;
+		FMappedFile MappedFile;
+
+		const void* Image = nullptr;
+		size_t ImageSize = 0;
+
+		int32_t NumBones = 0;
+		int32_t NumSamples = 0;
+		int32_t CellsPerAxis = 0;
+		float GridExtent = 0.f;
+		float CellSize = 0.f;
+
+		// views into the image
+		const float* Targets = nullptr;
+		const int16_t* Rotations = nullptr;
+		const uint32_t* CellStarts = nullptr;
+	};
+}
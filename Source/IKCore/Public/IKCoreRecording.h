@@ -0,0 +1,154 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace IKCore
+{
+	/** A chain of a recorded session: its reference pose, relative to the root bone's parent, and the settings it was solved with. */
+	struct IKCORE_API FRecordedChain
+	{
+		uint32_t Id = 0;
+		std::string Name;
+
+		float Precision = 1.f;
+		int32_t MaxIterations = 10;
+
+		// root first, in the frame of the root bone's parent
+		std::vector<Eigen::Vector3f> Positions;
+		TAlignedArray<Eigen::Quaternionf> Rotations;
+
+		int32_t Num() const { return static_cast<int32_t>(Positions.size()); }
+
+		/** The chain in pose space under a root parent at RootParentTranslation, RootParentRotation. */
+		void GetPose(const Eigen::Vector3f& RootParentTranslation, const Eigen::Quaternionf& RootParentRotation, FPose& OutPose) const;
+	};
+
+	/** The input of one solve of a recorded chain: where its root parent was and the target, both in pose space. */
+	struct FRecordedFrame
+	{
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+		Eigen::Quaternionf RootParentRotation = Eigen::Quaternionf::Identity();
+		Eigen::Vector3f RootParentTranslation = Eigen::Vector3f::Zero();
+		Eigen::Vector3f Target = Eigen::Vector3f::Zero();
+		uint64_t Frame = 0;
+		uint32_t ChainId = 0;
+	};
+
+	/**
+	 * Thread safe writer of recorded sessions, buffered in memory and written out by Flush like FTraceWriter.
+	 *
+	 * The file is "IKRC" and a uint32 version, then little endian chunks, either 'C' uint32 id, uint16 name length, the
+	 * name bytes, float precision, int32 max iterations, uint16 bone count and per bone the position and the x, y, z, w
+	 * rotation as floats, or 'F' uint64 frame, uint32 chain id, the root parent translation and x, y, z, w rotation and
+	 * the target as floats (53 bytes). A chain chunk always precedes the first frame using it. Nothing refers to the
+	 * end of the file, so a session can be read while it is written or from a truncated capture.
+	 */
+	class IKCORE_API FRecordingWriter
+	{
+	public:
+		static constexpr uint32_t Version = 1;
+
+		FRecordingWriter() = default;
+		~FRecordingWriter();
+
+		FRecordingWriter(const FRecordingWriter&) = delete;
+		FRecordingWriter& operator=(const FRecordingWriter&) = delete;
+
+		bool Open(const char* FilePath);
+		void Close();
+		bool IsOpen() const;
+
+		/**
+		 * Id of the chain called Name, registering it on first use with Pose, the chain in pose space under a root parent
+		 * at RootParentTranslation, RootParentRotation, as its reference pose. Ids only hold until the writer is opened again.
+		 */
+		uint32_t RegisterChain(const std::string& Name, const FPose& Pose, const Eigen::Vector3f& RootParentTranslation, const Eigen::Quaternionf& RootParentRotation,
+			const FSolverSettings& Settings);
+
+		void Write(const FRecordedFrame& Frame);
+
+		/**
+		 * Write Frame of the chain called Name, registered as by RegisterChain under Frame's root parent and the same lock
+		 * as the frame is queued, so that a recording restarted from another thread cannot leave the frame with the id
+		 * of a chain of the previous file.
+		 */
+		void Write(const FRecordedFrame& Frame, const std::string& Name, const FPose& Pose, const FSolverSettings& Settings);
+
+		void Flush();
+
+	private:
+		uint32_t RegisterChainLocked(const std::string& Name, const FPose& Pose, const Eigen::Vector3f& RootParentTranslation, const Eigen::Quaternionf& RootParentRotation,
+			const FSolverSettings& Settings);
+		void FlushLocked();
+
+		mutable std::mutex Mutex;
+		std::FILE* File = nullptr;
+
+		std::unordered_map<std::string, uint32_t> ChainIds;
+		std::vector<FRecordedChain> Chains;
+		size_t NumWrittenChains = 0;
+
+		std::vector<FRecordedFrame, Eigen::aligned_allocator<FRecordedFrame>> PendingFrames;
+		std::vector<char> Buffer;
+	};
+
+	/**
+	 * Streams a recorded session one frame at a time through a fixed size buffer, so a capture of any size is read in
+	 * constant memory. The chains are kept as their chunks come along.
+	 */
+	class IKCORE_API FRecordingReader
+	{
+	public:
+		FRecordingReader() = default;
+		~FRecordingReader();
+
+		FRecordingReader(const FRecordingReader&) = delete;
+		FRecordingReader& operator=(const FRecordingReader&) = delete;
+
+		bool Open(const char* FilePath);
+		void Close();
+		bool IsOpen() const { return File != nullptr; }
+
+		/** The next frame, taking in the chains defined before it. False at the end of the session or on a malformed chunk. */
+		bool Read(FRecordedFrame& OutFrame);
+
+		/** True when reading stopped at a malformed or truncated chunk rather than at the end of the file. */
+		bool HasError() const { return bError; }
+
+		/** Chain Id of the frames read so far, null when it was not defined yet. */
+		const FRecordedChain* FindChain(uint32_t Id) const;
+		int32_t GetNumChains() const { return static_cast<int32_t>(Chains.size()); }
+
+		uint64_t GetNumFramesRead() const { return NumFramesRead; }
+		uint64_t GetNumBytesRead() const { return NumBytesRead; }
+
+	private:
+		bool ReadBytes(void* Data, size_t Size);
+		bool ReadChain();
+
+		template <typename T>
+		bool ReadValue(T& Value)
+		{
+			return ReadBytes(&Value, sizeof(T));
+		}
+
+		std::FILE* File = nullptr;
+		std::vector<char> Buffer;
+		size_t BufferOffset = 0;
+		size_t BufferSize = 0;
+
+		std::vector<FRecordedChain> Chains;
+		uint64_t NumFramesRead = 0;
+		uint64_t NumBytesRead = 0;
+		bool bError = false;
+	};
+}
@@ -0,0 +1,125 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+#include "IKCoreRecording.h"
+#include "IKCoreSolveState.h"
+
+#include <vector>
+
+namespace IKCore
+{
+	/**
+	 * Non-negative samples counted in buckets a 32nd of an octave wide from 1e-4 to 1e6, so percentiles of any number of
+	 * samples are kept in constant memory, within 2.2% of the exact value, well inside the accuracy tolerance of the
+	 * replay's regression gates. Smaller samples share the first bucket.
+	 */
+	class IKCORE_API FLogHistogram
+	{
+	public:
+		FLogHistogram();
+
+		void Add(double Value);
+
+		/**
+		 * The Percentile (0 to 1) of the samples, interpolated within the bucket holding it as if its samples were spread
+		 * evenly on the log scale, never above the largest one.
+		 */
+		double GetPercentile(double Percentile) const;
+
+		int64_t GetNum() const { return Num; }
+		double GetMean() const { return Num > 0 ? Sum / static_cast<double>(Num) : 0.0; }
+		double GetMax() const { return Max; }
+
+	private:
+		std::vector<int64_t> Counts;
+		int64_t Num = 0;
+		double Sum = 0.0;
+		double Max = 0.0;
+	};
+
+	/** How one solver did on a replayed session. */
+	struct FReplayStats
+	{
+		ESolver Solver = ESolver::FABRIK;
+
+		int64_t NumSolves = 0;
+		int64_t NumSkipped = 0;
+		int64_t NumConverged = 0;
+		int64_t NumIterations = 0;
+		int32_t MaxIterations = 0;
+
+		// distance from the tip to the target after each solve
+		FLogHistogram Residuals;
+
+		// mean length of the second difference of the bone positions relative to the root parent, per solve of a chain
+		// solved on the two frames before too; the target's own motion sets a floor the same for every solver and run
+		FLogHistogram Jitter;
+
+		// time spent in the solves of every chain of a recorded frame
+		FLogHistogram FrameMicroseconds;
+		int64_t NumFrames = 0;
+		double Seconds = 0.0;
+	};
+
+	struct FReplaySettings
+	{
+		// what every chain remembers between its solves, as FChainSolveState does in the engine
+		FWarmStartSettings WarmStart;
+
+		// solve with Settings instead of the precision and the iteration cap each chain was recorded with
+		bool bOverrideSettings = false;
+		FSolverSettings Settings;
+	};
+
+	/**
+	 * Feeds recorded sessions through several solvers side by side: each recorded frame of a chain is solved once per
+	 * solver, each solver keeping its own warm start state for the chain, and the accuracy, iterations, jitter and
+	 * solve time are collected per solver. Sessions are streamed, the harness only keeps per chain state.
+	 */
+	class IKCORE_API FReplayHarness
+	{
+	public:
+		explicit FReplayHarness(const std::vector<ESolver>& Solvers, const FReplaySettings& InSettings = FReplaySettings());
+
+		/** Solve one recorded frame of Chain with every solver. Frames are expected in recorded order. */
+		void Solve(const FRecordedChain& Chain, const FRecordedFrame& Frame);
+
+		/** Solve the rest of Reader's session and Finish; false when reading stopped on a malformed chunk. */
+		bool Replay(FRecordingReader& Reader);
+
+		/** Count the frame being solved and forget the chains, at the end of a session and before reading the stats. */
+		void Finish();
+
+		const std::vector<FReplayStats>& GetStats() const { return Stats; }
+
+	private:
+		struct FChainReplay
+		{
+			FChainSolveState State;
+
+			// bone offsets from the root parent, in its frame, after the last two solves
+			std::vector<Eigen::Vector3f> LastOffsets;
+			std::vector<Eigen::Vector3f> OffsetsBefore;
+			uint64_t LastFrame = 0;
+			int32_t NumHistory = 0;
+		};
+
+		void EndFrame();
+
+		FReplaySettings Settings;
+		std::vector<FReplayStats> Stats;
+
+		// per solver, per chain id
+		std::vector<std::vector<FChainReplay>> ChainReplays;
+
+		// solve time of the current recorded frame per solver
+		std::vector<double> FrameSeconds;
+		uint64_t CurrentFrame = 0;
+		bool bInFrame = false;
+
+		FPose Pose;
+		std::vector<Eigen::Vector3f> Offsets;
+	};
+}
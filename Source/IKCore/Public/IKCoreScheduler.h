@@ -0,0 +1,114 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace IKCore
+{
+	struct FWorkerStats
+	{
+		// time spent inside jobs
+		double BusySeconds = 0.0;
+		int32_t NumJobs = 0;
+		int32_t NumSteals = 0;
+	};
+
+	struct IKCORE_API FParallelForStats
+	{
+		double WallSeconds = 0.0;
+		std::vector<FWorkerStats> Workers;
+
+		/** Share of the wall time worker WorkerIndex spent in jobs, in [0, 1]. */
+		float GetUtilization(int32_t WorkerIndex) const;
+		float GetAverageUtilization() const;
+	};
+
+	/**
+	 * Work-stealing distribution of NumJobs independent jobs over NumWorkers workers.
+	 *
+	 * The jobs are grouped in chunks and every worker starts with a contiguous range of chunks. A worker takes chunks
+	 * from the back of its own range and, once that is empty, steals the front half of another worker's range.
+	 * The queue does not own threads: each worker calls RunWorker from whatever thread runs it (FThreadPool in the
+	 * standalone library, ParallelFor in the engine) and returns once every job has been taken.
+	 */
+	class IKCORE_API FWorkStealingQueue
+	{
+	public:
+		using FJobFunction = std::function<void(int32_t JobIndex, int32_t WorkerIndex)>;
+
+		/** Deal NumJobs jobs to NumWorkers workers; not thread safe, call it before the workers start. */
+		void Reset(int32_t NumWorkers, int32_t NumJobs, int32_t JobsPerChunk = 1);
+
+		void RunWorker(int32_t WorkerIndex, const FJobFunction& Job);
+
+		int32_t GetNumWorkers() const { return NumWorkers; }
+		const FWorkerStats& GetWorkerStats(int32_t WorkerIndex) const { return Workers[WorkerIndex].Stats; }
+		void GetStats(double WallSeconds, FParallelForStats& OutStats) const;
+
+	private:
+		bool PopOwnChunk(int32_t WorkerIndex, int32_t& OutChunk);
+		bool StealChunks(int32_t WorkerIndex);
+
+		struct FWorker
+		{
+			std::mutex Mutex;
+			int32_t BeginChunk = 0;
+			int32_t EndChunk = 0;
+			FWorkerStats Stats;
+
+			// keeps neighbouring workers off each other's cache line (alignas would need C++17 aligned new)
+			char Padding[64];
+		};
+
+		std::unique_ptr<FWorker[]> Workers;
+		int32_t NumWorkers = 0;
+		int32_t NumAllocatedWorkers = 0;
+		int32_t NumJobs = 0;
+		int32_t JobsPerChunk = 1;
+	};
+
+	/**
+	 * Fixed set of threads running FWorkStealingQueue workers, for use outside the engine.
+	 * The calling thread is worker 0, so a pool of NumWorkers workers owns NumWorkers - 1 threads.
+	 */
+	class IKCORE_API FThreadPool
+	{
+	public:
+		explicit FThreadPool(int32_t InNumWorkers);
+		~FThreadPool();
+
+		FThreadPool(const FThreadPool&) = delete;
+		FThreadPool& operator=(const FThreadPool&) = delete;
+
+		/** Run Job for every index in [0, NumJobs) and return when all of them are done. */
+		void ParallelFor(int32_t NumJobs, const FWorkStealingQueue::FJobFunction& Job, int32_t JobsPerChunk = 1);
+
+		int32_t GetNumWorkers() const { return NumWorkers; }
+
+		/** Wall time and per worker utilization of the last ParallelFor. */
+		const FParallelForStats& GetLastStats() const { return LastStats; }
+
+	private:
+		void ThreadMain(int32_t WorkerIndex);
+
+		int32_t NumWorkers = 1;
+		std::vector<std::thread> Threads;
+		FWorkStealingQueue Queue;
+		FParallelForStats LastStats;
+
+		std::mutex Mutex;
+		std::condition_variable StartCondition;
+		std::condition_variable DoneCondition;
+		const FWorkStealingQueue::FJobFunction* CurrentJob = nullptr;
+		uint64_t Generation = 0;
+		int32_t NumRunningThreads = 0;
+		bool bShutdown = false;
+	};
+}
@@ -0,0 +1,134 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+#include "IKCoreMappedFile.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace IKCore
+{
+	/** One bone of a skeleton cache, as stored in the file (64 bytes). */
+	struct FSkeletonBone
+	{
+		int32_t Parent = -1;
+		uint32_t NameOffset = 0;
+
+		// reference pose relative to the parent, the rotation as x, y, z, w
+		float RestTranslation[3] = { 0.f, 0.f, 0.f };
+		float RestRotation[4] = { 0.f, 0.f, 0.f, 1.f };
+
+		// distance to the parent in the reference pose
+		float RestLength = 0.f;
+
+		// unit axis in the bone's frame towards its first child (away from its parent for a leaf), what the bone twists about
+		float TwistAxis[3] = { 1.f, 0.f, 0.f };
+
+		// radians: how far the twist axis may swing away from its reference direction, and the twist range about it
+		float SwingLimit = 3.14159265f;
+		float MinTwist = -3.14159265f;
+		float MaxTwist = 3.14159265f;
+	};
+	static_assert(sizeof(FSkeletonBone) == 64, "FSkeletonBone is part of the file format");
+
+	/** Precompiled chain from a root bone to a tip bone, as stored in the file (32 bytes). */
+	struct FSkeletonChain
+	{
+		uint32_t TipNameOffset = 0;
+		uint32_t RootNameOffset = 0;
+
+		// the chain's skeleton bone indices, root first, are NumBones entries of the chain bone table from FirstBone
+		uint32_t FirstBone = 0;
+		uint32_t NumBones = 0;
+
+		// sum of the rest lengths of the bones after the root
+		float TotalReach = 0.f;
+		uint32_t Reserved[3] = { 0, 0, 0 };
+	};
+	static_assert(sizeof(FSkeletonChain) == 32, "FSkeletonChain is part of the file format");
+
+	/**
+	 * Bone hierarchy, reference pose, joint limits and (tip, root) chain tables of one skeleton, cooked once so that
+	 * loading it is a file mapping instead of name queries against the skeleton for every character.
+	 *
+	 * The file is a flat image: a 32 byte header ("IKSK", version, bone, chain and chain bone counts, name table size),
+	 * the FSkeletonBone array, the FSkeletonChain array, the chain bone table as int32 and the name table of null
+	 * terminated UTF-8 strings, each array 8 byte aligned and every value little endian. Every bone comes after its parent.
+	 */
+	class IKCORE_API FSkeletonCache
+	{
+	public:
+		static constexpr uint32_t Version = 1;
+
+		/** Map the file at FilePath, nothing is copied. */
+		bool Open(const char* FilePath);
+
+		/** Use the image at Data without copying it; Data must be 8 byte aligned and outlive the cache or the next Open or Reset. */
+		bool SetImage(const void* Data, size_t Size);
+
+		void Reset();
+
+		bool IsValid() const { return NumBones > 0; }
+		int32_t GetNumBones() const { return NumBones; }
+		int32_t GetNumChains() const { return NumChains; }
+
+		const FSkeletonBone& GetBone(int32_t Index) const { return Bones[Index]; }
+		const char* GetBoneName(int32_t Index) const { return Names + Bones[Index].NameOffset; }
+		const char* GetName(uint32_t NameOffset) const { return Names + NameOffset; }
+
+		/** Index of the bone called Name, -1 when there is none. Linear, meant for loading rather than per frame use. */
+		int32_t FindBone(const char* Name) const;
+
+		const FSkeletonChain& GetChain(int32_t Index) const { return Chains[Index]; }
+		const FSkeletonChain* FindChain(const char* TipBoneName, const char* RootBoneName) const;
+		const int32_t* GetChainBones(const FSkeletonChain& Chain) const { return ChainBones + Chain.FirstBone; }
+
+		/** Reference pose of Chain in the frame of its root bone's parent. */
+		void GetRestPose(const FSkeletonChain& Chain, FPose& OutPose) const;
+
+	private:
+		void ClearView();
+
+		FMappedFile MappedFile;
+
+		int32_t NumBones = 0;
+		int32_t NumChains = 0;
+
+		// views into the image
+		const FSkeletonBone* Bones = nullptr;
+		const FSkeletonChain* Chains = nullptr;
+		const int32_t* ChainBones = nullptr;
+		const char* Names = nullptr;
+	};
+
+	/** Writes skeleton cache images: bones are added parents first, then the chains between them. */
+	class IKCORE_API FSkeletonCacheBuilder
+	{
+	public:
+		/** Index of the new bone. Its rest length and twist axis are derived from the reference pose when writing. */
+		int32_t AddBone(const char* Name, int32_t Parent, const Eigen::Vector3f& RestTranslation, const Eigen::Quaternionf& RestRotation);
+
+		void SetJointLimits(int32_t Bone, float SwingLimit, float MinTwist, float MaxTwist);
+
+		/** Add the chain from RootBone to TipBone, false when TipBone is not below RootBone. */
+		bool AddChain(int32_t TipBone, int32_t RootBone);
+
+		int32_t GetNumBones() const { return static_cast<int32_t>(Bones.size()); }
+		int32_t GetNumChains() const { return static_cast<int32_t>(ChainEnds.size()); }
+
+		/** The image, 8 byte elements for the alignment; OutSize is its size in bytes. */
+		void Write(std::vector<uint64_t>& OutImage, size_t& OutSize) const;
+
+		bool Save(const char* FilePath) const;
+
+	private:
+		std::vector<FSkeletonBone> Bones;
+		std::vector<std::string> BoneNames;
+		// tip and root bone of each chain, and the bones of every chain one after the other, root first
+		std::vector<std::pair<int32_t, int32_t>> ChainEnds;
+		std::vector<int32_t> ChainBones;
+	};
+}
@@ -0,0 +1,105 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+#include "IKCoreJacobian.h"
+#include "IKCorePoseDatabase.h"
+
+namespace IKCore
+{
+	struct FWarmStartSettings
+	{
+		// start from the previous solution instead of the incoming pose
+		bool bWarmStart = true;
+
+		// reuse the previous solution without solving when nothing moved and that solve converged or stalled
+		bool bSkipUnchanged = true;
+
+		// pose space distances under which the target, the root and the link lengths count as unchanged
+		float TargetTolerance = 0.01f;
+		float RootTolerance = 0.01f;
+
+		// radians, for the rotation of the root's parent
+		float RootAngleTolerance = 0.001f;
+
+		// solve once every IntervalFrames calls and blend from the solution before the last one to the last in between,
+		// the output trails the target by up to IntervalFrames - 1 frames
+		int32_t IntervalFrames = 1;
+
+		// baked solutions of the chain, a solve starts from the nearest ones when they are closer to the target than the
+		// pose it would start from otherwise, e.g. after a teleport or a new grab; see FPoseDatabase::SeedPose
+		const FPoseDatabase* PoseDatabase = nullptr;
+		int32_t PoseDatabaseNeighbours = 1;
+	};
+
+	/**
+	 * What a chain remembers from one solve to the next: the last solution and target, both relative to the root bone's
+	 * position and its parent's rotation so they follow the animated parent, and how that solve ended.
+	 */
+	class IKCORE_API FChainSolveState
+	{
+	public:
+		/**
+		 * Solve(Solver, Pose, Target, Settings, Workspace) with temporal coherence: when the target, the root and the parent
+		 * rotation did not move and the last solve converged or stalled, Pose is set to the last solution and the returned
+		 * result has zero iterations. Otherwise the solve starts from the last solution if WarmStartSettings.bWarmStart is set.
+		 * With WarmStartSettings.IntervalFrames above one, the calls in between two solves interpolate the last solutions.
+		 */
+		FSolveResult Solve(ESolver Solver, FPose& Pose, const Eigen::Vector3f& Target, const Eigen::Quaternionf& RootParentRotation,
+			const FSolverSettings& Settings, const FWarmStartSettings& WarmStartSettings, FJacobianWorkspace* Workspace = nullptr);
+
+		/** Forget the last solution, e.g. after a teleport or a change of chain. */
+		void Reset();
+
+		bool HasSolution() const { return bHasSolution; }
+		const FSolveResult& GetLastResult() const { return LastResult; }
+
+		/** True when the last call to Solve reused the previous solution. */
+		bool WasSkipped() const { return bSkipped; }
+
+		/** True when the last call to Solve interpolated between solutions instead of solving. */
+		bool WasInterpolated() const { return bInterpolated; }
+
+		int64_t GetNumSkipped() const { return NumSkipped; }
+		int64_t GetNumSolved() const { return NumSolved; }
+
+		/** Solves started from the pose database. */
+		int64_t GetNumSeeded() const { return NumSeeded; }
+
+	private:
+		bool CanReuse(const FPose& Pose, const FWarmStartSettings& WarmStartSettings) const;
+		void Restore(FPose& Pose, const Eigen::Quaternionf& RootParentRotation) const;
+		void Store(const FPose& Pose, const Eigen::Quaternionf& RootParentRotation);
+		void Interpolate(FPose& Pose, const Eigen::Quaternionf& RootParentRotation, float Alpha) const;
+
+		using FUnalignedQuaternion = Eigen::Quaternion<float, Eigen::DontAlign>;
+
+		bool bHasSolution = false;
+		bool bStalled = false;
+		bool bSkipped = false;
+		bool bInterpolated = false;
+
+		Eigen::Vector3f RootPosition = Eigen::Vector3f::Zero();
+		FUnalignedQuaternion RootParentRotation = FUnalignedQuaternion::Identity();
+		Eigen::Vector3f LocalTarget = Eigen::Vector3f::Zero();
+
+		// solution in the root parent frame: offsets from the root bone and rotations
+		std::vector<Eigen::Vector3f> LocalOffsets;
+		std::vector<FUnalignedQuaternion> LocalRotations;
+		std::vector<float> Lengths;
+
+		// the solution before, what Interpolate blends from
+		std::vector<Eigen::Vector3f> PreviousLocalOffsets;
+		std::vector<FUnalignedQuaternion> PreviousLocalRotations;
+		int32_t NumCallsSinceSolve = 0;
+
+		// link lengths of the incoming pose, a different length means the old solution no longer fits
+		std::vector<float> InputLengths;
+
+		FSolveResult LastResult;
+		int64_t NumSkipped = 0;
+		int64_t NumSolved = 0;
+		int64_t NumSeeded = 0;
+	};
+}
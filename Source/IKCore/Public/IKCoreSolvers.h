@@ -0,0 +1,54 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+#include "IKCoreJacobian.h"
+
+namespace IKCore
+{
+	/**
+	 * Every solver iterates on Pose in place until the tip is within Settings.Precision of Target or Settings.MaxIterations is hit.
+	 * The Jacobian solvers use fixed-size matrices for 2, 3, 4 and 6 links and Workspace for any other length
+	 * (the calling thread's one for that length when Workspace is null). Other scratch comes from GetThreadScratchArena.
+	 */
+	IKCORE_API FSolveResult SolveCCD(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings);
+	IKCORE_API FSolveResult SolveFABRIK(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings);
+	IKCORE_API FSolveResult SolveJacobianTranspose(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, FJacobianWorkspace* Workspace = nullptr);
+	IKCORE_API FSolveResult SolveJacobianPinv(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, FJacobianWorkspace* Workspace = nullptr);
+	IKCORE_API FSolveResult SolveDampedLeastSquares(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, FJacobianWorkspace* Workspace = nullptr);
+
+	/** Closed-form solve of a two-link chain (three bones), always a single iteration. */
+	IKCORE_API FSolveResult SolveTwoBone(FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings);
+
+	/** Dispatch to Solver, or to SolveTwoBone for two-link chains without joint limits when Settings.bAnalyticTwoBone is set. */
+	IKCORE_API FSolveResult Solve(ESolver Solver, FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, FJacobianWorkspace* Workspace = nullptr);
+
+	/**
+	 * Run the stages of Pipeline one after the other on Pose, stopping as soon as the tip is within Settings.Precision.
+	 * Settings.MaxIterations caps the iterations of all stages together; stages that are pipelines themselves are skipped.
+	 */
+	IKCORE_API FSolveResult SolvePipeline(const FSolverPipeline& Pipeline, FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, FJacobianWorkspace* Workspace = nullptr);
+
+	/**
+	 * The pipeline ESolver::Auto runs, picked for the fewest flops to reach Settings.Precision: the closed form for
+	 * two-link chains, a single FABRIK pass for targets out of reach and FABRIK alone on short chains. Longer chains run
+	 * damped least squares alone when the tip starts close to the target or LastResult (the previous solve of the chain)
+	 * converged in a few steps, and FABRIK down to a hand-off distance followed by damped least squares refinement
+	 * otherwise, with more refinement when LastResult did not converge.
+	 */
+	IKCORE_API FSolverPipeline SelectPipeline(const FPose& Pose, const Eigen::Vector3f& Target, const FSolverSettings& Settings, const FSolveResult* LastResult = nullptr);
+
+	/**
+	 * Position and orientation of the tip in one solve on the 6-row Jacobian, see TJacobianSolver::SolveTransform.
+	 * Solver is one of the Jacobian solvers; fixed-size matrices are used for the same lengths as for position targets.
+	 */
+	IKCORE_API FSolveResult SolveJacobianTransform(ESolver Solver, FPose& Pose, const FTransformTarget& Target, const FSolverSettings& Settings, FTransformJacobianWorkspace* Workspace = nullptr);
+
+	/**
+	 * Dispatch a position and orientation target: the Jacobian solvers go through SolveJacobianTransform, as do Pipeline
+	 * and Auto with damped least squares, the others solve for the position as above and then turn the tip bone onto
+	 * Target.Rotation.
+	 */
+	IKCORE_API FSolveResult Solve(ESolver Solver, FPose& Pose, const FTransformTarget& Target, const FSolverSettings& Settings, FTransformJacobianWorkspace* Workspace = nullptr);
+}
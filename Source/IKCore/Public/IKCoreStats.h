@@ -0,0 +1,73 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// phase timers are compiled in unless the build turns them off (IKCore.Build.cs does for shipping)
+#ifndef IKCORE_STATS
+#define IKCORE_STATS 1
+#endif
+
+namespace IKCore
+{
+	enum class ESolvePhase : uint8_t
+	{
+		JacobianAssembly,
+		LinearSolve,
+		PoseUpdate,
+		Num,
+	};
+
+	struct FPhaseTimes
+	{
+		double Seconds[static_cast<int32_t>(ESolvePhase::Num)] = {};
+		int32_t Calls[static_cast<int32_t>(ESolvePhase::Num)] = {};
+	};
+
+	/** Phase timing is off until enabled, so an idle profiler costs one flag test per timed scope. */
+	IKCORE_API void SetPhaseTimingEnabled(bool bEnabled);
+	IKCORE_API bool IsPhaseTimingEnabled();
+
+	IKCORE_API void AddPhaseTime(ESolvePhase Phase, double Seconds);
+
+	/** Time the calling thread spent in each phase since its previous call, which resets it. */
+	IKCORE_API FPhaseTimes TakePhaseTimes();
+
+	class FScopedPhaseTimer
+	{
+	public:
+		explicit FScopedPhaseTimer(ESolvePhase InPhase)
+			: Phase(InPhase)
+			, bEnabled(IsPhaseTimingEnabled())
+		{
+			if (bEnabled)
+			{
+				StartTime = std::chrono::steady_clock::now();
+			}
+		}
+
+		~FScopedPhaseTimer()
+		{
+			if (bEnabled)
+			{
+				AddPhaseTime(Phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count());
+			}
+		}
+
+		FScopedPhaseTimer(const FScopedPhaseTimer&) = delete;
+		FScopedPhaseTimer& operator=(const FScopedPhaseTimer&) = delete;
+
+	private:
+		ESolvePhase Phase;
+		bool bEnabled;
+		std::chrono::steady_clock::time_point StartTime;
+	};
+}
+
+#if IKCORE_STATS
+#define IKCORE_SCOPE_PHASE(Phase) const IKCore::FScopedPhaseTimer ScopedPhaseTimer(IKCore::ESolvePhase::Phase)
+#else
+#define IKCORE_SCOPE_PHASE(Phase)
+#endif
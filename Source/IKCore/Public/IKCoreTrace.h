@@ -0,0 +1,89 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace IKCore
+{
+	enum class ETraceFormat : uint8_t
+	{
+		Csv,
+		Binary,
+	};
+
+	/** One solve; OwnerId and ChainId are ids of names registered with the FTraceWriter it is written to. */
+	struct FTraceRecord
+	{
+		static constexpr uint8_t Converged = 1 << 0;
+		static constexpr uint8_t Skipped = 1 << 1;
+
+		uint64_t Frame = 0;
+		uint32_t OwnerId = 0;
+		uint32_t ChainId = 0;
+		float Residual = 0.f;
+		float Microseconds = 0.f;
+		uint16_t Iterations = 0;
+		uint16_t NumBones = 0;
+		ESolver Solver = ESolver::FABRIK;
+		uint8_t Flags = 0;
+	};
+
+	/**
+	 * Thread safe sink of solve records. Records are buffered in memory and written out by Flush, once per frame in the engine.
+	 *
+	 * Csv: a header line, then one line per record with the owner and chain names inline.
+	 * Binary: "IKTR" and a uint32 version, then little endian chunks, either 'N' uint32 id, uint16 length and the name bytes,
+	 * or 'R' and the FTraceRecord fields in declaration order without padding (30 bytes). A name chunk always precedes
+	 * the first record using it.
+	 */
+	class IKCORE_API FTraceWriter
+	{
+	public:
+		static constexpr uint32_t BinaryVersion = 1;
+
+		FTraceWriter() = default;
+		~FTraceWriter();
+
+		FTraceWriter(const FTraceWriter&) = delete;
+		FTraceWriter& operator=(const FTraceWriter&) = delete;
+
+		bool Open(const char* FilePath, ETraceFormat InFormat);
+		void Close();
+		bool IsOpen() const;
+
+		/** Id of Name, registering it on first use. Ids only hold until the writer is opened again. */
+		uint32_t RegisterName(const std::string& Name);
+
+		void Write(const FTraceRecord& Record);
+
+		/**
+		 * Write Record as made by Owner for Chain, their ids registered under the same lock as the record is queued, so
+		 * that a trace restarted from another thread cannot leave the record with the ids of the previous file.
+		 */
+		void Write(const FTraceRecord& Record, const std::string& Owner, const std::string& Chain);
+
+		void Flush();
+
+	private:
+		uint32_t RegisterNameLocked(const std::string& Name);
+		void FlushLocked();
+
+		mutable std::mutex Mutex;
+		std::FILE* File = nullptr;
+		ETraceFormat Format = ETraceFormat::Csv;
+
+		std::unordered_map<std::string, uint32_t> NameIds;
+		std::vector<std::string> Names;
+		size_t NumWrittenNames = 0;
+
+		std::vector<FTraceRecord> PendingRecords;
+		std::vector<char> Buffer;
+	};
+}
@@ -0,0 +1,237 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+
+namespace IKCore
+{
+	template <typename T>
+	using TAlignedArray = std::vector<T, Eigen::aligned_allocator<T>>;
+
+	enum class ESolver : uint8_t
+	{
+		CCD,
+		FABRIK,
+		JacobianTranspose,
+		JacobianPinv,
+		DampedLeastSquares,
+		TwoBone,
+
+		// the stages of FSolverSettings::Pipeline, one after the other
+		Pipeline,
+
+		// a pipeline picked for each solve from the chain, the target and the last solve, see SelectPipeline
+		Auto,
+	};
+
+	/**
+	 * One stage of a solver pipeline: Solver runs until the tip is within HandOffDistance of the target or MaxIterations
+	 * is hit, then the next stage takes over. The last stage runs to FSolverSettings::Precision.
+	 */
+	struct FSolverStage
+	{
+		ESolver Solver = ESolver::DampedLeastSquares;
+		int32_t MaxIterations = 1;
+		float HandOffDistance = 0.f;
+	};
+
+	/** Up to MaxStages solver stages, e.g. FABRIK for the coarse placement and a couple of damped least squares steps to finish. */
+	struct FSolverPipeline
+	{
+		static constexpr int32_t MaxStages = 4;
+
+		FSolverStage Stages[MaxStages];
+		int32_t NumStages = 0;
+
+		/** Append a stage, ignored once the pipeline is full. */
+		FSolverPipeline& Add(ESolver Solver, int32_t MaxIterations, float HandOffDistance = 0.f)
+		{
+			if (NumStages < MaxStages)
+			{
+				Stages[NumStages].Solver = Solver;
+				Stages[NumStages].MaxIterations = MaxIterations;
+				Stages[NumStages].HandOffDistance = HandOffDistance;
+				++NumStages;
+			}
+			return *this;
+		}
+	};
+
+	struct FTwoBoneSettings
+	{
+		// the middle joint bends towards PoleVector (pose space) when set, otherwise it keeps its current bend plane
+		bool bUsePoleVector = false;
+		Eigen::Vector3f PoleVector = Eigen::Vector3f::Zero();
+
+		// extra rotation of the bend plane about the root to target axis, in radians
+		float SwivelAngle = 0.f;
+
+		// past SoftStartRatio of the reach the chain straightens asymptotically instead of snapping straight
+		float SoftStartRatio = 1.f;
+
+		// let both links grow up to MaxStretchScale to reach targets beyond the (soft) reach
+		bool bAllowStretch = false;
+		float MaxStretchScale = 1.2f;
+	};
+
+	struct FSolverSettings
+	{
+		float Precision = 1.f;
+		int32_t MaxIterations = 10;
+
+		// damped least squares: lambda of the first step and, when adaptive, the range it is kept in
+		float Damping = 1.f;
+		float MinDamping = 0.01f;
+		float MaxDamping = 1000.f;
+		bool bAdaptiveDamping = true;
+
+		// Jacobian solvers: build the Jacobian once per solve and correct it with Broyden's rank-1 updates from how the tip
+		// actually moved, rebuilding it only when the residual stalls. An update costs about as much as building the
+		// Jacobian from an FPose, so this only pays where the bone locations and axes are expensive to get at
+		bool bBroydenUpdates = false;
+
+		// two-link chains are solved in closed form whatever solver is asked for
+		bool bAnalyticTwoBone = true;
+		FTwoBoneSettings TwoBone;
+
+		// orientation targets: angle from the target rotation, in radians, within which the tip counts as reached
+		float AnglePrecision = 0.01f;
+
+		// stages run by ESolver::Pipeline, an empty pipeline is picked as for ESolver::Auto; MaxIterations caps all stages together
+		FSolverPipeline Pipeline;
+	};
+
+	/**
+	 * Position and orientation target for the tip bone. The error is weighted per pose space axis, position rows first;
+	 * the rotation error is a rotation vector in radians, so RotationWeights also sets how much distance a radian is worth.
+	 */
+	struct FTransformTarget
+	{
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+		Eigen::Quaternionf Rotation = Eigen::Quaternionf::Identity();
+		Eigen::Vector3f Position = Eigen::Vector3f::Zero();
+
+		Eigen::Vector3f PositionWeights = Eigen::Vector3f::Ones();
+		Eigen::Vector3f RotationWeights = Eigen::Vector3f::Ones();
+	};
+
+	struct FSolveResult
+	{
+		int32_t Iterations = 0;
+		float Residual = 0.f;
+
+		// orientation targets only: angle between the tip and the target rotation, in radians
+		float AngleResidual = 0.f;
+
+		bool bConverged = false;
+	};
+
+	/**
+	 * Swing cone and twist range of a bone relative to its parent, measured from the bone's rest rotation. The twist is
+	 * the rotation about TwistAxis, the bone's axis along its link in its own frame, and the swing is what turns that
+	 * axis away from its rest direction. Angles in radians.
+	 */
+	struct IKCORE_API FJointLimit
+	{
+		// rotation of the bone relative to its parent at rest
+		Eigen::Quaternion<float, Eigen::DontAlign> RestRotation = Eigen::Quaternion<float, Eigen::DontAlign>::Identity();
+		Eigen::Vector3f TwistAxis = Eigen::Vector3f::UnitX();
+
+		// the swing's half-angle cosine is compared with the limit's, no angle is taken unless the twist is limited
+		float CosHalfSwing = -1.f;
+		float SinHalfSwing = 0.f;
+		float MinTwist = -3.14159265f;
+		float MaxTwist = 3.14159265f;
+		bool bLimitTwist = false;
+
+		FJointLimit() = default;
+		FJointLimit(const Eigen::Quaternionf& InRestRotation, const Eigen::Vector3f& InTwistAxis, float SwingLimit, float InMinTwist, float InMaxTwist);
+
+		bool IsFree() const { return CosHalfSwing <= -1.f && !bLimitTwist; }
+
+		/** LocalRotation, relative to the parent, moved into the limits: its swing shortened to the cone, its twist clamped to the range. */
+		Eigen::Quaternionf Clamp(const Eigen::Quaternionf& LocalRotation) const;
+	};
+
+	/**
+	 * Pose of a bone chain laid out as flat arrays, ordered from the root bone to the tip bone.
+	 * Positions and rotations share one space (component space in the engine adapter).
+	 */
+	struct IKCORE_API FPose
+	{
+		std::vector<Eigen::Vector3f> Positions;
+		TAlignedArray<Eigen::Quaternionf> Rotations;
+
+		// current length of the link between bone i and bone i + 1
+		std::vector<float> Lengths;
+
+		// limits of every bone but the tip, enforced by the solvers at each joint update; empty for a free chain.
+		// The root bone's limits are relative to RootParentRotation, the others' to the bone before.
+		std::vector<FJointLimit> JointLimits;
+		Eigen::Quaternion<float, Eigen::DontAlign> RootParentRotation = Eigen::Quaternion<float, Eigen::DontAlign>::Identity();
+
+		int32_t Num() const { return static_cast<int32_t>(Positions.size()); }
+		int32_t NumLinks() const { return Num() - 1; }
+		const Eigen::Vector3f& TipPosition() const { return Positions.back(); }
+
+		bool HasJointLimits() const { return !JointLimits.empty(); }
+
+		float TotalLength() const;
+		float TipDistance(const Eigen::Vector3f& Target) const { return (Positions.back() - Target).norm(); }
+
+		/** Rotation vector, in radians, that turns the tip bone onto TargetRotation the short way round. */
+		Eigen::Vector3f TipRotationError(const Eigen::Quaternionf& TargetRotation) const;
+
+		/**
+		 * Rotation, in pose space, of bone Index turned to Rotation under a parent at ParentRotation, moved into the bone's
+		 * limits. Rotation itself without limits.
+		 */
+		Eigen::Quaternionf ConstrainRotation(int32_t Index, const Eigen::Quaternionf& ParentRotation, const Eigen::Quaternionf& Rotation) const
+		{
+			if (JointLimits.empty() || JointLimits[Index].IsFree())
+			{
+				return Rotation;
+			}
+			return (ParentRotation * JointLimits[Index].Clamp(ParentRotation.conjugate() * Rotation)).normalized();
+		}
+
+		/** Recompute Lengths from Positions. */
+		void UpdateLengths();
+
+		/** Rotate bone Index and every bone after it about the position of bone Index. */
+		void RotateBone(int32_t Index, const Eigen::Quaternionf& DeltaRotation);
+
+		/**
+		 * RotateBone(Index, GetDeltaRotation(Index)) for every link from the tip's parent back to FirstIndex, in one O(n) pass
+		 * instead of O(n^2): each of those rotations pivots about a bone only its successors had moved, so a link ends up
+		 * turned by the prefix product of the rotations of its bone and every ancestor, and each bone from FirstIndex on is
+		 * rewritten once. Bones before FirstIndex are not touched. GetDeltaRotation is called from FirstIndex up and may
+		 * read bone Index, which still holds its value from before the pass.
+		 */
+		template <typename DeltaRotationFunctionType>
+		void RotateBones(int32_t FirstIndex, DeltaRotationFunctionType&& GetDeltaRotation)
+		{
+			Eigen::Quaternionf PrefixRotation = Eigen::Quaternionf::Identity();
+			Eigen::Vector3f ParentPosition = Positions[FirstIndex];
+			for (int32_t Index = FirstIndex; Index < NumLinks(); ++Index)
+			{
+				PrefixRotation = PrefixRotation * GetDeltaRotation(Index);
+				Rotations[Index] = (PrefixRotation * Rotations[Index]).normalized();
+
+				const Eigen::Vector3f ChildPosition = Positions[Index + 1];
+				Positions[Index + 1] = Positions[Index] + PrefixRotation * (ChildPosition - ParentPosition);
+				ParentPosition = ChildPosition;
+			}
+			Rotations.back() = (PrefixRotation * Rotations.back()).normalized();
+		}
+
+		/** Rebuild the rotations after the positions were moved directly, e.g. by FABRIK. */
+		void AlignRotationsToPositions(const Eigen::Vector3f* OriginalPositions);
+	};
+}
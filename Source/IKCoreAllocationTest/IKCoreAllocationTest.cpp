@@ -0,0 +1,296 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+// Checks that the solvers do not touch the heap in steady state: every solve path is warmed up, then solved again while
+// the heap allocations of the thread are counted. Exits with 1 when any path allocated, for ctest to fail.
+// The malloc family is replaced for this executable only, so no other binary pays for the counting.
+
+#include "IKCoreBenchmarkUtils.h"
+#include "IKCoreArena.h"
+#include "IKCoreBatch.h"
+#include "IKCoreMultiEffector.h"
+#include "IKCorePoseDatabase.h"
+#include "IKCoreSolveState.h"
+#include "IKCoreSolvers.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+
+// Every heap allocation of the process is counted per thread. Eigen allocates with malloc and libstdc++'s operator new
+// sits on top of it, so on glibc the malloc family is replaced; elsewhere only operator new is seen.
+namespace
+{
+	thread_local int64_t NumThreadAllocations = 0;
+}
+
+#if defined(__GLIBC__)
+extern "C"
+{
+	void* __libc_malloc(size_t Size);
+	void* __libc_calloc(size_t Count, size_t Size);
+	void* __libc_realloc(void* Pointer, size_t Size);
+	void* __libc_memalign(size_t Alignment, size_t Size);
+
+	void* malloc(size_t Size)
+	{
+		++NumThreadAllocations;
+		return __libc_malloc(Size);
+	}
+
+	void* calloc(size_t Count, size_t Size)
+	{
+		++NumThreadAllocations;
+		return __libc_calloc(Count, Size);
+	}
+
+	void* realloc(void* Pointer, size_t Size)
+	{
+		++NumThreadAllocations;
+		return __libc_realloc(Pointer, Size);
+	}
+
+	void* memalign(size_t Alignment, size_t Size)
+	{
+		++NumThreadAllocations;
+		return __libc_memalign(Alignment, Size);
+	}
+
+	void* aligned_alloc(size_t Alignment, size_t Size)
+	{
+		++NumThreadAllocations;
+		return __libc_memalign(Alignment, Size);
+	}
+
+	int posix_memalign(void** Pointer, size_t Alignment, size_t Size)
+	{
+		++NumThreadAllocations;
+		*Pointer = __libc_memalign(Alignment, Size);
+		return *Pointer != nullptr ? 0 : ENOMEM;
+	}
+}
+#else
+void* operator new(size_t Size)
+{
+	++NumThreadAllocations;
+	if (void* Pointer = std::malloc(Size > 0 ? Size : 1))
+	{
+		return Pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t Size)
+{
+	return operator new(Size);
+}
+
+void operator delete(void* Pointer) noexcept
+{
+	std::free(Pointer);
+}
+
+void operator delete[](void* Pointer) noexcept
+{
+	std::free(Pointer);
+}
+#endif
+
+namespace
+{
+	using namespace IKCoreBenchmark;
+
+	// solves before counting starts, for the workspaces, the solve state and the scratch arena to reach their size
+	constexpr int32_t NumWarmUpSolves = 64;
+	constexpr int32_t NumCountedSolves = 256;
+
+	int32_t NumFailed = 0;
+
+	/** Run Solve NumWarmUpSolves times, then count the heap allocations of NumCountedSolves more calls. */
+	void CheckAllocations(const std::string& Name, const std::function<void()>& Solve)
+	{
+		for (int32_t Index = 0; Index < NumWarmUpSolves; ++Index)
+		{
+			Solve();
+		}
+
+		const int64_t StartAllocations = NumThreadAllocations;
+		const int64_t StartScratchAllocations = IKCore::GetNumScratchHeapAllocations();
+		for (int32_t Index = 0; Index < NumCountedSolves; ++Index)
+		{
+			Solve();
+		}
+		const int64_t NumAllocations = NumThreadAllocations - StartAllocations;
+		const int64_t NumScratchAllocations = IKCore::GetNumScratchHeapAllocations() - StartScratchAllocations;
+
+		if (NumAllocations > 0)
+		{
+			++NumFailed;
+		}
+		std::printf("%s %s: %lld heap allocations (%lld by the scratch arena) in %d solves\n", NumAllocations > 0 ? "FAIL" : "ok  ", Name.c_str(),
+			static_cast<long long>(NumAllocations), static_cast<long long>(NumScratchAllocations), NumCountedSolves);
+	}
+
+	/** A solver on a chain of NumBones bones, with a workspace of its own or with the thread's one. */
+	void CheckSolve(const char* Name, IKCore::ESolver Solver, bool bWorkspace, int32_t NumBones)
+	{
+		const IKCore::FPose RestPose = MakeChain(NumBones);
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(64);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+
+		IKCore::FPose Pose = RestPose;
+		IKCore::FJacobianWorkspace Workspace(Pose.NumLinks());
+		size_t TargetIndex = 0;
+		CheckAllocations(std::string("Solve/") + Name + "/" + std::to_string(NumBones), [&]()
+		{
+			Pose = RestPose;
+			IKCore::Solve(Solver, Pose, Targets[TargetIndex], Settings, bWorkspace ? &Workspace : nullptr);
+			TargetIndex = (TargetIndex + 1) % Targets.size();
+		});
+	}
+
+	/** Solves through a chain's solve state, warm started and seeded from a pose database, as the character does. */
+	void CheckSolveState(const char* Name, IKCore::ESolver Solver)
+	{
+		const IKCore::FPose RestPose = MakeChain(8);
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(64);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+
+		IKCore::FPoseDatabase Database;
+		IKCore::FPoseDatabaseBakeSettings BakeSettings;
+		BakeSettings.NumSamples = 512;
+		Database.Bake(RestPose, Solver, Settings, BakeSettings);
+
+		IKCore::FWarmStartSettings WarmStartSettings;
+		WarmStartSettings.PoseDatabase = &Database;
+		WarmStartSettings.PoseDatabaseNeighbours = IKCore::FPoseDatabase::MaxNeighbours;
+
+		IKCore::FPose Pose = RestPose;
+		IKCore::FJacobianWorkspace Workspace(Pose.NumLinks());
+		IKCore::FChainSolveState SolveState;
+		size_t TargetIndex = 0;
+		CheckAllocations(std::string("SolveState/") + Name, [&]()
+		{
+			Pose = RestPose;
+			SolveState.Solve(Solver, Pose, Targets[TargetIndex], Eigen::Quaternionf::Identity(), Settings, WarmStartSettings, &Workspace);
+			TargetIndex = (TargetIndex + 1) % Targets.size();
+		});
+	}
+
+	/** Position and orientation targets on the 6-row Jacobian. */
+	void CheckSolveTransform(const char* Name, bool bWorkspace, int32_t NumBones)
+	{
+		const IKCore::FPose RestPose = MakeChain(NumBones);
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(64);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+
+		IKCore::FPose Pose = RestPose;
+		IKCore::FTransformJacobianWorkspace Workspace(Pose.NumLinks());
+		IKCore::FTransformTarget Target;
+		size_t TargetIndex = 0;
+		CheckAllocations(std::string("SolveTransform/") + Name + "/" + std::to_string(NumBones), [&]()
+		{
+			Pose = RestPose;
+			Target.Position = Targets[TargetIndex];
+			IKCore::Solve(IKCore::ESolver::DampedLeastSquares, Pose, Target, Settings, bWorkspace ? &Workspace : nullptr);
+			TargetIndex = (TargetIndex + 1) % Targets.size();
+		});
+	}
+
+	/** A multi-effector solver on a chain of NumBones bones with its tip as the effector. */
+	void CheckSolveMultiEffector(const char* Name, IKCore::ESolver Solver, bool bWorkspace, int32_t NumBones)
+	{
+		const IKCore::FPose Chain = MakeChain(NumBones);
+		IKCore::FTreePose RestPose;
+		for (int32_t Index = 0; Index < Chain.Num(); ++Index)
+		{
+			RestPose.Positions.push_back(Chain.Positions[Index]);
+			RestPose.Rotations.push_back(Chain.Rotations[Index]);
+			RestPose.Parents.push_back(Index - 1);
+		}
+		RestPose.UpdateLengths();
+
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(64);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+		std::vector<IKCore::FEffector> Effectors(1);
+		Effectors[0].BoneIndex = RestPose.Num() - 1;
+
+		IKCore::FTreePose Pose = RestPose;
+		IKCore::FMultiEffectorWorkspace Workspace;
+		size_t TargetIndex = 0;
+		CheckAllocations(std::string("SolveMultiEffector/") + Name + "/" + std::to_string(NumBones), [&]()
+		{
+			Pose = RestPose;
+			Effectors[0].Target = Targets[TargetIndex];
+			IKCore::SolveMultiEffector(Solver, Pose, Effectors, Settings, bWorkspace ? &Workspace : nullptr);
+			TargetIndex = (TargetIndex + 1) % Targets.size();
+		});
+	}
+
+	/** The batch kernels on 64 chains of NumBones bones, at the widest instruction set of the CPU. */
+	void CheckSolveBatch(const char* Name, bool bCCD, int32_t NumBones)
+	{
+		const IKCore::FPose RestPose = MakeChain(NumBones);
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(64);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+
+		IKCore::FChainBatch RestBatch;
+		RestBatch.Reset(static_cast<int32_t>(Targets.size()), RestPose.Num());
+		for (int32_t Chain = 0; Chain < RestBatch.NumChains; ++Chain)
+		{
+			RestBatch.SetChain(Chain, RestPose, Targets[Chain]);
+		}
+
+		IKCore::FChainBatch Batch = RestBatch;
+		CheckAllocations(std::string("SolveBatch/") + Name + "/" + std::to_string(NumBones), [&]()
+		{
+			Batch.PositionX = RestBatch.PositionX;
+			Batch.PositionY = RestBatch.PositionY;
+			Batch.PositionZ = RestBatch.PositionZ;
+			if (bCCD)
+			{
+				IKCore::SolveCCDBatch(Batch, Settings);
+			}
+			else
+			{
+				IKCore::SolveFABRIKBatch(Batch, Settings);
+			}
+		});
+	}
+}
+
+int main()
+{
+	// 48 bones is past the fixed-size Jacobians and the CCD stack buffer
+	for (int32_t NumBones : { 3, 8, 48 })
+	{
+		CheckSolve("CCD", IKCore::ESolver::CCD, false, NumBones);
+		CheckSolve("FABRIK", IKCore::ESolver::FABRIK, false, NumBones);
+		CheckSolve("JacobianTranspose", IKCore::ESolver::JacobianTranspose, true, NumBones);
+		CheckSolve("JacobianPinv", IKCore::ESolver::JacobianPinv, true, NumBones);
+		CheckSolve("DampedLeastSquares", IKCore::ESolver::DampedLeastSquares, true, NumBones);
+		CheckSolve("DampedLeastSquares/NoWorkspace", IKCore::ESolver::DampedLeastSquares, false, NumBones);
+		CheckSolve("Auto", IKCore::ESolver::Auto, true, NumBones);
+		CheckSolveTransform("Workspace", true, NumBones);
+		CheckSolveTransform("NoWorkspace", false, NumBones);
+	}
+	CheckSolveState("DampedLeastSquares", IKCore::ESolver::DampedLeastSquares);
+	CheckSolveState("Auto", IKCore::ESolver::Auto);
+	for (int32_t NumBones : { 8, 48 })
+	{
+		CheckSolveMultiEffector("FABRIK", IKCore::ESolver::FABRIK, true, NumBones);
+		CheckSolveMultiEffector("DampedLeastSquares", IKCore::ESolver::DampedLeastSquares, true, NumBones);
+		CheckSolveBatch("CCD", true, NumBones);
+		CheckSolveBatch("FABRIK", false, NumBones);
+	}
+	CheckSolveMultiEffector("DampedLeastSquares/NoWorkspace", IKCore::ESolver::DampedLeastSquares, false, 8);
+
+	if (NumFailed > 0)
+	{
+		std::printf("%d solve paths allocated on the heap\n", NumFailed);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,138 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreBenchmarkUtils.h"
+#include "IKCoreBatch.h"
+#include "IKCoreSolvers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+
+namespace
+{
+	using namespace IKCoreBenchmark;
+
+	// a crowd worth of chains, every one with its own target
+	constexpr int32_t NumCrowdChains = 256;
+
+	using FBatchSolver = void (*)(IKCore::FChainBatch&, const IKCore::FSolverSettings&, IKCore::ESimdLevel);
+	using FChainSolver = IKCore::FSolveResult (*)(IKCore::FPose&, const Eigen::Vector3f&, const IKCore::FSolverSettings&);
+
+	/**
+	 * One benchmark iteration resets every chain of the batch to its rest pose and solves all of them with SolveBatch.
+	 * Reports chains/sec (items_per_second) for the batch kernel of SimdLevel.
+	 */
+	void RunBatch(benchmark::State& State, FBatchSolver SolveBatch, IKCore::ESimdLevel SimdLevel)
+	{
+		if (IKCore::GetSupportedSimdLevel() < SimdLevel)
+		{
+			State.SkipWithError("instruction set not supported by this CPU");
+			return;
+		}
+
+		const IKCore::FPose RestPose = MakeChain(static_cast<int32_t>(State.range(0)));
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(NumCrowdChains);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+
+		IKCore::FChainBatch RestBatch;
+		RestBatch.Reset(NumCrowdChains, RestPose.Num());
+		for (int32_t Chain = 0; Chain < NumCrowdChains; ++Chain)
+		{
+			RestBatch.SetChain(Chain, RestPose, Targets[Chain]);
+		}
+
+		IKCore::FChainBatch Batch = RestBatch;
+		for (auto _ : State)
+		{
+			Batch.PositionX = RestBatch.PositionX;
+			Batch.PositionY = RestBatch.PositionY;
+			Batch.PositionZ = RestBatch.PositionZ;
+			SolveBatch(Batch, Settings, SimdLevel);
+			benchmark::DoNotOptimize(Batch.PositionX.data());
+		}
+
+		// a lane group runs as many iterations as its slowest lane, "lanes busy" is the share of that work that was not masked off
+		const int32_t SimdWidth = IKCore::GetSimdWidth(SimdLevel);
+		int64_t NumIterations = 0;
+		int64_t NumGroupIterations = 0;
+		int64_t NumConverged = 0;
+		for (int32_t Group = 0; Group < NumCrowdChains; Group += SimdWidth)
+		{
+			int32_t MaxIterations = 0;
+			for (int32_t Chain = Group; Chain < Group + SimdWidth; ++Chain)
+			{
+				const IKCore::FSolveResult Result = Batch.GetResult(Chain, Settings);
+				NumIterations += Result.Iterations;
+				NumConverged += Result.bConverged ? 1 : 0;
+				MaxIterations = std::max(MaxIterations, Result.Iterations);
+			}
+			NumGroupIterations += static_cast<int64_t>(MaxIterations) * SimdWidth;
+		}
+
+		State.SetItemsProcessed(State.iterations() * NumCrowdChains);
+		State.counters["iters/solve"] = static_cast<double>(NumIterations) / NumCrowdChains;
+		State.counters["converged"] = static_cast<double>(NumConverged) / NumCrowdChains;
+		State.counters["lanes busy"] = static_cast<double>(NumIterations) / static_cast<double>(NumGroupIterations);
+	}
+
+	/** The same crowd solved one chain at a time with Solve, the baseline for the batch kernels. */
+	void RunChains(benchmark::State& State, FChainSolver Solve)
+	{
+		const IKCore::FPose RestPose = MakeChain(static_cast<int32_t>(State.range(0)));
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(NumCrowdChains);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+
+		IKCore::FPose Pose = RestPose;
+		for (auto _ : State)
+		{
+			for (int32_t Chain = 0; Chain < NumCrowdChains; ++Chain)
+			{
+				Pose = RestPose;
+				Solve(Pose, Targets[Chain], Settings);
+				benchmark::DoNotOptimize(Pose.Positions.data());
+			}
+		}
+		State.SetItemsProcessed(State.iterations() * NumCrowdChains);
+	}
+
+	void BM_FABRIKBatch(benchmark::State& State, IKCore::ESimdLevel SimdLevel)
+	{
+		RunBatch(State, IKCore::SolveFABRIKBatch, SimdLevel);
+	}
+
+	void BM_FABRIKChains(benchmark::State& State)
+	{
+		RunChains(State, IKCore::SolveFABRIK);
+	}
+
+	void BM_CCDBatch(benchmark::State& State, IKCore::ESimdLevel SimdLevel)
+	{
+		RunBatch(State, IKCore::SolveCCDBatch, SimdLevel);
+	}
+
+	void BM_CCDChains(benchmark::State& State)
+	{
+		RunChains(State, IKCore::SolveCCD);
+	}
+
+	void CrowdChainLengths(benchmark::internal::Benchmark* Benchmark)
+	{
+		Benchmark->ArgName("joints");
+		for (int NumJoints : { 3, 4, 8, 16 })
+		{
+			Benchmark->Arg(NumJoints);
+		}
+	}
+}
+
+BENCHMARK(BM_FABRIKChains)->Apply(CrowdChainLengths);
+BENCHMARK_CAPTURE(BM_FABRIKBatch, Scalar, IKCore::ESimdLevel::Scalar)->Apply(CrowdChainLengths);
+BENCHMARK_CAPTURE(BM_FABRIKBatch, SSE, IKCore::ESimdLevel::SSE)->Apply(CrowdChainLengths);
+BENCHMARK_CAPTURE(BM_FABRIKBatch, AVX2, IKCore::ESimdLevel::AVX2)->Apply(CrowdChainLengths);
+BENCHMARK_CAPTURE(BM_FABRIKBatch, AVX512, IKCore::ESimdLevel::AVX512)->Apply(CrowdChainLengths);
+
+BENCHMARK(BM_CCDChains)->Apply(CrowdChainLengths);
+BENCHMARK_CAPTURE(BM_CCDBatch, Scalar, IKCore::ESimdLevel::Scalar)->Apply(CrowdChainLengths);
+BENCHMARK_CAPTURE(BM_CCDBatch, SSE, IKCore::ESimdLevel::SSE)->Apply(CrowdChainLengths);
+BENCHMARK_CAPTURE(BM_CCDBatch, AVX2, IKCore::ESimdLevel::AVX2)->Apply(CrowdChainLengths);
+BENCHMARK_CAPTURE(BM_CCDBatch, AVX512, IKCore::ESimdLevel::AVX512)->Apply(CrowdChainLengths);
@@ -0,0 +1,201 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreBenchmarkUtils.h"
+#include "IKCoreSolvers.h"
+#include "IKCoreSolveState.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+namespace
+{
+	using namespace IKCoreBenchmark;
+
+	/**
+	 * One benchmark iteration resets the chain to its rest pose and solves for the next target.
+	 * Reports solves/sec (items_per_second), time per solver iteration and the fraction of converged solves.
+	 * bBroydenUpdates has the Jacobian solvers update their Jacobian rather than rebuild it every iteration.
+	 */
+	void BM_Solve(benchmark::State& State, IKCore::ESolver Solver, bool bBroydenUpdates = false)
+	{
+		const IKCore::FPose RestPose = MakeChain(static_cast<int32_t>(State.range(0)));
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(64);
+		IKCore::FSolverSettings Settings = MakeSettings();
+		Settings.bBroydenUpdates = bBroydenUpdates;
+
+		IKCore::FPose Pose = RestPose;
+		IKCore::FJacobianWorkspace Workspace(Pose.NumLinks());
+		int64_t NumSolves = 0;
+		int64_t NumIterations = 0;
+		int64_t NumConverged = 0;
+		for (auto _ : State)
+		{
+			Pose = RestPose;
+			const IKCore::FSolveResult Result = IKCore::Solve(Solver, Pose, Targets[NumSolves % Targets.size()], Settings, &Workspace);
+			benchmark::DoNotOptimize(Pose.Positions.data());
+
+			++NumSolves;
+			NumIterations += Result.Iterations;
+			NumConverged += Result.bConverged ? 1 : 0;
+		}
+
+		State.SetItemsProcessed(NumSolves);
+		State.counters["time/iter"] = benchmark::Counter(static_cast<double>(NumIterations), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+		State.counters["iters/solve"] = static_cast<double>(NumIterations) / static_cast<double>(NumSolves);
+		State.counters["converged"] = static_cast<double>(NumConverged) / static_cast<double>(NumSolves);
+	}
+
+	/**
+	 * Frame to frame solves of an animated chain: every frame restarts from the rest pose, like an animation graph does,
+	 * while the target moves range(0) / 100 units per frame along a circle (0 keeps it still).
+	 * Cold solves start from the rest pose every frame; with bUseSolveState the chain warm starts and skips unchanged solves.
+	 * With bBroydenUpdates as well, a warm started frame builds its Jacobian once and only updates it after that.
+	 */
+	void BM_SolveCoherent(benchmark::State& State, IKCore::ESolver Solver, bool bUseSolveState, bool bBroydenUpdates = false)
+	{
+		const IKCore::FPose RestPose = MakeChain(8);
+		IKCore::FSolverSettings Settings = MakeSettings();
+		Settings.bBroydenUpdates = bBroydenUpdates;
+		const IKCore::FWarmStartSettings WarmStartSettings;
+		const float Speed = static_cast<float>(State.range(0)) / 100.f;
+		const float Radius = 0.5f * ChainReach;
+
+		IKCore::FPose Pose = RestPose;
+		IKCore::FJacobianWorkspace Workspace(Pose.NumLinks());
+		IKCore::FChainSolveState SolveState;
+		int64_t NumFrames = 0;
+		int64_t NumIterations = 0;
+		for (auto _ : State)
+		{
+			const float Angle = Speed * static_cast<float>(NumFrames) / Radius;
+			const Eigen::Vector3f Target(Radius * std::cos(Angle), Radius * std::sin(Angle), 0.25f * ChainReach);
+
+			Pose = RestPose;
+			const IKCore::FSolveResult Result = bUseSolveState
+				? SolveState.Solve(Solver, Pose, Target, Eigen::Quaternionf::Identity(), Settings, WarmStartSettings, &Workspace)
+				: IKCore::Solve(Solver, Pose, Target, Settings, &Workspace);
+			benchmark::DoNotOptimize(Pose.Positions.data());
+
+			++NumFrames;
+			NumIterations += Result.Iterations;
+		}
+
+		State.SetItemsProcessed(NumFrames);
+		State.counters["iters/solve"] = static_cast<double>(NumIterations) / static_cast<double>(NumFrames);
+		State.counters["skipped"] = static_cast<double>(SolveState.GetNumSkipped()) / static_cast<double>(NumFrames);
+	}
+
+	/**
+	 * Tip positions and rotations of the chain with every joint turned by up to MaxAngle radians about a random axis,
+	 * so that each target can be reached in both position and orientation.
+	 */
+	IKCore::TAlignedArray<IKCore::FTransformTarget> MakeTransformTargets(const IKCore::FPose& RestPose, int32_t NumTargets, float MaxAngle = 0.5f)
+	{
+		std::mt19937 Random(42);
+		std::normal_distribution<float> Normal;
+		std::uniform_real_distribution<float> Angle(0.f, MaxAngle);
+
+		IKCore::TAlignedArray<IKCore::FTransformTarget> Targets(NumTargets);
+		for (IKCore::FTransformTarget& Target : Targets)
+		{
+			IKCore::FPose Pose = RestPose;
+			Pose.RotateBones(0, [&](int32_t)
+			{
+				const Eigen::Vector3f Axis = Eigen::Vector3f(Normal(Random), Normal(Random), Normal(Random)).normalized();
+				return Eigen::Quaternionf(Eigen::AngleAxisf(Angle(Random), Axis));
+			});
+			Target.Position = Pose.TipPosition();
+			Target.Rotation = Pose.Rotations.back();
+		}
+		return Targets;
+	}
+
+	/**
+	 * Position and orientation targets, solved from the rest pose. "angle residual" is the mean angle left between the
+	 * tip and the target rotation, in radians; the CCD and FABRIK baselines turn the tip bone after the position solve.
+	 */
+	void BM_SolveTransform(benchmark::State& State, IKCore::ESolver Solver)
+	{
+		const IKCore::FPose RestPose = MakeChain(static_cast<int32_t>(State.range(0)));
+		const IKCore::TAlignedArray<IKCore::FTransformTarget> Targets = MakeTransformTargets(RestPose, 64);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+
+		IKCore::FPose Pose = RestPose;
+		IKCore::FTransformJacobianWorkspace Workspace(Pose.NumLinks());
+		int64_t NumSolves = 0;
+		int64_t NumIterations = 0;
+		int64_t NumConverged = 0;
+		double AngleResidualSum = 0.0;
+		for (auto _ : State)
+		{
+			Pose = RestPose;
+			const IKCore::FTransformTarget& Target = Targets[NumSolves % Targets.size()];
+			const IKCore::FSolveResult Result = IKCore::Solve(Solver, Pose, Target, Settings, &Workspace);
+			benchmark::DoNotOptimize(Pose.Positions.data());
+
+			++NumSolves;
+			NumIterations += Result.Iterations;
+			NumConverged += Result.bConverged ? 1 : 0;
+
+			// the baselines only see the rotation of the tip bone, not what it did to the link above
+			const Eigen::Quaternionf LinkRotation = Pose.Rotations[Pose.NumLinks() - 1] * RestPose.Rotations[Pose.NumLinks() - 1].conjugate() * RestPose.Rotations.back();
+			AngleResidualSum += LinkRotation.angularDistance(Target.Rotation);
+		}
+
+		State.SetItemsProcessed(NumSolves);
+		State.counters["iters/solve"] = static_cast<double>(NumIterations) / static_cast<double>(NumSolves);
+		State.counters["converged"] = static_cast<double>(NumConverged) / static_cast<double>(NumSolves);
+		State.counters["angle residual"] = AngleResidualSum / static_cast<double>(NumSolves);
+	}
+
+	void TargetSpeeds(benchmark::internal::Benchmark* Benchmark)
+	{
+		Benchmark->ArgName("speed");
+		for (int Speed : { 0, 10, 100 })
+		{
+			Benchmark->Arg(Speed);
+		}
+	}
+
+	void ChainLengths(benchmark::internal::Benchmark* Benchmark)
+	{
+		Benchmark->ArgName("joints");
+		for (int NumJoints : { 2, 3, 4, 6, 8, 16, 32, 64 })
+		{
+			Benchmark->Arg(NumJoints);
+		}
+	}
+
+	// an orientation target needs at least three links to leave the chain any freedom
+	void TransformChainLengths(benchmark::internal::Benchmark* Benchmark)
+	{
+		Benchmark->ArgName("joints");
+		for (int NumJoints : { 4, 5, 7, 8, 16 })
+		{
+			Benchmark->Arg(NumJoints);
+		}
+	}
+}
+
+BENCHMARK_CAPTURE(BM_Solve, CCD, IKCore::ESolver::CCD)->Apply(ChainLengths);
+BENCHMARK_CAPTURE(BM_Solve, FABRIK, IKCore::ESolver::FABRIK)->Apply(ChainLengths);
+BENCHMARK_CAPTURE(BM_Solve, JacobianTranspose, IKCore::ESolver::JacobianTranspose)->Apply(ChainLengths);
+BENCHMARK_CAPTURE(BM_Solve, JacobianPinv, IKCore::ESolver::JacobianPinv)->Apply(ChainLengths);
+BENCHMARK_CAPTURE(BM_Solve, DampedLeastSquares, IKCore::ESolver::DampedLeastSquares)->Apply(ChainLengths);
+BENCHMARK_CAPTURE(BM_Solve, TwoBone, IKCore::ESolver::TwoBone)->ArgName("joints")->Arg(3);
+BENCHMARK_CAPTURE(BM_Solve, Auto, IKCore::ESolver::Auto)->Apply(ChainLengths);
+BENCHMARK_CAPTURE(BM_Solve, JacobianPinv/Broyden, IKCore::ESolver::JacobianPinv, true)->Apply(ChainLengths);
+BENCHMARK_CAPTURE(BM_Solve, DampedLeastSquares/Broyden, IKCore::ESolver::DampedLeastSquares, true)->Apply(ChainLengths);
+
+BENCHMARK_CAPTURE(BM_SolveCoherent, DampedLeastSquares/Cold, IKCore::ESolver::DampedLeastSquares, false)->Apply(TargetSpeeds);
+BENCHMARK_CAPTURE(BM_SolveCoherent, DampedLeastSquares/WarmStart, IKCore::ESolver::DampedLeastSquares, true)->Apply(TargetSpeeds);
+BENCHMARK_CAPTURE(BM_SolveCoherent, DampedLeastSquares/WarmStart/Broyden, IKCore::ESolver::DampedLeastSquares, true, true)->Apply(TargetSpeeds);
+BENCHMARK_CAPTURE(BM_SolveCoherent, FABRIK/Cold, IKCore::ESolver::FABRIK, false)->Apply(TargetSpeeds);
+BENCHMARK_CAPTURE(BM_SolveCoherent, FABRIK/WarmStart, IKCore::ESolver::FABRIK, true)->Apply(TargetSpeeds);
+BENCHMARK_CAPTURE(BM_SolveCoherent, Auto/Cold, IKCore::ESolver::Auto, false)->Apply(TargetSpeeds);
+BENCHMARK_CAPTURE(BM_SolveCoherent, Auto/WarmStart, IKCore::ESolver::Auto, true)->Apply(TargetSpeeds);
+
+BENCHMARK_CAPTURE(BM_SolveTransform, FABRIK, IKCore::ESolver::FABRIK)->Apply(TransformChainLengths);
+BENCHMARK_CAPTURE(BM_SolveTransform, JacobianPinv, IKCore::ESolver::JacobianPinv)->Apply(TransformChainLengths);
+BENCHMARK_CAPTURE(BM_SolveTransform, DampedLeastSquares, IKCore::ESolver::DampedLeastSquares)->Apply(TransformChainLengths);
@@ -0,0 +1,63 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "IKCoreTypes.h"
+
+#include <cmath>
+#include <random>
+
+namespace IKCoreBenchmark
+{
+	// every synthetic chain has the same reach, so targets and precision mean the same thing for all lengths
+	constexpr float ChainReach = 100.f;
+
+	/** Chain of NumBones bones on a gentle arc in the XY plane, each bone's X axis pointing at its child. */
+	inline IKCore::FPose MakeChain(int32_t NumBones)
+	{
+		IKCore::FPose Pose;
+		const float LinkLength = ChainReach / static_cast<float>(NumBones - 1);
+		const float BendPerLink = 1.f / static_cast<float>(NumBones);
+
+		Eigen::Vector3f Position = Eigen::Vector3f::Zero();
+		for (int32_t Index = 0; Index < NumBones; ++Index)
+		{
+			const float Heading = BendPerLink * static_cast<float>(Index);
+			const Eigen::Vector3f Direction(std::cos(Heading), std::sin(Heading), 0.f);
+
+			Pose.Positions.push_back(Position);
+			Pose.Rotations.push_back(Eigen::Quaternionf::FromTwoVectors(Eigen::Vector3f::UnitX(), Direction));
+			Position += Direction * LinkLength;
+		}
+		Pose.UpdateLengths();
+		return Pose;
+	}
+
+	/** Reachable targets between 30% and 90% of the reach, in random directions around the root. */
+	inline std::vector<Eigen::Vector3f> MakeTargets(int32_t NumTargets, uint32_t Seed = 42)
+	{
+		std::mt19937 Random(Seed);
+		std::normal_distribution<float> Normal;
+		std::uniform_real_distribution<float> Radius(0.3f * ChainReach, 0.9f * ChainReach);
+
+		std::vector<Eigen::Vector3f> Targets;
+		Targets.reserve(NumTargets);
+		for (int32_t Index = 0; Index < NumTargets; ++Index)
+		{
+			const Eigen::Vector3f Direction = Eigen::Vector3f(Normal(Random), Normal(Random), Normal(Random)).normalized();
+			Targets.push_back(Direction * Radius(Random));
+		}
+		return Targets;
+	}
+
+	inline IKCore::FSolverSettings MakeSettings()
+	{
+		IKCore::FSolverSettings Settings;
+		Settings.Precision = 0.001f * ChainReach;
+		Settings.MaxIterations = 64;
+
+		// keep the per-solver numbers honest on three joint chains, the analytic path has its own benchmark
+		Settings.bAnalyticTwoBone = false;
+		return Settings;
+	}
+}
@@ -0,0 +1,86 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreBenchmarkUtils.h"
+#include "IKCoreBudget.h"
+#include "IKCoreSolveState.h"
+#include "IKCoreSolvers.h"
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+
+namespace
+{
+	using namespace IKCoreBenchmark;
+	using FClock = std::chrono::steady_clock;
+
+	constexpr int32_t NumCrowdJoints = 8;
+	constexpr double CrowdBudgetSeconds = 0.001;
+
+	/**
+	 * One benchmark iteration is one frame of range(0) characters, each solving one DLS chain towards a target circling
+	 * at its own speed, with the tiers of a 1 ms budget assigned from random significances and the previous frame's times.
+	 * The "ms/frame" counter should level off near the budget as the crowd grows while "full" drops.
+	 */
+	void BM_BudgetedCrowd(benchmark::State& State)
+	{
+		const int32_t NumCharacters = static_cast<int32_t>(State.range(0));
+		const IKCore::FPose RestPose = MakeChain(NumCrowdJoints);
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(NumCharacters);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+
+		std::mt19937 Random(7);
+		std::uniform_real_distribution<float> Significance(0.f, 1.f);
+		std::vector<float> Significances(NumCharacters);
+		for (float& CharacterSignificance : Significances)
+		{
+			CharacterSignificance = Significance(Random);
+		}
+
+		IKCore::FBudgetSettings BudgetSettings;
+		BudgetSettings.BudgetSeconds = CrowdBudgetSeconds;
+
+		std::vector<IKCore::FPose> Poses(NumCharacters, RestPose);
+		std::vector<IKCore::FChainSolveState> SolveStates(NumCharacters);
+		IKCore::FJacobianWorkspace Workspace;
+		IKCore::FFrameBudget Budget;
+
+		int64_t Frame = 0;
+		double SumFrameSeconds = 0.0;
+		int64_t NumFull = 0;
+		for (auto _ : State)
+		{
+			Budget.BeginFrame(BudgetSettings);
+			for (int32_t Index = 0; Index < NumCharacters; ++Index)
+			{
+				Budget.AddRequest(Significances[Index], 1);
+			}
+			Budget.AssignTiers();
+			NumFull += Budget.GetNumInTier(IKCore::ELODTier::Full);
+
+			const FClock::time_point FrameStart = FClock::now();
+			for (int32_t Index = 0; Index < NumCharacters; ++Index)
+			{
+				const IKCore::ELODTier Tier = Budget.GetTier(Index);
+				IKCore::FWarmStartSettings WarmStartSettings;
+				WarmStartSettings.IntervalFrames = Tier == IKCore::ELODTier::Interval ? BudgetSettings.IntervalFrames : 1;
+
+				const float Angle = 0.05f * static_cast<float>(Frame) * (1.f + static_cast<float>(Index % 5));
+				const Eigen::Vector3f Target = Eigen::AngleAxisf(Angle, Eigen::Vector3f::UnitZ()) * Targets[Index];
+
+				const FClock::time_point SolveStart = FClock::now();
+				Poses[Index] = RestPose;
+				SolveStates[Index].Solve(IKCore::ESolver::DampedLeastSquares, Poses[Index], Target, Eigen::Quaternionf::Identity(),
+					IKCore::GetTierSettings(Tier, Settings, BudgetSettings), WarmStartSettings, &Workspace);
+				Budget.ReportSolve(Tier, std::chrono::duration<double>(FClock::now() - SolveStart).count());
+			}
+			SumFrameSeconds += std::chrono::duration<double>(FClock::now() - FrameStart).count();
+			++Frame;
+		}
+
+		State.SetItemsProcessed(State.iterations() * NumCharacters);
+		State.counters["ms/frame"] = 1000.0 * SumFrameSeconds / static_cast<double>(State.iterations());
+		State.counters["full"] = static_cast<double>(NumFull) / static_cast<double>(State.iterations());
+	}
+}
+
+BENCHMARK(BM_BudgetedCrowd)->ArgName("characters")->RangeMultiplier(4)->Range(16, 4096);
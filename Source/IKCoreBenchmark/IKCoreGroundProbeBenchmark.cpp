@@ -0,0 +1,136 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreGroundProbe.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+
+namespace
+{
+	constexpr int32_t NumFeet = 2;
+	constexpr float FootHeight = 10.f;
+	constexpr float FrameSeconds = 1.f / 60.f;
+
+	/** 100 m square of rolling ground with a 2 m sample spacing, up to 1 m high. */
+	const IKCore::FHeightfieldGroundQuery& GetTerrain()
+	{
+		static IKCore::FHeightfieldGroundQuery Terrain;
+		static bool bInitialized = false;
+		if (!bInitialized)
+		{
+			constexpr int32_t NumSamples = 51;
+			std::vector<float> Heights(NumSamples * NumSamples);
+			for (int32_t Y = 0; Y < NumSamples; ++Y)
+			{
+				for (int32_t X = 0; X < NumSamples; ++X)
+				{
+					Heights[Y * NumSamples + X] = 50.f * (std::sin(0.3f * static_cast<float>(X)) + std::cos(0.2f * static_cast<float>(Y)));
+				}
+			}
+			Terrain.SetHeights(Eigen::Vector3f(-5000.f, -5000.f, 0.f), 200.f, NumSamples, NumSamples, Heights);
+			bInitialized = true;
+		}
+		return Terrain;
+	}
+
+	/**
+	 * range(0) characters walking across the terrain: every frame each one turns last frame's hits into foot targets and
+	 * queues the probes of its feet, then the whole frame's probes go to the heightfield as one batch. Reports frames/sec
+	 * and how far the smoothed feet are from FootHeight over the ground below them.
+	 */
+	void BM_FootPlacementFrame(benchmark::State& State)
+	{
+		const int32_t NumCharacters = static_cast<int32_t>(State.range(0));
+		IKCore::FHeightfieldGroundQuery Terrain = GetTerrain();
+		IKCore::FGroundProbeQueue Queue;
+		Queue.SetBackend(&Terrain);
+
+		std::mt19937 Random(42);
+		std::uniform_real_distribution<float> Coordinate(-4000.f, 4000.f);
+		std::vector<Eigen::Vector3f> Positions(NumCharacters);
+		for (Eigen::Vector3f& Position : Positions)
+		{
+			Position = Eigen::Vector3f(Coordinate(Random), Coordinate(Random), 0.f);
+		}
+
+		const Eigen::Vector3f Up = Eigen::Vector3f::UnitZ();
+		const Eigen::Vector3f Velocity(150.f * FrameSeconds, 0.f, 0.f);
+		const IKCore::FFootPlacementSettings Settings = []()
+		{
+			IKCore::FFootPlacementSettings Result;
+			Result.FootHeight = FootHeight;
+			Result.ProbeAbove = 150.f;
+			Result.ProbeBelow = 150.f;
+			return Result;
+		}();
+
+		std::vector<IKCore::FFootPlacement> Placements(NumCharacters);
+		for (IKCore::FFootPlacement& Placement : Placements)
+		{
+			Placement.Reset(NumFeet);
+		}
+		std::vector<int32_t> FirstProbes(NumCharacters, -1);
+		Eigen::Vector3f Feet[NumFeet];
+		Eigen::Vector3f Targets[NumFeet];
+		IKCore::FGroundProbe Probes[NumFeet];
+
+		double SummedError = 0.0;
+		int64_t NumErrors = 0;
+		for (auto _ : State)
+		{
+			for (int32_t Character = 0; Character < NumCharacters; ++Character)
+			{
+				// the animated feet stay on the character's flat ground plane, the terrain rolls under them
+				Positions[Character] += Velocity;
+				if (Positions[Character].x() > 4500.f)
+				{
+					Positions[Character].x() = -4500.f;
+				}
+				Feet[0] = Positions[Character] + Eigen::Vector3f(0.f, -15.f, FootHeight);
+				Feet[1] = Positions[Character] + Eigen::Vector3f(0.f, 15.f, FootHeight);
+
+				const IKCore::FGroundHit* Hits = FirstProbes[Character] >= 0 ? Queue.GetHits(FirstProbes[Character], NumFeet) : nullptr;
+				Placements[Character].Update(Hits, Feet, Up, Settings, FrameSeconds, Targets);
+				benchmark::DoNotOptimize(Targets);
+
+				Placements[Character].MakeProbes(Feet, Up, Settings, nullptr, Probes);
+				FirstProbes[Character] = Queue.Add(Probes, NumFeet);
+
+				SummedError += std::abs(Targets[0].z() - Terrain.GetHeight(Targets[0].x(), Targets[0].y()) - FootHeight);
+				++NumErrors;
+			}
+			Queue.Submit();
+		}
+
+		State.SetItemsProcessed(State.iterations());
+		State.counters["probes/frame"] = static_cast<double>(NumCharacters * NumFeet);
+		State.counters["foot error"] = SummedError / static_cast<double>(NumErrors);
+	}
+
+	/** One probe through the heightfield, straight down through 3 m. */
+	void BM_HeightfieldTrace(benchmark::State& State)
+	{
+		const IKCore::FHeightfieldGroundQuery& Terrain = GetTerrain();
+		std::mt19937 Random(42);
+		std::uniform_real_distribution<float> Coordinate(-4000.f, 4000.f);
+		std::vector<IKCore::FGroundProbe> Probes(256);
+		for (IKCore::FGroundProbe& Probe : Probes)
+		{
+			Probe.Start = Eigen::Vector3f(Coordinate(Random), Coordinate(Random), 150.f);
+			Probe.End = Probe.Start - Eigen::Vector3f(0.f, 0.f, 300.f);
+		}
+
+		size_t ProbeIndex = 0;
+		for (auto _ : State)
+		{
+			benchmark::DoNotOptimize(Terrain.Trace(Probes[ProbeIndex]));
+			ProbeIndex = (ProbeIndex + 1) % Probes.size();
+		}
+		State.SetItemsProcessed(State.iterations());
+	}
+}
+
+BENCHMARK(BM_FootPlacementFrame)->Arg(1)->Arg(64)->Arg(512);
+BENCHMARK(BM_HeightfieldTrace);
@@ -0,0 +1,190 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreBenchmarkUtils.h"
+#include "IKCoreSolveState.h"
+#include "IKCoreSolvers.h"
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+	using namespace IKCoreBenchmark;
+
+	/**
+	 * Limits on every bone of RestPose but the tip, around its rest rotation: the root may swing 120 degrees so the
+	 * targets all around it stay reachable, the other bones 60, and every bone twists by up to 45 degrees either way.
+	 */
+	void AddJointLimits(IKCore::FPose& RestPose)
+	{
+		constexpr float Degrees = 3.14159265f / 180.f;
+		RestPose.JointLimits.clear();
+		Eigen::Quaternionf ParentRotation = RestPose.RootParentRotation;
+		for (int32_t Index = 0; Index < RestPose.NumLinks(); ++Index)
+		{
+			const Eigen::Quaternionf RestRotation = ParentRotation.conjugate() * RestPose.Rotations[Index];
+			const float SwingLimit = (Index == 0 ? 120.f : 60.f) * Degrees;
+			RestPose.JointLimits.emplace_back(RestRotation, Eigen::Vector3f::UnitX(), SwingLimit, -45.f * Degrees, 45.f * Degrees);
+			ParentRotation = RestPose.Rotations[Index];
+		}
+	}
+
+	/**
+	 * Tip positions of LimitedPose with every bone turned from its rest rotation by up to MaxAngle radians about a random
+	 * axis and then clamped to its limits, so that each target can be reached with the limits as well as without them.
+	 */
+	std::vector<Eigen::Vector3f> MakeLimitedTargets(const IKCore::FPose& LimitedPose, int32_t NumTargets, float MaxAngle = 1.f)
+	{
+		std::mt19937 Random(42);
+		std::normal_distribution<float> Normal;
+		std::uniform_real_distribution<float> Angle(0.f, MaxAngle);
+
+		std::vector<Eigen::Vector3f> Targets;
+		Targets.reserve(NumTargets);
+		for (int32_t TargetIndex = 0; TargetIndex < NumTargets; ++TargetIndex)
+		{
+			Eigen::Vector3f Position = LimitedPose.Positions[0];
+			Eigen::Quaternionf RestParentRotation = LimitedPose.RootParentRotation;
+			Eigen::Quaternionf ParentRotation = LimitedPose.RootParentRotation;
+			for (int32_t Index = 0; Index < LimitedPose.NumLinks(); ++Index)
+			{
+				const Eigen::Quaternionf& RestRotation = LimitedPose.Rotations[Index];
+				const Eigen::Vector3f Axis = Eigen::Vector3f(Normal(Random), Normal(Random), Normal(Random)).normalized();
+				const Eigen::Quaternionf LocalRotation = Eigen::AngleAxisf(Angle(Random), Axis) * (RestParentRotation.conjugate() * RestRotation);
+				const Eigen::Quaternionf Rotation = LimitedPose.ConstrainRotation(Index, ParentRotation, ParentRotation * LocalRotation);
+
+				Position += Rotation * (RestRotation.conjugate() * (LimitedPose.Positions[Index + 1] - LimitedPose.Positions[Index]));
+				RestParentRotation = RestRotation;
+				ParentRotation = Rotation;
+			}
+			Targets.push_back(Position);
+		}
+		return Targets;
+	}
+
+	/** Mean angle, in radians, by which the bones of Pose are outside the limits of LimitedPose under RootParentRotation. */
+	double GetViolation(const IKCore::FPose& LimitedPose, const IKCore::FPose& Pose, const Eigen::Quaternionf& RootParentRotation)
+	{
+		double Violation = 0.0;
+		Eigen::Quaternionf ParentRotation = RootParentRotation;
+		for (int32_t Index = 0; Index < Pose.NumLinks(); ++Index)
+		{
+			const Eigen::Quaternionf& Rotation = Pose.Rotations[Index];
+			Violation += LimitedPose.ConstrainRotation(Index, ParentRotation, Rotation).angularDistance(Rotation);
+			ParentRotation = Rotation;
+		}
+		return Violation / static_cast<double>(Pose.NumLinks());
+	}
+
+	/**
+	 * Solves from the rest pose with the joint limits of AddJointLimits when bLimited is set, for the cost of enforcing
+	 * them in every iteration. The targets are the same in both modes and all reachable within the limits, so the free
+	 * and limited rows compare iterations and convergence on the same problems. "violation" is the mean angle, in
+	 * radians, by which the solved bones end up outside their limits, which stays zero when they are enforced.
+	 */
+	void BM_SolveLimited(benchmark::State& State, IKCore::ESolver Solver, bool bLimited)
+	{
+		IKCore::FPose RestPose = MakeChain(static_cast<int32_t>(State.range(0)));
+		IKCore::FPose LimitedPose = RestPose;
+		AddJointLimits(LimitedPose);
+		if (bLimited)
+		{
+			RestPose = LimitedPose;
+		}
+		const std::vector<Eigen::Vector3f> Targets = MakeLimitedTargets(LimitedPose, 64);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+
+		IKCore::FPose Pose = RestPose;
+		IKCore::FJacobianWorkspace Workspace(Pose.NumLinks());
+		int64_t NumSolves = 0;
+		int64_t NumIterations = 0;
+		int64_t NumConverged = 0;
+		double ViolationSum = 0.0;
+		for (auto _ : State)
+		{
+			Pose = RestPose;
+			const IKCore::FSolveResult Result = IKCore::Solve(Solver, Pose, Targets[NumSolves % Targets.size()], Settings, &Workspace);
+			benchmark::DoNotOptimize(Pose.Positions.data());
+
+			++NumSolves;
+			NumIterations += Result.Iterations;
+			NumConverged += Result.bConverged ? 1 : 0;
+			ViolationSum += GetViolation(LimitedPose, Pose, Pose.RootParentRotation);
+		}
+
+		State.SetItemsProcessed(NumSolves);
+		State.counters["time/iter"] = benchmark::Counter(static_cast<double>(NumIterations), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+		State.counters["iters/solve"] = static_cast<double>(NumIterations) / static_cast<double>(NumSolves);
+		State.counters["converged"] = static_cast<double>(NumConverged) / static_cast<double>(NumSolves);
+		State.counters["violation"] = ViolationSum / static_cast<double>(NumSolves);
+	}
+
+	/**
+	 * The animation graph node's solve of a limited chain: every frame starts from the rest pose turned with the root's
+	 * parent, which sways about Z, and goes through the chain's solve state with that parent rotation while the target
+	 * circles in front of the chain. "violation" stays zero only when the limits are held against the turned parent.
+	 */
+	void BM_SolveCoherentLimited(benchmark::State& State, IKCore::ESolver Solver)
+	{
+		IKCore::FPose RestPose = MakeChain(8);
+		AddJointLimits(RestPose);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+		const IKCore::FWarmStartSettings WarmStartSettings;
+		const float Radius = 0.5f * ChainReach;
+
+		IKCore::FPose Pose = RestPose;
+		IKCore::FJacobianWorkspace Workspace(Pose.NumLinks());
+		IKCore::FChainSolveState SolveState;
+		int64_t NumFrames = 0;
+		int64_t NumIterations = 0;
+		int64_t NumConverged = 0;
+		double ViolationSum = 0.0;
+		for (auto _ : State)
+		{
+			const float Time = 0.05f * static_cast<float>(NumFrames);
+			const Eigen::Quaternionf ParentRotation(Eigen::AngleAxisf(0.5f * std::sin(Time), Eigen::Vector3f::UnitZ()));
+			const Eigen::Vector3f Target = ParentRotation * Eigen::Vector3f(Radius, 0.5f * Radius * std::cos(0.7f * Time), 0.5f * Radius * std::sin(0.7f * Time));
+
+			for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+			{
+				Pose.Positions[Index] = ParentRotation * RestPose.Positions[Index];
+				Pose.Rotations[Index] = ParentRotation * RestPose.Rotations[Index];
+			}
+			const Eigen::Quaternionf RootParentRotation = ParentRotation * RestPose.RootParentRotation;
+			Pose.RootParentRotation = RootParentRotation;
+			const IKCore::FSolveResult Result = SolveState.Solve(Solver, Pose, Target, RootParentRotation, Settings, WarmStartSettings, &Workspace);
+			benchmark::DoNotOptimize(Pose.Positions.data());
+
+			++NumFrames;
+			NumIterations += Result.Iterations;
+			NumConverged += Result.bConverged ? 1 : 0;
+			ViolationSum += GetViolation(RestPose, Pose, RootParentRotation);
+		}
+
+		State.SetItemsProcessed(NumFrames);
+		State.counters["iters/solve"] = static_cast<double>(NumIterations) / static_cast<double>(NumFrames);
+		State.counters["converged"] = static_cast<double>(NumConverged) / static_cast<double>(NumFrames);
+		State.counters["violation"] = ViolationSum / static_cast<double>(NumFrames);
+	}
+
+	void LimitedChainLengths(benchmark::internal::Benchmark* Benchmark)
+	{
+		Benchmark->ArgName("joints");
+		for (int NumJoints : { 3, 4, 8, 16 })
+		{
+			Benchmark->Arg(NumJoints);
+		}
+	}
+}
+
+BENCHMARK_CAPTURE(BM_SolveLimited, CCD/Free, IKCore::ESolver::CCD, false)->Apply(LimitedChainLengths);
+BENCHMARK_CAPTURE(BM_SolveLimited, CCD/Limited, IKCore::ESolver::CCD, true)->Apply(LimitedChainLengths);
+BENCHMARK_CAPTURE(BM_SolveLimited, FABRIK/Free, IKCore::ESolver::FABRIK, false)->Apply(LimitedChainLengths);
+BENCHMARK_CAPTURE(BM_SolveLimited, FABRIK/Limited, IKCore::ESolver::FABRIK, true)->Apply(LimitedChainLengths);
+BENCHMARK_CAPTURE(BM_SolveLimited, DampedLeastSquares/Free, IKCore::ESolver::DampedLeastSquares, false)->Apply(LimitedChainLengths);
+BENCHMARK_CAPTURE(BM_SolveLimited, DampedLeastSquares/Limited, IKCore::ESolver::DampedLeastSquares, true)->Apply(LimitedChainLengths);
+BENCHMARK_CAPTURE(BM_SolveLimited, Auto/Free, IKCore::ESolver::Auto, false)->Apply(LimitedChainLengths);
+BENCHMARK_CAPTURE(BM_SolveLimited, Auto/Limited, IKCore::ESolver::Auto, true)->Apply(LimitedChainLengths);
+
+BENCHMARK_CAPTURE(BM_SolveCoherentLimited, FABRIK, IKCore::ESolver::FABRIK);
+BENCHMARK_CAPTURE(BM_SolveCoherentLimited, DampedLeastSquares, IKCore::ESolver::DampedLeastSquares);
+BENCHMARK_CAPTURE(BM_SolveCoherentLimited, Auto, IKCore::ESolver::Auto);
@@ -0,0 +1,277 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreMultiEffector.h"
+#include "IKCoreSolvers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	// number of target sets cycled through, so no solve starts where the previous one converged
+	constexpr int32_t NumTargetSets = 64;
+
+	struct FHumanoid
+	{
+		IKCore::FTreePose Pose;
+
+		// hands then feet
+		std::vector<int32_t> TipBones;
+
+		// bones from the pelvis to each tip
+		std::vector<std::vector<int32_t>> Chains;
+	};
+
+	int32_t AddBone(IKCore::FTreePose& Pose, int32_t Parent, const Eigen::Vector3f& Offset)
+	{
+		Pose.Positions.push_back(Parent < 0 ? Offset : Eigen::Vector3f(Pose.Positions[Parent] + Offset));
+		Pose.Rotations.push_back(Eigen::Quaternionf::Identity());
+		Pose.Parents.push_back(Parent);
+		return Pose.Num() - 1;
+	}
+
+	/** Pelvis, three spine bones, two arms off the top of the spine and two legs off the pelvis, in centimeters. */
+	FHumanoid MakeHumanoid()
+	{
+		FHumanoid Humanoid;
+		IKCore::FTreePose& Pose = Humanoid.Pose;
+		const int32_t Pelvis = AddBone(Pose, -1, Eigen::Vector3f(0.f, 0.f, 100.f));
+		int32_t Spine = Pelvis;
+		for (int32_t Index = 0; Index < 3; ++Index)
+		{
+			Spine = AddBone(Pose, Spine, Eigen::Vector3f(0.f, 1.f, 15.f));
+		}
+
+		for (float Side : { 1.f, -1.f })
+		{
+			const int32_t Clavicle = AddBone(Pose, Spine, Eigen::Vector3f(Side * 5.f, 0.f, 10.f));
+			const int32_t UpperArm = AddBone(Pose, Clavicle, Eigen::Vector3f(Side * 15.f, 0.f, 0.f));
+			const int32_t LowerArm = AddBone(Pose, UpperArm, Eigen::Vector3f(Side * 20.f, 0.f, -18.f));
+			Humanoid.TipBones.push_back(AddBone(Pose, LowerArm, Eigen::Vector3f(Side * 15.f, 10.f, -15.f)));
+		}
+		for (float Side : { 1.f, -1.f })
+		{
+			const int32_t Thigh = AddBone(Pose, Pelvis, Eigen::Vector3f(Side * 10.f, 0.f, -5.f));
+			const int32_t Calf = AddBone(Pose, Thigh, Eigen::Vector3f(0.f, 3.f, -45.f));
+			Humanoid.TipBones.push_back(AddBone(Pose, Calf, Eigen::Vector3f(0.f, -3.f, -42.f)));
+		}
+
+		// each bone's X axis points at its first child, as MakeChain does
+		for (int32_t Index = Pose.Num() - 1; Index > 0; --Index)
+		{
+			const int32_t Parent = Pose.Parents[Index];
+			Pose.Rotations[Parent] = Eigen::Quaternionf::FromTwoVectors(Eigen::Vector3f::UnitX(), Pose.Positions[Index] - Pose.Positions[Parent]);
+		}
+		for (int32_t Tip : Humanoid.TipBones)
+		{
+			Pose.Rotations[Tip] = Pose.Rotations[Pose.Parents[Tip]];
+		}
+		Pose.UpdateLengths();
+
+		for (int32_t Tip : Humanoid.TipBones)
+		{
+			std::vector<int32_t> Chain;
+			for (int32_t Index = Tip; Index >= 0; Index = Pose.Parents[Index])
+			{
+				Chain.push_back(Index);
+			}
+			std::reverse(Chain.begin(), Chain.end());
+			Humanoid.Chains.push_back(Chain);
+		}
+		return Humanoid;
+	}
+
+	/**
+	 * Tip positions of the humanoid with every joint turned by up to MaxAngle radians about a random axis, so that each
+	 * set of targets can be reached by the whole body, but not by every limb on its own.
+	 */
+	std::vector<std::vector<IKCore::FEffector>> MakeEffectorSets(const FHumanoid& Humanoid, float MaxAngle = 0.3f)
+	{
+		std::mt19937 Random(42);
+		std::normal_distribution<float> Normal;
+		std::uniform_real_distribution<float> Angle(0.f, MaxAngle);
+
+		const IKCore::FTreePose& RestPose = Humanoid.Pose;
+		std::vector<std::vector<IKCore::FEffector>> EffectorSets(NumTargetSets);
+		IKCore::TAlignedArray<Eigen::Quaternionf> Rotations(RestPose.Num());
+		std::vector<Eigen::Vector3f> Positions(RestPose.Num());
+		for (std::vector<IKCore::FEffector>& Effectors : EffectorSets)
+		{
+			Positions[0] = RestPose.Positions[0];
+			for (int32_t Index = 0; Index < RestPose.Num(); ++Index)
+			{
+				const Eigen::Vector3f Axis = Eigen::Vector3f(Normal(Random), Normal(Random), Normal(Random)).normalized();
+				const int32_t Parent = RestPose.Parents[Index];
+				const Eigen::Quaternionf ParentRotation = Parent < 0 ? Eigen::Quaternionf::Identity() : Rotations[Parent];
+				Rotations[Index] = ParentRotation * Eigen::Quaternionf(Eigen::AngleAxisf(Angle(Random), Axis));
+				if (Parent >= 0)
+				{
+					Positions[Index] = Positions[Parent] + ParentRotation * (RestPose.Positions[Index] - RestPose.Positions[Parent]);
+				}
+			}
+
+			for (int32_t Tip : Humanoid.TipBones)
+			{
+				IKCore::FEffector Effector;
+				Effector.BoneIndex = Tip;
+				Effector.Target = Positions[Tip];
+				Effectors.push_back(Effector);
+			}
+		}
+		return EffectorSets;
+	}
+
+	IKCore::FSolverSettings MakeFullBodySettings()
+	{
+		IKCore::FSolverSettings Settings;
+		Settings.Precision = 0.1f;
+		Settings.MaxIterations = 32;
+		Settings.bAnalyticTwoBone = false;
+		return Settings;
+	}
+
+	/**
+	 * Solve one pelvis to tip chain of Pose and carry the result into the rest of the tree by forward kinematics,
+	 * what a separate chain solve and commit per limb amounts to. Bones off the chain keep their parent relative transforms.
+	 */
+	IKCore::FSolveResult SolveChainOfTree(IKCore::ESolver Solver, IKCore::FTreePose& Pose, const std::vector<int32_t>& Chain, const Eigen::Vector3f& Target,
+		const IKCore::FSolverSettings& Settings, IKCore::FPose& ChainPose, IKCore::FJacobianWorkspace& Workspace,
+		IKCore::TAlignedArray<Eigen::Quaternionf>& LocalRotations, std::vector<Eigen::Vector3f>& LocalOffsets)
+	{
+		const int32_t NumBones = static_cast<int32_t>(Chain.size());
+		ChainPose.Positions.resize(NumBones);
+		ChainPose.Rotations.resize(NumBones);
+		for (int32_t Index = 0; Index < NumBones; ++Index)
+		{
+			ChainPose.Positions[Index] = Pose.Positions[Chain[Index]];
+			ChainPose.Rotations[Index] = Pose.Rotations[Chain[Index]];
+		}
+		ChainPose.UpdateLengths();
+
+		const IKCore::FSolveResult Result = IKCore::Solve(Solver, ChainPose, Target, Settings, &Workspace);
+
+		LocalRotations.resize(Pose.Num());
+		LocalOffsets.resize(Pose.Num());
+		for (int32_t Index = 1; Index < Pose.Num(); ++Index)
+		{
+			const Eigen::Quaternionf InverseParentRotation = Pose.Rotations[Pose.Parents[Index]].conjugate();
+			LocalRotations[Index] = InverseParentRotation * Pose.Rotations[Index];
+			LocalOffsets[Index] = InverseParentRotation * (Pose.Positions[Index] - Pose.Positions[Pose.Parents[Index]]);
+		}
+		for (int32_t Index = 0; Index < NumBones; ++Index)
+		{
+			Pose.Rotations[Chain[Index]] = ChainPose.Rotations[Index];
+		}
+
+		int32_t ChainIndex = 1;
+		for (int32_t Index = 1; Index < Pose.Num(); ++Index)
+		{
+			const int32_t Parent = Pose.Parents[Index];
+			Pose.Positions[Index] = Pose.Positions[Parent] + Pose.Rotations[Parent] * LocalOffsets[Index];
+			if (ChainIndex < NumBones && Chain[ChainIndex] == Index)
+			{
+				++ChainIndex;
+			}
+			else
+			{
+				Pose.Rotations[Index] = Pose.Rotations[Parent] * LocalRotations[Index];
+			}
+		}
+		return Result;
+	}
+
+	float MaxEffectorDistance(const IKCore::FTreePose& Pose, const std::vector<IKCore::FEffector>& Effectors)
+	{
+		float Distance = 0.f;
+		for (const IKCore::FEffector& Effector : Effectors)
+		{
+			Distance = std::max(Distance, (Pose.Positions[Effector.BoneIndex] - Effector.Target).norm());
+		}
+		return Distance;
+	}
+
+	// rounds of separate chain solves before giving up on the limbs agreeing
+	constexpr int32_t MaxRounds = 16;
+
+	/**
+	 * Hands and feet of a humanoid solved as four pelvis rooted chains one after the other, each carried into the tree
+	 * before the next one starts. Every limb undoes part of the others' work on the spine and the pelvis, so the four
+	 * solves are repeated until all effectors are within precision or MaxRounds is hit; "max residual" is the worst
+	 * effector distance at the end.
+	 */
+	void BM_FullBodySeparateChains(benchmark::State& State, IKCore::ESolver Solver)
+	{
+		const FHumanoid Humanoid = MakeHumanoid();
+		const std::vector<std::vector<IKCore::FEffector>> EffectorSets = MakeEffectorSets(Humanoid);
+		const IKCore::FSolverSettings Settings = MakeFullBodySettings();
+
+		IKCore::FTreePose Pose;
+		IKCore::FPose ChainPose;
+		IKCore::FJacobianWorkspace Workspace;
+		IKCore::TAlignedArray<Eigen::Quaternionf> LocalRotations;
+		std::vector<Eigen::Vector3f> LocalOffsets;
+		int64_t NumIterations = 0;
+		int64_t NumRounds = 0;
+		double ResidualSum = 0.0;
+		int32_t SetIndex = 0;
+		for (auto _ : State)
+		{
+			const std::vector<IKCore::FEffector>& Effectors = EffectorSets[SetIndex];
+			Pose = Humanoid.Pose;
+			float Residual = MaxEffectorDistance(Pose, Effectors);
+			for (int32_t Round = 0; Round < MaxRounds && Residual > Settings.Precision; ++Round)
+			{
+				for (int32_t TipIndex = 0; TipIndex < static_cast<int32_t>(Effectors.size()); ++TipIndex)
+				{
+					NumIterations += SolveChainOfTree(Solver, Pose, Humanoid.Chains[TipIndex], Effectors[TipIndex].Target, Settings, ChainPose, Workspace, LocalRotations, LocalOffsets).Iterations;
+				}
+				Residual = MaxEffectorDistance(Pose, Effectors);
+				++NumRounds;
+			}
+			benchmark::DoNotOptimize(Pose.Positions.data());
+
+			ResidualSum += Residual;
+			SetIndex = (SetIndex + 1) % NumTargetSets;
+		}
+
+		State.SetItemsProcessed(State.iterations());
+		State.counters["iters/solve"] = static_cast<double>(NumIterations) / static_cast<double>(State.iterations());
+		State.counters["rounds"] = static_cast<double>(NumRounds) / static_cast<double>(State.iterations());
+		State.counters["max residual"] = ResidualSum / static_cast<double>(State.iterations());
+	}
+
+	/** The same four effectors in a single solve of the tree. */
+	void BM_FullBodyMultiEffector(benchmark::State& State, IKCore::ESolver Solver)
+	{
+		const FHumanoid Humanoid = MakeHumanoid();
+		const std::vector<std::vector<IKCore::FEffector>> EffectorSets = MakeEffectorSets(Humanoid);
+		const IKCore::FSolverSettings Settings = MakeFullBodySettings();
+
+		IKCore::FTreePose Pose;
+		IKCore::FMultiEffectorWorkspace Workspace;
+		int64_t NumIterations = 0;
+		double ResidualSum = 0.0;
+		int32_t SetIndex = 0;
+		for (auto _ : State)
+		{
+			const std::vector<IKCore::FEffector>& Effectors = EffectorSets[SetIndex];
+			Pose = Humanoid.Pose;
+			NumIterations += IKCore::SolveMultiEffector(Solver, Pose, Effectors, Settings, &Workspace).Iterations;
+			benchmark::DoNotOptimize(Pose.Positions.data());
+
+			ResidualSum += MaxEffectorDistance(Pose, Effectors);
+			SetIndex = (SetIndex + 1) % NumTargetSets;
+		}
+
+		State.SetItemsProcessed(State.iterations());
+		State.counters["iters/solve"] = static_cast<double>(NumIterations) / static_cast<double>(State.iterations());
+		State.counters["max residual"] = ResidualSum / static_cast<double>(State.iterations());
+	}
+}
+
+BENCHMARK_CAPTURE(BM_FullBodySeparateChains, FABRIK, IKCore::ESolver::FABRIK);
+BENCHMARK_CAPTURE(BM_FullBodyMultiEffector, FABRIK, IKCore::ESolver::FABRIK);
+BENCHMARK_CAPTURE(BM_FullBodySeparateChains, DLS, IKCore::ESolver::DampedLeastSquares);
+BENCHMARK_CAPTURE(BM_FullBodyMultiEffector, DLS, IKCore::ESolver::DampedLeastSquares);
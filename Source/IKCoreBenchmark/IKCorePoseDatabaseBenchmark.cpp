@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreBenchmarkUtils.h"
+#include "IKCorePoseDatabase.h"
+#include "IKCoreSolveState.h"
+#include "IKCoreSolvers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+
+using namespace IKCoreBenchmark;
+
+namespace
+{
+	constexpr int32_t NumBones = 8;
+
+	/** Database of the benchmark chain baked with Solver, once per solver for the whole run. */
+	const IKCore::FPoseDatabase& GetPoseDatabase(IKCore::ESolver Solver)
+	{
+		static std::map<IKCore::ESolver, IKCore::FPoseDatabase> Databases;
+		IKCore::FPoseDatabase& Database = Databases[Solver];
+		if (!Database.IsValid())
+		{
+			IKCore::FPoseDatabaseBakeSettings BakeSettings;
+			Database.Bake(MakeChain(NumBones), Solver, MakeSettings(), BakeSettings);
+		}
+		return Database;
+	}
+
+	/**
+	 * A new random target every frame, as after a teleport or a grab of something else, solved from the animated pose
+	 * (the rest pose here) or from the last solution, and from the nearest baked solutions when range(0) is above zero.
+	 */
+	void BM_SolveTargetJump(benchmark::State& State, IKCore::ESolver Solver, bool bWarmStart)
+	{
+		const IKCore::FPose RestPose = MakeChain(NumBones);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(256);
+
+		IKCore::FWarmStartSettings WarmStartSettings;
+		WarmStartSettings.bWarmStart = bWarmStart;
+		WarmStartSettings.PoseDatabaseNeighbours = static_cast<int32_t>(State.range(0));
+		WarmStartSettings.PoseDatabase = WarmStartSettings.PoseDatabaseNeighbours > 0 ? &GetPoseDatabase(Solver) : nullptr;
+
+		IKCore::FPose Pose = RestPose;
+		IKCore::FJacobianWorkspace Workspace(Pose.NumLinks());
+		IKCore::FChainSolveState SolveState;
+		size_t TargetIndex = 0;
+		int64_t NumIterations = 0;
+		for (auto _ : State)
+		{
+			Pose = RestPose;
+			NumIterations += SolveState.Solve(Solver, Pose, Targets[TargetIndex], Eigen::Quaternionf::Identity(), Settings, WarmStartSettings, &Workspace).Iterations;
+			benchmark::DoNotOptimize(Pose.Positions.data());
+			TargetIndex = (TargetIndex + 1) % Targets.size();
+		}
+
+		State.SetItemsProcessed(State.iterations());
+		State.counters["iters/solve"] = static_cast<double>(NumIterations) / static_cast<double>(State.iterations());
+		State.counters["seeded"] = static_cast<double>(SolveState.GetNumSeeded()) / static_cast<double>(State.iterations());
+	}
+
+	/** Cost of the lookup and blend alone, range(0) neighbours. */
+	void BM_PoseDatabaseSeed(benchmark::State& State)
+	{
+		const IKCore::FPose RestPose = MakeChain(NumBones);
+		const IKCore::FPoseDatabase& Database = GetPoseDatabase(IKCore::ESolver::DampedLeastSquares);
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(256);
+		const int32_t NumNeighbours = static_cast<int32_t>(State.range(0));
+
+		IKCore::FPose Pose = RestPose;
+		size_t TargetIndex = 0;
+		for (auto _ : State)
+		{
+			Pose = RestPose;
+			benchmark::DoNotOptimize(Database.SeedPose(Pose, Targets[TargetIndex], Eigen::Quaternionf::Identity(), NumNeighbours));
+			TargetIndex = (TargetIndex + 1) % Targets.size();
+		}
+
+		State.SetItemsProcessed(State.iterations());
+		State.counters["samples"] = Database.GetNumSamples();
+		State.counters["bytes"] = static_cast<double>(Database.GetImageSize());
+	}
+}
+
+BENCHMARK_CAPTURE(BM_SolveTargetJump, DampedLeastSquares/Cold, IKCore::ESolver::DampedLeastSquares, false)->Arg(0)->Arg(1)->Arg(4);
+BENCHMARK_CAPTURE(BM_SolveTargetJump, DampedLeastSquares/WarmStart, IKCore::ESolver::DampedLeastSquares, true)->Arg(0)->Arg(1)->Arg(4);
+BENCHMARK_CAPTURE(BM_SolveTargetJump, FABRIK/Cold, IKCore::ESolver::FABRIK, false)->Arg(0)->Arg(1)->Arg(4);
+BENCHMARK_CAPTURE(BM_SolveTargetJump, Auto/Cold, IKCore::ESolver::Auto, false)->Arg(0)->Arg(1)->Arg(4);
+BENCHMARK(BM_PoseDatabaseSeed)->Arg(1)->Arg(4);
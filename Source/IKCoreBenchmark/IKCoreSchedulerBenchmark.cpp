@@ -0,0 +1,59 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreBenchmarkUtils.h"
+#include "IKCoreScheduler.h"
+#include "IKCoreSolvers.h"
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+	using namespace IKCoreBenchmark;
+
+	// a frame worth of characters, each solving one chain
+	constexpr int32_t NumFrameJobs = 1024;
+	constexpr int32_t NumFrameJoints = 8;
+
+	/**
+	 * One benchmark iteration is one frame: every chain is reset to its rest pose and solved with DLS on a pool of
+	 * range(0) workers. Reports chains/sec (items_per_second), the average worker utilization and steals per frame.
+	 * Wall clock time is used, run with --benchmark_filter=ParallelSolve on the target machine to see 1 to 16 core scaling.
+	 */
+	void BM_ParallelSolve(benchmark::State& State)
+	{
+		const int32_t NumWorkers = static_cast<int32_t>(State.range(0));
+		const IKCore::FPose RestPose = MakeChain(NumFrameJoints);
+		const std::vector<Eigen::Vector3f> Targets = MakeTargets(NumFrameJobs);
+		const IKCore::FSolverSettings Settings = MakeSettings();
+
+		std::vector<IKCore::FPose> Poses(NumFrameJobs, RestPose);
+		std::vector<IKCore::FJacobianWorkspace> Workspaces(NumWorkers);
+		IKCore::FThreadPool Pool(NumWorkers);
+
+		const IKCore::FWorkStealingQueue::FJobFunction SolveJob = [&](int32_t JobIndex, int32_t WorkerIndex)
+		{
+			Poses[JobIndex] = RestPose;
+			IKCore::SolveDampedLeastSquares(Poses[JobIndex], Targets[JobIndex], Settings, &Workspaces[WorkerIndex]);
+		};
+
+		double SumUtilization = 0.0;
+		int64_t NumSteals = 0;
+		for (auto _ : State)
+		{
+			Pool.ParallelFor(NumFrameJobs, SolveJob, 8);
+
+			const IKCore::FParallelForStats& Stats = Pool.GetLastStats();
+			SumUtilization += Stats.GetAverageUtilization();
+			for (const IKCore::FWorkerStats& WorkerStats : Stats.Workers)
+			{
+				NumSteals += WorkerStats.NumSteals;
+			}
+		}
+
+		State.SetItemsProcessed(State.iterations() * NumFrameJobs);
+		State.counters["utilization"] = SumUtilization / static_cast<double>(State.iterations());
+		State.counters["steals/frame"] = static_cast<double>(NumSteals) / static_cast<double>(State.iterations());
+	}
+}
+
+BENCHMARK(BM_ParallelSolve)->ArgName("workers")->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKCoreSkeletonCache.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+
+namespace
+{
+	constexpr const char* CacheFilePath = "IKCoreBenchmark.ikskel";
+
+	// a mannequin sized skeleton: a spine with limbs of this many bones, each limb chain precompiled
+	constexpr int32_t NumLimbs = 12;
+	constexpr int32_t BonesPerLimb = 6;
+
+	std::string LimbBoneName(int32_t Limb, int32_t Bone)
+	{
+		return "limb" + std::to_string(Limb) + "_" + std::to_string(Bone);
+	}
+
+	IKCore::FSkeletonCacheBuilder MakeSkeleton()
+	{
+		IKCore::FSkeletonCacheBuilder Builder;
+		const int32_t Root = Builder.AddBone("root", -1, Eigen::Vector3f::Zero(), Eigen::Quaternionf::Identity());
+		for (int32_t Limb = 0; Limb < NumLimbs; ++Limb)
+		{
+			int32_t Parent = Root;
+			for (int32_t Bone = 0; Bone < BonesPerLimb; ++Bone)
+			{
+				Parent = Builder.AddBone(LimbBoneName(Limb, Bone).c_str(), Parent, Eigen::Vector3f(10.f, 0.f, 0.f), Eigen::Quaternionf::Identity());
+			}
+			Builder.AddChain(Parent, Parent - (BonesPerLimb - 1));
+		}
+		return Builder;
+	}
+
+	/** Open the cooked file and look up every limb chain, what a character spawned with a cooked skeleton does. */
+	void BM_SkeletonCacheOpen(benchmark::State& State)
+	{
+		MakeSkeleton().Save(CacheFilePath);
+
+		std::vector<std::string> TipNames;
+		std::vector<std::string> RootNames;
+		for (int32_t Limb = 0; Limb < NumLimbs; ++Limb)
+		{
+			TipNames.push_back(LimbBoneName(Limb, BonesPerLimb - 1));
+			RootNames.push_back(LimbBoneName(Limb, 0));
+		}
+
+		int64_t NumChainBones = 0;
+		for (auto _ : State)
+		{
+			IKCore::FSkeletonCache Cache;
+			Cache.Open(CacheFilePath);
+			for (int32_t Limb = 0; Limb < NumLimbs; ++Limb)
+			{
+				const IKCore::FSkeletonChain* Chain = Cache.FindChain(TipNames[Limb].c_str(), RootNames[Limb].c_str());
+				NumChainBones += Chain != nullptr ? Chain->NumBones : 0;
+				benchmark::DoNotOptimize(Chain != nullptr ? Cache.GetChainBones(*Chain) : nullptr);
+			}
+		}
+		std::remove(CacheFilePath);
+
+		State.SetItemsProcessed(State.iterations() * NumLimbs);
+		State.counters["bones/chain"] = static_cast<double>(NumChainBones) / static_cast<double>(State.iterations() * NumLimbs);
+	}
+}
+
+BENCHMARK(BM_SkeletonCacheOpen);
@@ -0,0 +1,469 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+// Replays recorded IK sessions (ik.Record.Start in the engine, or "generate" for a synthetic corpus) through every
+// solver and reports accuracy against cost, failing when a run regresses from a baseline report.
+//
+//   IKCoreReplay generate Corpus.ikrec [--characters 16] [--frames 3600] [--seed 1]
+//   IKCoreReplay run Session.ikrec... [--solvers CCD,FABRIK,...] [--report Report.csv] [--baseline Baseline.csv]
+//       [--repeat 3] [--accuracy-tolerance 0.05] [--cost-tolerance 0.25]
+//
+// Every session is streamed, so captures of any size replay in constant memory; the timings are the fastest of the
+// repeated passes. run exits with 1 when a solver of the baseline got less accurate or more expensive than the
+// tolerances allow, relative to the baseline's value, and 2 on bad arguments or unreadable files.
+
+#include "IKCoreRecording.h"
+#include "IKCoreReplay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using namespace IKCore;
+
+	const char* const SolverNames[] = { "CCD", "FABRIK", "JacobianTranspose", "JacobianPinv", "DampedLeastSquares", "TwoBone", "Pipeline", "Auto" };
+
+	constexpr float FrameSeconds = 1.f / 60.f;
+
+	bool FindSolver(const std::string& Name, ESolver& OutSolver)
+	{
+		for (size_t Index = 0; Index < sizeof(SolverNames) / sizeof(SolverNames[0]); ++Index)
+		{
+			if (Name == SolverNames[Index])
+			{
+				OutSolver = static_cast<ESolver>(Index);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::vector<std::string> Split(const std::string& List)
+	{
+		std::vector<std::string> Items;
+		size_t Start = 0;
+		while (Start <= List.size())
+		{
+			const size_t End = std::min(List.find(',', Start), List.size());
+			if (End > Start)
+			{
+				Items.push_back(List.substr(Start, End - Start));
+			}
+			Start = End + 1;
+		}
+		return Items;
+	}
+
+	/** Reference pose of a chain with the given link lengths, zigzagging a little so no solver starts on a singularity. */
+	FPose MakeChain(const std::vector<float>& LinkLengths, const Eigen::Vector3f& Direction)
+	{
+		FPose Pose;
+		Pose.Positions.push_back(Eigen::Vector3f::Zero());
+		for (size_t Index = 0; Index < LinkLengths.size(); ++Index)
+		{
+			const Eigen::Vector3f Bend(0.f, 0.f, Index % 2 == 0 ? 0.15f : -0.15f);
+			Pose.Positions.push_back(Pose.Positions.back() + (Direction + Bend).normalized() * LinkLengths[Index]);
+		}
+		for (int32_t Index = 0; Index < Pose.Num(); ++Index)
+		{
+			const Eigen::Vector3f Link = Index < Pose.NumLinks() ? Pose.Positions[Index + 1] - Pose.Positions[Index] : Pose.Positions[Index] - Pose.Positions[Index - 1];
+			Pose.Rotations.push_back(Eigen::Quaternionf::FromTwoVectors(Eigen::Vector3f::UnitX(), Link));
+		}
+		Pose.UpdateLengths();
+		return Pose;
+	}
+
+	/** Target of one chain in its root parent's frame: a Lissajous curve around a center that jumps now and then. */
+	struct FTargetTrajectory
+	{
+		Eigen::Vector3f Center = Eigen::Vector3f::Zero();
+		Eigen::Vector3f Amplitude = Eigen::Vector3f::Zero();
+		Eigen::Vector3f Frequency = Eigen::Vector3f::Ones();
+		float NextJumpTime = 0.f;
+
+		void Jump(const FPose& Chain, float Time, std::mt19937& Random)
+		{
+			// mostly within reach, sometimes beyond it where the solvers can only stretch towards the target
+			std::uniform_real_distribution<float> Unit(-1.f, 1.f);
+			std::uniform_real_distribution<float> Fraction(0.f, 1.f);
+			const float Reach = Chain.TotalLength();
+			const float Distance = Reach * (Fraction(Random) < 0.1f ? 1.1f + 0.3f * Fraction(Random) : 0.3f + 0.5f * Fraction(Random));
+			Center = Chain.Positions[0] + Eigen::Vector3f(Unit(Random), Unit(Random), Unit(Random)).normalized() * Distance;
+			Amplitude = Eigen::Vector3f(Fraction(Random), Fraction(Random), Fraction(Random)) * 0.2f * Reach;
+			Frequency = Eigen::Vector3f(0.5f + Fraction(Random), 0.5f + Fraction(Random), 0.5f + Fraction(Random)) * 2.f;
+			NextJumpTime = Time + 1.f + 4.f * Fraction(Random);
+		}
+
+		Eigen::Vector3f Evaluate(float Time) const
+		{
+			return Center + Eigen::Vector3f(Amplitude.x() * std::sin(Frequency.x() * Time), Amplitude.y() * std::sin(Frequency.y() * Time),
+				Amplitude.z() * std::cos(Frequency.z() * Time));
+		}
+	};
+
+	int Generate(const std::string& FilePath, int32_t NumCharacters, int32_t NumFrames, uint32_t Seed)
+	{
+		FRecordingWriter Writer;
+		if (!Writer.Open(FilePath.c_str()))
+		{
+			std::fprintf(stderr, "could not write %s\n", FilePath.c_str());
+			return 2;
+		}
+
+		// an arm from the clavicle, a leg (solved in closed form by default) and a tail long enough for the iterative solvers
+		const FPose Chains[] = {
+			MakeChain({ 15.f, 30.f, 26.f }, Eigen::Vector3f(0.f, 1.f, 0.f)),
+			MakeChain({ 45.f, 42.f }, Eigen::Vector3f(0.f, 0.f, -1.f)),
+			MakeChain({ 12.f, 12.f, 12.f, 12.f, 12.f, 12.f }, Eigen::Vector3f(-1.f, 0.f, 0.f)),
+		};
+		const char* const ChainNames[] = { "hand_l", "foot_l", "tail_06" };
+		constexpr int32_t NumChains = sizeof(Chains) / sizeof(Chains[0]);
+
+		std::mt19937 Random(Seed);
+		std::uniform_real_distribution<float> Fraction(0.f, 1.f);
+		FSolverSettings Settings;
+
+		struct FCharacter
+		{
+			float Radius = 0.f;
+			float Speed = 0.f;
+			float Phase = 0.f;
+			uint32_t ChainIds[NumChains] = {};
+			FTargetTrajectory Trajectories[NumChains];
+		};
+		std::vector<FCharacter> Characters(NumCharacters);
+		for (int32_t Index = 0; Index < NumCharacters; ++Index)
+		{
+			FCharacter& Character = Characters[Index];
+			Character.Radius = 200.f + 800.f * Fraction(Random);
+			Character.Speed = 150.f * Fraction(Random);
+			Character.Phase = 6.2831853f * Fraction(Random);
+			for (int32_t Chain = 0; Chain < NumChains; ++Chain)
+			{
+				const std::string Name = "Character" + std::to_string(Index) + "/" + ChainNames[Chain];
+				Character.ChainIds[Chain] = Writer.RegisterChain(Name, Chains[Chain], Eigen::Vector3f::Zero(), Eigen::Quaternionf::Identity(), Settings);
+				Character.Trajectories[Chain].Jump(Chains[Chain], 0.f, Random);
+			}
+		}
+
+		// the characters walk circles, each chain's root parent following the character around
+		FRecordedFrame Frame;
+		for (int32_t FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+		{
+			const float Time = static_cast<float>(FrameIndex) * FrameSeconds;
+			Frame.Frame = static_cast<uint64_t>(FrameIndex);
+			for (FCharacter& Character : Characters)
+			{
+				const float Angle = Character.Phase + Time * Character.Speed / Character.Radius;
+				Frame.RootParentTranslation = Eigen::Vector3f(Character.Radius * std::cos(Angle), Character.Radius * std::sin(Angle), 100.f);
+				Frame.RootParentRotation = Eigen::Quaternionf(Eigen::AngleAxisf(Angle + 1.5707963f, Eigen::Vector3f::UnitZ()));
+				for (int32_t Chain = 0; Chain < NumChains; ++Chain)
+				{
+					FTargetTrajectory& Trajectory = Character.Trajectories[Chain];
+					if (Time >= Trajectory.NextJumpTime)
+					{
+						Trajectory.Jump(Chains[Chain], Time, Random);
+					}
+					Frame.ChainId = Character.ChainIds[Chain];
+					Frame.Target = Frame.RootParentTranslation + Frame.RootParentRotation * Trajectory.Evaluate(Time);
+					Writer.Write(Frame);
+				}
+			}
+			Writer.Flush();
+		}
+		Writer.Close();
+		std::printf("wrote %d frames of %d characters to %s\n", NumFrames, NumCharacters, FilePath.c_str());
+		return 0;
+	}
+
+	/** One row of a report, per solver. */
+	struct FReportRow
+	{
+		double Solves = 0.0;
+		double ConvergedRatio = 0.0;
+		double ResidualMean = 0.0;
+		double ResidualP50 = 0.0;
+		double ResidualP95 = 0.0;
+		double ResidualP99 = 0.0;
+		double ResidualMax = 0.0;
+		double IterationsMean = 0.0;
+		double IterationsMax = 0.0;
+		double JitterMean = 0.0;
+		double JitterP95 = 0.0;
+		double MicrosecondsPerSolve = 0.0;
+		double MicrosecondsPerFrame = 0.0;
+		double MicrosecondsPerFrameP95 = 0.0;
+	};
+
+	const char* const ReportHeader = "solver,solves,converged_ratio,residual_mean,residual_p50,residual_p95,residual_p99,residual_max,"
+		"iterations_mean,iterations_max,jitter_mean,jitter_p95,us_per_solve,us_per_frame,us_per_frame_p95";
+
+	FReportRow MakeRow(const FReplayStats& Stats)
+	{
+		const double NumSolves = static_cast<double>(std::max<int64_t>(Stats.NumSolves, 1));
+		FReportRow Row;
+		Row.Solves = static_cast<double>(Stats.NumSolves);
+		Row.ConvergedRatio = static_cast<double>(Stats.NumConverged) / NumSolves;
+		Row.ResidualMean = Stats.Residuals.GetMean();
+		Row.ResidualP50 = Stats.Residuals.GetPercentile(0.5);
+		Row.ResidualP95 = Stats.Residuals.GetPercentile(0.95);
+		Row.ResidualP99 = Stats.Residuals.GetPercentile(0.99);
+		Row.ResidualMax = Stats.Residuals.GetMax();
+		Row.IterationsMean = static_cast<double>(Stats.NumIterations) / NumSolves;
+		Row.IterationsMax = static_cast<double>(Stats.MaxIterations);
+		Row.JitterMean = Stats.Jitter.GetMean();
+		Row.JitterP95 = Stats.Jitter.GetPercentile(0.95);
+		Row.MicrosecondsPerSolve = Stats.Seconds * 1e6 / NumSolves;
+		Row.MicrosecondsPerFrame = Stats.FrameMicroseconds.GetMean();
+		Row.MicrosecondsPerFrameP95 = Stats.FrameMicroseconds.GetPercentile(0.95);
+		return Row;
+	}
+
+	void WriteRow(std::FILE* File, const char* Solver, const FReportRow& Row)
+	{
+		std::fprintf(File, "%s,%.0f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.3f,%.0f,%.5f,%.5f,%.3f,%.2f,%.2f\n", Solver, Row.Solves, Row.ConvergedRatio, Row.ResidualMean,
+			Row.ResidualP50, Row.ResidualP95, Row.ResidualP99, Row.ResidualMax, Row.IterationsMean, Row.IterationsMax, Row.JitterMean, Row.JitterP95,
+			Row.MicrosecondsPerSolve, Row.MicrosecondsPerFrame, Row.MicrosecondsPerFrameP95);
+	}
+
+	bool ReadReport(const std::string& FilePath, std::map<std::string, FReportRow>& OutRows)
+	{
+		std::FILE* File = std::fopen(FilePath.c_str(), "r");
+		if (File == nullptr)
+		{
+			return false;
+		}
+
+		char Line[1024];
+		bool bHeader = true;
+		while (std::fgets(Line, sizeof(Line), File) != nullptr)
+		{
+			if (bHeader)
+			{
+				bHeader = false;
+				continue;
+			}
+
+			char Solver[64];
+			FReportRow Row;
+			if (std::sscanf(Line, "%63[^,],%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", Solver, &Row.Solves, &Row.ConvergedRatio, &Row.ResidualMean,
+				&Row.ResidualP50, &Row.ResidualP95, &Row.ResidualP99, &Row.ResidualMax, &Row.IterationsMean, &Row.IterationsMax, &Row.JitterMean, &Row.JitterP95,
+				&Row.MicrosecondsPerSolve, &Row.MicrosecondsPerFrame, &Row.MicrosecondsPerFrameP95) == 15)
+			{
+				OutRows[Solver] = Row;
+			}
+		}
+		std::fclose(File);
+		return true;
+	}
+
+	/**
+	 * Whether Current is worse than Baseline by more than Tolerance of it; Floor keeps values near zero (a residual well
+	 * under the precision, a solve skipped outright) from failing on noise.
+	 */
+	bool CheckRegression(const char* Solver, const char* Metric, double Baseline, double Current, double Tolerance, double Floor)
+	{
+		if (Current <= Baseline * (1.0 + Tolerance) + Floor)
+		{
+			return true;
+		}
+		std::printf("REGRESSION %s %s: %.4f -> %.4f (%+.1f%%)\n", Solver, Metric, Baseline, Current, Baseline > 0.0 ? 100.0 * (Current / Baseline - 1.0) : 100.0);
+		return false;
+	}
+
+	/** Replay every session with a fresh harness; false when a file cannot be opened. */
+	bool Replay(const std::vector<std::string>& FilePaths, const std::vector<ESolver>& Solvers, bool bVerbose, std::vector<FReplayStats>& OutStats)
+	{
+		FReplayHarness Harness(Solvers);
+		for (const std::string& FilePath : FilePaths)
+		{
+			FRecordingReader Reader;
+			if (!Reader.Open(FilePath.c_str()))
+			{
+				std::fprintf(stderr, "could not read %s\n", FilePath.c_str());
+				return false;
+			}
+			if (!Harness.Replay(Reader))
+			{
+				std::fprintf(stderr, "%s: malformed chunk after %llu frames, the rest is skipped\n", FilePath.c_str(), static_cast<unsigned long long>(Reader.GetNumFramesRead()));
+			}
+			if (bVerbose)
+			{
+				std::printf("%s: %llu solves of %d chains, %.1f MB\n", FilePath.c_str(), static_cast<unsigned long long>(Reader.GetNumFramesRead()), Reader.GetNumChains(),
+					static_cast<double>(Reader.GetNumBytesRead()) / (1024.0 * 1024.0));
+			}
+		}
+		OutStats = Harness.GetStats();
+		return true;
+	}
+
+	int Run(const std::vector<std::string>& FilePaths, const std::vector<ESolver>& Solvers, int32_t NumRepeats, const std::string& ReportPath, const std::string& BaselinePath,
+		double AccuracyTolerance, double CostTolerance)
+	{
+		// the solves are deterministic, the timings are not: every pass gives the same accuracy and the fastest one is kept
+		std::vector<FReportRow> SolverRows(Solvers.size());
+		for (int32_t Repeat = 0; Repeat < NumRepeats; ++Repeat)
+		{
+			std::vector<FReplayStats> Stats;
+			if (!Replay(FilePaths, Solvers, Repeat == 0, Stats))
+			{
+				return 2;
+			}
+			for (size_t Index = 0; Index < Solvers.size(); ++Index)
+			{
+				const FReportRow Row = MakeRow(Stats[Index]);
+				if (Repeat == 0 || Row.MicrosecondsPerSolve < SolverRows[Index].MicrosecondsPerSolve)
+				{
+					SolverRows[Index] = Row;
+				}
+			}
+		}
+
+		std::map<std::string, FReportRow> Rows;
+		std::FILE* ReportFile = !ReportPath.empty() ? std::fopen(ReportPath.c_str(), "w") : nullptr;
+		if (!ReportPath.empty() && ReportFile == nullptr)
+		{
+			std::fprintf(stderr, "could not write %s\n", ReportPath.c_str());
+			return 2;
+		}
+		std::printf("%s\n", ReportHeader);
+		if (ReportFile != nullptr)
+		{
+			std::fprintf(ReportFile, "%s\n", ReportHeader);
+		}
+		for (size_t Index = 0; Index < Solvers.size(); ++Index)
+		{
+			const char* Solver = SolverNames[static_cast<int32_t>(Solvers[Index])];
+			const FReportRow& Row = SolverRows[Index];
+			Rows[Solver] = Row;
+			WriteRow(stdout, Solver, Row);
+			if (ReportFile != nullptr)
+			{
+				WriteRow(ReportFile, Solver, Row);
+			}
+		}
+		if (ReportFile != nullptr)
+		{
+			std::fclose(ReportFile);
+		}
+
+		if (BaselinePath.empty())
+		{
+			return 0;
+		}
+		std::map<std::string, FReportRow> BaselineRows;
+		if (!ReadReport(BaselinePath, BaselineRows))
+		{
+			std::fprintf(stderr, "could not read %s\n", BaselinePath.c_str());
+			return 2;
+		}
+
+		// iteration counts are deterministic, but a change of them is a change of cost; the timings carry the machine's noise
+		bool bPassed = true;
+		for (const auto& Baseline : BaselineRows)
+		{
+			const auto Current = Rows.find(Baseline.first);
+			if (Current == Rows.end())
+			{
+				continue;
+			}
+			const char* Solver = Baseline.first.c_str();
+			const FReportRow& Old = Baseline.second;
+			const FReportRow& New = Current->second;
+			bPassed &= CheckRegression(Solver, "residual_mean", Old.ResidualMean, New.ResidualMean, AccuracyTolerance, 0.01);
+			bPassed &= CheckRegression(Solver, "residual_p95", Old.ResidualP95, New.ResidualP95, AccuracyTolerance, 0.01);
+			bPassed &= CheckRegression(Solver, "residual_p99", Old.ResidualP99, New.ResidualP99, AccuracyTolerance, 0.01);
+			bPassed &= CheckRegression(Solver, "non_converged_ratio", 1.0 - Old.ConvergedRatio, 1.0 - New.ConvergedRatio, AccuracyTolerance, 0.001);
+			bPassed &= CheckRegression(Solver, "jitter_mean", Old.JitterMean, New.JitterMean, AccuracyTolerance, 0.001);
+			bPassed &= CheckRegression(Solver, "iterations_mean", Old.IterationsMean, New.IterationsMean, CostTolerance, 0.01);
+			bPassed &= CheckRegression(Solver, "us_per_solve", Old.MicrosecondsPerSolve, New.MicrosecondsPerSolve, CostTolerance, 0.05);
+		}
+		std::printf(bPassed ? "no regression against %s\n" : "regressed against %s\n", BaselinePath.c_str());
+		return bPassed ? 0 : 1;
+	}
+
+	int PrintUsage()
+	{
+		std::fprintf(stderr,
+			"usage: IKCoreReplay generate Corpus.ikrec [--characters 16] [--frames 3600] [--seed 1]\n"
+			"       IKCoreReplay run Session.ikrec... [--solvers CCD,FABRIK,...] [--report Report.csv] [--baseline Baseline.csv]\n"
+			"           [--repeat 3] [--accuracy-tolerance 0.05] [--cost-tolerance 0.25]\n");
+		return 2;
+	}
+}
+
+int main(int ArgC, char** ArgV)
+{
+	if (ArgC < 3)
+	{
+		return PrintUsage();
+	}
+
+	const std::string Command = ArgV[1];
+	std::vector<std::string> FilePaths;
+	std::map<std::string, std::string> Options;
+	for (int Index = 2; Index < ArgC; ++Index)
+	{
+		if (std::strncmp(ArgV[Index], "--", 2) == 0)
+		{
+			if (Index + 1 >= ArgC)
+			{
+				return PrintUsage();
+			}
+			Options[ArgV[Index] + 2] = ArgV[Index + 1];
+			++Index;
+		}
+		else
+		{
+			FilePaths.push_back(ArgV[Index]);
+		}
+	}
+	const auto GetOption = [&Options](const char* Name, const char* Default)
+	{
+		const auto Found = Options.find(Name);
+		return Found != Options.end() ? Found->second : std::string(Default);
+	};
+
+	if (Command == "generate" && FilePaths.size() == 1)
+	{
+		const int32_t NumCharacters = std::atoi(GetOption("characters", "16").c_str());
+		const int32_t NumFrames = std::atoi(GetOption("frames", "3600").c_str());
+		const uint32_t Seed = static_cast<uint32_t>(std::strtoul(GetOption("seed", "1").c_str(), nullptr, 10));
+		if (NumCharacters <= 0 || NumFrames <= 0)
+		{
+			return PrintUsage();
+		}
+		return Generate(FilePaths[0], NumCharacters, NumFrames, Seed);
+	}
+
+	if (Command == "run" && !FilePaths.empty())
+	{
+		std::vector<ESolver> Solvers;
+		for (const std::string& Name : Split(GetOption("solvers", "CCD,FABRIK,JacobianTranspose,JacobianPinv,DampedLeastSquares,Auto")))
+		{
+			ESolver Solver;
+			if (!FindSolver(Name, Solver))
+			{
+				std::fprintf(stderr, "no solver %s\n", Name.c_str());
+				return 2;
+			}
+			Solvers.push_back(Solver);
+		}
+		const int32_t NumRepeats = std::atoi(GetOption("repeat", "3").c_str());
+		if (NumRepeats <= 0)
+		{
+			return PrintUsage();
+		}
+		return Run(FilePaths, Solvers, NumRepeats, GetOption("report", ""), GetOption("baseline", ""), std::atof(GetOption("accuracy-tolerance", "0.05").c_str()),
+			std::atof(GetOption("cost-tolerance", "0.25").c_str()));
+	}
+
+	return PrintUsage();
+}
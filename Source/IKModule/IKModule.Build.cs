@@ -13,7 +13,9 @@ public class IKModule : ModuleRules
             "CoreUObject",
             "Engine",
             "InputCore",
-            "HeadMountedDisplay"
+            "HeadMountedDisplay",
+            "AnimGraphRuntime",
+            "IKCore"
         });
 	}
 }
@@ -0,0 +1,197 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AnimNode_IKModuleSolver.h"
+#include "AnimationRuntime.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Algo/Reverse.h"
+#include "Engine/SkeletalMesh.h"
+#include "IKChain.h"
+#include "IKCoreConversion.h"
+#include "IKModuleStats.h"
+#include "IKCoreSolvers.h"
+#include "IKSkeletonCache.h"
+
+FAnimNode_IKModuleSolver::FAnimNode_IKModuleSolver()
+	: EffectorLocation(FVector::ZeroVector)
+	, EffectorLocationSpace(BCS_ComponentSpace)
+	, bConstrainEffectorRotation(false)
+	, EffectorRotation(FRotator::ZeroRotator)
+	, EffectorRotationWeight(10.f)
+	, AnglePrecision(1.f)
+	, Solver(EIKSolverType::DampedLeastSquares)
+	, Precision(1.f)
+	, MaxIterations(10)
+	, bAnalyticTwoBone(true)
+	, bAllowStretch(false)
+	, MaxStretchScale(1.2f)
+	, SoftStartRatio(1.f)
+	, bUsePoleVector(false)
+	, PoleLocation(FVector::ZeroVector)
+	, SwivelAngle(0.f)
+	, bBroydenUpdates(false)
+	, bWarmStart(true)
+	, bSkipUnchangedSolves(true)
+{
+}
+
+void FAnimNode_IKModuleSolver::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString DebugLine = DebugData.GetNodeName(this);
+	DebugLine += FString::Printf(TEXT("(Iterations: %d, Residual: %.3f, Solved: %lld, Skipped: %lld)"), LastResult.Iterations, LastResult.Residual, static_cast<int64>(SolveState.GetNumSolved()), static_cast<int64>(SolveState.GetNumSkipped()));
+	DebugData.AddDebugItem(DebugLine);
+
+	ComponentPose.GatherDebugData(DebugData);
+}
+
+void FAnimNode_IKModuleSolver::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
+{
+	check(OutBoneTransforms.Num() == 0);
+
+	const int32 NumBones = ChainBoneIndices.Num();
+	Pose.Positions.resize(NumBones);
+	Pose.Rotations.resize(NumBones);
+	for (int32 Index = 0; Index < NumBones; ++Index)
+	{
+		const FTransform& BoneTransform = Output.Pose.GetComponentSpaceTransform(ChainBoneIndices[Index]);
+		Pose.Positions[Index] = ToEigen(BoneTransform.GetTranslation());
+		Pose.Rotations[Index] = ToEigen(BoneTransform.GetRotation());
+	}
+	Pose.UpdateLengths();
+
+	// the joint limits hold against the root's parent, for the transform target as well as through the solve state
+	const FQuat RootParentRotation = RootParentIndex.IsValid() ? Output.Pose.GetComponentSpaceTransform(RootParentIndex).GetRotation() : FQuat::Identity;
+	Pose.RootParentRotation = ToEigen(RootParentRotation);
+
+	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
+	FTransform EffectorTransform(EffectorRotation, EffectorLocation);
+	FAnimationRuntime::ConvertBoneSpaceTransformToCS(Output.AnimInstanceProxy->GetComponentTransform(), Output.Pose, EffectorTransform, EffectorTarget.GetCompactPoseIndex(BoneContainer), EffectorLocationSpace);
+
+	IKCore::FSolverSettings Settings;
+	Settings.Precision = Precision;
+	Settings.MaxIterations = MaxIterations;
+	Settings.bAnalyticTwoBone = bAnalyticTwoBone;
+	Settings.TwoBone.bAllowStretch = bAllowStretch;
+	Settings.TwoBone.MaxStretchScale = MaxStretchScale;
+	Settings.TwoBone.SoftStartRatio = SoftStartRatio;
+	Settings.TwoBone.SwivelAngle = FMath::DegreesToRadians(SwivelAngle);
+	if (bUsePoleVector)
+	{
+		FTransform PoleTransform(PoleLocation);
+		FAnimationRuntime::ConvertBoneSpaceTransformToCS(Output.AnimInstanceProxy->GetComponentTransform(), Output.Pose, PoleTransform, EffectorTarget.GetCompactPoseIndex(BoneContainer), EffectorLocationSpace);
+		Settings.TwoBone.bUsePoleVector = true;
+		Settings.TwoBone.PoleVector = ToEigen(PoleTransform.GetTranslation());
+	}
+	Settings.bBroydenUpdates = bBroydenUpdates;
+	Settings.AnglePrecision = FMath::DegreesToRadians(AnglePrecision);
+	Settings.Pipeline = ToIKCore(PipelineStages);
+
+	IKCore::FWarmStartSettings WarmStartSettings;
+	WarmStartSettings.bWarmStart = bWarmStart;
+	WarmStartSettings.bSkipUnchanged = bSkipUnchangedSolves;
+
+	FIKSolveRecord Record;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_IKModule_Solve);
+		const double StartTime = FPlatformTime::Seconds();
+		if (bConstrainEffectorRotation)
+		{
+			IKCore::FTransformTarget Target;
+			Target.Position = ToEigen(EffectorTransform.GetTranslation());
+			Target.Rotation = ToEigen(EffectorTransform.GetRotation());
+			Target.RotationWeights.setConstant(EffectorRotationWeight);
+
+			// the solve state only knows position targets, its solution would be stale once the rotation is released
+			SolveState.Reset();
+			LastResult = IKCore::Solve(ToIKCore(Solver), Pose, Target, Settings, &TransformJacobianWorkspace);
+		}
+		else
+		{
+			LastResult = SolveState.Solve(ToIKCore(Solver), Pose, ToEigen(EffectorTransform.GetTranslation()), ToEigen(RootParentRotation), Settings, WarmStartSettings, &JacobianWorkspace);
+		}
+		Record.Seconds = FPlatformTime::Seconds() - StartTime;
+	}
+	const USkeletalMeshComponent* MeshComp = Output.AnimInstanceProxy->GetSkelMeshComponent();
+	Record.OwnerName = MeshComp->GetOwner() != nullptr ? MeshComp->GetOwner()->GetFName() : MeshComp->GetFName();
+	Record.ChainName = TipBone.BoneName;
+	Record.Solver = ToIKCore(Solver);
+	Record.NumBones = NumBones;
+	Record.Precision = Precision;
+	Record.bSkipped = SolveState.WasSkipped();
+	FIKModuleStats::RecordSolve(Record, LastResult);
+
+	// written back even when the solve was skipped since the incoming pose is animated again every frame,
+	// chain bones are ordered parent first, as OutBoneTransforms requires
+	OutBoneTransforms.Reserve(NumBones);
+	for (int32 Index = 0; Index < NumBones; ++Index)
+	{
+		FTransform BoneTransform = Output.Pose.GetComponentSpaceTransform(ChainBoneIndices[Index]);
+		BoneTransform.SetTranslation(ToUnreal(Pose.Positions[Index]));
+		BoneTransform.SetRotation(ToUnreal(Pose.Rotations[Index]));
+		OutBoneTransforms.Add(FBoneTransform(ChainBoneIndices[Index], BoneTransform));
+	}
+}
+
+bool FAnimNode_IKModuleSolver::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
+{
+	if (ChainBoneIndices.Num() < 2)
+	{
+		return false;
+	}
+
+	if (EffectorLocationSpace == BCS_ParentBoneSpace || EffectorLocationSpace == BCS_BoneSpace)
+	{
+		return EffectorTarget.IsValidToEvaluate(RequiredBones);
+	}
+	return true;
+}
+
+void FAnimNode_IKModuleSolver::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	TipBone.Initialize(RequiredBones);
+	RootBone.Initialize(RequiredBones);
+	EffectorTarget.Initialize(RequiredBones);
+
+	ChainBoneIndices.Reset();
+	RootParentIndex = FCompactPoseBoneIndex(INDEX_NONE);
+	Pose.JointLimits.clear();
+	SolveState.Reset();
+	if (!TipBone.IsValidToEvaluate(RequiredBones) || !RootBone.IsValidToEvaluate(RequiredBones))
+	{
+		return;
+	}
+
+	// walk up from the tip, the root has to be one of its ancestors
+	const FCompactPoseBoneIndex RootIndex = RootBone.GetCompactPoseIndex(RequiredBones);
+	FCompactPoseBoneIndex BoneIndex = TipBone.GetCompactPoseIndex(RequiredBones);
+	while (BoneIndex.IsValid())
+	{
+		ChainBoneIndices.Add(BoneIndex);
+		if (BoneIndex == RootIndex)
+		{
+			break;
+		}
+		BoneIndex = RequiredBones.GetParentBoneIndex(BoneIndex);
+	}
+	if (!BoneIndex.IsValid())
+	{
+		ChainBoneIndices.Reset();
+		return;
+	}
+	Algo::Reverse(ChainBoneIndices);
+	RootParentIndex = RequiredBones.GetParentBoneIndex(RootIndex);
+
+	const int32 NumLinks = ChainBoneIndices.Num() - 1;
+	if (NumLinks > 0)
+	{
+		JacobianWorkspace.Resize(NumLinks);
+		TransformJacobianWorkspace.Resize(NumLinks);
+	}
+
+	// joint limits come with the mesh's chain, shared with the characters showing it
+	const USkeletalMesh* SkeletalMesh = RequiredBones.GetSkeletalMeshAsset();
+	const FIKChain* Chain = SkeletalMesh != nullptr ? FIKSkeletonCacheRegistry::Get().FindOrBuildChain(*SkeletalMesh, TipBone.BoneName, RootBone.BoneName) : nullptr;
+	if (Chain != nullptr && Chain->NumBones() == ChainBoneIndices.Num())
+	{
+		Pose.JointLimits.assign(Chain->JointLimits.GetData(), Chain->JointLimits.GetData() + Chain->JointLimits.Num());
+	}
+}
@@ -0,0 +1,224 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKChain.h"
+#include "Algo/Reverse.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "IKModuleStats.h"
+#include "IKSkeletonCache.h"
+#include "IKCoreSkeletonCache.h"
+
+bool FIKChain::Build(const FReferenceSkeleton& RefSkeleton, FName InTipBoneName, FName InRootBoneName, FIKChain& OutChain)
+{
+	OutChain = FIKChain();
+	OutChain.TipBoneName = InTipBoneName;
+	OutChain.RootBoneName = InRootBoneName;
+
+	const int32 TipIndex = RefSkeleton.FindBoneIndex(InTipBoneName);
+	const int32 RootIndex = RefSkeleton.FindBoneIndex(InRootBoneName);
+	if (TipIndex == INDEX_NONE || RootIndex == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK chain %s -> %s: bone not found in skeleton"), *InRootBoneName.ToString(), *InTipBoneName.ToString());
+		return false;
+	}
+
+	// check that the root bone is above the tip bone in the bone hierarchy
+	int32 BoneIndex = TipIndex;
+	while (BoneIndex != INDEX_NONE)
+	{
+		OutChain.BoneIndices.Add(BoneIndex);
+		if (BoneIndex == RootIndex)
+		{
+			break;
+		}
+		BoneIndex = RefSkeleton.GetParentIndex(BoneIndex);
+	}
+	if (BoneIndex == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("TipBoneName is NOT a child of RootBoneName"));
+		OutChain.BoneIndices.Reset();
+		return false;
+	}
+	Algo::Reverse(OutChain.BoneIndices);
+
+	const TArray<FTransform>& RefBonePose = RefSkeleton.GetRefBonePose();
+	const int32 NumBones = OutChain.BoneIndices.Num();
+	OutChain.BoneNames.Reserve(NumBones);
+	OutChain.ParentIndices.Reserve(NumBones);
+	OutChain.RestLengths.Reserve(NumBones - 1);
+	for (int32 Index = 0; Index < NumBones; ++Index)
+	{
+		const int32 SkeletonIndex = OutChain.BoneIndices[Index];
+		OutChain.BoneNames.Add(RefSkeleton.GetBoneName(SkeletonIndex));
+		OutChain.ParentIndices.Add(RefSkeleton.GetParentIndex(SkeletonIndex));
+
+		if (Index > 0)
+		{
+			float BoneLength = RefBonePose[SkeletonIndex].GetTranslation().Size();
+			OutChain.RestLengths.Add(BoneLength);
+			OutChain.TotalReach += BoneLength;
+		}
+	}
+	return true;
+}
+
+bool FIKChain::Build(const IKCore::FSkeletonCache& Cache, const IKCore::FSkeletonChain& CachedChain, FIKChain& OutChain)
+{
+	OutChain = FIKChain();
+	OutChain.TipBoneName = FName(UTF8_TO_TCHAR(Cache.GetName(CachedChain.TipNameOffset)));
+	OutChain.RootBoneName = FName(UTF8_TO_TCHAR(Cache.GetName(CachedChain.RootNameOffset)));
+	OutChain.TotalReach = CachedChain.TotalReach;
+
+	const int32* BoneIndices = Cache.GetChainBones(CachedChain);
+	const int32 NumBones = static_cast<int32>(CachedChain.NumBones);
+	OutChain.BoneIndices.Append(BoneIndices, NumBones);
+	OutChain.BoneNames.Reserve(NumBones);
+	OutChain.ParentIndices.Reserve(NumBones);
+	OutChain.RestLengths.Reserve(NumBones - 1);
+	for (int32 Index = 0; Index < NumBones; ++Index)
+	{
+		const IKCore::FSkeletonBone& Bone = Cache.GetBone(BoneIndices[Index]);
+		OutChain.BoneNames.Add(FName(UTF8_TO_TCHAR(Cache.GetBoneName(BoneIndices[Index]))));
+		OutChain.ParentIndices.Add(Bone.Parent);
+		if (Index > 0)
+		{
+			OutChain.RestLengths.Add(Bone.RestLength);
+		}
+	}
+
+	bool bLimited = false;
+	OutChain.JointLimits.Reserve(NumBones - 1);
+	for (int32 Index = 0; Index < NumBones - 1; ++Index)
+	{
+		const IKCore::FSkeletonBone& Bone = Cache.GetBone(BoneIndices[Index]);
+		const Eigen::Quaternionf RestRotation(Bone.RestRotation[3], Bone.RestRotation[0], Bone.RestRotation[1], Bone.RestRotation[2]);
+		const Eigen::Vector3f TwistAxis(Bone.TwistAxis[0], Bone.TwistAxis[1], Bone.TwistAxis[2]);
+		OutChain.JointLimits.Emplace(RestRotation, TwistAxis, Bone.SwingLimit, Bone.MinTwist, Bone.MaxTwist);
+		bLimited |= !OutChain.JointLimits.Last().IsFree();
+	}
+	if (!bLimited)
+	{
+		OutChain.JointLimits.Empty();
+	}
+	return OutChain.IsValid();
+}
+
+bool FIKTree::Build(const FReferenceSkeleton& RefSkeleton, const TArray<FName>& InTipBoneNames, FName InRootBoneName, FIKTree& OutTree)
+{
+	OutTree = FIKTree();
+	OutTree.TipBoneNames = InTipBoneNames;
+	OutTree.RootBoneName = InRootBoneName;
+
+	const int32 RootIndex = RefSkeleton.FindBoneIndex(InRootBoneName);
+	if (RootIndex == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK tree %s: bone not found in skeleton"), *InRootBoneName.ToString());
+		return false;
+	}
+
+	// every bone from each tip up to the root, once
+	TArray<int32> TipSkeletonIndices;
+	for (const FName& TipBoneName : InTipBoneNames)
+	{
+		const int32 TipIndex = RefSkeleton.FindBoneIndex(TipBoneName);
+		if (TipIndex == INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("IK tree %s -> %s: bone not found in skeleton"), *InRootBoneName.ToString(), *TipBoneName.ToString());
+			return false;
+		}
+
+		int32 BoneIndex = TipIndex;
+		while (BoneIndex != INDEX_NONE && BoneIndex != RootIndex)
+		{
+			OutTree.BoneIndices.AddUnique(BoneIndex);
+			BoneIndex = RefSkeleton.GetParentIndex(BoneIndex);
+		}
+		if (BoneIndex == INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s is NOT a child of %s"), *TipBoneName.ToString(), *InRootBoneName.ToString());
+			OutTree.BoneIndices.Reset();
+			return false;
+		}
+		TipSkeletonIndices.Add(TipIndex);
+	}
+	OutTree.BoneIndices.Add(RootIndex);
+
+	// the reference skeleton lists every bone after its parent already
+	OutTree.BoneIndices.Sort();
+	OutTree.ParentIndices.Reserve(OutTree.NumBones());
+	for (int32 SkeletonIndex : OutTree.BoneIndices)
+	{
+		OutTree.ParentIndices.Add(SkeletonIndex == RootIndex ? INDEX_NONE : OutTree.BoneIndices.Find(RefSkeleton.GetParentIndex(SkeletonIndex)));
+	}
+	OutTree.TipIndices.Reserve(TipSkeletonIndices.Num());
+	for (int32 TipIndex : TipSkeletonIndices)
+	{
+		OutTree.TipIndices.Add(OutTree.BoneIndices.Find(TipIndex));
+	}
+	return true;
+}
+
+const USkeletalMesh* FIKChainCache::UpdateMesh(const USkinnedMeshComponent* MeshComp)
+{
+	const USkeletalMesh* SkeletalMesh = MeshComp ? MeshComp->SkeletalMesh : nullptr;
+	if (SkeletalMesh != nullptr && CachedMesh.Get() != SkeletalMesh)
+	{
+		Reset();
+		CachedMesh = SkeletalMesh;
+	}
+	return SkeletalMesh;
+}
+
+const FIKChain* FIKChainCache::FindOrBuild(const USkinnedMeshComponent* MeshComp, FName TipBoneName, FName RootBoneName)
+{
+	SCOPE_CYCLE_COUNTER(STAT_IKModule_ChainBuild);
+
+	const USkeletalMesh* SkeletalMesh = UpdateMesh(MeshComp);
+	if (SkeletalMesh == nullptr)
+	{
+		return nullptr;
+	}
+
+	const TPair<FName, FName> Key(TipBoneName, RootBoneName);
+	if (const FIKChain* const* Chain = Chains.Find(Key))
+	{
+		return *Chain;
+	}
+
+	// failed lookups are cached as well, as null
+	const FIKChain* Chain = FIKSkeletonCacheRegistry::Get().FindOrBuildChain(*SkeletalMesh, TipBoneName, RootBoneName);
+	Chains.Add(Key, Chain);
+	return Chain;
+}
+
+const FIKTree* FIKChainCache::FindOrBuildTree(const USkinnedMeshComponent* MeshComp, const TArray<FName>& TipBoneNames, FName RootBoneName)
+{
+	SCOPE_CYCLE_COUNTER(STAT_IKModule_ChainBuild);
+
+	const USkeletalMesh* SkeletalMesh = UpdateMesh(MeshComp);
+	if (SkeletalMesh == nullptr)
+	{
+		return nullptr;
+	}
+
+	const TUniquePtr<FIKTree>* CachedTree = Trees.FindByPredicate([&](const TUniquePtr<FIKTree>& Tree)
+	{
+		return Tree->RootBoneName == RootBoneName && Tree->TipBoneNames == TipBoneNames;
+	});
+	const FIKTree* Tree = CachedTree != nullptr ? CachedTree->Get() : nullptr;
+	if (Tree == nullptr)
+	{
+		// failed builds are cached as well, as for chains
+		TUniquePtr<FIKTree> NewTree = MakeUnique<FIKTree>();
+		FIKTree::Build(SkeletalMesh->RefSkeleton, TipBoneNames, RootBoneName, *NewTree);
+		Tree = Trees.Add_GetRef(MoveTemp(NewTree)).Get();
+	}
+	return Tree->IsValid() ? Tree : nullptr;
+}
+
+void FIKChainCache::Reset()
+{
+	CachedMesh.Reset();
+	Chains.Reset();
+	Trees.Reset();
+}
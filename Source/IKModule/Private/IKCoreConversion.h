@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IKCoreTypes.h"
+#include "IKSolverType.h"
+
+FORCEINLINE Eigen::Vector3f ToEigen(const FVector& Vector)
+{
+	return Eigen::Vector3f(Vector.X, Vector.Y, Vector.Z);
+}
+
+FORCEINLINE Eigen::Quaternionf ToEigen(const FQuat& Quat)
+{
+	return Eigen::Quaternionf(Quat.W, Quat.X, Quat.Y, Quat.Z);
+}
+
+FORCEINLINE FVector ToUnreal(const Eigen::Vector3f& Vector)
+{
+	return FVector(Vector.x(), Vector.y(), Vector.z());
+}
+
+FORCEINLINE FQuat ToUnreal(const Eigen::Quaternionf& Quat)
+{
+	return FQuat(Quat.x(), Quat.y(), Quat.z(), Quat.w());
+}
+
+FORCEINLINE IKCore::ESolver ToIKCore(EIKSolverType Solver)
+{
+	static_assert(static_cast<uint8>(EIKSolverType::Auto) == static_cast<uint8>(IKCore::ESolver::Auto), "EIKSolverType must mirror IKCore::ESolver");
+	return static_cast<IKCore::ESolver>(Solver);
+}
+
+/** The first IKCore::FSolverPipeline::MaxStages stages of Stages. */
+inline IKCore::FSolverPipeline ToIKCore(const TArray<FIKSolverStage>& Stages)
+{
+	IKCore::FSolverPipeline Pipeline;
+	for (const FIKSolverStage& Stage : Stages)
+	{
+		Pipeline.Add(ToIKCore(Stage.Solver), Stage.MaxIterations, Stage.HandOffDistance);
+	}
+	return Pipeline;
+}
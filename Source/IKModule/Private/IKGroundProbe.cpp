@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKGroundProbe.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+#include "IKCoreConversion.h"
+
+FIKAsyncTraceGroundQuery::FIKAsyncTraceGroundQuery(UWorld& InWorld, ECollisionChannel InChannel)
+	: World(&InWorld)
+	, Channel(InChannel)
+{
+}
+
+void FIKAsyncTraceGroundQuery::Submit(const IKCore::FGroundProbe* Probes, int32_t NumProbes)
+{
+	Handles.Reset(NumProbes);
+	UWorld* TraceWorld = World.Get();
+	if (TraceWorld == nullptr)
+	{
+		return;
+	}
+
+	for (int32 Index = 0; Index < NumProbes; ++Index)
+	{
+		const IKCore::FGroundProbe& Probe = Probes[Index];
+		const FCollisionQueryParams Params(SCENE_QUERY_STAT(IKGroundProbe), false, static_cast<const AActor*>(Probe.IgnoredOwner));
+		Handles.Add(TraceWorld->AsyncLineTraceByChannel(EAsyncTraceType::Single, ToUnreal(Probe.Start), ToUnreal(Probe.End), Channel, Params));
+	}
+}
+
+bool FIKAsyncTraceGroundQuery::Fetch(IKCore::FGroundHit* OutHits, int32_t NumProbes)
+{
+	UWorld* TraceWorld = World.Get();
+	if (TraceWorld == nullptr || Handles.Num() != NumProbes)
+	{
+		return false;
+	}
+
+	for (int32 Index = 0; Index < NumProbes; ++Index)
+	{
+		if (!TraceWorld->QueryTraceData(Handles[Index], Datum))
+		{
+			return false;
+		}
+
+		IKCore::FGroundHit& Hit = OutHits[Index];
+		const FHitResult* Blocking = Datum.OutHits.FindByPredicate([](const FHitResult& Result) { return Result.bBlockingHit; });
+		Hit.bHit = Blocking != nullptr;
+		if (Blocking != nullptr)
+		{
+			Hit.Location = ToEigen(Blocking->ImpactPoint);
+			Hit.Normal = ToEigen(Blocking->ImpactNormal);
+		}
+	}
+	return true;
+}
@@ -2,6 +2,20 @@
 
 #include "IKModule.h"
 #include "Modules/ModuleManager.h"
+#include "IKModuleStats.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, IKModule, "IKModule" );
- 
\ No newline at end of file
+class FIKModuleImpl : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		FIKModuleStats::Startup();
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FIKModuleStats::Shutdown();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FIKModuleImpl, IKModule, "IKModule" );
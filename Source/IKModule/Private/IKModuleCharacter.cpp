@@ -8,8 +8,14 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
 #include "GameFramework/SpringArmComponent.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "AnimationRuntime.h"
 
-#include <Eigen/Dense>
+#include "IKCoreConversion.h"
+#include "IKModuleStats.h"
+#include "IKPoseDatabase.h"
+#include "IKCoreSolvers.h"
 
 AIKModuleCharacter::AIKModuleCharacter()
 {
@@ -47,6 +53,26 @@ AIKModuleCharacter::AIKModuleCharacter()
 
 	poseableMeshComp = CreateDefaultSubobject<UPoseableMeshComponent>(TEXT("IK"));
 	poseableMeshComp->SetupAttachment(RootComponent);
+
+	ReachTargetLocation = FVector(0.f, 0.f, 260.f);
+	IKSolver = EIKSolverType::Auto;
+	bDeferSolves = true;
+	bSkipUnchangedSolves = true;
+	bAnalyticTwoBone = true;
+	bAllowStretch = false;
+	MaxStretchScale = 1.2f;
+	SoftStartRatio = 1.f;
+	bUseReachPole = false;
+	ReachPoleLocation = FVector::ZeroVector;
+	ReachSwivelAngle = 0.f;
+	IKPriority = 1.f;
+
+	bFootPlacement = false;
+	Feet.Emplace(FName("foot_l"), FName("thigh_l"));
+	Feet.Emplace(FName("foot_r"), FName("thigh_r"));
+	FootProbeAbove = 50.f;
+	FootProbeBelow = 75.f;
+	FootSmoothingHalfLife = 0.05f;
 }
 
 void AIKModuleCharacter::SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent)
@@ -112,428 +138,259 @@ void AIKModuleCharacter::MoveRight(float Value)
 void AIKModuleCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
-	
+	UpdateIKTier();
+
+	if (bFootPlacement)
+	{
+		PlaceFeet(DeltaTime);
+	}
+
 	FName TipBoneName = FName("hand_l");
 	FName RootBoneName = FName("upperarm_l");
-	//SolveFABRIK(TipBoneName, RootBoneName, FVector(0, 0, 260), 1.0f, 10);
-	SolveJacobianTranspose(TipBoneName, RootBoneName, FVector(0, 0, 260), 1.0f);
-
+	SolveChain(ToIKCore(IKSolver), TipBoneName, RootBoneName, ReachTargetLocation, 1.0f, 10, bUseReachPole ? &ReachPoleLocation : nullptr, ReachSwivelAngle);
 }
 
 void AIKModuleCharacter::SolveCCD(FName TipBoneName, FName RootBoneName, FVector TargetLocation, float Precision, int32 MaxIterations)
 {
-	// bone hierarchy tip bone  root bone ִ Ȯ
-	FName BoneName = TipBoneName;
-	TArray<FName> BoneNames;
-	BoneNames.Add(BoneName);
-	while (!BoneName.IsEqual(RootBoneName))
-	{
-		BoneName = poseableMeshComp->GetParentBone(BoneName);
-		BoneNames.Insert(BoneName, 0);
-	}
-	if (BoneName.IsEqual("None"))
-	{
-		UE_LOG(LogTemp, Warning, TEXT("TipBoneName is NOT a child of RootBoneName"));
-		return;
-	}
-	
-	// solve
-	int32 IterationCount = 0;
-	float Distance = FVector::Dist(poseableMeshComp->GetBoneLocation(TipBoneName), TargetLocation);
-	
-	while (Distance > Precision && IterationCount++ < MaxIterations)
-	{
-		for (int32 Index = BoneNames.Num() - 2; Index >= 0; --Index)
-		{
-			FVector TipLocation = poseableMeshComp->GetBoneLocationByName(TipBoneName, EBoneSpaces::WorldSpace);
-
-			FName CurrentBoneName = BoneNames[Index];
-			FVector CurrentBoneLocation = poseableMeshComp->GetBoneLocationByName(CurrentBoneName, EBoneSpaces::WorldSpace);
-
-			FVector ToEnd = TipLocation - CurrentBoneLocation;
-			FVector ToTarget = TargetLocation - CurrentBoneLocation;
-			ToEnd.Normalize();
-			ToTarget.Normalize();
-
-			float Angle = FMath::Acos(FVector::DotProduct(ToEnd, ToTarget));
-			FVector RotationAxis = FVector::CrossProduct(ToEnd, ToTarget);
-			if (RotationAxis.SizeSquared() > 0.f)
-			{
-				FQuat DeltaRotation(RotationAxis, Angle);
-				FQuat CurrentQuat = poseableMeshComp->GetBoneQuaternion(CurrentBoneName);
-				FQuat NewQuat = DeltaRotation * CurrentQuat;
-				NewQuat.Normalize();
-				poseableMeshComp->SetBoneRotationByName(CurrentBoneName, NewQuat.Rotator(), EBoneSpaces::WorldSpace);
-			}
-		}
-		Distance = FVector::Dist(poseableMeshComp->GetBoneLocation(TipBoneName), TargetLocation);
-	}
+	SolveChain(IKCore::ESolver::CCD, TipBoneName, RootBoneName, TargetLocation, Precision, MaxIterations);
 }
 
 void AIKModuleCharacter::SolveFABRIK(FName TipBoneName, FName RootBoneName, FVector TargetLocation, float Precision, int32 MaxIterations)
 {
-	// bone hierarchy tip bone  root bone ִ Ȯ
-	FName BoneName = TipBoneName;
-	TArray<FName> BoneNames;
-	TArray<FVector> OriginalLocation;
-	BoneNames.Add(BoneName);
-	OriginalLocation.Add(poseableMeshComp->GetBoneLocationByName(BoneName, EBoneSpaces::WorldSpace));
-	while (!BoneName.IsEqual(RootBoneName))
+	SolveChain(IKCore::ESolver::FABRIK, TipBoneName, RootBoneName, TargetLocation, Precision, MaxIterations);
+}
+
+void AIKModuleCharacter::SolveJacobianTranspose(FName TipBoneName, FName RootBoneName, FVector TargetLocation, float Precision)
+{
+	// a single Jacobian step per frame
+	SolveChain(IKCore::ESolver::JacobianTranspose, TipBoneName, RootBoneName, TargetLocation, Precision, 1);
+}
+
+void AIKModuleCharacter::SolveJacobianPinv(FName TipBoneName, FName RootBoneName, FVector TargetLocation, float Precision)
+{
+	// a single Jacobian step per frame
+	SolveChain(IKCore::ESolver::JacobianPinv, TipBoneName, RootBoneName, TargetLocation, Precision, 1);
+}
+
+void AIKModuleCharacter::SolveDampedLeastSquares(FName TipBoneName, FName RootBoneName, FVector TargetLocation, float Precision, int32 MaxIterations)
+{
+	SolveChain(IKCore::ESolver::DampedLeastSquares, TipBoneName, RootBoneName, TargetLocation, Precision, MaxIterations);
+}
+
+IKCore::FSolveResult AIKModuleCharacter::SolveMultiEffector(IKCore::ESolver Solver, FName RootBoneName, const TArray<FIKEffectorTarget>& Targets, float Precision, int32 MaxIterations)
+{
+	EffectorTipNames.Reset(Targets.Num());
+	for (const FIKEffectorTarget& Target : Targets)
 	{
-		BoneName = poseableMeshComp->GetParentBone(BoneName);
-		BoneNames.Insert(BoneName, 0);
-		OriginalLocation.Insert(poseableMeshComp->GetBoneLocationByName(BoneName, EBoneSpaces::WorldSpace), 0);
+		EffectorTipNames.Add(Target.TipBoneName);
 	}
-	if (BoneName.IsEqual("None"))
+	const FIKTree* Tree = ChainCache.FindOrBuildTree(poseableMeshComp, EffectorTipNames, RootBoneName);
+	if (Tree == nullptr || !TreePoseBuffer.Load(*poseableMeshComp, *Tree))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("TipBoneName is NOT a child of RootBoneName"));
-		return;
+		return IKCore::FSolveResult();
 	}
-	
-	// bone length
-	TArray<float> BoneLengths;
-	float BoneLengthSum = 0.f;
-	for (int32 Index = 0; Index < BoneNames.Num() - 1; ++Index)
+
+	const FTransform& ComponentTransform = poseableMeshComp->GetComponentTransform();
+	Effectors.resize(Targets.Num());
+	for (int32 Index = 0; Index < Targets.Num(); ++Index)
 	{
-		FVector CurrentLocation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index], EBoneSpaces::WorldSpace);
-		FVector NextLocation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index + 1], EBoneSpaces::WorldSpace);
-		
-		float BoneLength = FVector::Dist(CurrentLocation, NextLocation);
-		BoneLengths.Add(BoneLength);
-		BoneLengthSum += BoneLength;
+		Effectors[Index].BoneIndex = Tree->TipIndices[Index];
+		Effectors[Index].Target = ToEigen(ComponentTransform.InverseTransformPosition(Targets[Index].TargetLocation));
+		Effectors[Index].Weight = Targets[Index].Weight;
 	}
 
-	// reachability calculation
-	FVector RootLocation = poseableMeshComp->GetBoneLocationByName(RootBoneName, EBoneSpaces::WorldSpace);
-	float RootToTargetDist = FVector::Dist(RootLocation, TargetLocation);
-
-	// unreachable
-	if (RootToTargetDist > BoneLengthSum)
+	IKCore::FSolverSettings Settings;
+	Settings.Precision = Precision;
+	Settings.MaxIterations = MaxIterations;
+	UIKSolveSubsystem* SolveSubsystem = GetWorld()->GetSubsystem<UIKSolveSubsystem>();
+	if (SolveSubsystem != nullptr)
 	{
-		for (int32 Index = 0; Index < BoneNames.Num() - 1; ++Index)
-		{
-			FVector BoneLocation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index], EBoneSpaces::WorldSpace);
-			float DistanceToTarget = FVector::Dist(BoneLocation, TargetLocation);
-			float Lambda = BoneLengths[Index] / DistanceToTarget;
-
-			FVector NewLocation = (1 - Lambda) * BoneLocation + Lambda * TargetLocation;
-			poseableMeshComp->SetBoneLocationByName(BoneNames[Index + 1], NewLocation, EBoneSpaces::WorldSpace);
-		}
+		Settings = IKCore::GetTierSettings(IKTier, Settings, SolveSubsystem->GetBudgetSettings());
 	}
 
-	// reachable
-	else
+	IKCore::FSolveResult Result;
+	FIKSolveRecord Record;
 	{
-		int32 IterationCount = 0;
-		float Distance = FVector::Dist(poseableMeshComp->GetBoneLocation(TipBoneName), TargetLocation);
-		
-		while (Distance > Precision && IterationCount++ < MaxIterations)
-		{
-			// forward reaching
-			poseableMeshComp->SetBoneLocationByName(TipBoneName, TargetLocation, EBoneSpaces::WorldSpace);
-			for (int32 Index = BoneNames.Num() - 2; Index >= 0; --Index)
-			{
-				FVector BoneLocation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index], EBoneSpaces::WorldSpace);
-				FVector NextBoneLocation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index + 1], EBoneSpaces::WorldSpace);
-				float JointDistance = FVector::Dist(BoneLocation, NextBoneLocation);
-				float Lambda = BoneLengths[Index] / JointDistance;
-
-				FVector NewLocation = (1 - Lambda) * NextBoneLocation + Lambda * BoneLocation;
-				poseableMeshComp->SetBoneLocationByName(BoneNames[Index], NewLocation, EBoneSpaces::WorldSpace);
-			}
-
-			// backward reaching
-			poseableMeshComp->SetBoneLocationByName(RootBoneName, RootLocation, EBoneSpaces::WorldSpace);
-			for (int32 Index = 0; Index < BoneNames.Num() - 1; ++Index)
-			{
-				FVector BoneLocation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index], EBoneSpaces::WorldSpace);
-				FVector NextBoneLocation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index + 1], EBoneSpaces::WorldSpace);
-				float JointDistance = FVector::Dist(BoneLocation, NextBoneLocation);
-				float Lambda = BoneLengths[Index] / JointDistance;
-
-				FVector NewLocation = (1 - Lambda) * BoneLocation + Lambda * NextBoneLocation;
-				poseableMeshComp->SetBoneLocationByName(BoneNames[Index + 1], NewLocation, EBoneSpaces::WorldSpace);
-			}
-
-			Distance = FVector::Dist(poseableMeshComp->GetBoneLocation(TipBoneName), TargetLocation);
-		}
-		
+		SCOPE_CYCLE_COUNTER(STAT_IKModule_Solve);
+		const double StartTime = FPlatformTime::Seconds();
+		Result = IKCore::SolveMultiEffector(Solver, TreePoseBuffer.Pose, Effectors, Settings, &MultiEffectorWorkspace);
+		Record.Seconds = FPlatformTime::Seconds() - StartTime;
 	}
-	// orientation adjustment
-	for (int32 Index = 0; Index < BoneNames.Num() - 1; ++Index)
+	Record.OwnerName = GetFName();
+	Record.ChainName = RootBoneName;
+	Record.Solver = Solver;
+	Record.NumBones = TreePoseBuffer.Pose.Num();
+	Record.Precision = Precision;
+	FIKModuleStats::RecordSolve(Record, Result);
+	if (SolveSubsystem != nullptr)
 	{
-		FVector OriginalOrientation = OriginalLocation[Index + 1] - OriginalLocation[Index];
-		FVector NewOrientation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index + 1], EBoneSpaces::WorldSpace) - poseableMeshComp->GetBoneLocationByName(BoneNames[Index], EBoneSpaces::WorldSpace);
-		OriginalOrientation.Normalize();
-		NewOrientation.Normalize();
-
-		float Angle = FMath::Acos(FVector::DotProduct(OriginalOrientation, NewOrientation));
-		FVector RotationAxis = FVector::CrossProduct(OriginalOrientation, NewOrientation);
-		if (RotationAxis.SizeSquared() > 0.f)
-		{
-			FQuat DeltaRotation(RotationAxis, Angle);
-			FQuat BoneQuat = poseableMeshComp->GetBoneQuaternion(BoneNames[Index]);
-			FQuat NewQuat = DeltaRotation * BoneQuat;
-			NewQuat.Normalize();
-			poseableMeshComp->SetBoneRotationByName(BoneNames[Index], NewQuat.Rotator(), EBoneSpaces::WorldSpace);
-		}
+		SolveSubsystem->ReportSolveTime(IKTier, Record.Seconds);
 	}
+
+	TreePoseBuffer.Commit(*poseableMeshComp, *Tree);
+	return Result;
 }
 
-void AIKModuleCharacter::SolveJacobianTranspose(FName TipBoneName, FName RootBoneName, FVector TargetLocation, float Precision)
+void AIKModuleCharacter::PlaceFeet(float DeltaTime)
 {
-	// bone hierarchy tip bone  root bone ִ Ȯ
-	FName BoneName = TipBoneName;
-	TArray<FName> BoneNames;
-	BoneNames.Add(BoneName);
-	while (!BoneName.IsEqual(RootBoneName))
-	{
-		BoneName = poseableMeshComp->GetParentBone(BoneName);
-		BoneNames.Insert(BoneName, 0);
-	}
-	if (BoneName.IsEqual("None"))
+	UIKSolveSubsystem* SolveSubsystem = GetWorld()->GetSubsystem<UIKSolveSubsystem>();
+	const USkeletalMesh* Mesh = poseableMeshComp->SkeletalMesh;
+	if (SolveSubsystem == nullptr || Mesh == nullptr || Feet.Num() == 0)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("TipBoneName is NOT a child of RootBoneName"));
 		return;
 	}
 
-	FVector TipBoneLocation = poseableMeshComp->GetBoneLocationByName(TipBoneName, EBoneSpaces::WorldSpace);
-	float Distance = FVector::Dist(TipBoneLocation, TargetLocation);
-	if (Distance > Precision)
+	const int32 NumFeet = Feet.Num();
+	if (FootPlacement.GetNumFeet() != NumFeet)
 	{
-		// create Jacobian matrix
-		Eigen::MatrixXf JacobianMat;
-		int NumOfLinks = BoneNames.Num() - 1;
-		JacobianMat.resize(3, NumOfLinks * 3);
-
-		FVector TipLocation = poseableMeshComp->GetBoneLocationByName(TipBoneName, EBoneSpaces::WorldSpace);
-		for (int32 Index = 0; Index < NumOfLinks; ++Index)
+		FootPlacement.Reset(NumFeet);
+		FootProbeTicket = FIKGroundProbeTicket();
+	}
+	FootLocations.resize(NumFeet);
+	FootTargets.resize(NumFeet);
+	FootProbes.resize(NumFeet);
+
+	// the mesh plays no animation, so the animated feet are those of the reference pose, which stands on the component's origin
+	const FTransform& ComponentTransform = poseableMeshComp->GetComponentTransform();
+	IKCore::FFootPlacementSettings Settings;
+	for (int32 Index = 0; Index < NumFeet; ++Index)
+	{
+		const FIKChain* Chain = ChainCache.FindOrBuild(poseableMeshComp, Feet[Index].FootBoneName, Feet[Index].RootBoneName);
+		if (Chain == nullptr)
 		{
-			FVector BoneLocation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index], EBoneSpaces::WorldSpace);
-
-			FVector RotAxisX = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::X) - BoneLocation;
-			FVector RotAxisY = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::Y) - BoneLocation;
-			FVector RotAxisZ = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::Z) - BoneLocation;
-
-			int ColumnOffset = Index * 3;
-
-			if (RotAxisX.SizeSquared() > 0.f)
-			{
-				RotAxisX.Normalize();
-				FVector DeltaX = FVector::CrossProduct(RotAxisX, TipLocation - BoneLocation);
-				if (DeltaX.SizeSquared() > 0.f)
-				{
-					for (int Row = 0; Row < 3; ++Row)
-						JacobianMat(Row, ColumnOffset) = DeltaX[Row];
-				}
-			}
-
-			if (RotAxisY.SizeSquared() > 0.f)
-			{
-				RotAxisY.Normalize();
-				FVector DeltaY = FVector::CrossProduct(RotAxisY, TipLocation - BoneLocation);
-				if (DeltaY.SizeSquared() > 0.f)
-				{
-					DeltaY.Normalize();
-					for (int Row = 0; Row < 3; ++Row)
-						JacobianMat(Row, ColumnOffset + 1) = DeltaY[Row];
-				}
-			}
-
-			if (RotAxisZ.SizeSquared() > 0.f)
-			{
-				RotAxisZ.Normalize();
-				FVector DeltaZ = FVector::CrossProduct(RotAxisZ, TipLocation - BoneLocation);
-				if (DeltaZ.SizeSquared() > 0.f)
-				{
-					for (int Row = 0; Row < 3; ++Row)
-						JacobianMat(Row, ColumnOffset + 2) = DeltaZ[Row];
-				}
-			}
+			return;
 		}
-
-		// calculate Jacobian Square
-		Eigen::MatrixXf JacobianTranspose = JacobianMat.transpose();
-		Eigen::MatrixXf JacobianSquare = JacobianMat * JacobianTranspose;
-		
-		// calculate effector derivative
-		Eigen::Vector3f TargetEigen, TipEigen;
-		for (int i = 0; i < 3; ++i)
+		const FVector* CachedRefLocation = FootRefLocations.Find(Chain);
+		if (CachedRefLocation == nullptr)
 		{
-			TargetEigen(i) = TargetLocation[i];
-			TipEigen(i) = TipLocation[i];
+			CachedRefLocation = &FootRefLocations.Add(Chain, FAnimationRuntime::GetComponentSpaceTransformRefPose(Mesh->RefSkeleton, Chain->BoneIndices.Last()).GetLocation());
 		}
-		Eigen::Vector3f EffectorDerivatives = TargetEigen - TipEigen;
+		const FVector RefLocation = *CachedRefLocation;
+		FootLocations[Index] = ToEigen(ComponentTransform.TransformPosition(RefLocation));
+		Settings.FootHeight += RefLocation.Z * ComponentTransform.GetScale3D().Z / NumFeet;
+	}
+	Settings.ProbeAbove = FootProbeAbove;
+	Settings.ProbeBelow = FootProbeBelow;
+	Settings.SmoothingHalfLife = FootSmoothingHalfLife;
 
-		// solve
-		Eigen::Vector3f Result = JacobianSquare * EffectorDerivatives;
-		Eigen::Vector3f EffectorDerivativesVector = EffectorDerivatives;
-		float AlphaBottom = Result.dot(Result);
-		float AlphaUp = EffectorDerivativesVector.dot(Result);
+	// last frame's probes place this frame's feet, this frame's probes come back on the next one
+	const Eigen::Vector3f Up = ToEigen(ComponentTransform.GetUnitAxis(EAxis::Z));
+	FootPlacement.Update(SolveSubsystem->GetGroundHits(FootProbeTicket), FootLocations.data(), Up, Settings, DeltaTime, FootTargets.data());
+	FootPlacement.MakeProbes(FootLocations.data(), Up, Settings, this, FootProbes.data());
+	FootProbeTicket = SolveSubsystem->SubmitGroundProbes(FootProbes.data(), NumFeet);
 
-		Eigen::MatrixXf DeltaRotation;
-		if (!FMath::IsNearlyZero(AlphaBottom))
-		{
-			DeltaRotation = (AlphaUp / AlphaBottom) * JacobianTranspose * EffectorDerivatives;
-
-			// apply the result
-			for (int32 Index = 0; Index < NumOfLinks; ++Index)
-			{
-				FVector BoneLocation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index], EBoneSpaces::WorldSpace);
-				FVector RotAxisX = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::X) - BoneLocation;
-				FVector RotAxisY = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::Y) - BoneLocation;
-				FVector RotAxisZ = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::Z) - BoneLocation;
-
-				FQuat Quat = poseableMeshComp->GetBoneQuaternion(BoneNames[Index], EBoneSpaces::WorldSpace);
-
-				if (RotAxisX.SizeSquared() > 0.f)
-				{
-					RotAxisX.Normalize();
-					FQuat DeltaQuatX(RotAxisX, DeltaRotation(0));
-					Quat = DeltaQuatX * Quat;
-				}
-
-				if (RotAxisY.SizeSquared() > 0.f)
-				{
-					RotAxisY.Normalize();
-					FQuat DeltaQuatY(RotAxisY, DeltaRotation(1));
-					Quat = DeltaQuatY * Quat;
-				}
-
-				if (RotAxisZ.SizeSquared() > 0.f)
-				{
-					RotAxisZ.Normalize();
-					FQuat DeltaQuatZ(RotAxisZ, DeltaRotation(2));
-					Quat = DeltaQuatZ * Quat;
-				}
-				poseableMeshComp->SetBoneRotationByName(BoneNames[Index], Quat.Rotator(), EBoneSpaces::WorldSpace);
-			}
-		}
+	for (int32 Index = 0; Index < NumFeet; ++Index)
+	{
+		SolveChain(ToIKCore(IKSolver), Feet[Index].FootBoneName, Feet[Index].RootBoneName, ToUnreal(FootTargets[Index]), 1.0f, 10);
+	}
+}
 
-		FRotator Rotator = poseableMeshComp->GetBoneRotationByName(BoneNames[0], EBoneSpaces::WorldSpace);
-		GEngine->AddOnScreenDebugMessage(1, 0.1f, FColor::Red, FString::Printf(TEXT("%f"), Distance));
+void AIKModuleCharacter::UpdateIKTier()
+{
+	UIKSolveSubsystem* SolveSubsystem = GetWorld()->GetSubsystem<UIKSolveSubsystem>();
+	if (SolveSubsystem == nullptr)
+	{
+		IKTier = IKCore::ELODTier::Full;
+		return;
 	}
+
+	// without a local view (dedicated server) only the priority counts, off screen characters rank last
+	float Significance = IKPriority;
+	const APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0);
+	if (CameraManager != nullptr)
+	{
+		const float Distance = FVector::Dist(CameraManager->GetCameraLocation(), GetActorLocation());
+		const float TanHalfFOV = FMath::Tan(FMath::DegreesToRadians(CameraManager->GetFOVAngle() * 0.5f));
+		Significance = WasRecentlyRendered() ? IKCore::ComputeSignificance(Distance, poseableMeshComp->Bounds.SphereRadius, TanHalfFOV, IKPriority) : 0.f;
+	}
+	IKTier = SolveSubsystem->RequestTier(*this, Significance, FMath::Max(SolveStates.Num(), 1));
 }
 
-void AIKModuleCharacter::SolveJacobianPinv(FName TipBoneName, FName RootBoneName, FVector TargetLocation, float Precision)
+IKCore::FSolveResult AIKModuleCharacter::SolveChain(IKCore::ESolver Solver, FName TipBoneName, FName RootBoneName, const FVector& TargetLocation, float Precision, int32 MaxIterations,
+	const FVector* PoleLocation, float SwivelAngle)
 {
-	// bone hierarchy tip bone  root bone ִ Ȯ
-	FName BoneName = TipBoneName;
-	TArray<FName> BoneNames;
-	BoneNames.Add(BoneName);
-	while (!BoneName.IsEqual(RootBoneName))
+	const FIKChain* Chain = ChainCache.FindOrBuild(poseableMeshComp, TipBoneName, RootBoneName);
+	if (Chain == nullptr)
 	{
-		BoneName = poseableMeshComp->GetParentBone(BoneName);
-		BoneNames.Insert(BoneName, 0);
+		return IKCore::FSolveResult();
 	}
-	if (BoneName.IsEqual("None"))
+
+	IKCore::FSolverSettings Settings;
+	Settings.Precision = Precision;
+	Settings.MaxIterations = MaxIterations;
+	Settings.bAnalyticTwoBone = bAnalyticTwoBone;
+	Settings.TwoBone.bAllowStretch = bAllowStretch;
+	Settings.TwoBone.MaxStretchScale = MaxStretchScale;
+	Settings.TwoBone.SoftStartRatio = SoftStartRatio;
+	Settings.TwoBone.SwivelAngle = FMath::DegreesToRadians(SwivelAngle);
+	if (PoleLocation != nullptr)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("TipBoneName is NOT a child of RootBoneName"));
-		return;
+		Settings.TwoBone.bUsePoleVector = true;
+		Settings.TwoBone.PoleVector = ToEigen(poseableMeshComp->GetComponentTransform().InverseTransformPosition(*PoleLocation));
 	}
 
-	FVector TipBoneLocation = poseableMeshComp->GetBoneLocationByName(TipBoneName, EBoneSpaces::WorldSpace);
-	float Distance = FVector::Dist(TipBoneLocation, TargetLocation);
-	if (Distance > Precision)
+	FChainSolve& ChainSolve = SolveStates.FindOrAdd(TPair<FName, FName>(TipBoneName, RootBoneName));
+	if (!ChainSolve.State.IsValid())
 	{
-		// create Jacobian matrix
-		Eigen::MatrixXf JacobianMat;
-		int NumOfLinks = BoneNames.Num() - 1;
-		JacobianMat.resize(3, NumOfLinks * 3);
+		ChainSolve.State = MakeUnique<IKCore::FChainSolveState>();
+	}
+	IKCore::FChainSolveState* SolveState = ChainSolve.State.Get();
+	IKCore::FWarmStartSettings WarmStartSettings;
+	WarmStartSettings.bSkipUnchanged = bSkipUnchangedSolves;
+	if (poseableMeshComp->SkeletalMesh != nullptr)
+	{
+		WarmStartSettings.PoseDatabase = FIKPoseDatabaseRegistry::Get().Find(*poseableMeshComp->SkeletalMesh, *Chain);
+		WarmStartSettings.PoseDatabaseNeighbours = FIKPoseDatabaseRegistry::GetNumNeighbours();
+	}
 
-		FVector TipLocation = poseableMeshComp->GetBoneLocationByName(TipBoneName, EBoneSpaces::WorldSpace);
-		for (int32 Index = 0; Index < NumOfLinks; ++Index)
-		{
-			FVector BoneLocation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index], EBoneSpaces::WorldSpace);
-
-			FVector RotAxisX = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::X) - BoneLocation;
-			FVector RotAxisY = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::Y) - BoneLocation;
-			FVector RotAxisZ = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::Z) - BoneLocation;
-
-			int ColumnOffset = Index * 3;
-
-			if (RotAxisX.SizeSquared() > 0.f)
-			{
-				RotAxisX.Normalize();
-				FVector DeltaX = FVector::CrossProduct(RotAxisX, TipLocation - BoneLocation);
-				if (DeltaX.SizeSquared() > 0.f)
-				{
-					for (int Row = 0; Row < 3; ++Row)
-						JacobianMat(Row, ColumnOffset) = DeltaX[Row];
-				}
-			}
-
-			if (RotAxisY.SizeSquared() > 0.f)
-			{
-				RotAxisY.Normalize();
-				FVector DeltaY = FVector::CrossProduct(RotAxisY, TipLocation - BoneLocation);
-				if (DeltaY.SizeSquared() > 0.f)
-				{
-					DeltaY.Normalize();
-					for (int Row = 0; Row < 3; ++Row)
-						JacobianMat(Row, ColumnOffset + 1) = DeltaY[Row];
-				}
-			}
-
-			if (RotAxisZ.SizeSquared() > 0.f)
-			{
-				RotAxisZ.Normalize();
-				FVector DeltaZ = FVector::CrossProduct(RotAxisZ, TipLocation - BoneLocation);
-				if (DeltaZ.SizeSquared() > 0.f)
-				{
-					for (int Row = 0; Row < 3; ++Row)
-						JacobianMat(Row, ColumnOffset + 2) = DeltaZ[Row];
-				}
-			}
-		}
+	UIKSolveSubsystem* SolveSubsystem = GetWorld()->GetSubsystem<UIKSolveSubsystem>();
+	if (SolveSubsystem != nullptr)
+	{
+		const IKCore::FBudgetSettings& BudgetSettings = SolveSubsystem->GetBudgetSettings();
+		Settings = IKCore::GetTierSettings(IKTier, Settings, BudgetSettings);
+		WarmStartSettings.IntervalFrames = IKTier == IKCore::ELODTier::Interval ? BudgetSettings.IntervalFrames : 1;
+	}
 
-		// calculate effector derivative
-		Eigen::Vector3f TargetEigen, TipEigen;
-		for (int i = 0; i < 3; ++i)
-		{
-			TargetEigen(i) = TargetLocation[i];
-			TipEigen(i) = TipLocation[i];
-		}
-		Eigen::Vector3f EffectorDerivatives = TargetEigen - TipEigen;
+	if (bDeferSolves && SolveSubsystem != nullptr)
+	{
+		// solved with every other queued chain at the subsystem's sync point, so the result at hand is the previous frame's
+		IKCore::FSolveResult PreviousResult;
+		SolveSubsystem->GetSolveResult(ChainSolve.Ticket, PreviousResult);
+		ChainSolve.Ticket = SolveSubsystem->SubmitSolve(*poseableMeshComp, *Chain, Solver, TargetLocation, Settings, SolveState, WarmStartSettings, IKTier);
+		return PreviousResult;
+	}
 
-		Eigen::MatrixXf JacobianSquare = JacobianMat.transpose() * JacobianMat;
+	if (!PoseBuffer.Load(*poseableMeshComp, *Chain))
+	{
+		return IKCore::FSolveResult();
+	}
 
-		// Eigen::MatrixXf JacobianPinv = JacobianMat.completeOrthogonalDecomposition().pseudoInverse();
-		Eigen::MatrixXf JacobianPinv = JacobianSquare.inverse() * JacobianMat.transpose();
-		Eigen::MatrixXf DeltaRotation = JacobianPinv * EffectorDerivatives;
+	const FVector Target = poseableMeshComp->GetComponentTransform().InverseTransformPosition(TargetLocation);
+	FIKModuleStats::RecordSolveInput(GetFName(), TipBoneName, PoseBuffer, ToEigen(Target), Settings);
+	const Eigen::Quaternionf RootParentRotation = ToEigen(PoseBuffer.RootParentTransform.GetRotation());
+	IKCore::FSolveResult Result;
+	FIKSolveRecord Record;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_IKModule_Solve);
+		const double StartTime = FPlatformTime::Seconds();
+		Result = SolveState->Solve(Solver, PoseBuffer.Pose, ToEigen(Target), RootParentRotation, Settings, WarmStartSettings);
+		Record.Seconds = FPlatformTime::Seconds() - StartTime;
+	}
+	Record.OwnerName = GetFName();
+	Record.ChainName = TipBoneName;
+	Record.Solver = Solver;
+	Record.NumBones = PoseBuffer.Pose.Num();
+	Record.Precision = Precision;
+	Record.bSkipped = SolveState->WasSkipped();
+	FIKModuleStats::RecordSolve(Record, Result);
+	if (SolveSubsystem != nullptr)
+	{
+		SolveSubsystem->ReportSolveTime(IKTier, Record.Seconds);
+	}
 
-		// apply the result
-		for (int32 Index = 0; Index < NumOfLinks; ++Index)
-		{
-			FVector BoneLocation = poseableMeshComp->GetBoneLocationByName(BoneNames[Index], EBoneSpaces::WorldSpace);
-			FVector RotAxisX = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::X) - BoneLocation;
-			FVector RotAxisY = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::Y) - BoneLocation;
-			FVector RotAxisZ = poseableMeshComp->GetBoneAxis(BoneNames[Index], EAxis::Z) - BoneLocation;
-
-			FQuat Quat = poseableMeshComp->GetBoneQuaternion(BoneNames[Index], EBoneSpaces::WorldSpace);
-
-			if (RotAxisX.SizeSquared() > 0.f)
-			{
-				RotAxisX.Normalize();
-				FQuat DeltaQuatX(RotAxisX, DeltaRotation(0));
-				Quat = DeltaQuatX * Quat;
-			}
-
-			if (RotAxisY.SizeSquared() > 0.f)
-			{
-				RotAxisY.Normalize();
-				FQuat DeltaQuatY(RotAxisY, DeltaRotation(1));
-				Quat = DeltaQuatY * Quat;
-			}
-
-			if (RotAxisZ.SizeSquared() > 0.f)
-			{
-				RotAxisZ.Normalize();
-				FQuat DeltaQuatZ(RotAxisZ, DeltaRotation(2));
-				Quat = DeltaQuatZ * Quat;
-			}
-			Quat.Normalize();
-			poseableMeshComp->SetBoneRotationByName(BoneNames[Index], Quat.Rotator(), EBoneSpaces::WorldSpace);
-		}
+	if (!Record.bSkipped)
+	{
+		PoseBuffer.Commit(*poseableMeshComp, *Chain);
 	}
-}
\ No newline at end of file
+	return Result;
+}
@@ -0,0 +1,264 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKModuleStats.h"
+#include "IKPoseBuffer.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/FileManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+#include "IKCoreArena.h"
+#include "IKCoreConversion.h"
+#include "IKCoreRecording.h"
+#include "IKCoreStats.h"
+#include "IKCoreTrace.h"
+
+DEFINE_STAT(STAT_IKModule_ChainBuild);
+DEFINE_STAT(STAT_IKModule_Solve);
+DEFINE_STAT(STAT_IKModule_JacobianAssembly);
+DEFINE_STAT(STAT_IKModule_LinearSolve);
+DEFINE_STAT(STAT_IKModule_PoseUpdate);
+DEFINE_STAT(STAT_IKModule_WriteBack);
+
+DEFINE_STAT(STAT_IKModule_Solves);
+DEFINE_STAT(STAT_IKModule_SkippedSolves);
+DEFINE_STAT(STAT_IKModule_NotConverged);
+DEFINE_STAT(STAT_IKModule_ScratchHeapAllocations);
+
+DEFINE_STAT(STAT_IKModule_Iterations1);
+DEFINE_STAT(STAT_IKModule_Iterations2);
+DEFINE_STAT(STAT_IKModule_Iterations4);
+DEFINE_STAT(STAT_IKModule_Iterations8);
+DEFINE_STAT(STAT_IKModule_Iterations16);
+DEFINE_STAT(STAT_IKModule_Residual1);
+DEFINE_STAT(STAT_IKModule_Residual2);
+DEFINE_STAT(STAT_IKModule_Residual10);
+DEFINE_STAT(STAT_IKModule_ResidualMore);
+
+namespace
+{
+	IKCore::FTraceWriter TraceWriter;
+	IKCore::FRecordingWriter RecordingWriter;
+	FDelegateHandle EndFrameHandle;
+	int64 LastScratchHeapAllocations = 0;
+
+	void OnEndFrame()
+	{
+		TraceWriter.Flush();
+		RecordingWriter.Flush();
+
+		const int64 ScratchHeapAllocations = IKCore::GetNumScratchHeapAllocations();
+		INC_DWORD_STAT_BY(STAT_IKModule_ScratchHeapAllocations, static_cast<uint32>(ScratchHeapAllocations - LastScratchHeapAllocations));
+		LastScratchHeapAllocations = ScratchHeapAllocations;
+
+		// the core timers cost a clock read per phase, only pay for it while someone listens
+		bool bCollecting = TraceWriter.IsOpen();
+#if STATS
+		bCollecting |= FThreadStats::IsCollectingData();
+#endif
+		IKCore::SetPhaseTimingEnabled(bCollecting);
+	}
+}
+
+static FAutoConsoleCommand IKTraceStartCommand(
+	TEXT("ik.Trace.Start"),
+	TEXT("Trace every IK solve to a file in the profiling directory, binary unless csv is given. Usage: ik.Trace.Start [File] [csv]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const bool bCsv = Args.Contains(TEXT("csv"));
+		FString FileName = Args.Num() > 0 && Args[0] != TEXT("csv") ? Args[0] : TEXT("IKTrace-") + FDateTime::Now().ToString();
+		if (FPaths::GetExtension(FileName).IsEmpty())
+		{
+			FileName += bCsv ? TEXT(".csv") : TEXT(".iktrace");
+		}
+		FIKModuleStats::StartTrace(FPaths::ProfilingDir() / FileName, bCsv);
+	}));
+
+static FAutoConsoleCommand IKTraceStopCommand(
+	TEXT("ik.Trace.Stop"),
+	TEXT("Stop the IK solve trace."),
+	FConsoleCommandDelegate::CreateStatic(&FIKModuleStats::StopTrace));
+
+static FAutoConsoleCommand IKRecordStartCommand(
+	TEXT("ik.Record.Start"),
+	TEXT("Record the chains, root transforms and targets of every IK solve to a file in the profiling directory, for IKCoreReplay. Usage: ik.Record.Start [File]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FString FileName = Args.Num() > 0 ? Args[0] : TEXT("IKRecording-") + FDateTime::Now().ToString();
+		if (FPaths::GetExtension(FileName).IsEmpty())
+		{
+			FileName += TEXT(".ikrec");
+		}
+		FIKModuleStats::StartRecording(FPaths::ProfilingDir() / FileName);
+	}));
+
+static FAutoConsoleCommand IKRecordStopCommand(
+	TEXT("ik.Record.Stop"),
+	TEXT("Stop the IK solve recording."),
+	FConsoleCommandDelegate::CreateStatic(&FIKModuleStats::StopRecording));
+
+void FIKModuleStats::Startup()
+{
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&OnEndFrame);
+}
+
+void FIKModuleStats::Shutdown()
+{
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	StopTrace();
+	StopRecording();
+}
+
+void FIKModuleStats::RecordSolve(const FIKSolveRecord& Record, const IKCore::FSolveResult& Result)
+{
+	const IKCore::FPhaseTimes PhaseTimes = IKCore::TakePhaseTimes();
+
+#if STATS
+	const double CyclesPerSecond = 1.0 / FPlatformTime::GetSecondsPerCycle();
+	const FName PhaseStats[] = { GET_STATFNAME(STAT_IKModule_JacobianAssembly), GET_STATFNAME(STAT_IKModule_LinearSolve), GET_STATFNAME(STAT_IKModule_PoseUpdate) };
+	static_assert(UE_ARRAY_COUNT(PhaseStats) == static_cast<int32>(IKCore::ESolvePhase::Num), "Every core phase needs a stat");
+	for (int32 Phase = 0; Phase < UE_ARRAY_COUNT(PhaseStats); ++Phase)
+	{
+		if (PhaseTimes.Calls[Phase] > 0)
+		{
+			FThreadStats::AddMessage(PhaseStats[Phase], EStatOperation::Add, static_cast<int64>(PhaseTimes.Seconds[Phase] * CyclesPerSecond), true);
+		}
+	}
+#endif
+
+	if (Record.bSkipped)
+	{
+		INC_DWORD_STAT(STAT_IKModule_SkippedSolves);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_IKModule_Solves);
+		if (!Result.bConverged)
+		{
+			INC_DWORD_STAT(STAT_IKModule_NotConverged);
+		}
+
+		if (Result.Iterations >= 16)
+		{
+			INC_DWORD_STAT(STAT_IKModule_Iterations16);
+		}
+		else if (Result.Iterations >= 8)
+		{
+			INC_DWORD_STAT(STAT_IKModule_Iterations8);
+		}
+		else if (Result.Iterations >= 4)
+		{
+			INC_DWORD_STAT(STAT_IKModule_Iterations4);
+		}
+		else if (Result.Iterations >= 2)
+		{
+			INC_DWORD_STAT(STAT_IKModule_Iterations2);
+		}
+		else
+		{
+			INC_DWORD_STAT(STAT_IKModule_Iterations1);
+		}
+
+		if (Result.Residual < Record.Precision)
+		{
+			INC_DWORD_STAT(STAT_IKModule_Residual1);
+		}
+		else if (Result.Residual < 2.f * Record.Precision)
+		{
+			INC_DWORD_STAT(STAT_IKModule_Residual2);
+		}
+		else if (Result.Residual < 10.f * Record.Precision)
+		{
+			INC_DWORD_STAT(STAT_IKModule_Residual10);
+		}
+		else
+		{
+			INC_DWORD_STAT(STAT_IKModule_ResidualMore);
+		}
+	}
+
+	if (TraceWriter.IsOpen())
+	{
+		IKCore::FTraceRecord TraceRecord;
+		TraceRecord.Frame = GFrameCounter;
+		TraceRecord.Residual = Result.Residual;
+		TraceRecord.Microseconds = static_cast<float>(Record.Seconds * 1e6);
+		TraceRecord.Iterations = static_cast<uint16>(FMath::Min(Result.Iterations, static_cast<int32>(MAX_uint16)));
+		TraceRecord.NumBones = static_cast<uint16>(Record.NumBones);
+		TraceRecord.Solver = Record.Solver;
+		TraceRecord.Flags = (Result.bConverged ? IKCore::FTraceRecord::Converged : 0) | (Record.bSkipped ? IKCore::FTraceRecord::Skipped : 0);
+		TraceWriter.Write(TraceRecord, TCHAR_TO_UTF8(*Record.OwnerName.ToString()), TCHAR_TO_UTF8(*Record.ChainName.ToString()));
+	}
+}
+
+bool FIKModuleStats::StartTrace(const FString& FilePath, bool bCsv)
+{
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(FilePath), true);
+	const FString FullPath = FPaths::ConvertRelativePathToFull(FilePath);
+	if (!TraceWriter.Open(TCHAR_TO_UTF8(*FullPath), bCsv ? IKCore::ETraceFormat::Csv : IKCore::ETraceFormat::Binary))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK trace: could not open %s"), *FullPath);
+		return false;
+	}
+	IKCore::SetPhaseTimingEnabled(true);
+	UE_LOG(LogTemp, Log, TEXT("IK trace: writing to %s"), *FullPath);
+	return true;
+}
+
+void FIKModuleStats::StopTrace()
+{
+	if (TraceWriter.IsOpen())
+	{
+		TraceWriter.Close();
+		UE_LOG(LogTemp, Log, TEXT("IK trace: stopped"));
+	}
+}
+
+bool FIKModuleStats::IsTracing()
+{
+	return TraceWriter.IsOpen();
+}
+
+void FIKModuleStats::RecordSolveInput(FName OwnerName, FName ChainName, const FIKPoseBuffer& PoseBuffer, const Eigen::Vector3f& Target, const IKCore::FSolverSettings& Settings)
+{
+	if (!RecordingWriter.IsOpen())
+	{
+		return;
+	}
+
+	IKCore::FRecordedFrame Frame;
+	Frame.Frame = GFrameCounter;
+	Frame.RootParentTranslation = ToEigen(PoseBuffer.RootParentTransform.GetTranslation());
+	Frame.RootParentRotation = ToEigen(PoseBuffer.RootParentTransform.GetRotation());
+	Frame.Target = Target;
+	const FString Name = OwnerName.ToString() / ChainName.ToString();
+	RecordingWriter.Write(Frame, TCHAR_TO_UTF8(*Name), PoseBuffer.Pose, Settings);
+}
+
+bool FIKModuleStats::StartRecording(const FString& FilePath)
+{
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(FilePath), true);
+	const FString FullPath = FPaths::ConvertRelativePathToFull(FilePath);
+	if (!RecordingWriter.Open(TCHAR_TO_UTF8(*FullPath)))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK recording: could not open %s"), *FullPath);
+		return false;
+	}
+	UE_LOG(LogTemp, Log, TEXT("IK recording: writing to %s"), *FullPath);
+	return true;
+}
+
+void FIKModuleStats::StopRecording()
+{
+	if (RecordingWriter.IsOpen())
+	{
+		RecordingWriter.Close();
+		UE_LOG(LogTemp, Log, TEXT("IK recording: stopped"));
+	}
+}
+
+bool FIKModuleStats::IsRecording()
+{
+	return RecordingWriter.IsOpen();
+}
@@ -0,0 +1,74 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "IKCoreTypes.h"
+
+struct FIKPoseBuffer;
+
+DECLARE_STATS_GROUP(TEXT("IKModule"), STATGROUP_IKModule, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Chain Build"), STAT_IKModule_ChainBuild, STATGROUP_IKModule, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Solve"), STAT_IKModule_Solve, STATGROUP_IKModule, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Jacobian Assembly"), STAT_IKModule_JacobianAssembly, STATGROUP_IKModule, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Linear Solve"), STAT_IKModule_LinearSolve, STATGROUP_IKModule, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pose Update"), STAT_IKModule_PoseUpdate, STATGROUP_IKModule, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Write Back"), STAT_IKModule_WriteBack, STATGROUP_IKModule, );
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Solves"), STAT_IKModule_Solves, STATGROUP_IKModule, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Skipped Solves"), STAT_IKModule_SkippedSolves, STATGROUP_IKModule, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Not Converged"), STAT_IKModule_NotConverged, STATGROUP_IKModule, );
+
+// solver scratch that had to grow this frame, zero once every thread has seen the largest chain
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Scratch Heap Allocations"), STAT_IKModule_ScratchHeapAllocations, STATGROUP_IKModule, );
+
+// the stats system has no histogram type, the distributions are counted in buckets instead
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Iterations 0-1"), STAT_IKModule_Iterations1, STATGROUP_IKModule, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Iterations 2-3"), STAT_IKModule_Iterations2, STATGROUP_IKModule, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Iterations 4-7"), STAT_IKModule_Iterations4, STATGROUP_IKModule, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Iterations 8-15"), STAT_IKModule_Iterations8, STATGROUP_IKModule, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Iterations 16+"), STAT_IKModule_Iterations16, STATGROUP_IKModule, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Residual < Precision"), STAT_IKModule_Residual1, STATGROUP_IKModule, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Residual < 2x Precision"), STAT_IKModule_Residual2, STATGROUP_IKModule, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Residual < 10x Precision"), STAT_IKModule_Residual10, STATGROUP_IKModule, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Residual >= 10x Precision"), STAT_IKModule_ResidualMore, STATGROUP_IKModule, );
+
+/** One solve, as reported to the stat group and the trace. */
+struct FIKSolveRecord
+{
+	FName OwnerName;
+	FName ChainName;
+	IKCore::ESolver Solver = IKCore::ESolver::FABRIK;
+	int32 NumBones = 0;
+	float Precision = 0.f;
+	bool bSkipped = false;
+	double Seconds = 0.0;
+};
+
+/**
+ * Per solve instrumentation: the STATGROUP_IKModule counters ("stat IKModule"), a per frame trace of every solve
+ * for headless runs, started with "ik.Trace.Start [File] [csv]", and a recording of the solves' inputs for the
+ * IKCoreReplay harness, started with "ik.Record.Start [File]"; both are written to the profiling directory.
+ */
+struct FIKModuleStats
+{
+	/** Hook the end of frame flush of the trace and the switch of the core phase timers. */
+	static void Startup();
+	static void Shutdown();
+
+	/** Report a solve and the core phase times of the calling thread since its last report. Any thread. */
+	static void RecordSolve(const FIKSolveRecord& Record, const IKCore::FSolveResult& Result);
+
+	static bool StartTrace(const FString& FilePath, bool bCsv);
+	static void StopTrace();
+	static bool IsTracing();
+
+	/** Record the input of a solve of the chain ending at ChainName, with its pose loaded in PoseBuffer and Target in pose space. Game thread. */
+	static void RecordSolveInput(FName OwnerName, FName ChainName, const FIKPoseBuffer& PoseBuffer, const Eigen::Vector3f& Target, const IKCore::FSolverSettings& Settings);
+
+	static bool StartRecording(const FString& FilePath);
+	static void StopRecording();
+	static bool IsRecording();
+};
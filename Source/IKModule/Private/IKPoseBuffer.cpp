@@ -0,0 +1,127 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKPoseBuffer.h"
+#include "IKChain.h"
+#include "IKCoreConversion.h"
+#include "IKModuleStats.h"
+#include "Components/PoseableMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+
+bool FIKPoseBuffer::Load(const UPoseableMeshComponent& MeshComp, const FIKChain& Chain)
+{
+	SCOPE_CYCLE_COUNTER(STAT_IKModule_ChainBuild);
+
+	const USkeletalMesh* SkeletalMesh = MeshComp.SkeletalMesh;
+	const TArray<FTransform>& BoneSpaceTransforms = MeshComp.BoneSpaceTransforms;
+	if (SkeletalMesh == nullptr || BoneSpaceTransforms.Num() != SkeletalMesh->RefSkeleton.GetNum())
+	{
+		return false;
+	}
+
+	RootParentTransform = FTransform::Identity;
+	for (int32 ParentIndex = Chain.ParentIndices[0]; ParentIndex != INDEX_NONE; ParentIndex = SkeletalMesh->RefSkeleton.GetParentIndex(ParentIndex))
+	{
+		RootParentTransform = RootParentTransform * BoneSpaceTransforms[ParentIndex];
+	}
+
+	const int32 NumBones = Chain.NumBones();
+	Pose.Positions.resize(NumBones);
+	Pose.Rotations.resize(NumBones);
+
+	FTransform ComponentSpaceTransform = RootParentTransform;
+	for (int32 Index = 0; Index < NumBones; ++Index)
+	{
+		// a stretch committed on an earlier frame is still in the mesh's translations, every solve starts from the rest lengths
+		FTransform BoneSpaceTransform = BoneSpaceTransforms[Chain.BoneIndices[Index]];
+		if (Index > 0)
+		{
+			BoneSpaceTransform.SetTranslation(BoneSpaceTransform.GetTranslation().GetSafeNormal() * Chain.RestLengths[Index - 1]);
+		}
+		ComponentSpaceTransform = BoneSpaceTransform * ComponentSpaceTransform;
+		Pose.Positions[Index] = ToEigen(ComponentSpaceTransform.GetTranslation());
+		Pose.Rotations[Index] = ToEigen(ComponentSpaceTransform.GetRotation());
+	}
+	Pose.UpdateLengths();
+	Pose.JointLimits.assign(Chain.JointLimits.GetData(), Chain.JointLimits.GetData() + Chain.JointLimits.Num());
+	Pose.RootParentRotation = ToEigen(RootParentTransform.GetRotation());
+	return true;
+}
+
+void FIKPoseBuffer::Commit(UPoseableMeshComponent& MeshComp, const FIKChain& Chain) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_IKModule_WriteBack);
+
+	// local rotations are written back, and every link's translation at its solved length, the rest length unless stretched
+	FQuat ParentRotation = RootParentTransform.GetRotation();
+	for (int32 Index = 0; Index < Pose.Num(); ++Index)
+	{
+		FTransform& BoneSpaceTransform = MeshComp.BoneSpaceTransforms[Chain.BoneIndices[Index]];
+
+		const FQuat Rotation = ToUnreal(Pose.Rotations[Index]);
+		FQuat LocalRotation = ParentRotation.Inverse() * Rotation;
+		LocalRotation.Normalize();
+		BoneSpaceTransform.SetRotation(LocalRotation);
+		ParentRotation = Rotation;
+
+		if (Index > 0 && Chain.RestLengths[Index - 1] > KINDA_SMALL_NUMBER)
+		{
+			BoneSpaceTransform.SetTranslation(BoneSpaceTransform.GetTranslation().GetSafeNormal() * Pose.Lengths[Index - 1]);
+		}
+	}
+	MeshComp.MarkRefreshTransformDirty();
+}
+
+bool FIKTreePoseBuffer::Load(const UPoseableMeshComponent& MeshComp, const FIKTree& Tree)
+{
+	SCOPE_CYCLE_COUNTER(STAT_IKModule_ChainBuild);
+
+	const USkeletalMesh* SkeletalMesh = MeshComp.SkeletalMesh;
+	const TArray<FTransform>& BoneSpaceTransforms = MeshComp.BoneSpaceTransforms;
+	if (SkeletalMesh == nullptr || BoneSpaceTransforms.Num() != SkeletalMesh->RefSkeleton.GetNum())
+	{
+		return false;
+	}
+
+	RootParentTransform = FTransform::Identity;
+	for (int32 ParentIndex = SkeletalMesh->RefSkeleton.GetParentIndex(Tree.BoneIndices[0]); ParentIndex != INDEX_NONE; ParentIndex = SkeletalMesh->RefSkeleton.GetParentIndex(ParentIndex))
+	{
+		RootParentTransform = RootParentTransform * BoneSpaceTransforms[ParentIndex];
+	}
+
+	const int32 NumBones = Tree.NumBones();
+	Pose.Positions.resize(NumBones);
+	Pose.Rotations.resize(NumBones);
+	Pose.Parents.resize(NumBones);
+
+	// parents come first, so each bone's parent is in component space by the time the bone is reached
+	TArray<FTransform, TInlineAllocator<64>> ComponentSpaceTransforms;
+	ComponentSpaceTransforms.SetNum(NumBones);
+	for (int32 Index = 0; Index < NumBones; ++Index)
+	{
+		const int32 Parent = Tree.ParentIndices[Index];
+		const FTransform& ParentTransform = Parent == INDEX_NONE ? RootParentTransform : ComponentSpaceTransforms[Parent];
+		ComponentSpaceTransforms[Index] = BoneSpaceTransforms[Tree.BoneIndices[Index]] * ParentTransform;
+		Pose.Positions[Index] = ToEigen(ComponentSpaceTransforms[Index].GetTranslation());
+		Pose.Rotations[Index] = ToEigen(ComponentSpaceTransforms[Index].GetRotation());
+		Pose.Parents[Index] = Parent;
+	}
+	Pose.UpdateLengths();
+	return true;
+}
+
+void FIKTreePoseBuffer::Commit(UPoseableMeshComponent& MeshComp, const FIKTree& Tree) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_IKModule_WriteBack);
+
+	// the multi-effector solvers keep every link length, only local rotations are written back
+	for (int32 Index = 0; Index < Pose.Num(); ++Index)
+	{
+		const int32 Parent = Tree.ParentIndices[Index];
+		const FQuat ParentRotation = Parent == INDEX_NONE ? RootParentTransform.GetRotation() : ToUnreal(Pose.Rotations[Parent]);
+
+		FQuat LocalRotation = ParentRotation.Inverse() * ToUnreal(Pose.Rotations[Index]);
+		LocalRotation.Normalize();
+		MeshComp.BoneSpaceTransforms[Tree.BoneIndices[Index]].SetRotation(LocalRotation);
+	}
+	MeshComp.MarkRefreshTransformDirty();
+}
@@ -0,0 +1,168 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKPoseDatabase.h"
+#include "IKChain.h"
+#include "IKCoreConversion.h"
+#include "Async/MappedFileHandle.h"
+#include "Engine/SkeletalMesh.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<bool> CVarIKPoseDatabaseEnable(
+	TEXT("ik.PoseDatabase.Enable"),
+	true,
+	TEXT("Start IK solves from the nearest solutions of the chain's baked pose database when one is closer to the target."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarIKPoseDatabaseNeighbours(
+	TEXT("ik.PoseDatabase.Neighbours"),
+	1,
+	TEXT("Number of nearest baked solutions blended into the start pose, 1 to 4."),
+	ECVF_Default);
+
+static FAutoConsoleCommand IKPoseDatabaseBakeCommand(
+	TEXT("ik.PoseDatabase.Bake"),
+	TEXT("Bake the pose database of a chain from the mesh's reference pose. Usage: ik.PoseDatabase.Bake Mesh TipBone RootBone [Samples]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (Args.Num() < 3)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Usage: ik.PoseDatabase.Bake Mesh TipBone RootBone [Samples]"));
+			return;
+		}
+
+		const USkeletalMesh* Mesh = LoadObject<USkeletalMesh>(nullptr, *Args[0]);
+		FIKChain Chain;
+		if (Mesh == nullptr || !FIKChain::Build(Mesh->RefSkeleton, FName(*Args[1]), FName(*Args[2]), Chain))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("IK pose database: no chain %s -> %s on mesh %s"), *Args[2], *Args[1], *Args[0]);
+			return;
+		}
+
+		IKCore::FPoseDatabaseBakeSettings BakeSettings;
+		if (Args.Num() > 3)
+		{
+			BakeSettings.NumSamples = FCString::Atoi(*Args[3]);
+		}
+		FIKPoseDatabaseRegistry::Get().Bake(*Mesh, Chain, IKCore::ESolver::DampedLeastSquares, BakeSettings);
+	}));
+
+FIKPoseDatabaseRegistry::FEntry::~FEntry()
+{
+	// the database views the mapped region, which must go before the file
+	Database.Reset();
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+FIKPoseDatabaseRegistry& FIKPoseDatabaseRegistry::Get()
+{
+	static FIKPoseDatabaseRegistry Registry;
+	return Registry;
+}
+
+const IKCore::FPoseDatabase* FIKPoseDatabaseRegistry::Find(const USkeletalMesh& Mesh, const FIKChain& Chain)
+{
+	if (!CVarIKPoseDatabaseEnable.GetValueOnGameThread())
+	{
+		return nullptr;
+	}
+
+	const FKey Key(FObjectKey(&Mesh), Chain.TipBoneName, Chain.RootBoneName);
+	if (const TUniquePtr<FEntry>* Found = Entries.Find(Key))
+	{
+		return Found->IsValid() ? &(*Found)->Database : nullptr;
+	}
+
+	TUniquePtr<FEntry>& Entry = Entries.Add(Key);
+	const FString FilePath = GetFilePath(Mesh, Chain);
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*FilePath))
+	{
+		return nullptr;
+	}
+
+	TUniquePtr<FEntry> Loaded = MakeUnique<FEntry>();
+	Loaded->MappedFile.Reset(PlatformFile.OpenMapped(*FilePath));
+	if (Loaded->MappedFile.IsValid())
+	{
+		Loaded->MappedRegion.Reset(Loaded->MappedFile->MapRegion(0, Loaded->MappedFile->GetFileSize()));
+	}
+	if (!Loaded->MappedRegion.IsValid() || !Loaded->Database.SetImage(Loaded->MappedRegion->GetMappedPtr(), Loaded->MappedRegion->GetMappedSize()))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK pose database %s: could not map it or not a pose database of this version"), *FilePath);
+		return nullptr;
+	}
+
+	// a database baked for another version of the skeleton would seed poses with the wrong bones
+	if (Loaded->Database.GetNumBones() != Chain.NumBones())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK pose database %s: %d bones, the chain has %d, bake it again"), *FilePath, Loaded->Database.GetNumBones(), Chain.NumBones());
+		return nullptr;
+	}
+
+	Entry = MoveTemp(Loaded);
+	return &Entry->Database;
+}
+
+bool FIKPoseDatabaseRegistry::Bake(const USkeletalMesh& Mesh, const FIKChain& Chain, IKCore::ESolver Solver, const IKCore::FPoseDatabaseBakeSettings& BakeSettings)
+{
+	// the reference pose in the frame of the root bone's parent
+	const TArray<FTransform>& RefBonePose = Mesh.RefSkeleton.GetRefBonePose();
+	IKCore::FPose RestPose;
+	RestPose.Positions.resize(Chain.NumBones());
+	RestPose.Rotations.resize(Chain.NumBones());
+	FTransform Transform = FTransform::Identity;
+	for (int32 Index = 0; Index < Chain.NumBones(); ++Index)
+	{
+		Transform = RefBonePose[Chain.BoneIndices[Index]] * Transform;
+		RestPose.Positions[Index] = ToEigen(Transform.GetTranslation());
+		RestPose.Rotations[Index] = ToEigen(Transform.GetRotation());
+	}
+	RestPose.UpdateLengths();
+
+	IKCore::FSolverSettings Settings;
+	Settings.Precision = 0.001f * Chain.TotalReach;
+	Settings.MaxIterations = 64;
+
+	// an entry the solve jobs may already point at is baked in place, and left empty rather than freed on failure
+	TUniquePtr<FEntry>& Entry = Entries.FindOrAdd(FKey(FObjectKey(&Mesh), Chain.TipBoneName, Chain.RootBoneName));
+	if (!Entry.IsValid())
+	{
+		Entry = MakeUnique<FEntry>();
+	}
+	Entry->Database.Reset();
+	Entry->MappedRegion.Reset();
+	Entry->MappedFile.Reset();
+
+	const double StartTime = FPlatformTime::Seconds();
+	if (!Entry->Database.Bake(RestPose, Solver, Settings, BakeSettings))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK pose database %s -> %s: no sample converged"), *Chain.RootBoneName.ToString(), *Chain.TipBoneName.ToString());
+		return false;
+	}
+
+	const FString FilePath = GetFilePath(Mesh, Chain);
+	const TArrayView<const uint8> Image(static_cast<const uint8*>(Entry->Database.GetImage()), static_cast<int32>(Entry->Database.GetImageSize()));
+	if (!FFileHelper::SaveArrayToFile(Image, *FilePath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK pose database: could not write %s"), *FilePath);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("IK pose database: %d of %d samples in %.1f s, %d KB written to %s"), Entry->Database.GetNumSamples(), BakeSettings.NumSamples,
+		FPlatformTime::Seconds() - StartTime, static_cast<int32>(Entry->Database.GetImageSize() / 1024), *FilePath);
+	return true;
+}
+
+FString FIKPoseDatabaseRegistry::GetFilePath(const USkeletalMesh& Mesh, const FIKChain& Chain)
+{
+	return FPaths::ProjectContentDir() / TEXT("IK/PoseDatabases") / FString::Printf(TEXT("%s_%s_%s.ikpose"), *Mesh.GetName(), *Chain.RootBoneName.ToString(), *Chain.TipBoneName.ToString());
+}
+
+int32 FIKPoseDatabaseRegistry::GetNumNeighbours()
+{
+	return FMath::Clamp(CVarIKPoseDatabaseNeighbours.GetValueOnAnyThread(), 1, IKCore::FPoseDatabase::MaxNeighbours);
+}
@@ -0,0 +1,217 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKSkeletonCache.h"
+#include "IKChain.h"
+#include "IKCoreConversion.h"
+#include "IKModuleStats.h"
+#include "Async/MappedFileHandle.h"
+#include "Engine/SkeletalMesh.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/PhysicsConstraintTemplate.h"
+
+namespace
+{
+	/** Bones, reference pose and the joint limits of the physics asset of Mesh, as they are cooked. */
+	void AddSkeleton(const USkeletalMesh& Mesh, IKCore::FSkeletonCacheBuilder& Builder)
+	{
+		const FReferenceSkeleton& RefSkeleton = Mesh.RefSkeleton;
+		const TArray<FTransform>& RefBonePose = RefSkeleton.GetRefBonePose();
+		for (int32 Index = 0; Index < RefSkeleton.GetNum(); ++Index)
+		{
+			Builder.AddBone(TCHAR_TO_UTF8(*RefSkeleton.GetBoneName(Index).ToString()), RefSkeleton.GetParentIndex(Index),
+				ToEigen(RefBonePose[Index].GetTranslation()), ToEigen(RefBonePose[Index].GetRotation()));
+		}
+
+		// The physics asset's constraints limit the child bone, converted to the cache's limit model, which is coarser:
+		// - the swing is one round cone around the bone's link as it rests in the reference pose; Swing1 and Swing2 are not
+		//   kept as an ellipse, the cone takes the larger of the two, so the tighter direction can swing further than the
+		//   physics allows;
+		// - the twist is about the link, and both swing and twist are measured from the reference pose; the constraint's
+		//   own frames are ignored, so a constraint whose twist axis is not along the bone, or whose frames are offset
+		//   from the reference pose, limits different rotations here than in the physics simulation.
+		// The IK solve therefore stays within the physics limits only where the constraints are set up along the bones.
+		if (const UPhysicsAsset* PhysicsAsset = Mesh.GetPhysicsAsset())
+		{
+			auto GetLimit = [](EAngularConstraintMotion Motion, float LimitDegrees)
+			{
+				return Motion == ACM_Free ? PI : Motion == ACM_Locked ? 0.f : FMath::DegreesToRadians(LimitDegrees);
+			};
+			for (const UPhysicsConstraintTemplate* Template : PhysicsAsset->ConstraintSetup)
+			{
+				const FConstraintInstance& Constraint = Template->DefaultInstance;
+				const int32 BoneIndex = RefSkeleton.FindBoneIndex(Constraint.ConstraintBone1);
+				if (BoneIndex != INDEX_NONE)
+				{
+					const float SwingLimit = FMath::Max(GetLimit(Constraint.GetAngularSwing1Motion(), Constraint.GetAngularSwing1Limit()),
+						GetLimit(Constraint.GetAngularSwing2Motion(), Constraint.GetAngularSwing2Limit()));
+					const float TwistLimit = GetLimit(Constraint.GetAngularTwistMotion(), Constraint.GetAngularTwistLimit());
+					Builder.SetJointLimits(BoneIndex, SwingLimit, -TwistLimit, TwistLimit);
+				}
+			}
+		}
+	}
+
+	/**
+	 * Chain of a mesh whose cache does not have it. With a physics asset it is built through a cache image made in
+	 * memory, so that it gets the same joint limits as a cooked chain; without one its joints are free.
+	 */
+	bool BuildUncookedChain(const USkeletalMesh& Mesh, FName TipBoneName, FName RootBoneName, FIKChain& OutChain)
+	{
+		const FReferenceSkeleton& RefSkeleton = Mesh.RefSkeleton;
+		if (Mesh.GetPhysicsAsset() == nullptr)
+		{
+			UE_LOG(LogTemp, Log, TEXT("IK chain %s -> %s of %s: no physics asset, its joints are free"), *RootBoneName.ToString(), *TipBoneName.ToString(), *Mesh.GetName());
+			return FIKChain::Build(RefSkeleton, TipBoneName, RootBoneName, OutChain);
+		}
+
+		IKCore::FSkeletonCacheBuilder Builder;
+		AddSkeleton(Mesh, Builder);
+		const int32 TipIndex = RefSkeleton.FindBoneIndex(TipBoneName);
+		const int32 RootIndex = RefSkeleton.FindBoneIndex(RootBoneName);
+		if (TipIndex == INDEX_NONE || RootIndex == INDEX_NONE || !Builder.AddChain(TipIndex, RootIndex))
+		{
+			// the build from the reference skeleton says what is wrong with the chain
+			return FIKChain::Build(RefSkeleton, TipBoneName, RootBoneName, OutChain);
+		}
+
+		std::vector<uint64_t> Image;
+		size_t ImageSize = 0;
+		Builder.Write(Image, ImageSize);
+		IKCore::FSkeletonCache Cache;
+		return Cache.SetImage(Image.data(), ImageSize) && FIKChain::Build(Cache, Cache.GetChain(0), OutChain);
+	}
+}
+
+FIKSkeletonCacheRegistry::FMeshEntry::~FMeshEntry()
+{
+	// the cache views the mapped region, which must go before the file
+	Cache.Reset();
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+FIKSkeletonCacheRegistry& FIKSkeletonCacheRegistry::Get()
+{
+	static FIKSkeletonCacheRegistry Registry;
+	return Registry;
+}
+
+const FIKChain* FIKSkeletonCacheRegistry::FindOrBuildChain(const USkeletalMesh& Mesh, FName TipBoneName, FName RootBoneName)
+{
+	FScopeLock Lock(&Mutex);
+	FMeshEntry& Entry = FindOrLoad(Mesh);
+	const TPair<FName, FName> Key(TipBoneName, RootBoneName);
+	if (const TUniquePtr<FIKChain>* Chain = Entry.Chains.Find(Key))
+	{
+		return Chain->Get();
+	}
+
+	// a chain that was not cooked is built once for the mesh rather than once for every character showing it
+	SCOPE_CYCLE_COUNTER(STAT_IKModule_ChainBuild);
+	TUniquePtr<FIKChain> Chain = MakeUnique<FIKChain>();
+	if (!BuildUncookedChain(Mesh, TipBoneName, RootBoneName, *Chain))
+	{
+		Chain.Reset();
+	}
+	return Entry.Chains.Add(Key, MoveTemp(Chain)).Get();
+}
+
+const IKCore::FSkeletonCache* FIKSkeletonCacheRegistry::FindCache(const USkeletalMesh& Mesh)
+{
+	FScopeLock Lock(&Mutex);
+	const FMeshEntry& Entry = FindOrLoad(Mesh);
+	return Entry.Cache.IsValid() ? &Entry.Cache : nullptr;
+}
+
+FIKSkeletonCacheRegistry::FMeshEntry& FIKSkeletonCacheRegistry::FindOrLoad(const USkeletalMesh& Mesh)
+{
+	TUniquePtr<FMeshEntry>& Entry = Meshes.FindOrAdd(FObjectKey(&Mesh));
+	if (Entry.IsValid())
+	{
+		return *Entry;
+	}
+	Entry = MakeUnique<FMeshEntry>();
+
+	const FString FilePath = GetFilePath(Mesh);
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*FilePath))
+	{
+		return *Entry;
+	}
+
+	Entry->MappedFile.Reset(PlatformFile.OpenMapped(*FilePath));
+	if (Entry->MappedFile.IsValid())
+	{
+		Entry->MappedRegion.Reset(Entry->MappedFile->MapRegion(0, Entry->MappedFile->GetFileSize()));
+	}
+	if (!Entry->MappedRegion.IsValid() || !Entry->Cache.SetImage(Entry->MappedRegion->GetMappedPtr(), Entry->MappedRegion->GetMappedSize()))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK skeleton cache %s: could not map it or not a skeleton cache of this version"), *FilePath);
+		Entry = MakeUnique<FMeshEntry>();
+		return *Entry;
+	}
+
+	// a cache cooked before the skeleton was edited would hand out the wrong bones
+	const FReferenceSkeleton& RefSkeleton = Mesh.RefSkeleton;
+	bool bMatches = Entry->Cache.GetNumBones() == RefSkeleton.GetNum();
+	for (int32 Index = 0; bMatches && Index < RefSkeleton.GetNum(); ++Index)
+	{
+		bMatches = Entry->Cache.GetBone(Index).Parent == RefSkeleton.GetParentIndex(Index)
+			&& FName(UTF8_TO_TCHAR(Entry->Cache.GetBoneName(Index))) == RefSkeleton.GetBoneName(Index);
+	}
+	if (!bMatches)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK skeleton cache %s does not match the skeleton of %s, cook it again"), *FilePath, *Mesh.GetName());
+		Entry = MakeUnique<FMeshEntry>();
+		return *Entry;
+	}
+
+	for (int32 Index = 0; Index < Entry->Cache.GetNumChains(); ++Index)
+	{
+		TUniquePtr<FIKChain> Chain = MakeUnique<FIKChain>();
+		if (FIKChain::Build(Entry->Cache, Entry->Cache.GetChain(Index), *Chain))
+		{
+			const TPair<FName, FName> Key(Chain->TipBoneName, Chain->RootBoneName);
+			Entry->Chains.Add(Key, MoveTemp(Chain));
+		}
+	}
+	return *Entry;
+}
+
+bool FIKSkeletonCacheRegistry::Cook(const USkeletalMesh& Mesh, const TArray<TPair<FName, FName>>& Chains, const FString& FilePath)
+{
+	const FReferenceSkeleton& RefSkeleton = Mesh.RefSkeleton;
+	IKCore::FSkeletonCacheBuilder Builder;
+	AddSkeleton(Mesh, Builder);
+
+	for (const TPair<FName, FName>& Chain : Chains)
+	{
+		const int32 TipIndex = RefSkeleton.FindBoneIndex(Chain.Key);
+		const int32 RootIndex = RefSkeleton.FindBoneIndex(Chain.Value);
+		if (TipIndex == INDEX_NONE || RootIndex == INDEX_NONE || !Builder.AddChain(TipIndex, RootIndex))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("IK skeleton cache of %s: no chain %s -> %s"), *Mesh.GetName(), *Chain.Value.ToString(), *Chain.Key.ToString());
+		}
+	}
+
+	std::vector<uint64_t> Image;
+	size_t ImageSize = 0;
+	Builder.Write(Image, ImageSize);
+	if (!FFileHelper::SaveArrayToFile(TArrayView<const uint8>(reinterpret_cast<const uint8*>(Image.data()), static_cast<int32>(ImageSize)), *FilePath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK skeleton cache: could not write %s"), *FilePath);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("IK skeleton cache: %d bones and %d chains of %s written to %s"), Builder.GetNumBones(), Builder.GetNumChains(), *Mesh.GetName(), *FilePath);
+	return true;
+}
+
+FString FIKSkeletonCacheRegistry::GetFilePath(const USkeletalMesh& Mesh)
+{
+	return FPaths::ProjectContentDir() / TEXT("IK/Skeletons") / Mesh.GetName() + TEXT(".ikskel");
+}
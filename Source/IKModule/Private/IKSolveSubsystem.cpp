@@ -0,0 +1,312 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKSolveSubsystem.h"
+#include "Async/ParallelFor.h"
+#include "Components/PoseableMeshComponent.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+
+#include "IKCoreConversion.h"
+#include "IKGroundProbe.h"
+#include "IKModuleStats.h"
+#include "IKCoreSolvers.h"
+
+static TAutoConsoleVariable<int32> CVarIKSolveNumWorkers(
+	TEXT("ik.Solve.NumWorkers"),
+	0,
+	TEXT("Number of workers solving the queued IK jobs, 0 uses the game thread and every task graph worker."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarIKSolveJobsPerChunk(
+	TEXT("ik.Solve.JobsPerChunk"),
+	4,
+	TEXT("Number of IK jobs a worker takes (or steals) at once."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarIKBudgetEnable(
+	TEXT("ik.Budget.Enable"),
+	true,
+	TEXT("Fit the characters' IK in ik.Budget.Milliseconds per frame by lowering the quality of the least significant ones."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarIKBudgetMilliseconds(
+	TEXT("ik.Budget.Milliseconds"),
+	1.5f,
+	TEXT("IK time per frame the budget assigns the quality tiers for."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarIKBudgetReducedIterations(
+	TEXT("ik.Budget.ReducedIterations"),
+	3,
+	TEXT("Iteration cap of the reduced quality tier."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarIKBudgetIntervalFrames(
+	TEXT("ik.Budget.IntervalFrames"),
+	4,
+	TEXT("Frames between two solves of the interval tier, interpolated in between."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarIKSolveShowStats(
+	TEXT("ik.Solve.ShowStats"),
+	false,
+	TEXT("Show the wall time and the per worker utilization of the IK solve queue on screen."),
+	ECVF_Default);
+
+FIKSolveTicket UIKSolveSubsystem::SubmitSolve(UPoseableMeshComponent& MeshComp, const FIKChain& Chain, IKCore::ESolver Solver, const FVector& TargetLocation, const IKCore::FSolverSettings& Settings,
+	IKCore::FChainSolveState* SolveState, const IKCore::FWarmStartSettings& WarmStartSettings, IKCore::ELODTier Tier)
+{
+	check(IsInGameThread());
+
+	if (NumJobs == Jobs.Num())
+	{
+		Jobs.Add(MakeUnique<FJob>());
+	}
+
+	FJob& Job = *Jobs[NumJobs];
+	if (!Job.PoseBuffer.Load(MeshComp, Chain))
+	{
+		return FIKSolveTicket();
+	}
+	Job.MeshComp = &MeshComp;
+	Job.OwnerName = MeshComp.GetOwner() != nullptr ? MeshComp.GetOwner()->GetFName() : MeshComp.GetFName();
+	Job.Chain = Chain;
+	Job.Target = ToEigen(MeshComp.GetComponentTransform().InverseTransformPosition(TargetLocation));
+	Job.Solver = Solver;
+	Job.Settings = Settings;
+	Job.SolveState = SolveState;
+	Job.WarmStartSettings = WarmStartSettings;
+	Job.Tier = Tier;
+	Job.Result = IKCore::FSolveResult();
+	FIKModuleStats::RecordSolveInput(Job.OwnerName, Chain.TipBoneName, Job.PoseBuffer, Job.Target, Settings);
+
+	FIKSolveTicket Ticket;
+	Ticket.Frame = GFrameCounter;
+	Ticket.Index = NumJobs++;
+	return Ticket;
+}
+
+bool UIKSolveSubsystem::GetSolveResult(const FIKSolveTicket& Ticket, IKCore::FSolveResult& OutResult) const
+{
+	if (Ticket.Frame != CompletedFrame || !CompletedResults.IsValidIndex(Ticket.Index))
+	{
+		return false;
+	}
+	OutResult = CompletedResults[Ticket.Index];
+	return true;
+}
+
+FIKGroundProbeTicket UIKSolveSubsystem::SubmitGroundProbes(const IKCore::FGroundProbe* Probes, int32 NumProbes)
+{
+	check(IsInGameThread());
+
+	if (!GroundQueryBackend.IsValid())
+	{
+		SetGroundQueryBackend(nullptr);
+	}
+
+	FIKGroundProbeTicket Ticket;
+	Ticket.Frame = GFrameCounter;
+	Ticket.Index = GroundProbes.Add(Probes, NumProbes);
+	Ticket.Num = NumProbes;
+	return Ticket;
+}
+
+const IKCore::FGroundHit* UIKSolveSubsystem::GetGroundHits(const FIKGroundProbeTicket& Ticket)
+{
+	check(IsInGameThread());
+	return Ticket.Frame == GroundProbeFrame ? GroundProbes.GetHits(Ticket.Index, Ticket.Num) : nullptr;
+}
+
+void UIKSolveSubsystem::SetGroundQueryBackend(TSharedPtr<IKCore::IGroundQueryBackend> Backend)
+{
+	check(IsInGameThread());
+	GroundQueryBackend = Backend.IsValid() ? Backend : MakeShared<FIKAsyncTraceGroundQuery>(*GetWorld());
+	GroundProbes.SetBackend(GroundQueryBackend.Get());
+}
+
+IKCore::ELODTier UIKSolveSubsystem::RequestTier(const UObject& Owner, float Significance, int32 NumChains)
+{
+	check(IsInGameThread());
+
+	if (!CVarIKBudgetEnable.GetValueOnGameThread())
+	{
+		return IKCore::ELODTier::Full;
+	}
+
+	const TObjectKey<UObject> OwnerKey(&Owner);
+	if (!BudgetRequests.Contains(OwnerKey))
+	{
+		BudgetRequests.Add(OwnerKey, Budget.AddRequest(Significance, NumChains));
+	}
+	const IKCore::ELODTier* Tier = AssignedTiers.Find(OwnerKey);
+	return Tier != nullptr ? *Tier : IKCore::ELODTier::Full;
+}
+
+void UIKSolveSubsystem::ReportSolveTime(IKCore::ELODTier Tier, double Seconds)
+{
+	check(IsInGameThread());
+	Budget.ReportSolve(Tier, Seconds);
+}
+
+void UIKSolveSubsystem::Tick(float DeltaTime)
+{
+	if (NumJobs > 0)
+	{
+		SolveJobs();
+	}
+	else
+	{
+		// only budget requests this frame, every character solved in its own Tick
+		LastFrameStats.NumJobs = 0;
+		LastFrameStats.SolveSeconds = 0.0;
+	}
+
+	const double CommitStartTime = FPlatformTime::Seconds();
+	CommitJobs();
+	LastFrameStats.CommitSeconds = FPlatformTime::Seconds() - CommitStartTime;
+
+	UpdateBudget();
+
+	// the frame's probes go out together after every character queued its own, their hits are read on the next frame
+	GroundProbes.Submit();
+	GroundProbeFrame = GFrameCounter;
+
+	if (CVarIKSolveShowStats.GetValueOnGameThread() && GEngine != nullptr)
+	{
+		FString Utilization;
+		for (int32 WorkerIndex = 0; WorkerIndex < LastFrameStats.NumWorkers; ++WorkerIndex)
+		{
+			Utilization += FString::Printf(TEXT(" %.0f%%"), LastFrameStats.WorkerUtilization[WorkerIndex] * 100.f);
+		}
+		GEngine->AddOnScreenDebugMessage(reinterpret_cast<uint64>(this), 0.f, FColor::Yellow, FString::Printf(TEXT("IK solve: %d jobs (%d skipped) on %d workers, solve %.3f ms, commit %.3f ms, utilization%s"),
+			LastFrameStats.NumJobs, LastFrameStats.NumSkipped, LastFrameStats.NumWorkers, LastFrameStats.SolveSeconds * 1000.0, LastFrameStats.CommitSeconds * 1000.0, *Utilization));
+		GEngine->AddOnScreenDebugMessage(reinterpret_cast<uint64>(this) + 1, 0.f, FColor::Yellow, FString::Printf(TEXT("IK budget: %d full, %d reduced, %d interval, %d analytic, planned %.3f ms"),
+			LastFrameStats.NumInTier[0], LastFrameStats.NumInTier[1], LastFrameStats.NumInTier[2], LastFrameStats.NumInTier[3], LastFrameStats.PlannedSeconds * 1000.0));
+	}
+}
+
+void UIKSolveSubsystem::SolveJobs()
+{
+	const int32 NumWorkersSetting = CVarIKSolveNumWorkers.GetValueOnGameThread();
+	const int32 MaxWorkers = NumWorkersSetting > 0 ? NumWorkersSetting : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	const int32 NumWorkers = FMath::Clamp(MaxWorkers, 1, NumJobs);
+
+	// the jobs only touch their own pose buffer; without a workspace the solvers take their scratch from the thread's
+	// arena and its Jacobian workspace for the chain's length, which stop allocating once the thread has solved every length
+	const IKCore::FWorkStealingQueue::FJobFunction SolveJob = [this](int32_t JobIndex, int32_t)
+	{
+		FJob& Job = *Jobs[JobIndex];
+		SCOPE_CYCLE_COUNTER(STAT_IKModule_Solve);
+		const double StartTime = FPlatformTime::Seconds();
+		if (Job.SolveState != nullptr)
+		{
+			const Eigen::Quaternionf RootParentRotation = ToEigen(Job.PoseBuffer.RootParentTransform.GetRotation());
+			Job.Result = Job.SolveState->Solve(Job.Solver, Job.PoseBuffer.Pose, Job.Target, RootParentRotation, Job.Settings, Job.WarmStartSettings);
+		}
+		else
+		{
+			Job.Result = IKCore::Solve(Job.Solver, Job.PoseBuffer.Pose, Job.Target, Job.Settings);
+		}
+
+		FIKSolveRecord Record;
+		Record.OwnerName = Job.OwnerName;
+		Record.ChainName = Job.Chain.TipBoneName;
+		Record.Solver = Job.Solver;
+		Record.NumBones = Job.PoseBuffer.Pose.Num();
+		Record.Precision = Job.Settings.Precision;
+		Record.bSkipped = Job.SolveState != nullptr && Job.SolveState->WasSkipped();
+		Record.Seconds = FPlatformTime::Seconds() - StartTime;
+		FIKModuleStats::RecordSolve(Record, Job.Result);
+		Job.Seconds = Record.Seconds;
+	};
+
+	const double StartTime = FPlatformTime::Seconds();
+	Queue.Reset(NumWorkers, NumJobs, CVarIKSolveJobsPerChunk.GetValueOnGameThread());
+	ParallelFor(NumWorkers, [this, &SolveJob](int32 WorkerIndex)
+	{
+		Queue.RunWorker(WorkerIndex, SolveJob);
+	}, NumWorkers == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::Unbalanced);
+	Queue.GetStats(FPlatformTime::Seconds() - StartTime, SchedulerStats);
+
+	LastFrameStats.NumJobs = NumJobs;
+	LastFrameStats.NumWorkers = NumWorkers;
+	LastFrameStats.SolveSeconds = SchedulerStats.WallSeconds;
+	LastFrameStats.WorkerUtilization.SetNum(NumWorkers);
+	LastFrameStats.WorkerSteals.SetNum(NumWorkers);
+	for (int32 WorkerIndex = 0; WorkerIndex < NumWorkers; ++WorkerIndex)
+	{
+		LastFrameStats.WorkerUtilization[WorkerIndex] = SchedulerStats.GetUtilization(WorkerIndex);
+		LastFrameStats.WorkerSteals[WorkerIndex] = SchedulerStats.Workers[WorkerIndex].NumSteals;
+	}
+}
+
+void UIKSolveSubsystem::CommitJobs()
+{
+	CompletedResults.SetNum(NumJobs);
+	LastFrameStats.NumSkipped = 0;
+	for (int32 JobIndex = 0; JobIndex < NumJobs; ++JobIndex)
+	{
+		const FJob& Job = *Jobs[JobIndex];
+		const bool bSkipped = Job.SolveState != nullptr && Job.SolveState->WasSkipped();
+		if (bSkipped)
+		{
+			++LastFrameStats.NumSkipped;
+		}
+
+		// interpolated interval frames change the pose without iterating, only a skipped solve left it as it is
+		UPoseableMeshComponent* MeshComp = Job.MeshComp.Get();
+		if (MeshComp != nullptr && !bSkipped)
+		{
+			Job.PoseBuffer.Commit(*MeshComp, Job.Chain);
+		}
+		CompletedResults[JobIndex] = Job.Result;
+		Budget.ReportSolve(Job.Tier, Job.Seconds);
+	}
+	CompletedFrame = GFrameCounter;
+	NumJobs = 0;
+}
+
+void UIKSolveSubsystem::UpdateBudget()
+{
+	// the tiers ranked from this frame's requests apply to the next frame's solves
+	Budget.AssignTiers();
+	AssignedTiers.Reset();
+	for (const TPair<TObjectKey<UObject>, int32>& Request : BudgetRequests)
+	{
+		AssignedTiers.Add(Request.Key, Budget.GetTier(Request.Value));
+	}
+	BudgetRequests.Reset();
+
+	for (int32 Tier = 0; Tier < static_cast<int32>(IKCore::ELODTier::Num); ++Tier)
+	{
+		LastFrameStats.NumInTier[Tier] = Budget.GetNumInTier(static_cast<IKCore::ELODTier>(Tier));
+	}
+	LastFrameStats.PlannedSeconds = Budget.GetPlannedSeconds();
+
+	IKCore::FBudgetSettings BudgetSettings;
+	BudgetSettings.BudgetSeconds = CVarIKBudgetMilliseconds.GetValueOnGameThread() / 1000.0;
+	BudgetSettings.ReducedMaxIterations = CVarIKBudgetReducedIterations.GetValueOnGameThread();
+	BudgetSettings.IntervalFrames = CVarIKBudgetIntervalFrames.GetValueOnGameThread();
+	Budget.BeginFrame(BudgetSettings);
+}
+
+ETickableTickType UIKSolveSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UIKSolveSubsystem::IsTickable() const
+{
+	return NumJobs > 0 || Budget.GetNumRequests() > 0 || GroundProbes.GetNumQueued() > 0;
+}
+
+UWorld* UIKSolveSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UIKSolveSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UIKSolveSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,138 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoneContainer.h"
+#include "BoneControllers/AnimNode_SkeletalControlBase.h"
+#include "IKCoreJacobian.h"
+#include "IKCoreSolveState.h"
+#include "IKSolverType.h"
+
+#include "AnimNode_IKModuleSolver.generated.h"
+
+/**
+ * Runs the IKCore solvers on the compact pose of an animation graph, so the solve happens on the
+ * animation worker threads together with the rest of the graph instead of in the actor's Tick.
+ */
+USTRUCT(BlueprintInternalUseOnly)
+struct IKMODULE_API FAnimNode_IKModuleSolver : public FAnimNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+	/** Effector location, in EffectorLocationSpace. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Effector, meta = (PinShownByDefault))
+	FVector EffectorLocation;
+
+	UPROPERTY(EditAnywhere, Category = Effector)
+	TEnumAsByte<enum EBoneControlSpace> EffectorLocationSpace;
+
+	/** Bone the effector location is relative to for the parent bone and bone spaces. */
+	UPROPERTY(EditAnywhere, Category = Effector)
+	FBoneReference EffectorTarget;
+
+	/**
+	 * Also turn the tip bone to EffectorRotation. The Jacobian solvers solve position and orientation together, the others
+	 * set the tip's rotation after the position solve. Warm starting and skipping only apply without it.
+	 */
+	UPROPERTY(EditAnywhere, Category = Effector)
+	bool bConstrainEffectorRotation;
+
+	/** Effector rotation, in EffectorLocationSpace. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Effector, meta = (PinHiddenByDefault, EditCondition = "bConstrainEffectorRotation"))
+	FRotator EffectorRotation;
+
+	/** How many units of distance a radian of rotation error is worth against the location error. */
+	UPROPERTY(EditAnywhere, Category = Effector, meta = (ClampMin = "0.0", EditCondition = "bConstrainEffectorRotation"))
+	float EffectorRotationWeight;
+
+	/** Angle from the effector rotation, in degrees, at which the solve stops. */
+	UPROPERTY(EditAnywhere, Category = Effector, meta = (ClampMin = "0.0", EditCondition = "bConstrainEffectorRotation"))
+	float AnglePrecision;
+
+	UPROPERTY(EditAnywhere, Category = Solver)
+	FBoneReference TipBone;
+
+	UPROPERTY(EditAnywhere, Category = Solver)
+	FBoneReference RootBone;
+
+	UPROPERTY(EditAnywhere, Category = Solver, meta = (PinShownByDefault))
+	EIKSolverType Solver;
+
+	/** Stages run when Solver is Pipeline, up to four; left empty the stages are picked as for Auto. */
+	UPROPERTY(EditAnywhere, Category = Solver)
+	TArray<FIKSolverStage> PipelineStages;
+
+	/** Distance from the effector at which the solve stops. */
+	UPROPERTY(EditAnywhere, Category = Solver, meta = (PinShownByDefault, ClampMin = "0.0"))
+	float Precision;
+
+	UPROPERTY(EditAnywhere, Category = Solver, meta = (PinShownByDefault, ClampMin = "1"))
+	int32 MaxIterations;
+
+	/** Solve two-link chains in closed form whatever Solver is. */
+	UPROPERTY(EditAnywhere, Category = Solver)
+	bool bAnalyticTwoBone;
+
+	/** Closed form two-link chains: let both links grow up to MaxStretchScale to reach an effector past the limb's reach. */
+	UPROPERTY(EditAnywhere, Category = TwoBone, meta = (EditCondition = "bAnalyticTwoBone"))
+	bool bAllowStretch;
+
+	UPROPERTY(EditAnywhere, Category = TwoBone, meta = (ClampMin = "1.0", EditCondition = "bAllowStretch"))
+	float MaxStretchScale;
+
+	/** Fraction of the reach past which the limb straightens asymptotically instead of snapping straight. */
+	UPROPERTY(EditAnywhere, Category = TwoBone, meta = (ClampMin = "0.0", ClampMax = "1.0", EditCondition = "bAnalyticTwoBone"))
+	float SoftStartRatio;
+
+	/** Bend the middle joint towards PoleLocation instead of keeping its current bend plane. */
+	UPROPERTY(EditAnywhere, Category = TwoBone, meta = (EditCondition = "bAnalyticTwoBone"))
+	bool bUsePoleVector;
+
+	/** Location the middle joint bends towards, in EffectorLocationSpace. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = TwoBone, meta = (PinHiddenByDefault, EditCondition = "bUsePoleVector"))
+	FVector PoleLocation;
+
+	/** Extra turn of the bend plane about the line from the root to the effector, in degrees. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = TwoBone, meta = (PinHiddenByDefault, EditCondition = "bAnalyticTwoBone"))
+	float SwivelAngle;
+
+	/** Jacobian solvers: build the Jacobian once per solve and update it from the effector's motion after that. */
+	UPROPERTY(EditAnywhere, Category = Solver)
+	bool bBroydenUpdates;
+
+	/** Start each solve from the previous frame's solution, carried along with the root's parent. */
+	UPROPERTY(EditAnywhere, Category = Solver)
+	bool bWarmStart;
+
+	/** Reuse the previous solution without solving while the effector and the chain root have not moved. */
+	UPROPERTY(EditAnywhere, Category = Solver)
+	bool bSkipUnchangedSolves;
+
+	FAnimNode_IKModuleSolver();
+
+	// FAnimNode_Base interface
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+	// End of FAnimNode_Base interface
+
+	// FAnimNode_SkeletalControlBase interface
+	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
+	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
+	// End of FAnimNode_SkeletalControlBase interface
+
+private:
+	// FAnimNode_SkeletalControlBase interface
+	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
+	// End of FAnimNode_SkeletalControlBase interface
+
+	// compact pose indices from RootBone to TipBone, rebuilt only when the required bones change
+	TArray<FCompactPoseBoneIndex> ChainBoneIndices;
+	FCompactPoseBoneIndex RootParentIndex = FCompactPoseBoneIndex(INDEX_NONE);
+
+	// positions and rotations from the incoming pose every evaluation, joint limits from the mesh's chain with the bone references
+	IKCore::FPose Pose;
+	IKCore::FJacobianWorkspace JacobianWorkspace;
+	IKCore::FTransformJacobianWorkspace TransformJacobianWorkspace;
+	IKCore::FChainSolveState SolveState;
+	IKCore::FSolveResult LastResult;
+};
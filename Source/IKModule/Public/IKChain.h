@@ -0,0 +1,93 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IKCoreTypes.h"
+
+class USkinnedMeshComponent;
+class USkeletalMesh;
+struct FReferenceSkeleton;
+
+namespace IKCore
+{
+	class FSkeletonCache;
+	struct FSkeletonChain;
+}
+
+/**
+ * Bone chain between a root bone and a tip bone, resolved once against a skeleton.
+ * All arrays are ordered from the root bone to the tip bone.
+ */
+struct FIKChain
+{
+	FName TipBoneName;
+	FName RootBoneName;
+
+	TArray<FName> BoneNames;
+	TArray<int32> BoneIndices;
+	TArray<int32> ParentIndices;
+
+	// length of the link between bone i and bone i + 1, taken from the reference pose
+	TArray<float> RestLengths;
+	float TotalReach = 0.f;
+
+	// limits of every bone but the tip from the mesh's physics asset, empty when they are all free or there is none
+	TArray<IKCore::FJointLimit> JointLimits;
+
+	int32 NumBones() const { return BoneIndices.Num(); }
+	int32 NumLinks() const { return FMath::Max(BoneIndices.Num() - 1, 0); }
+	bool IsValid() const { return BoneIndices.Num() > 1; }
+
+	static bool Build(const FReferenceSkeleton& RefSkeleton, FName InTipBoneName, FName InRootBoneName, FIKChain& OutChain);
+
+	/** The same from a chain precompiled into a cooked skeleton cache, without looking up any bone by name. */
+	static bool Build(const IKCore::FSkeletonCache& Cache, const IKCore::FSkeletonChain& CachedChain, FIKChain& OutChain);
+};
+
+/**
+ * Bones from a common root bone (e.g. pelvis) to each of several tip bones, resolved once against a skeleton.
+ * A bone on the way to more than one tip is in the tree once. Every bone comes after its parent, bone 0 is the root.
+ */
+struct FIKTree
+{
+	FName RootBoneName;
+	TArray<FName> TipBoneNames;
+
+	TArray<int32> BoneIndices;
+
+	// tree index of each bone's parent, INDEX_NONE for the root
+	TArray<int32> ParentIndices;
+
+	// tree index of each tip bone, in the order of TipBoneNames
+	TArray<int32> TipIndices;
+
+	int32 NumBones() const { return BoneIndices.Num(); }
+	bool IsValid() const { return BoneIndices.Num() > 1; }
+
+	static bool Build(const FReferenceSkeleton& RefSkeleton, const TArray<FName>& InTipBoneNames, FName InRootBoneName, FIKTree& OutTree);
+};
+
+/**
+ * Chains of a single mesh component keyed by (tip, root), and trees keyed by (tips, root).
+ * The cache is flushed only when the component's skeletal mesh changes. Chains are resolved once per mesh by
+ * FIKSkeletonCacheRegistry and shared, the cache only remembers where.
+ */
+class FIKChainCache
+{
+public:
+	const FIKChain* FindOrBuild(const USkinnedMeshComponent* MeshComp, FName TipBoneName, FName RootBoneName);
+	const FIKTree* FindOrBuildTree(const USkinnedMeshComponent* MeshComp, const TArray<FName>& TipBoneNames, FName RootBoneName);
+	void Reset();
+
+private:
+	/** Flush the cache when MeshComp shows another mesh than the one it was built for. */
+	const USkeletalMesh* UpdateMesh(const USkinnedMeshComponent* MeshComp);
+
+	TWeakObjectPtr<const USkeletalMesh> CachedMesh;
+	TMap<TPair<FName, FName>, const FIKChain*> Chains;
+
+	// a character has a handful of trees at most, they are looked up linearly; each is allocated on its own so that the
+	// pointers handed out stay valid while more are added
+	TArray<TUniquePtr<FIKTree>> Trees;
+};
@@ -0,0 +1,32 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+#include "IKCoreGroundProbe.h"
+
+class UWorld;
+
+/**
+ * Ground probes traced with the world's async line traces on one channel, the default backend of the solve subsystem.
+ * The engine runs all traces requested in a frame together on its task threads and has them ready on the next frame.
+ * A probe's IgnoredOwner, when set, is the AActor that sent it.
+ */
+class IKMODULE_API FIKAsyncTraceGroundQuery : public IKCore::IGroundQueryBackend
+{
+public:
+	explicit FIKAsyncTraceGroundQuery(UWorld& InWorld, ECollisionChannel InChannel = ECC_Visibility);
+
+	// IGroundQueryBackend interface
+	virtual void Submit(const IKCore::FGroundProbe* Probes, int32_t NumProbes) override;
+	virtual bool Fetch(IKCore::FGroundHit* OutHits, int32_t NumProbes) override;
+	// End of IGroundQueryBackend interface
+
+private:
+	TWeakObjectPtr<UWorld> World;
+	ECollisionChannel Channel;
+	TArray<FTraceHandle> Handles;
+	FTraceDatum Datum;
+};
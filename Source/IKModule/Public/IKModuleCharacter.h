@@ -5,11 +5,45 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "Components/PoseableMeshComponent.h"
+#include "IKChain.h"
+#include "IKPoseBuffer.h"
+#include "IKSolveSubsystem.h"
+#include "IKCoreGroundProbe.h"
+#include "IKCoreJacobian.h"
+#include "IKSolverType.h"
 
 #include "IKModuleCharacter.generated.h"
 
+/** Tip bone of a multi-effector solve, its world space target and how much it counts against the other tips. */
+struct FIKEffectorTarget
+{
+	FName TipBoneName;
+	FVector TargetLocation = FVector::ZeroVector;
+	float Weight = 1.f;
+};
+
+/** Foot placed on the ground by probing below it, solved on the chain from RootBoneName (e.g. the thigh) to FootBoneName. */
+USTRUCT()
+struct FIKFootDefinition
+{
+	GENERATED_BODY()
+
+	FIKFootDefinition() = default;
+	FIKFootDefinition(FName InFootBoneName, FName InRootBoneName)
+		: FootBoneName(InFootBoneName)
+		, RootBoneName(InRootBoneName)
+	{
+	}
+
+	UPROPERTY(EditAnywhere, Category = "IK")
+	FName FootBoneName;
+
+	UPROPERTY(EditAnywhere, Category = "IK")
+	FName RootBoneName;
+};
+
 UCLASS(config=Game)
-class AIKModuleCharacter : public ACharacter
+class IKMODULE_API AIKModuleCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
@@ -26,6 +60,14 @@ public:
 	void SolveFABRIK(FName TipBoneName, FName RootBoneName, FVector TargetLocation, float Precision, int32 MaxIterations);
 	void SolveJacobianTranspose(FName TipBoneName, FName RootBoneName, FVector TargetLocation, float Precision);
 	void SolveJacobianPinv(FName TipBoneName, FName RootBoneName, FVector TargetLocation, float Precision);
+	void SolveDampedLeastSquares(FName TipBoneName, FName RootBoneName, FVector TargetLocation, float Precision, int32 MaxIterations);
+
+	/**
+	 * Solve every effector in one pass over the tree from RootBoneName (e.g. pelvis) to their tips, so that limbs sharing
+	 * a spine do not undo each other. Jacobian solvers run the stacked damped least squares, the others sub-base FABRIK.
+	 * Always solved immediately, the solve subsystem only queues single chains.
+	 */
+	IKCore::FSolveResult SolveMultiEffector(IKCore::ESolver Solver, FName RootBoneName, const TArray<FIKEffectorTarget>& Targets, float Precision, int32 MaxIterations);
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
 	float BaseTurnRate;
@@ -36,6 +78,109 @@ public:
 	UPROPERTY(VisibleAnywhere, Category = "IK")
 	UPoseableMeshComponent* poseableMeshComp;
 
+	/** World space target of the left hand, solved on the arm chain in Tick. */
+	UPROPERTY(EditAnywhere, Category = "IK")
+	FVector ReachTargetLocation;
+
+	/** Solver of the chains solved in Tick, Auto picks the stages for each solve. */
+	UPROPERTY(EditAnywhere, Category = "IK")
+	EIKSolverType IKSolver;
+
+	/** Queue the solves on the world's IK solve subsystem instead of solving them in Tick. */
+	UPROPERTY(EditAnywhere, Category = "IK")
+	bool bDeferSolves;
+
+	/** Solve two-link chains, the arm and the legs, in closed form whatever IKSolver is. */
+	UPROPERTY(EditAnywhere, Category = "IK|Two Bone")
+	bool bAnalyticTwoBone;
+
+	/** Let both links of a two-link chain grow up to MaxStretchScale to reach a target past the limb's reach. */
+	UPROPERTY(EditAnywhere, Category = "IK|Two Bone", meta = (EditCondition = "bAnalyticTwoBone"))
+	bool bAllowStretch;
+
+	UPROPERTY(EditAnywhere, Category = "IK|Two Bone", meta = (ClampMin = "1.0", EditCondition = "bAllowStretch"))
+	float MaxStretchScale;
+
+	/** Fraction of the reach past which a limb straightens asymptotically instead of snapping straight. */
+	UPROPERTY(EditAnywhere, Category = "IK|Two Bone", meta = (ClampMin = "0.0", ClampMax = "1.0", EditCondition = "bAnalyticTwoBone"))
+	float SoftStartRatio;
+
+	/** Bend the elbow of the arm solved on ReachTargetLocation towards ReachPoleLocation instead of keeping its bend plane. */
+	UPROPERTY(EditAnywhere, Category = "IK|Two Bone", meta = (EditCondition = "bAnalyticTwoBone"))
+	bool bUseReachPole;
+
+	/** World space location the elbow bends towards. */
+	UPROPERTY(EditAnywhere, Category = "IK|Two Bone", meta = (EditCondition = "bUseReachPole"))
+	FVector ReachPoleLocation;
+
+	/** Extra turn of the arm's bend plane about the line from the shoulder to ReachTargetLocation, in degrees. */
+	UPROPERTY(EditAnywhere, Category = "IK|Two Bone", meta = (EditCondition = "bAnalyticTwoBone"))
+	float ReachSwivelAngle;
+
+	/** Skip a chain's solve while its target and root stay where the last converged solve left them. */
+	UPROPERTY(EditAnywhere, Category = "IK")
+	bool bSkipUnchangedSolves;
+
+	/** Gameplay weight of this character's IK in the frame's IK budget, on top of its size on screen. */
+	UPROPERTY(EditAnywhere, Category = "IK", meta = (ClampMin = "0.0"))
+	float IKPriority;
+
+	/**
+	 * Put the feet on the ground below them, probed with the solve subsystem's batched traces a frame ahead. Off by
+	 * default: it adds a leg solve and a trace per foot every frame.
+	 */
+	UPROPERTY(EditAnywhere, Category = "IK|Foot Placement")
+	bool bFootPlacement;
+
+	UPROPERTY(EditAnywhere, Category = "IK|Foot Placement")
+	TArray<FIKFootDefinition> Feet;
+
+	/** How far above and below its animated height a foot looks for ground, and moves at most. */
+	UPROPERTY(EditAnywhere, Category = "IK|Foot Placement", meta = (ClampMin = "0.0"))
+	float FootProbeAbove;
+
+	UPROPERTY(EditAnywhere, Category = "IK|Foot Placement", meta = (ClampMin = "0.0"))
+	float FootProbeBelow;
+
+	/** Seconds for a foot to cover half of the way to new ground, so steps and slopes do not make it pop. */
+	UPROPERTY(EditAnywhere, Category = "IK|Foot Placement", meta = (ClampMin = "0.0"))
+	float FootSmoothingHalfLife;
+
+private:
+	void UpdateIKTier();
+	void PlaceFeet(float DeltaTime);
+	IKCore::FSolveResult SolveChain(IKCore::ESolver Solver, FName TipBoneName, FName RootBoneName, const FVector& TargetLocation, float Precision, int32 MaxIterations,
+		const FVector* PoleLocation = nullptr, float SwivelAngle = 0.f);
+
+	FIKChainCache ChainCache;
+	FIKPoseBuffer PoseBuffer;
+
+	FIKTreePoseBuffer TreePoseBuffer;
+	IKCore::FMultiEffectorWorkspace MultiEffectorWorkspace;
+	std::vector<IKCore::FEffector> Effectors;
+	TArray<FName> EffectorTipNames;
+
+	// foot placement: animated feet, their targets and probes, and the ticket of last frame's probes
+	IKCore::FFootPlacement FootPlacement;
+	std::vector<Eigen::Vector3f> FootLocations;
+	std::vector<Eigen::Vector3f> FootTargets;
+	std::vector<IKCore::FGroundProbe> FootProbes;
+	FIKGroundProbeTicket FootProbeTicket;
+
+	// component space reference location of each foot chain's tip, found once per chain; chains live for the whole run
+	TMap<const FIKChain*, FVector> FootRefLocations;
+
+	// quality the frame budget gave this character's solves
+	IKCore::ELODTier IKTier = IKCore::ELODTier::Full;
+
+	// each (tip, root) chain's last solution, heap allocated so queued jobs can point at it, and the ticket of its queued solve
+	struct FChainSolve
+	{
+		TUniquePtr<IKCore::FChainSolveState> State;
+		FIKSolveTicket Ticket;
+	};
+	TMap<TPair<FName, FName>, FChainSolve> SolveStates;
+
 protected:
 	void MoveForward(float Value);
 	void MoveRight(float Value);
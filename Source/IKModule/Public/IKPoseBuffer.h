@@ -0,0 +1,38 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IKCoreTypes.h"
+#include "IKCoreMultiEffector.h"
+
+class UPoseableMeshComponent;
+struct FIKChain;
+struct FIKTree;
+
+/**
+ * Component space pose of an IK chain, handed to the IKCore solvers.
+ * The mesh is read once in Load and written once in Commit.
+ */
+struct FIKPoseBuffer
+{
+	IKCore::FPose Pose;
+
+	// component space transform of the root bone's parent
+	FTransform RootParentTransform;
+
+	bool Load(const UPoseableMeshComponent& MeshComp, const FIKChain& Chain);
+	void Commit(UPoseableMeshComponent& MeshComp, const FIKChain& Chain) const;
+};
+
+/** Component space pose of an IK tree for the multi-effector solvers, loaded and committed like FIKPoseBuffer. */
+struct FIKTreePoseBuffer
+{
+	IKCore::FTreePose Pose;
+
+	// component space transform of the root bone's parent
+	FTransform RootParentTransform;
+
+	bool Load(const UPoseableMeshComponent& MeshComp, const FIKTree& Tree);
+	void Commit(UPoseableMeshComponent& MeshComp, const FIKTree& Tree) const;
+};
@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "IKCorePoseDatabase.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+class USkeletalMesh;
+struct FIKChain;
+
+/**
+ * Pose databases of skeletal mesh chains, baked from the reference pose with ik.PoseDatabase.Bake and loaded on first use.
+ * The files are mapped from Content/IK/PoseDatabases, which is staged outside the pak files. Databases stay loaded for the
+ * rest of the run, so solve jobs can point at them. Game thread only.
+ */
+class FIKPoseDatabaseRegistry
+{
+public:
+	static FIKPoseDatabaseRegistry& Get();
+
+	/** Database of Chain on Mesh, null when none was baked or ik.PoseDatabase.Enable is off. */
+	const IKCore::FPoseDatabase* Find(const USkeletalMesh& Mesh, const FIKChain& Chain);
+
+	/** Bake the database of Chain on Mesh, save it and use it from now on. */
+	bool Bake(const USkeletalMesh& Mesh, const FIKChain& Chain, IKCore::ESolver Solver, const IKCore::FPoseDatabaseBakeSettings& BakeSettings);
+
+	static FString GetFilePath(const USkeletalMesh& Mesh, const FIKChain& Chain);
+
+	/** Blend of this many nearest baked solutions the solves start from, ik.PoseDatabase.Neighbours. */
+	static int32 GetNumNeighbours();
+
+private:
+	struct FEntry
+	{
+		~FEntry();
+
+		// file the database views, unmapped after a bake
+		TUniquePtr<IMappedFileHandle> MappedFile;
+		TUniquePtr<IMappedFileRegion> MappedRegion;
+		IKCore::FPoseDatabase Database;
+	};
+
+	using FKey = TTuple<FObjectKey, FName, FName>;
+
+	// null entries remember chains without a file, so the disk is looked at once
+	TMap<FKey, TUniquePtr<FEntry>> Entries;
+};
@@ -0,0 +1,60 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "IKCoreSkeletonCache.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+class USkeletalMesh;
+struct FIKChain;
+
+/**
+ * Chains of every skeletal mesh, shared by all the characters showing it. A mesh's chains come from its cooked skeleton
+ * cache when there is one, mapped rather than read, and are built from the reference skeleton and the physics asset's
+ * joint limits on first use otherwise; either way a chain is resolved once per mesh instead of once per character.
+ * Chains stay alive for the rest of the run.
+ *
+ * Caches are written by the IKSkeletonCache commandlet to Content/IK/Skeletons, which is staged outside the pak files
+ * so that it can be mapped.
+ */
+class IKMODULE_API FIKSkeletonCacheRegistry
+{
+public:
+	static FIKSkeletonCacheRegistry& Get();
+
+	/** Chain from RootBoneName to TipBoneName on Mesh, null when there is none. */
+	const FIKChain* FindOrBuildChain(const USkeletalMesh& Mesh, FName TipBoneName, FName RootBoneName);
+
+	/** Cooked cache of Mesh, null when none was cooked or it does not match the mesh's skeleton any more. */
+	const IKCore::FSkeletonCache* FindCache(const USkeletalMesh& Mesh);
+
+	/**
+	 * Write the cache of Mesh to FilePath: its bones and reference pose, the joint limits of its physics asset and the
+	 * chains given as (tip, root) pairs.
+	 */
+	static bool Cook(const USkeletalMesh& Mesh, const TArray<TPair<FName, FName>>& Chains, const FString& FilePath);
+
+	static FString GetFilePath(const USkeletalMesh& Mesh);
+
+private:
+	struct FMeshEntry
+	{
+		~FMeshEntry();
+
+		TUniquePtr<IMappedFileHandle> MappedFile;
+		TUniquePtr<IMappedFileRegion> MappedRegion;
+		IKCore::FSkeletonCache Cache;
+
+		// null for chains the skeleton does not have, so that they warn once
+		TMap<TPair<FName, FName>, TUniquePtr<FIKChain>> Chains;
+	};
+
+	FMeshEntry& FindOrLoad(const USkeletalMesh& Mesh);
+
+	// chains may be looked up from any thread
+	FCriticalSection Mutex;
+	TMap<FObjectKey, TUniquePtr<FMeshEntry>> Meshes;
+};
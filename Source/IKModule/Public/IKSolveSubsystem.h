@@ -0,0 +1,149 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "IKChain.h"
+#include "IKPoseBuffer.h"
+#include "IKCoreBudget.h"
+#include "IKCoreGroundProbe.h"
+#include "IKCoreJacobian.h"
+#include "IKCoreScheduler.h"
+#include "IKCoreSolveState.h"
+
+#include "IKSolveSubsystem.generated.h"
+
+class UPoseableMeshComponent;
+
+/** Handle of a submitted solve, to read its result back after the frame's sync point. */
+struct FIKSolveTicket
+{
+	uint64 Frame = 0;
+	int32 Index = INDEX_NONE;
+};
+
+/** Handle of ground probes submitted during a frame, to read their hits on the next one. */
+struct FIKGroundProbeTicket
+{
+	uint64 Frame = 0;
+	int32 Index = INDEX_NONE;
+	int32 Num = 0;
+};
+
+struct FIKSolveFrameStats
+{
+	int32 NumJobs = 0;
+
+	// jobs whose chain state found nothing had moved since its last converged solve
+	int32 NumSkipped = 0;
+	int32 NumWorkers = 0;
+
+	// wall time of the parallel solve and of the commit to the meshes
+	double SolveSeconds = 0.0;
+	double CommitSeconds = 0.0;
+
+	TArray<float> WorkerUtilization;
+	TArray<int32> WorkerSteals;
+
+	// characters per budget tier and the IK time the budget planned for them
+	int32 NumInTier[static_cast<int32>(IKCore::ELODTier::Num)] = {};
+	double PlannedSeconds = 0.0;
+};
+
+/**
+ * Central IK solve queue of a world.
+ * Characters submit chain/target jobs from their Tick; the subsystem ticks once all actors did, solves every job
+ * of the frame with a work-stealing queue on ParallelFor and writes the results back to the meshes in a single sync point,
+ * before the end of frame updates send the new bone transforms to the renderer.
+ * It also owns the frame's IK time budget, which puts the characters in quality tiers by significance, and sends the
+ * ground probes of every character as one batch of traces at the end of the frame, answered on the next one.
+ */
+UCLASS()
+class IKMODULE_API UIKSolveSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Load Chain from MeshComp now and queue its solve towards the world space TargetLocation. Game thread only.
+	 * With a SolveState the solve is warm started or skipped through it; the state must outlive the frame's sync point.
+	 * Its time is reported to the budget as a solve in Tier.
+	 */
+	FIKSolveTicket SubmitSolve(UPoseableMeshComponent& MeshComp, const FIKChain& Chain, IKCore::ESolver Solver, const FVector& TargetLocation, const IKCore::FSolverSettings& Settings,
+		IKCore::FChainSolveState* SolveState = nullptr, const IKCore::FWarmStartSettings& WarmStartSettings = IKCore::FWarmStartSettings(), IKCore::ELODTier Tier = IKCore::ELODTier::Full);
+
+	/**
+	 * Enter Owner in this frame's IK budget and get the tier the budget gave it at the end of the last frame,
+	 * Full until it was ranked once or while the budget is off (ik.Budget.Enable). Game thread only.
+	 */
+	IKCore::ELODTier RequestTier(const UObject& Owner, float Significance, int32 NumChains);
+
+	/** Time of a chain solve made outside the queue, in Tier. Game thread only. */
+	void ReportSolveTime(IKCore::ELODTier Tier, double Seconds);
+
+	const IKCore::FBudgetSettings& GetBudgetSettings() const { return Budget.GetSettings(); }
+
+	/** Result of a solve submitted during the last completed frame. */
+	bool GetSolveResult(const FIKSolveTicket& Ticket, IKCore::FSolveResult& OutResult) const;
+
+	const FIKSolveFrameStats& GetLastFrameStats() const { return LastFrameStats; }
+
+	/** Queue world space ground probes for this frame's batch. Game thread only. */
+	FIKGroundProbeTicket SubmitGroundProbes(const IKCore::FGroundProbe* Probes, int32 NumProbes);
+
+	/** Hits of probes submitted during the last frame, null while their traces are running. Game thread only. */
+	const IKCore::FGroundHit* GetGroundHits(const FIKGroundProbeTicket& Ticket);
+
+	/** Trace the ground probes with Backend, e.g. a heightfield, instead of the world's async line traces; null goes back to those. */
+	void SetGroundQueryBackend(TSharedPtr<IKCore::IGroundQueryBackend> Backend);
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	struct FJob
+	{
+		TWeakObjectPtr<UPoseableMeshComponent> MeshComp;
+		FName OwnerName;
+		FIKChain Chain;
+		FIKPoseBuffer PoseBuffer;
+		Eigen::Vector3f Target;
+		IKCore::ESolver Solver = IKCore::ESolver::FABRIK;
+		IKCore::FSolverSettings Settings;
+		IKCore::FChainSolveState* SolveState = nullptr;
+		IKCore::FWarmStartSettings WarmStartSettings;
+		IKCore::ELODTier Tier = IKCore::ELODTier::Full;
+		IKCore::FSolveResult Result;
+		double Seconds = 0.0;
+	};
+
+	void SolveJobs();
+	void CommitJobs();
+	void UpdateBudget();
+
+	// slots are reused from frame to frame so the chain and pose arrays keep their allocations
+	TArray<TUniquePtr<FJob>> Jobs;
+	int32 NumJobs = 0;
+
+	IKCore::FWorkStealingQueue Queue;
+	IKCore::FParallelForStats SchedulerStats;
+
+	uint64 CompletedFrame = 0;
+	TArray<IKCore::FSolveResult> CompletedResults;
+	FIKSolveFrameStats LastFrameStats;
+
+	IKCore::FGroundProbeQueue GroundProbes;
+	TSharedPtr<IKCore::IGroundQueryBackend> GroundQueryBackend;
+	uint64 GroundProbeFrame = 0;
+
+	IKCore::FFrameBudget Budget;
+	TMap<TObjectKey<UObject>, int32> BudgetRequests;
+	TMap<TObjectKey<UObject>, IKCore::ELODTier> AssignedTiers;
+};
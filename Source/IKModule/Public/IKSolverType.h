@@ -0,0 +1,43 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "IKSolverType.generated.h"
+
+/** Blueprint facing mirror of IKCore::ESolver. */
+UENUM(BlueprintType)
+enum class EIKSolverType : uint8
+{
+	CCD,
+	FABRIK,
+	JacobianTranspose,
+	JacobianPinv,
+	DampedLeastSquares,
+	TwoBone,
+
+	/** The stages of the pipeline, one after the other. */
+	Pipeline,
+
+	/** A pipeline picked for each solve from the chain length, the distance to the target and the last solve. */
+	Auto,
+};
+
+/** Blueprint facing mirror of IKCore::FSolverStage. */
+USTRUCT(BlueprintType)
+struct FIKSolverStage
+{
+	GENERATED_BODY()
+
+	/** Pipeline and Auto stages are skipped. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver)
+	EIKSolverType Solver = EIKSolverType::DampedLeastSquares;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (ClampMin = "1"))
+	int32 MaxIterations = 1;
+
+	/** Distance from the effector at which the next stage takes over, the last stage runs to the solve's precision. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (ClampMin = "0.0"))
+	float HandOffDistance = 0.f;
+};
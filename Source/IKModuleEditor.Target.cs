@@ -9,6 +9,6 @@ public class IKModuleEditorTarget : TargetRules
 	{
 		Type = TargetType.Editor;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
-		ExtraModuleNames.Add("IKModule");
+		ExtraModuleNames.AddRange(new string[] { "IKModule", "IKModuleEditor" });
 	}
 }
@@ -0,0 +1,25 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class IKModuleEditor : ModuleRules
+{
+	public IKModuleEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] {
+            "Core",
+            "CoreUObject",
+            "Engine",
+            "IKModule"
+        });
+
+		PrivateDependencyModuleNames.AddRange(new string[] {
+            "AnimGraph",
+            "AnimGraphRuntime",
+            "BlueprintGraph",
+            "UnrealEd"
+        });
+	}
+}
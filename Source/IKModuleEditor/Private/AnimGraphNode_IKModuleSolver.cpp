@@ -0,0 +1,31 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AnimGraphNode_IKModuleSolver.h"
+
+#define LOCTEXT_NAMESPACE "AnimGraphNode_IKModuleSolver"
+
+FText UAnimGraphNode_IKModuleSolver::GetControllerDescription() const
+{
+	return LOCTEXT("IKModuleSolver", "IK Module Solver");
+}
+
+FText UAnimGraphNode_IKModuleSolver::GetTooltipText() const
+{
+	return LOCTEXT("IKModuleSolverTooltip", "Solves the chain from Root Bone to Tip Bone towards the effector with the selected IK Module solver (CCD, FABRIK, Jacobian or two-bone).");
+}
+
+FText UAnimGraphNode_IKModuleSolver::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	if ((TitleType == ENodeTitleType::ListView || TitleType == ENodeTitleType::MenuTitle) || (Node.TipBone.BoneName == NAME_None))
+	{
+		return GetControllerDescription();
+	}
+
+	FFormatNamedArguments Args;
+	Args.Add(TEXT("ControllerDescription"), GetControllerDescription());
+	Args.Add(TEXT("TipBoneName"), FText::FromName(Node.TipBone.BoneName));
+	Args.Add(TEXT("Solver"), StaticEnum<EIKSolverType>()->GetDisplayNameTextByValue(static_cast<int64>(Node.Solver)));
+	return FText::Format(LOCTEXT("IKModuleSolverTitle", "{ControllerDescription}\nTip: {TipBoneName} ({Solver})"), Args);
+}
+
+#undef LOCTEXT_NAMESPACE
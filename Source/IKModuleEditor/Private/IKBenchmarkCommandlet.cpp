@@ -0,0 +1,275 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKBenchmarkCommandlet.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Math/RandomStream.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Tickable.h"
+#include "UObject/Package.h"
+
+#include "IKModuleCharacter.h"
+#include "IKSolveSubsystem.h"
+
+namespace
+{
+	constexpr float FrameSeconds = 1.f / 60.f;
+
+	// characters stand on a square grid this far apart
+	constexpr float CharacterSpacing = 200.f;
+
+	struct FBenchmarkRun
+	{
+		EIKSolverType Solver = EIKSolverType::FABRIK;
+		int32 NumCharacters = 0;
+		int32 NumFrames = 0;
+
+		// per measured frame
+		TArray<double> GameThreadSeconds;
+		double SolveSeconds = 0.0;
+		double CommitSeconds = 0.0;
+		int64 NumJobs = 0;
+		int64 NumSkipped = 0;
+
+		int64 MemoryBytes = 0;
+	};
+
+	UWorld* LoadWorld(const FString& MapPath)
+	{
+		UWorld* World = nullptr;
+		if (UPackage* Package = LoadPackage(nullptr, *MapPath, LOAD_None))
+		{
+			World = UWorld::FindWorldInPackage(Package);
+		}
+
+		if (World == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("IK benchmark: no map %s, running in an empty world"), *MapPath);
+			World = UWorld::CreateWorld(EWorldType::Game, false);
+		}
+		else
+		{
+			World->AddToRoot();
+			World->WorldType = EWorldType::Game;
+			if (!World->bIsWorldInitialized)
+			{
+				World->InitWorld(UWorld::InitializationValues().AllowAudioPlayback(false).CreatePhysicsScene(true).ShouldSimulatePhysics(true));
+			}
+			World->UpdateWorldComponents(true, false);
+		}
+
+		GEngine->CreateNewWorldContext(EWorldType::Game).SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+		return World;
+	}
+
+	void DestroyWorld(UWorld* World)
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		World->RemoveFromRoot();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	/** A frame as the engine loop runs it: the world's tick groups, then the tickable objects such as the solve subsystem. */
+	double TickFrame(UWorld& World)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		World.Tick(LEVELTICK_All, FrameSeconds);
+		FTickableGameObject::TickObjects(&World, LEVELTICK_All, false, FrameSeconds);
+		const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+		++GFrameCounter;
+		FCoreDelegates::OnEndFrame.Broadcast();
+		return Seconds;
+	}
+
+	double GetPercentile(TArray<double> Values, double Percentile)
+	{
+		if (Values.Num() == 0)
+		{
+			return 0.0;
+		}
+		Values.Sort();
+		return Values[FMath::Clamp(FMath::FloorToInt(Percentile * Values.Num()), 0, Values.Num() - 1)];
+	}
+
+	void RunBenchmark(UWorld& World, UClass& CharacterClass, FBenchmarkRun& Run, int32 NumWarmUpFrames, FRandomStream& Random)
+	{
+		const int64 StartMemory = static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical);
+
+		const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Run.NumCharacters)));
+		const float GridOffset = 0.5f * CharacterSpacing * (GridSize - 1);
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		// every hand reaches for a target circling a random point in front of the shoulder, so no solve can be skipped
+		TArray<AIKModuleCharacter*> Characters;
+		TArray<FVector> TargetCenters;
+		TArray<float> TargetPhases;
+		for (int32 Index = 0; Index < Run.NumCharacters; ++Index)
+		{
+			const FVector Location(CharacterSpacing * (Index % GridSize) - GridOffset, CharacterSpacing * (Index / GridSize) - GridOffset, 200.f);
+			AIKModuleCharacter* Character = World.SpawnActor<AIKModuleCharacter>(&CharacterClass, Location, FRotator::ZeroRotator, SpawnParameters);
+			if (Character == nullptr)
+			{
+				continue;
+			}
+			// only the reach chain is solved, and by the solver under test rather than the analytic two-bone path
+			Character->IKSolver = Run.Solver;
+			Character->bAnalyticTwoBone = false;
+			Character->bFootPlacement = false;
+			Characters.Add(Character);
+			TargetCenters.Add(Location + FVector(Random.FRandRange(20.f, 50.f), Random.FRandRange(-30.f, 30.f), Random.FRandRange(40.f, 80.f)));
+			TargetPhases.Add(Random.FRandRange(0.f, 2.f * PI));
+		}
+		Run.NumCharacters = Characters.Num();
+
+		const UIKSolveSubsystem* SolveSubsystem = World.GetSubsystem<UIKSolveSubsystem>();
+		for (int32 Frame = 0; Frame < NumWarmUpFrames + Run.NumFrames; ++Frame)
+		{
+			const float Time = Frame * FrameSeconds;
+			for (int32 Index = 0; Index < Characters.Num(); ++Index)
+			{
+				const float Angle = TargetPhases[Index] + 2.f * Time;
+				Characters[Index]->ReachTargetLocation = TargetCenters[Index] + 10.f * FVector(0.f, FMath::Cos(Angle), FMath::Sin(Angle));
+			}
+
+			const double Seconds = TickFrame(World);
+			if (Frame < NumWarmUpFrames)
+			{
+				continue;
+			}
+
+			Run.GameThreadSeconds.Add(Seconds);
+			if (SolveSubsystem != nullptr)
+			{
+				const FIKSolveFrameStats& Stats = SolveSubsystem->GetLastFrameStats();
+				Run.SolveSeconds += Stats.SolveSeconds;
+				Run.CommitSeconds += Stats.CommitSeconds;
+				Run.NumJobs += Stats.NumJobs;
+				Run.NumSkipped += Stats.NumSkipped;
+			}
+		}
+
+		Run.MemoryBytes = static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical) - StartMemory;
+
+		for (AIKModuleCharacter* Character : Characters)
+		{
+			Character->Destroy();
+		}
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+}
+
+int32 UIKBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MapPath = TEXT("/Game/ThirdPersonCPP/Maps/ThirdPersonExampleMap");
+	FString CharacterPath = TEXT("/Game/ThirdPersonCPP/Blueprints/ThirdPersonCharacter.ThirdPersonCharacter_C");
+	FString CountList = TEXT("1,10,50,100,250,500,1000,2000");
+	FString SolverList = TEXT("CCD,FABRIK,JacobianTranspose,JacobianPinv,DampedLeastSquares,Auto");
+	FString ReportPath = FPaths::ProfilingDir() / TEXT("IKBenchmark-") + FDateTime::Now().ToString() + TEXT(".csv");
+	int32 NumFrames = 300;
+	int32 NumWarmUpFrames = 30;
+	int32 Seed = 1;
+	FParse::Value(*Params, TEXT("Map="), MapPath, false);
+	FParse::Value(*Params, TEXT("Character="), CharacterPath, false);
+	FParse::Value(*Params, TEXT("Counts="), CountList, false);
+	FParse::Value(*Params, TEXT("Solvers="), SolverList, false);
+	FParse::Value(*Params, TEXT("Report="), ReportPath, false);
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+	FParse::Value(*Params, TEXT("WarmUpFrames="), NumWarmUpFrames);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	TArray<FString> CountNames;
+	CountList.ParseIntoArray(CountNames, TEXT(","));
+	TArray<FString> SolverNames;
+	SolverList.ParseIntoArray(SolverNames, TEXT(","));
+
+	const UEnum* SolverEnum = StaticEnum<EIKSolverType>();
+	TArray<EIKSolverType> Solvers;
+	for (const FString& SolverName : SolverNames)
+	{
+		const int64 Value = SolverEnum->GetValueByNameString(SolverName);
+		if (Value == INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Error, TEXT("IK benchmark: no solver %s"), *SolverName);
+			return 1;
+		}
+		Solvers.Add(static_cast<EIKSolverType>(Value));
+	}
+
+	UClass* CharacterClass = LoadClass<AIKModuleCharacter>(nullptr, *CharacterPath);
+	if (CharacterClass == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("IK benchmark: no character class %s, spawning AIKModuleCharacter"), *CharacterPath);
+		CharacterClass = AIKModuleCharacter::StaticClass();
+	}
+
+	if (!FParse::Param(*Params, TEXT("KeepBudget")))
+	{
+		if (IConsoleVariable* BudgetEnable = IConsoleManager::Get().FindConsoleVariable(TEXT("ik.Budget.Enable")))
+		{
+			BudgetEnable->Set(false);
+		}
+	}
+
+	UWorld* World = LoadWorld(MapPath);
+	FRandomStream Random(Seed);
+	FString Report = TEXT("solver,characters,frames,game_thread_ms,game_thread_p95_ms,ik_workers_ms,ik_commit_ms,solves_per_sec,skipped_per_frame,memory_per_character_kb\n");
+	for (EIKSolverType Solver : Solvers)
+	{
+		for (const FString& CountName : CountNames)
+		{
+			FBenchmarkRun Run;
+			Run.Solver = Solver;
+			Run.NumCharacters = FCString::Atoi(*CountName);
+			Run.NumFrames = NumFrames;
+			if (Run.NumCharacters <= 0 || Run.NumFrames <= 0)
+			{
+				continue;
+			}
+			RunBenchmark(*World, *CharacterClass, Run, NumWarmUpFrames, Random);
+			if (Run.NumCharacters == 0)
+			{
+				UE_LOG(LogTemp, Error, TEXT("IK benchmark: could not spawn %s"), *CharacterClass->GetName());
+				DestroyWorld(World);
+				return 1;
+			}
+
+			double GameThreadSeconds = 0.0;
+			for (double Seconds : Run.GameThreadSeconds)
+			{
+				GameThreadSeconds += Seconds;
+			}
+			const FString SolverName = SolverEnum->GetNameStringByValue(static_cast<int64>(Solver));
+			const double Row[] = {
+				GameThreadSeconds * 1000.0 / Run.NumFrames,
+				GetPercentile(Run.GameThreadSeconds, 0.95) * 1000.0,
+				Run.SolveSeconds * 1000.0 / Run.NumFrames,
+				Run.CommitSeconds * 1000.0 / Run.NumFrames,
+				GameThreadSeconds > 0.0 ? (Run.NumJobs - Run.NumSkipped) / GameThreadSeconds : 0.0,
+				static_cast<double>(Run.NumSkipped) / Run.NumFrames,
+				Run.MemoryBytes / 1024.0 / Run.NumCharacters };
+			Report += FString::Printf(TEXT("%s,%d,%d,%.4f,%.4f,%.4f,%.4f,%.1f,%.2f,%.2f\n"), *SolverName, Run.NumCharacters, Run.NumFrames, Row[0], Row[1], Row[2], Row[3], Row[4], Row[5], Row[6]);
+			UE_LOG(LogTemp, Display, TEXT("IK benchmark: %s, %d characters: %.3f ms game thread, %.3f ms IK workers, %.0f solves/s"), *SolverName, Run.NumCharacters, Row[0], Row[2], Row[4]);
+		}
+	}
+	DestroyWorld(World);
+
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(ReportPath), true);
+	if (!FFileHelper::SaveStringToFile(Report, *ReportPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("IK benchmark: could not write %s"), *ReportPath);
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("IK benchmark: report written to %s"), *FPaths::ConvertRelativePathToFull(ReportPath));
+	return 0;
+}
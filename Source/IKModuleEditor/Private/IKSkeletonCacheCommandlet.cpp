@@ -0,0 +1,45 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IKSkeletonCacheCommandlet.h"
+#include "IKSkeletonCache.h"
+#include "Engine/SkeletalMesh.h"
+
+int32 UIKSkeletonCacheCommandlet::Main(const FString& Params)
+{
+	FString MeshList = TEXT("/Game/Mannequin/Character/Mesh/SK_Mannequin");
+	FString ChainList = TEXT("hand_l:upperarm_l,hand_r:upperarm_r,foot_l:thigh_l,foot_r:thigh_r");
+	FParse::Value(*Params, TEXT("Meshes="), MeshList, false);
+	FParse::Value(*Params, TEXT("Chains="), ChainList, false);
+
+	TArray<FString> MeshPaths;
+	MeshList.ParseIntoArray(MeshPaths, TEXT(","));
+	TArray<FString> ChainNames;
+	ChainList.ParseIntoArray(ChainNames, TEXT(","));
+
+	TArray<TPair<FName, FName>> Chains;
+	for (const FString& ChainName : ChainNames)
+	{
+		FString TipBoneName;
+		FString RootBoneName;
+		if (!ChainName.Split(TEXT(":"), &TipBoneName, &RootBoneName))
+		{
+			UE_LOG(LogTemp, Error, TEXT("IK skeleton cache: chain %s is not tip:root"), *ChainName);
+			return 1;
+		}
+		Chains.Emplace(FName(*TipBoneName), FName(*RootBoneName));
+	}
+
+	int32 NumFailed = 0;
+	for (const FString& MeshPath : MeshPaths)
+	{
+		const USkeletalMesh* Mesh = LoadObject<USkeletalMesh>(nullptr, *MeshPath);
+		if (Mesh == nullptr)
+		{
+			UE_LOG(LogTemp, Error, TEXT("IK skeleton cache: no skeletal mesh %s"), *MeshPath);
+			++NumFailed;
+			continue;
+		}
+		NumFailed += FIKSkeletonCacheRegistry::Cook(*Mesh, Chains, FIKSkeletonCacheRegistry::GetFilePath(*Mesh)) ? 0 : 1;
+	}
+	return NumFailed > 0 ? 1 : 0;
+}
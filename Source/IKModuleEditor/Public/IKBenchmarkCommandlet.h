@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "IKBenchmarkCommandlet.generated.h"
+
+/**
+ * Crowd stress benchmark of the characters' IK, headless:
+ * UE4Editor-Cmd IKModule -run=IKBenchmark -nullrhi [-Map=/Game/Path/Map] [-Character=/Game/Path/Blueprint.Blueprint_C]
+ *     [-Counts=1,10,...] [-Solvers=FABRIK,...] [-Frames=300] [-WarmUpFrames=30] [-Seed=1] [-KeepBudget] [-Report=File.csv]
+ * For every solver and character count the map is filled with that many characters reaching for targets moving
+ * around random points in front of them, and ticked for a fixed number of frames at 60 Hz. The arm is solved by the
+ * solver of the run rather than the analytic two-bone path, and foot placement is off, so every job is an arm solve by
+ * that solver. One CSV row per run goes to the report, in the profiling directory by default: game thread and IK worker
+ * times per frame, solves per second and memory per character. The frame budget is off unless -KeepBudget is given, so every run solves at full quality.
+ */
+UCLASS()
+class UIKBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+};
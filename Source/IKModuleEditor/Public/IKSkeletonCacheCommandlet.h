@@ -0,0 +1,22 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "IKSkeletonCacheCommandlet.generated.h"
+
+/**
+ * Cook the IK skeleton caches of skeletal meshes, run before packaging:
+ * UE4Editor-Cmd IKModule -run=IKSkeletonCache [-Meshes=/Game/Path/Mesh,...] [-Chains=tip:root,...]
+ * Without arguments the mannequin is cooked with the limb chains the characters solve.
+ */
+UCLASS()
+class UIKSkeletonCacheCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+};